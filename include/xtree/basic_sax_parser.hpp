@@ -0,0 +1,563 @@
+//
+// Created by ZHENG Zhong on 2011-10-14.
+//
+
+#ifndef XTREE_BASIC_SAX_PARSER_HPP_20111014__
+#define XTREE_BASIC_SAX_PARSER_HPP_20111014__
+
+#include "xtree/config.hpp"
+#include "xtree/xml_base.hpp"
+#include "xtree/sax_attribute_view.hpp"
+#include "xtree/sax_error_info.hpp"
+#include "xtree/sax_features.hpp"
+#include "xtree/sax_string_view.hpp"
+#include "xtree/libxml2_fwd.hpp"
+#include "xtree/unused_arg.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+
+namespace xtree {
+
+
+    //! This class template is the base class of the handlers used by basic_sax_parser. A handler
+    //! should derive from this class template with itself as the template argument (CRTP), and
+    //! hide the functions of the events it wants to handle. The events not handled are detected
+    //! at compile time, and their callbacks are not registered to libxml2 at all. The functions
+    //! should be non-virtual and not overloaded.
+    //!
+    //! Names, texts and attributes are passed as non-owning views into the buffers of libxml2,
+    //! which are only valid during the callback receiving them.
+    template<class Derived>
+    class basic_sax_handler
+    {
+
+    public:
+
+        //! Receives notification of the beginning of an XML document.
+        void start_document()
+        {
+            // Do nothing.
+        }
+
+        //! Receives notification of the end of an XML document.
+        void end_document()
+        {
+            // Do nothing.
+        }
+
+        //! Receives notification of the beginning of an element.
+        void start_element(const sax_string_view& name,
+                           const sax_string_view& prefix,
+                           const sax_string_view& uri,
+                           const sax_attribute_view_list& attrs)
+        {
+            // Do nothing.
+            detail::unused_arg(name);
+            detail::unused_arg(prefix);
+            detail::unused_arg(uri);
+            detail::unused_arg(attrs);
+        }
+
+        //! Receives notification of the end of an element.
+        void end_element(const sax_string_view& name,
+                         const sax_string_view& prefix,
+                         const sax_string_view& uri)
+        {
+            // Do nothing.
+            detail::unused_arg(name);
+            detail::unused_arg(prefix);
+            detail::unused_arg(uri);
+        }
+
+        //! Receives notification of text.
+        void characters(const sax_string_view& chars)
+        {
+            // Do nothing.
+            detail::unused_arg(chars);
+        }
+
+        //! Receives notification of a CData block.
+        void cdata_block(const sax_string_view& chars)
+        {
+            // Do nothing.
+            detail::unused_arg(chars);
+        }
+
+        //! Receives notification of ignorable whitespace.
+        void ignorable_whitespace(const sax_string_view& chars)
+        {
+            // Do nothing.
+            detail::unused_arg(chars);
+        }
+
+        //! Receives notification of a comment.
+        void comment(const sax_string_view& chars)
+        {
+            // Do nothing.
+            detail::unused_arg(chars);
+        }
+
+        //! Receives notification of a warning.
+        void warning(const sax_error_info& info)
+        {
+            // Do nothing.
+            detail::unused_arg(info);
+        }
+
+        //! Receives notification of a recoverable error.
+        void error(const sax_error_info& info)
+        {
+            // Do nothing.
+            detail::unused_arg(info);
+        }
+
+        //! Receives notification of a fatal error.
+        void fatal(const sax_error_info& info)
+        {
+            // Do nothing.
+            detail::unused_arg(info);
+        }
+
+    protected:
+
+        //! Protected constructor: this class should be derived.
+        basic_sax_handler()
+        {
+            // Do nothing.
+        }
+
+        //! Protected non-virtual destructor: this class should be derived.
+        ~basic_sax_handler()
+        {
+            // Do nothing.
+        }
+
+    };
+
+
+    //! \cond DEV
+
+    namespace detail {
+
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // SAX callback table
+        //
+
+
+        //! This struct holds the subset of libxml2's SAX2 callbacks supported by basic_sax_parser.
+        //! It mirrors the corresponding fields of xmlSAXHandler, so that this header does not
+        //! depend on libxml2's headers. Null callbacks are not registered to libxml2.
+        struct sax_callback_table
+        {
+            void (*start_document)(void*);
+            void (*end_document)(void*);
+            void (*start_element_ns)(void*, const xmlChar*, const xmlChar*, const xmlChar*,
+                                     int, const xmlChar**, int, int, const xmlChar**);
+            void (*end_element_ns)(void*, const xmlChar*, const xmlChar*, const xmlChar*);
+            void (*characters)(void*, const xmlChar*, int);
+            void (*cdata_block)(void*, const xmlChar*, int);
+            void (*ignorable_whitespace)(void*, const xmlChar*, int);
+            void (*comment)(void*, const xmlChar*);
+            void (*structured_error)(void*, xmlError*);
+        };
+
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // handler traits
+        //
+
+
+        //! This class template detects at compile time which events a handler derived from
+        //! basic_sax_handler handles: a member function is considered as handling an event if it
+        //! is not the one inherited from basic_sax_handler.
+        template<class Handler>
+        class sax_handler_traits
+        {
+
+            typedef char         yes_type;
+            typedef char (&no_type)[2];
+
+            template<class F, class C>
+            static yes_type test(F C::*);
+
+            template<class F>
+            static no_type test(F basic_sax_handler<Handler>::*);
+
+        public:
+
+            enum
+            {
+                start_document       = (sizeof(test(&Handler::start_document)) == 1),
+                end_document         = (sizeof(test(&Handler::end_document)) == 1),
+                start_element        = (sizeof(test(&Handler::start_element)) == 1),
+                end_element          = (sizeof(test(&Handler::end_element)) == 1),
+                characters           = (sizeof(test(&Handler::characters)) == 1),
+                cdata_block          = (sizeof(test(&Handler::cdata_block)) == 1),
+                ignorable_whitespace = (sizeof(test(&Handler::ignorable_whitespace)) == 1),
+                comment              = (sizeof(test(&Handler::comment)) == 1),
+                warning              = (sizeof(test(&Handler::warning)) == 1),
+                error                = (sizeof(test(&Handler::error)) == 1),
+                fatal                = (sizeof(test(&Handler::fatal)) == 1)
+            };
+
+        };
+
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // basic_sax_parser_base
+        //
+
+
+        //! The non-template base class of basic_sax_parser, which drives the libxml2 parser.
+        class XTREE_DECL basic_sax_parser_base: private xml_base
+        {
+
+        public:
+
+            //! Stops the parsing. This function is typically called from a callback: the rest
+            //! of the XML is ignored, and no more callbacks are invoked. Stopping the parsing is
+            //! not considered as an error.
+            void stop();
+
+            //! Returns whether the last (or current) parsing has been stopped.
+            //! \return true if the parsing has been stopped, false otherwise.
+            bool stopped() const
+            {
+                return stopped_;
+            }
+
+            //! Enables or disables a feature. The namespaces and namespace_prefixes features have
+            //! no effect: the handler always receives the names as reported by libxml2.
+            //! \param feature  the feature to enable or disable.
+            //! \param enable   true to enable, false to disable.
+            void set_feature(sax_feature::type feature, bool enable)
+            {
+                features_.set(feature, enable);
+            }
+
+            //! Returns whether a feature is enabled.
+            //! \param feature  the feature.
+            //! \return true if this feature is enabled, false otherwise.
+            bool get_feature(sax_feature::type feature) const
+            {
+                return features_.test(feature);
+            }
+
+            //! Sets all the features at once. Defaults to sax_feature_set().
+            //! \param features  the features to set.
+            void set_features(const sax_feature_set& features)
+            {
+                features_ = features;
+            }
+
+            //! Returns the features.
+            //! \return the features.
+            const sax_feature_set& get_features() const
+            {
+                return features_;
+            }
+
+            //! Returns the libxml2 parser context during parsing, null otherwise.
+            xmlParserCtxt* context() const
+            {
+                return context_;
+            }
+
+        protected:
+
+            //! The levels of the errors reported by libxml2.
+            enum error_level_t
+            {
+                warning_level,
+                error_level,
+                fatal_level
+            };
+
+            explicit basic_sax_parser_base();
+
+            ~basic_sax_parser_base();
+
+            //! Parses an XML file with a SAX callback table. The callbacks receive this object as
+            //! user data.
+            //! \throws sax_error  if fail to parse the XML file.
+            void parse_file_(const sax_callback_table& callbacks, const std::string& file_name);
+
+            //! Parses a memory buffer with a SAX callback table. The callbacks receive this object
+            //! as user data.
+            //! \throws sax_error  if fail to parse the XML buffer.
+            void parse_buffer_(const sax_callback_table& callbacks,
+                               const char* data,
+                               std::size_t size);
+
+            //! Returns the level of a libxml2 error.
+            static error_level_t get_error_level_(const xmlError* err);
+
+            //! Returns the information of a libxml2 error.
+            static sax_error_info get_error_info_(const xmlError* err);
+
+        private:
+
+            //! Non-implemented copy constructor.
+            basic_sax_parser_base(const basic_sax_parser_base&);
+
+            //! Non-implemented copy assignment.
+            basic_sax_parser_base& operator=(const basic_sax_parser_base&);
+
+            //! Parses the XML under a parser context, and frees the parser context.
+            void parse_in_context_(xmlParserCtxt* context,
+                                   const sax_callback_table& callbacks,
+                                   const std::string& what);
+
+        private:
+
+            sax_feature_set features_;  //!< The features.
+            xmlParserCtxt*  context_;   //!< The libxml2 parser context during parsing.
+            bool            stopped_;   //!< Whether the parsing has been stopped.
+
+        };
+
+
+    }  // namespace xtree::detail
+
+    //! \endcond
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // basic_sax_parser
+    //
+
+
+    //! This class template represents an XML SAX parser dispatching the events to a handler at
+    //! compile time. Unlike sax_parser, there is no virtual function call nor null handler check
+    //! per event, and the callbacks of the events not handled by the handler are not registered
+    //! to libxml2 at all (libxml2 simply skips them). The handler class should derive from
+    //! basic_sax_handler<Handler>. Example:
+    //!
+    //! \code
+    //! class title_finder: public xtree::basic_sax_handler<title_finder>
+    //! {
+    //! public:
+    //!     void start_element(const xtree::sax_string_view& name, ...);
+    //!     void characters(const xtree::sax_string_view& chars);
+    //! };
+    //!
+    //! title_finder finder;
+    //! xtree::basic_sax_parser<title_finder> parser(finder);
+    //! parser.parse_file("books.xml");
+    //! \endcode
+    template<class Handler>
+    class basic_sax_parser: public detail::basic_sax_parser_base
+    {
+
+        typedef detail::sax_handler_traits<Handler> traits;
+
+    public:
+
+        typedef Handler handler_type;
+
+        //! Constructs a SAX parser dispatching the events to a handler.
+        //! \param handler  the handler, which should outlive the parser.
+        explicit basic_sax_parser(Handler& handler): handler_(&handler)
+        {
+            // Do nothing.
+        }
+
+        //! Returns the handler.
+        Handler& handler()
+        {
+            return *handler_;
+        }
+
+        //! Parses an XML file and invokes the handler.
+        //! \param file_name  the XML file name.
+        //! \throws sax_error  if fail to parse the XML file.
+        void parse_file(const std::string& file_name)
+        {
+            parse_file_(callbacks_, file_name);
+        }
+
+        //! Parses a string containing the XML and invokes the handler.
+        //! \param str  the XML string to parse.
+        //! \throws sax_error  if fail to parse the XML string.
+        void parse_string(const char* str)
+        {
+            if (str == 0)
+            {
+                parse_buffer_(callbacks_, 0, 0);
+            }
+            else
+            {
+                parse_buffer_(callbacks_, str, std::strlen(str));
+            }
+        }
+
+        //! Parses a memory buffer (not necessarily null-terminated) and invokes the handler.
+        //! \param data  pointer to the XML to parse.
+        //! \param size  the size of the XML in bytes.
+        //! \throws sax_error  if fail to parse the XML buffer.
+        void parse_buffer(const char* data, std::size_t size)
+        {
+            parse_buffer_(callbacks_, data, size);
+        }
+
+        //! Parses a contiguous range of characters containing the XML and invokes the handler
+        //! (see sax_parser::parse_buffer()).
+        //! \param range  the contiguous range of characters containing the XML to parse.
+        //! \throws sax_error  if fail to parse the XML buffer.
+        template<class ContiguousRange>
+        void parse_buffer(const ContiguousRange& range)
+        {
+            if (range.empty())
+            {
+                parse_buffer(static_cast<const char*>(0), 0);
+            }
+            else
+            {
+                parse_buffer(reinterpret_cast<const char*>(&range[0]),
+                             range.size() * sizeof(range[0]));
+            }
+        }
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        //! \name Libxml2 Callback Functions
+        //! \{
+
+        static basic_sax_parser& get_parser(void* context)
+        {
+            return static_cast<basic_sax_parser&>(
+                *static_cast<detail::basic_sax_parser_base*>(context)
+            );
+        }
+
+        static Handler& get_handler(void* context)
+        {
+            return *(get_parser(context).handler_);
+        }
+
+        static void start_document(void* context)
+        {
+            get_handler(context).start_document();
+        }
+
+        static void end_document(void* context)
+        {
+            // libxml2 always ends the document, even if the parsing has been stopped.
+            if (!get_parser(context).stopped())
+            {
+                get_handler(context).end_document();
+            }
+        }
+
+        static void start_element_ns(void* context,
+                                     const xmlChar* name,
+                                     const xmlChar* prefix,
+                                     const xmlChar* uri,
+                                     int ,
+                                     const xmlChar** ,
+                                     int nb_attrs,
+                                     int ,
+                                     const xmlChar** attrs)
+        {
+            get_handler(context).start_element(
+                sax_string_view(reinterpret_cast<const char*>(name)),
+                sax_string_view(reinterpret_cast<const char*>(prefix)),
+                sax_string_view(reinterpret_cast<const char*>(uri)),
+                sax_attribute_view_list(attrs, nb_attrs)
+            );
+        }
+
+        static void end_element_ns(void* context,
+                                   const xmlChar* name,
+                                   const xmlChar* prefix,
+                                   const xmlChar* uri)
+        {
+            get_handler(context).end_element(
+                sax_string_view(reinterpret_cast<const char*>(name)),
+                sax_string_view(reinterpret_cast<const char*>(prefix)),
+                sax_string_view(reinterpret_cast<const char*>(uri))
+            );
+        }
+
+        static void characters(void* context, const xmlChar* chars, int length)
+        {
+            get_handler(context).characters(
+                sax_string_view(reinterpret_cast<const char*>(chars), length)
+            );
+        }
+
+        static void cdata_block(void* context, const xmlChar* chars, int length)
+        {
+            get_handler(context).cdata_block(
+                sax_string_view(reinterpret_cast<const char*>(chars), length)
+            );
+        }
+
+        static void ignorable_whitespace(void* context, const xmlChar* chars, int length)
+        {
+            get_handler(context).ignorable_whitespace(
+                sax_string_view(reinterpret_cast<const char*>(chars), length)
+            );
+        }
+
+        static void comment(void* context, const xmlChar* chars)
+        {
+            get_handler(context).comment(sax_string_view(reinterpret_cast<const char*>(chars)));
+        }
+
+        static void structured_error(void* context, xmlError* err)
+        {
+            // This callback is always registered, so that libxml2 does not print the errors.
+            if (traits::warning || traits::error || traits::fatal)
+            {
+                switch (get_error_level_(err))
+                {
+                case warning_level:
+                    get_handler(context).warning(get_error_info_(err));
+                    break;
+                case error_level:
+                    get_handler(context).error(get_error_info_(err));
+                    break;
+                default:
+                    get_handler(context).fatal(get_error_info_(err));
+                    break;
+                }
+            }
+        }
+
+        //! \}
+
+    private:
+
+        //! The SAX callback table of this handler class, initialized at compile time.
+        static const detail::sax_callback_table callbacks_;
+
+        Handler* handler_;  //!< The handler.
+
+    };
+
+
+    template<class Handler>
+    const detail::sax_callback_table basic_sax_parser<Handler>::callbacks_ = {
+        (traits::start_document       ? &basic_sax_parser::start_document       : 0),
+        (traits::end_document         ? &basic_sax_parser::end_document         : 0),
+        (traits::start_element        ? &basic_sax_parser::start_element_ns     : 0),
+        (traits::end_element          ? &basic_sax_parser::end_element_ns       : 0),
+        (traits::characters           ? &basic_sax_parser::characters           : 0),
+        (traits::cdata_block          ? &basic_sax_parser::cdata_block          : 0),
+        (traits::ignorable_whitespace ? &basic_sax_parser::ignorable_whitespace : 0),
+        (traits::comment              ? &basic_sax_parser::comment              : 0),
+        &basic_sax_parser::structured_error,
+    };
+
+
+}  // namespace xtree
+
+
+#endif  // XTREE_BASIC_SAX_PARSER_HPP_20111014__
+
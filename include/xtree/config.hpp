@@ -98,6 +98,17 @@
 #include "xtree/user_config.hpp"
 
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Determine C++11 support (threads, atomics, thread-local storage) ...
+//
+
+#if !defined(XTREE_NO_CXX11) && !defined(XTREE_HAS_CXX11)
+#  if (__cplusplus >= 201103L) || (defined(XTREE_MSVC) && XTREE_MSVC >= 1900)
+#    define XTREE_HAS_CXX11 1
+#  endif
+#endif  // !XTREE_NO_CXX11 && !XTREE_HAS_CXX11
+
+
 //! The namespace of xtree library.
 namespace xtree { }
 
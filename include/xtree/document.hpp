@@ -19,6 +19,20 @@
 #include <string>
 
 
+//! \cond DEV
+
+namespace xtree {
+namespace detail {
+
+    class wrapper_arena;
+    class memory_region;
+
+}  // namespace xtree::detail
+}  // namespace xtree
+
+//! \endcond
+
+
 namespace xtree {
 
 
@@ -30,6 +44,7 @@ namespace xtree {
 
     class XTREE_DECL xpath;
     class XTREE_DECL xpath_result;
+    class XTREE_DECL xpath_variables;
     class XTREE_DECL node_set;
 
 
@@ -637,6 +652,13 @@ namespace xtree {
         //! \throws xpath_error  if the XPath expression is invalid.
         void eval(const xpath& expr, xpath_result& result);
 
+        //! Evaluates an XPath expression with variables.
+        //! \param expr    the XPath expression.
+        //! \param vars    the XPath variables referenced by the expression.
+        //! \param result  the generic XPath result.
+        //! \throws xpath_error  if the XPath expression is invalid.
+        void eval(const xpath& expr, const xpath_variables& vars, xpath_result& result);
+
         //! Evaluates an XPath expression to a boolean.
         //! \param expr  the XPath expression.
         //! \return the boolean result.
@@ -683,6 +705,47 @@ namespace xtree {
 
         //! \}
 
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        //! \name Node Wrapper Memory Management
+        //! \{
+
+        //! Returns the arena serving the node wrappers of this document, creating it on first
+        //! call. All the wrappers created on demand for the nodes of this document (see lazy node
+        //! wrappers) are allocated from this arena, which is released in one shot when this
+        //! document is destructed. This function should NOT be called by client code.
+        //! \return the arena serving the node wrappers of this document.
+        detail::wrapper_arena* get_wrapper_arena();
+
+        //! Returns the arena serving the node wrappers of this document if it has been created.
+        //! This function should NOT be called by client code.
+        //! \return the arena serving the node wrappers of this document, or null.
+        detail::wrapper_arena* find_wrapper_arena() const
+        {
+            return arena_;
+        }
+
+        //! Keeps the node wrappers allocated by another document alive as long as this document
+        //! is alive. This function is called when this document adopts nodes from the other one,
+        //! and should NOT be called by client code. Note that moving nodes back and forth between
+        //! two documents makes their arenas retain each other, so that their memory is not
+        //! reclaimed: clone the nodes instead of adopting them in this case.
+        //! \param source  the document whose nodes are adopted by this document.
+        void share_wrapper_arena(const document& source);
+
+        //! Attaches the arena from which the node wrappers have been allocated while the libxml2
+        //! document was being built. The document takes over the reference to the arena. This
+        //! function should NOT be called by client code.
+        //! \param arena  the arena to attach, may be null.
+        void attach_wrapper_arena(detail::wrapper_arena* arena);
+
+        //! Attaches the memory region from which the libxml2 document has been allocated. The
+        //! region is released after the libxml2 document is freed. This function should NOT be
+        //! called by client code.
+        //! \param region  the memory region to attach, may be null.
+        void attach_memory_region(detail::memory_region* region);
+
+        //! \}
+
         //! \endcond
 
     private:
@@ -705,7 +768,9 @@ namespace xtree {
 
     private:
 
-        child_node_list children_;  //!< The child node list under this document.
+        child_node_list         children_;  //!< The child node list under this document.
+        detail::wrapper_arena*  arena_;     //!< The arena serving node wrappers, may be null.
+        detail::memory_region*  region_;    //!< The memory region of libxml2, may be null.
 
     };
 
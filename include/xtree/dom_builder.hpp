@@ -0,0 +1,116 @@
+//
+// Created by ZHENG Zhong on 2011-10-17.
+//
+
+#ifndef XTREE_DOM_BUILDER_HPP_20111017__
+#define XTREE_DOM_BUILDER_HPP_20111017__
+
+#include "xtree/config.hpp"
+#include "xtree/xml_base.hpp"
+#include "xtree/document.hpp"
+#include "xtree/sax_handler.hpp"
+#include "xtree/libxml2_fwd.hpp"
+
+#if defined(XTREE_GNUC) && XTREE_GNUC >= 4
+#  pragma GCC diagnostic ignored "-Wdeprecated-declarations"  // std::auto_ptr is deprecated.
+#endif
+
+#include <memory>
+#include <string>
+
+
+namespace xtree {
+
+
+    //! This class represents a SAX content handler which builds a document object from the SAX
+    //! events it receives. It can be set as the content handler of any SAX parser, or be given
+    //! the events replayed from a sax_event_buffer.
+    //!
+    //! The namespaces of the elements and the attributes are declared where they are first used,
+    //! unless a namespace with the same prefix and URI is already in scope. Namespace
+    //! declarations which are not used by any element or attribute are therefore dropped.
+    //!
+    //! The node wrappers created while building are allocated from a wrapper arena, which is
+    //! handed over to the document released.
+    class XTREE_DECL dom_builder: public sax_content_handler, private xml_base
+    {
+
+    public:
+
+        //! Constructs a DOM builder.
+        explicit dom_builder();
+
+        //! Destructor: releases the document being built, if any.
+        ~dom_builder();
+
+        //! Returns the document built, and resets this builder for a new document.
+        //! \return the document built.
+        //! \throws bad_dom_operation  if no document has been built.
+        std::auto_ptr<document> release();
+
+        //! Creates a new document, discarding the document being built, if any.
+        virtual void start_document();
+
+        //! Checks that all the elements have been closed.
+        virtual void end_document();
+
+        //! Appends an element to the current element, and makes it the current element.
+        virtual void start_element(const std::string& name,
+                                   const std::string& prefix,
+                                   const std::string& uri,
+                                   const sax_attribute_list& attrs);
+
+        //! Closes the current element.
+        virtual void end_element(const std::string& name,
+                                 const std::string& prefix,
+                                 const std::string& uri);
+
+        //! Appends a text node to the current element.
+        virtual void characters(const char* chars, int length);
+
+        //! Appends a CDATA section to the current element.
+        virtual void cdata_block(const char* chars, int length);
+
+        //! Appends a text node to the current element.
+        virtual void ignorable_whitespace(const char* chars, int length);
+
+        //! Appends a comment to the current element, or to the document.
+        virtual void comment(const char* chars);
+
+    private:
+
+        //! Non-implemented copy constructor.
+        dom_builder(const dom_builder&);
+
+        //! Non-implemented copy assignment.
+        dom_builder& operator=(const dom_builder&);
+
+        //! Frees the document being built and its wrapper arena, if any.
+        void free_document_();
+
+        //! Appends a node to the current element, or to the document if there is no current
+        //! element. Releases the node if it cannot be appended.
+        void append_(xmlNode* px);
+
+        //! Declares a namespace on the current element, unless its prefix is already declared
+        //! on the current element.
+        void declare_xmlns_(const std::string& prefix, const std::string& uri);
+
+        //! Finds the namespace in scope with the given prefix and URI, or declares it on the
+        //! current element.
+        xmlNs* get_xmlns_(const std::string& prefix, const std::string& uri);
+
+    private:
+
+        xmlDoc*                doc_;      //!< The libxml2 document being built.
+        xmlNode*               current_;  //!< The current element, or null.
+        detail::wrapper_arena* arena_;    //!< The arena of the document being built, or null.
+
+    };
+
+
+}  // namespace xtree
+
+
+#endif  // XTREE_DOM_BUILDER_HPP_20111017__
+
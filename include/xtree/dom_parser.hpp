@@ -9,11 +9,13 @@
 #include "xtree/xml_base.hpp"
 #include "xtree/document.hpp"
 #include "xtree/libxml2_fwd.hpp"
+#include "xtree/libxml2_memory.hpp"
 
 #if defined(XTREE_GNUC) && XTREE_GNUC >= 4
 #  pragma GCC diagnostic ignored "-Wdeprecated-declarations"  // std::auto_ptr is deprecated.
 #endif
 
+#include <cstddef>
 #include <memory>
 #include <string>
 
@@ -21,11 +23,46 @@
 namespace xtree {
 
 
+    //! \cond DEV
+
+    namespace detail {
+
+        //! Initializes a libxml2 parser context for DOM parsing. The parsing options are applied
+        //! to the parser context through xmlCtxtUseOptions(), instead of libxml2's global
+        //! variables (such as xmlKeepBlanksDefault() or xmlSubstituteEntitiesDefault()) which are
+        //! shared by all the threads: this makes it possible to parse documents concurrently.
+        //! \param context  the libxml2 parser context to initialize.
+        //! \param options  the libxml2 parser options (a combination of xmlParserOption).
+        void init_dom_parser_context(xmlParserCtxt* context, int options);
+
+    }  // namespace xtree::detail
+
+    //! \endcond
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+
     //! This class represents an XML DOM parser. A parser is used to parse an XML file or string
-    //! and return the document object.
+    //! and return the document object. The parsing options are held by the parser and applied
+    //! to every libxml2 parser context it creates, without touching libxml2's global variables:
+    //! parsers used by different threads can parse documents concurrently. Note that parse_url()
+    //! is an exception, since libxml2's NanoHTTP proxy settings are global.
+    //!
+    //! A parser keeps its libxml2 parser context, and resets and reuses it for every file or
+    //! string it parses, so that the setup cost of the parser context (including its dictionary
+    //! and input buffers) is amortized. To parse many small documents, keep a parser per thread
+    //! (see get_thread_dom_parser()) rather than creating a parser for every document. Note that
+    //! the dictionary of the parser context grows with the number of distinct names parsed.
     class XTREE_DECL dom_parser: private xml_base
     {
 
+        //! \cond DEV
+
+        friend class dom_push_parser;
+
+        //! \endcond
+
     public:
 
         //! Default constructor.
@@ -34,6 +71,41 @@ namespace xtree {
         //! Destructor.
         ~dom_parser();
 
+        //! Sets whether to keep the blank text nodes (ignorable whitespaces). Defaults to false.
+        //! \param flag  true to keep the blank text nodes, false to remove them.
+        void set_keep_blanks(bool flag);
+
+        //! Returns whether to keep the blank text nodes (ignorable whitespaces).
+        //! \return true if the blank text nodes are kept, false otherwise.
+        bool get_keep_blanks() const;
+
+        //! Sets whether to substitute entities. Defaults to true.
+        //! \param flag  true to substitute entities, false otherwise.
+        void set_substitute_entities(bool flag);
+
+        //! Returns whether to substitute entities.
+        //! \return true if entities are substituted, false otherwise.
+        bool get_substitute_entities() const;
+
+        //! Sets whether to load the external DTD subset. Defaults to true.
+        //! \param flag  true to load the external DTD subset, false otherwise.
+        void set_load_external_dtd(bool flag);
+
+        //! Returns whether to load the external DTD subset.
+        //! \return true if the external DTD subset is loaded, false otherwise.
+        bool get_load_external_dtd() const;
+
+        //! Sets whether to map the XML file to memory in parse_file(), instead of reading it with
+        //! libxml2's buffered file reader. This saves the read() system calls on large files.
+        //! Compressed files, and files which cannot be mapped, are still read by libxml2's file
+        //! reader. Defaults to false.
+        //! \param flag  true to map the XML file to memory, false otherwise.
+        void set_memory_map(bool flag);
+
+        //! Returns whether to map the XML file to memory in parse_file().
+        //! \return true if the XML file is mapped to memory, false otherwise.
+        bool get_memory_map() const;
+
         //! Parses an XML file to a document object.
         //! \param file_name  the name of the xml file to parse.
         //! \return a document object parsed from the file, never null.
@@ -46,6 +118,32 @@ namespace xtree {
         //! \throws dom_error  if fail to parse the XML string.
         std::auto_ptr<document> parse_string(char const* str);
 
+        //! Parses a memory buffer containing XML to a document object. The buffer does not need
+        //! to be null-terminated: it can be a slice of a larger buffer (e.g. a network receive
+        //! buffer). The buffer is passed to libxml2 directly, without being copied to a string.
+        //! \param data  pointer to the XML to parse.
+        //! \param size  the size of the XML in bytes.
+        //! \return a document object parsed from the buffer, never null.
+        //! \throws dom_error  if fail to parse the XML buffer.
+        std::auto_ptr<document> parse_buffer(const char* data, std::size_t size);
+
+        //! Parses a contiguous range of characters containing XML to a document object. The range
+        //! should provide empty(), size() and operator[], and hold its characters contiguously
+        //! (e.g. std::string, std::vector<char>, boost::iterator_range<const char*>).
+        //! \param range  the contiguous range of characters containing XML to parse.
+        //! \return a document object parsed from the range, never null.
+        //! \throws dom_error  if fail to parse the XML range.
+        template<class ContiguousRange>
+        std::auto_ptr<document> parse_buffer(const ContiguousRange& range)
+        {
+            if (range.empty())
+            {
+                return parse_buffer(static_cast<const char*>(0), 0);
+            }
+            return parse_buffer(reinterpret_cast<const char*>(&range[0]),
+                                range.size() * sizeof(range[0]));
+        }
+
         //! Parses an XML file from a given URL to a document object.
         //! \param url    the URL to the XML file to parse.
         //! \param proxy  the HTTP proxy. If empty (by default), use system variable "http_proxy".
@@ -62,6 +160,24 @@ namespace xtree {
         //! Non-implemented copy assignment.
         dom_parser& operator=(const dom_parser&);
 
+        //! Returns the reusable libxml2 parser context of this parser, creating it on first call.
+        //! \param region_scope  the memory region scope of the current parsing.
+        //! \return the reusable parser context, or null if the parser context should not be
+        //!         reused (because the document is allocated from a memory region).
+        //! \throws internal_dom_error  if fail to create the parser context.
+        xmlParserCtxt* reusable_context_(const detail::memory_region_scope& region_scope);
+
+        //! Returns the libxml2 parser options (a combination of xmlParserOption).
+        int options_() const;
+
+    private:
+
+        bool           keep_blanks_;          //!< Whether to keep blank text nodes.
+        bool           substitute_entities_;  //!< Whether to substitute entities.
+        bool           load_external_dtd_;    //!< Whether to load the external DTD subset.
+        bool           memory_map_;           //!< Whether to map the XML file to memory.
+        xmlParserCtxt* context_;              //!< The reusable libxml2 parser context.
+
     };
 
 
@@ -86,6 +202,23 @@ namespace xtree {
     }
 
 
+    //! Parses a memory buffer containing XML to a document object.
+    inline std::auto_ptr<document> parse_buffer(const char* data, std::size_t size)
+    {
+        dom_parser p;
+        return p.parse_buffer(data, size);
+    }
+
+
+    //! Parses a contiguous range of characters containing XML to a document object.
+    template<class ContiguousRange>
+    inline std::auto_ptr<document> parse_buffer(const ContiguousRange& range)
+    {
+        dom_parser p;
+        return p.parse_buffer(range);
+    }
+
+
     //! Parses an XML file from a URL to a document object.
     inline std::auto_ptr<document> parse_url(const std::string& url,
                                              const std::string& proxy = std::string())
@@ -95,6 +228,20 @@ namespace xtree {
     }
 
 
+#ifdef XTREE_HAS_CXX11
+
+
+    //! Returns the DOM parser owned by the calling thread, creating it on first call. Reusing this
+    //! parser for all the documents parsed in a thread amortizes the setup cost of the libxml2
+    //! parser context. The parser should not be shared with other threads. Note that the parsing
+    //! options set on this parser are kept for the subsequent parsing in the same thread.
+    //! \return the DOM parser owned by the calling thread.
+    XTREE_DECL dom_parser& get_thread_dom_parser();
+
+
+#endif  // XTREE_HAS_CXX11
+
+
     //! \}
 
 
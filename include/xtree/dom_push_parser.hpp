@@ -0,0 +1,110 @@
+//
+// Created by ZHENG Zhong on 2011-10-08.
+//
+
+#ifndef XTREE_DOM_PUSH_PARSER_HPP_20111008__
+#define XTREE_DOM_PUSH_PARSER_HPP_20111008__
+
+#include "xtree/config.hpp"
+#include "xtree/xml_base.hpp"
+#include "xtree/document.hpp"
+#include "xtree/dom_parser.hpp"
+#include "xtree/libxml2_fwd.hpp"
+
+#if defined(XTREE_GNUC) && XTREE_GNUC >= 4
+#  pragma GCC diagnostic ignored "-Wdeprecated-declarations"  // std::auto_ptr is deprecated.
+#endif
+
+#include <cstddef>
+#include <memory>
+
+
+namespace xtree {
+
+
+    //! This class represents an incremental (push-mode) XML DOM parser. Instead of parsing a
+    //! whole file or string in one blocking call, the XML is fed to the parser chunk by chunk as
+    //! it arrives (e.g. from a socket), and the document object is returned once the last chunk
+    //! has been fed. This makes it possible to overlap receiving and parsing, without buffering
+    //! the whole XML first.
+    //!
+    //! After finish() returns, or after an error is thrown, the parser is ready to parse another
+    //! document: its libxml2 parser context is reset and reused. Note that document memory
+    //! regions are not used by the push parser, since parsing spans several calls; the node
+    //! wrappers created while parsing are allocated from a wrapper arena, though.
+    class XTREE_DECL dom_push_parser: private xml_base
+    {
+
+    public:
+
+        //! Constructs a push parser with the default parsing options.
+        explicit dom_push_parser();
+
+        //! Constructs a push parser with the parsing options of a DOM parser.
+        //! \param parser  the DOM parser whose parsing options are used.
+        explicit dom_push_parser(const dom_parser& parser);
+
+        //! Destructor.
+        ~dom_push_parser();
+
+        //! Feeds a chunk of XML to the parser. The chunk may end anywhere, including in the
+        //! middle of a tag or a multi-byte character. The chunk is not used after this function
+        //! returns.
+        //! \param data  pointer to the chunk of XML.
+        //! \param size  the size of the chunk in bytes.
+        //! \throws dom_error  if the XML fed so far is not well-formed. The current document is
+        //!                    discarded, and the parser is ready to parse another document.
+        void feed(const char* data, std::size_t size);
+
+        //! Notifies the parser that the whole XML has been fed, and returns the document.
+        //! \return the document object parsed from the chunks fed, never null.
+        //! \throws dom_error  if nothing has been fed, or if the XML is not well-formed. The
+        //!                    parser is ready to parse another document.
+        std::auto_ptr<document> finish();
+
+        //! Discards the document being parsed, if any. The parser is ready to parse another
+        //! document.
+        void reset();
+
+        //! Returns whether a document is being parsed (i.e. some chunks have been fed since the
+        //! last call to finish() or reset()).
+        //! \return true if a document is being parsed, false otherwise.
+        bool started() const
+        {
+            return started_;
+        }
+
+    private:
+
+        //! Non-implemented copy constructor.
+        dom_push_parser(const dom_push_parser&);
+
+        //! Non-implemented copy assignment.
+        dom_push_parser& operator=(const dom_push_parser&);
+
+        //! Starts parsing a new document: creates or resets the libxml2 parser context.
+        //! \throws internal_dom_error  if fail to create the parser context.
+        void start_();
+
+        //! Feeds a chunk to the libxml2 parser context, and checks the result.
+        //! \param data       pointer to the chunk, may be null if size is 0.
+        //! \param size       the size of the chunk, which should fit in an int.
+        //! \param terminate  whether this is the last chunk.
+        //! \throws dom_error  if the XML is not well-formed.
+        void parse_chunk_(const char* data, int size, bool terminate);
+
+    private:
+
+        int                    options_;   //!< The libxml2 parser options.
+        xmlParserCtxt*         context_;   //!< The libxml2 push parser context.
+        bool                   started_;   //!< Whether a document is being parsed.
+        detail::wrapper_arena* arena_;     //!< The arena of the document being parsed, or null.
+
+    };
+
+
+}  // namespace xtree
+
+
+#endif  // XTREE_DOM_PUSH_PARSER_HPP_20111008__
+
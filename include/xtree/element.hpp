@@ -32,6 +32,7 @@ namespace xtree {
     class XTREE_DECL xmlns;
     class XTREE_DECL xpath;
     class XTREE_DECL xpath_result;
+    class XTREE_DECL xpath_variables;
     class XTREE_DECL node_set;
 
 
@@ -645,6 +646,13 @@ namespace xtree {
         //! \throws xpath_error  if the XPath expression is invalid.
         void eval(const xpath& expr, xpath_result& result);
 
+        //! Evaluates an XPath expression with variables.
+        //! \param expr    the XPath expression.
+        //! \param vars    the XPath variables referenced by the expression.
+        //! \param result  the generic XPath result.
+        //! \throws xpath_error  if the XPath expression is invalid.
+        void eval(const xpath& expr, const xpath_variables& vars, xpath_result& result);
+
         //! Evaluates an XPath expression to a boolean.
         //! \param expr  the XPath expression.
         //! \return the boolean result.
@@ -15,6 +15,25 @@ namespace xtree {
 namespace detail {
 
 
+    class wrapper_arena;
+
+
+    //! Returns the wrapper arena of the document owning a libxml2 node. If the node does not
+    //! belong to a wrapped document yet, the arena of the current wrapper arena scope is returned
+    //! instead, if any.
+    //! \param px      the libxml2 node.
+    //! \param create  whether to create the arena if the document does not have one yet.
+    //! \return the wrapper arena, or null if no arena is found.
+    wrapper_arena* get_owner_arena(const xmlNode* px, bool create);
+
+
+    //! Attribute version of get_owner_arena().
+    //! \param px      the libxml2 attribute.
+    //! \param create  whether to create the arena if the document does not have one yet.
+    //! \return the wrapper arena, or null.
+    wrapper_arena* get_owner_arena(const xmlAttr* px, bool create);
+
+
     //! Callback function invoked by libxml2 whenever an xmlNode has been constructed.
     //! \param px  the libxml2 node object constructed.
     void on_node_construct(xmlNode* px);
@@ -25,6 +44,20 @@ namespace detail {
     void on_node_destruct(xmlNode* px);
 
 
+    //! Returns the wrapper object of a libxml2 node. If the node does not have a wrapper yet (this
+    //! is the case when lazy node wrappers are enabled), the wrapper is created and attached to
+    //! the node's _private field, and will be deleted together with the node.
+    //! \param px  the libxml2 node, should not be null.
+    //! \return the wrapper object, or null if the node type is not supported.
+    void* get_or_create_private(const xmlNode* px);
+
+
+    //! Attribute version of get_or_create_private().
+    //! \param px  the libxml2 attribute, should not be null.
+    //! \return the attribute wrapper object.
+    void* get_or_create_private(const xmlAttr* px);
+
+
 } // namespace xtree::detail
 } // namespace xtree
 
@@ -21,6 +21,7 @@ typedef unsigned char xmlChar;
 
 struct _xmlError;
 struct _xmlNode;
+struct _xmlAttr;
 struct _xmlNs;
 struct _xmlDoc;
 struct _xmlSchema;
@@ -28,9 +29,15 @@ struct _xmlXPathContext;
 struct _xmlXPathCompExpr;
 struct _xmlXPathObject;
 struct _xmlNodeSet;
+struct _xmlMutex;
+struct _xmlParserCtxt;
+struct _xmlTextReader;
+struct _xmlPattern;
+struct _xmlStreamCtxt;
 
 typedef struct _xmlError          xmlError;
 typedef struct _xmlNode           xmlNode;
+typedef struct _xmlAttr           xmlAttr;
 typedef struct _xmlNs             xmlNs;
 typedef struct _xmlDoc            xmlDoc;
 typedef struct _xmlSchema         xmlSchema;
@@ -38,6 +45,11 @@ typedef struct _xmlXPathContext   xmlXPathContext;
 typedef struct _xmlXPathCompExpr  xmlXPathCompExpr;
 typedef struct _xmlXPathObject    xmlXPathObject;
 typedef struct _xmlNodeSet        xmlNodeSet;
+typedef struct _xmlMutex          xmlMutex;
+typedef struct _xmlParserCtxt     xmlParserCtxt;
+typedef struct _xmlTextReader     xmlTextReader;
+typedef struct _xmlPattern        xmlPattern;
+typedef struct _xmlStreamCtxt     xmlStreamCtxt;
 
 
 typedef void (*xmlRegisterNodeFunc)   (xmlNode*);
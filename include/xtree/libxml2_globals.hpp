@@ -8,6 +8,7 @@
 #include "xtree/config.hpp"
 #include "xtree/phoenix_singleton.hpp"
 #include "xtree/libxml2_fwd.hpp"
+#include "xtree/libxml2_memory.hpp"
 
 
 //! \cond DEV
@@ -33,6 +34,21 @@ namespace detail {
         //! Initializes the global resources of libxml2 as necessary.
         static void initialize();
 
+        //! Installs the memory allocator for libxml2, then initializes the global resources of
+        //! libxml2 as necessary.
+        //! \param allocator  the memory allocator for libxml2.
+        static void initialize(libxml2_allocator_t allocator);
+
+        //! Installs the memory allocator for libxml2. The allocator should be installed before
+        //! libxml2 is initialized. Once the pool allocator is installed, it cannot be uninstalled.
+        //! \param allocator  the memory allocator for libxml2.
+        //! \throws bad_dom_operation  if the allocator cannot be installed.
+        static void set_allocator(libxml2_allocator_t allocator);
+
+        //! Returns the memory allocator used by libxml2.
+        //! \return the memory allocator used by libxml2.
+        static libxml2_allocator_t get_allocator();
+
         //! Sets the cleanup parser flag to indicate whether to call xmlCleanupParser() at exit.
         //! WARNING: in a multi-threaded environment, calling xmlCleanupParser() at exit may crash
         //! the application if another thread is still using libxml2... So by default, this flag
@@ -44,6 +60,27 @@ namespace detail {
         //! \return the cleanup parser flag.
         static bool get_cleanup_parser();
 
+        //! Sets the lazy node wrappers flag. When this flag is set to true, the C++ wrapper of a
+        //! libxml2 node is no longer created when the node is constructed, but on first access
+        //! through the xtree API. By default, this flag is set to false.
+        //! \param flag  the new lazy node wrappers flag.
+        static void set_lazy_node_wrappers(bool flag);
+
+        //! Returns the lazy node wrappers flag.
+        //! \return the lazy node wrappers flag.
+        static bool get_lazy_node_wrappers();
+
+        //! Sets the document regions flag. When this flag is set to true and the pool allocator
+        //! is installed, the small memory blocks allocated by libxml2 while parsing a document
+        //! are carved out of a memory region owned by the document. By default, this flag is set
+        //! to false.
+        //! \param flag  the new document regions flag.
+        static void set_document_regions(bool flag);
+
+        //! Returns the document regions flag.
+        //! \return the document regions flag.
+        static bool get_document_regions();
+
     private:
 
         //! Constructor: initializes the global resources of libxml2.
@@ -59,7 +96,9 @@ namespace detail {
         xmlRegisterNodeFunc   old_thr_def_register_node_fn_;
         xmlDeregisterNodeFunc old_thr_def_deregister_node_fn_;
 
-        bool cleanup_parser_;  //!< indicates whether to cleanup parser at exit.
+        bool cleanup_parser_;      //!< indicates whether to cleanup parser at exit.
+        bool lazy_node_wrappers_;  //!< indicates whether to create node wrappers on demand.
+        bool document_regions_;    //!< indicates whether to allocate documents from regions.
 
     };
 
@@ -89,6 +128,34 @@ namespace xtree {
     XTREE_DECL void initialize_libxml2();
 
 
+    //! Installs the memory allocator for libxml2, then initializes libxml2 library. This is the
+    //! recommended way to install the pool allocator, which greatly reduces the contention on
+    //! malloc when documents are parsed concurrently by several threads.
+    //! \param allocator  the memory allocator for libxml2.
+    //! \throws bad_dom_operation  if the allocator cannot be installed.
+    XTREE_DECL void initialize_libxml2(libxml2_allocator_t allocator);
+
+
+    //! Installs the memory allocator for libxml2, through xmlGcMemSetup(). Although the pool
+    //! allocator can be installed at any moment, it should preferably be installed before libxml2
+    //! is initialized. Once the pool allocator is installed, it cannot be uninstalled. The pool
+    //! allocator requires C++11 support (see XTREE_HAS_CXX11).
+    //! \param allocator  the memory allocator for libxml2.
+    //! \throws bad_dom_operation  if the allocator cannot be installed.
+    XTREE_DECL void set_libxml2_allocator(libxml2_allocator_t allocator);
+
+
+    //! Returns the memory allocator used by libxml2.
+    //! \return the memory allocator used by libxml2.
+    XTREE_DECL libxml2_allocator_t get_libxml2_allocator();
+
+
+    //! Returns the statistics of the memory allocated by libxml2. The statistics are collected
+    //! per thread, and are only available when the pool allocator is installed.
+    //! \return the statistics of the memory allocated by libxml2.
+    XTREE_DECL libxml2_memory_stats get_libxml2_memory_stats();
+
+
     //! Sets the cleanup parser flag to indicate whether to call xmlCleanupParser() at exit.
     //! \param flag  the new cleanup parser flag.
     XTREE_DECL void set_libxml2_cleanup_parser(bool flag);
@@ -99,6 +166,37 @@ namespace xtree {
     XTREE_DECL bool get_libxml2_cleanup_parser();
 
 
+    //! Sets the lazy node wrappers flag to indicate whether to create the C++ wrappers of libxml2
+    //! nodes on demand. By default, a wrapper is allocated for every node constructed by libxml2
+    //! (e.g. every node of a parsed document). When this flag is set to true, a wrapper is only
+    //! created when the node is first accessed through the xtree API, and it is deleted together
+    //! with the node. This saves a lot of time and memory when only a small part of a large
+    //! document is visited. Note that in this mode, const member functions may create wrappers,
+    //! so concurrent read access to the same document must be synchronized by the user.
+    //! \param flag  the new lazy node wrappers flag.
+    XTREE_DECL void set_lazy_node_wrappers(bool flag);
+
+
+    //! Returns the lazy node wrappers flag.
+    //! \return the lazy node wrappers flag.
+    XTREE_DECL bool get_lazy_node_wrappers();
+
+
+    //! Sets the document regions flag. When this flag is set to true and the pool allocator is
+    //! installed, the small memory blocks allocated by libxml2 while parsing a document (nodes,
+    //! attributes, strings, dictionary entries...) are carved out of a memory region owned by the
+    //! document, which is released in one shot once the document is destructed. The memory is
+    //! not reused before the region is released, so this mode suits documents which are parsed,
+    //! read and destructed, rather than documents which are heavily modified.
+    //! \param flag  the new document regions flag.
+    XTREE_DECL void set_libxml2_document_regions(bool flag);
+
+
+    //! Returns the document regions flag.
+    //! \return the document regions flag.
+    XTREE_DECL bool get_libxml2_document_regions();
+
+
     //! \}
 
 
@@ -0,0 +1,149 @@
+//
+// Created by ZHENG Zhong on 2011-09-27.
+//
+
+#ifndef XTREE_LIBXML2_MEMORY_HPP_20110927__
+#define XTREE_LIBXML2_MEMORY_HPP_20110927__
+
+#include "xtree/config.hpp"
+
+#include <cstddef>
+
+
+namespace xtree {
+
+
+    //! The memory allocators which libxml2 can be configured to use.
+    enum libxml2_allocator_t
+    {
+        libxml2_malloc_allocator = 0,  //!< The C runtime malloc/free (libxml2's default).
+        libxml2_pool_allocator         //!< The thread-caching pool allocator of xtree.
+    };
+
+
+    //! This struct holds the statistics of the memory allocated by libxml2. The statistics are
+    //! only collected when the pool allocator is installed.
+    struct libxml2_memory_stats
+    {
+
+        unsigned long long allocations;      //!< Number of memory blocks allocated.
+        unsigned long long deallocations;    //!< Number of memory blocks freed.
+        unsigned long long reallocations;    //!< Number of memory blocks reallocated.
+        unsigned long long allocated_bytes;  //!< Total size of memory requested by libxml2.
+        unsigned long long reserved_bytes;   //!< Total size of memory reserved from the system.
+        unsigned long long regions;          //!< Number of document regions created.
+
+        explicit libxml2_memory_stats(): allocations(0)
+                                       , deallocations(0)
+                                       , reallocations(0)
+                                       , allocated_bytes(0)
+                                       , reserved_bytes(0)
+                                       , regions(0)
+        {
+            // Do nothing.
+        }
+
+    };
+
+
+}  // namespace xtree
+
+
+//! \cond DEV
+
+#ifdef XTREE_MSVC
+#  pragma warning(push)
+#  pragma warning(disable: 4511 4512)  // noncopyable warnings
+#endif
+
+namespace xtree {
+namespace detail {
+
+
+    class memory_region;
+
+
+    //! Installs the memory allocator for libxml2 through xmlGcMemSetup(). Switching from the
+    //! malloc allocator to the pool allocator is supported at any moment, since the memory blocks
+    //! allocated before are recognized and released by free(). Switching back is NOT supported.
+    //! \param allocator  the memory allocator to install.
+    //! \throws bad_dom_operation  if the allocator cannot be installed.
+    void install_libxml2_allocator(libxml2_allocator_t allocator);
+
+
+    //! Returns the memory allocator currently used by libxml2.
+    //! \return the memory allocator currently used by libxml2.
+    libxml2_allocator_t get_libxml2_allocator();
+
+
+    //! Returns the statistics of the memory allocated by libxml2.
+    //! \return the statistics of the memory allocated by libxml2.
+    libxml2_memory_stats get_libxml2_memory_stats();
+
+
+    //! Releases a memory region owned by a document. The memory of the region is reclaimed once
+    //! all the memory blocks allocated from the region are freed.
+    //! \param region  the memory region to release, may be null.
+    void release_memory_region(memory_region* region);
+
+
+    //! This class creates a memory region and makes it the current region of the calling thread
+    //! during its lifetime: the small memory blocks allocated by libxml2 in the calling thread
+    //! are then carved out of the region. The region is typically detached and attached to the
+    //! document being parsed, which releases it on destruction.
+    class memory_region_scope
+    {
+
+    public:
+
+        //! Creates a memory region if document regions are enabled and the pool allocator is
+        //! installed, and makes it the current region of the calling thread.
+        explicit memory_region_scope();
+
+        //! Restores the previous region of the calling thread, and releases the region if it has
+        //! not been detached.
+        ~memory_region_scope();
+
+        //! Detaches the memory region from this scope. The caller is responsible for releasing
+        //! the region by release_memory_region(). The region remains the current region of the
+        //! calling thread until this scope is destructed.
+        //! \return the memory region, or null if no region is created.
+        memory_region* detach();
+
+        //! Returns whether a memory region is created by this scope.
+        //! \return true if a memory region is created by this scope, false otherwise.
+        bool active() const
+        {
+            return (region_ != 0);
+        }
+
+    private:
+
+        //! Non-implemented copy constructor.
+        memory_region_scope(const memory_region_scope&);
+
+        //! Non-implemented copy assignment.
+        memory_region_scope& operator=(const memory_region_scope&);
+
+    private:
+
+        memory_region* region_;    //!< The memory region created by this scope.
+        memory_region* previous_;  //!< The previous region of the calling thread.
+        bool           detached_;  //!< Whether the region has been detached.
+
+    };
+
+
+}  // namespace xtree::detail
+}  // namespace xtree
+
+
+#ifdef XTREE_MSVC
+#  pragma warning(pop)  // noncopyable warnings
+#endif
+
+//! \endcond
+
+
+#endif  // XTREE_LIBXML2_MEMORY_HPP_20110927__
+
@@ -7,6 +7,7 @@
 
 #include "xtree/config.hpp"
 #include "xtree/libxml2_fwd.hpp"
+#include "xtree/types.hpp"
 
 #include <string>
 #include <utility>
@@ -14,6 +15,13 @@
 
 //! \cond DEV
 
+namespace xtree {
+
+    struct xpath_value;
+
+}  // namespace xtree
+
+
 namespace xtree {
 namespace detail {
 
@@ -59,6 +67,25 @@ namespace detail {
     }
 
 
+    //! Builds QName from a namespace prefix and a local name.
+    //! \param prefix  the namespace prefix, may be null or empty.
+    //! \param name    the local name.
+    //! \return the QName.
+    inline std::string build_qname(const xmlChar* prefix, const xmlChar* name)
+    {
+        std::string qname;
+        if (prefix != 0 && *prefix != 0)
+        {
+            qname.append(to_chars(prefix)).append(1, ':');
+        }
+        if (name != 0)
+        {
+            qname.append(to_chars(name));
+        }
+        return qname;
+    }
+
+
     //! Builds an error message from an error code.
     //! \param code  the error code.
     //! \return an error message.
@@ -71,6 +98,14 @@ namespace detail {
     std::string build_error_message(const xmlError& err);
 
 
+    //! Converts an XPath result to a value of the requested type, following the rules of the
+    //! XPath functions string(), number() and boolean().
+    //! \param result  the XPath result, or null for an empty node set.
+    //! \param type    the requested value type.
+    //! \param value   output argument to hold the value.
+    void convert_xpath_result(xmlXPathObject* result, xpath_result_t type, xpath_value& value);
+
+
 }  // namespace xtree::detail
 }  // namespace xtree
 
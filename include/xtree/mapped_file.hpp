@@ -0,0 +1,121 @@
+//
+// Created by ZHENG Zhong on 2011-10-04.
+//
+
+#ifndef XTREE_MAPPED_FILE_HPP_20111004__
+#define XTREE_MAPPED_FILE_HPP_20111004__
+
+#include "xtree/config.hpp"
+#include "xtree/libxml2_fwd.hpp"
+
+#include <cstddef>
+#include <string>
+
+
+//! \cond DEV
+
+#ifdef XTREE_MSVC
+#  pragma warning(push)
+#  pragma warning(disable: 4511 4512)  // noncopyable warnings
+#endif
+
+namespace xtree {
+namespace detail {
+
+
+    //! This class maps a file to memory (read-only), so that the file can be fed to the libxml2
+    //! parser without read() system calls. The file is advised to be accessed sequentially.
+    //! The mapping is released on destruction.
+    class mapped_file
+    {
+
+    public:
+
+        //! Default constructor: no file is mapped.
+        explicit mapped_file();
+
+        //! Destructor: unmaps the file, if any.
+        ~mapped_file();
+
+        //! Maps a file to memory. This function does not throw: if the file cannot be mapped
+        //! (e.g. it does not exist, it is empty, or it is not a regular file), the caller should
+        //! fall back to libxml2's file reader.
+        //! \param file_name  the name of the file to map.
+        //! \return true if the file is mapped, false otherwise.
+        bool open(const std::string& file_name);
+
+        //! Unmaps the file, if any.
+        void close();
+
+        //! Returns whether a file is mapped.
+        //! \return true if a file is mapped, false otherwise.
+        bool is_open() const
+        {
+            return (data_ != 0);
+        }
+
+        //! Returns the content of the mapped file.
+        //! \return the content of the mapped file, or null if no file is mapped.
+        const char* data() const
+        {
+            return data_;
+        }
+
+        //! Returns the size of the mapped file.
+        //! \return the size of the mapped file, or 0 if no file is mapped.
+        std::size_t size() const
+        {
+            return size_;
+        }
+
+        //! Returns whether the mapped file is compressed (gzip or xz/lzma). Compressed files
+        //! should be left to libxml2's file reader, which decompresses them on the fly.
+        //! \return true if the mapped file is compressed, false otherwise.
+        bool compressed() const;
+
+        //! Pushes the mapped file as the input of a libxml2 parser context. The content of the
+        //! mapped file is pulled by the parser through I/O callbacks, chunk by chunk, so that
+        //! files larger than 2GB can be parsed. The mapping should be kept open until the parser
+        //! context is freed or reset.
+        //! \param context    the libxml2 parser context.
+        //! \param file_name  the name of the file, used as the URL of the input.
+        //! \return true on success, false on failure.
+        bool push_input(xmlParserCtxt* context, const std::string& file_name);
+
+    private:
+
+        //! Non-implemented copy constructor.
+        mapped_file(const mapped_file&);
+
+        //! Non-implemented copy assignment.
+        mapped_file& operator=(const mapped_file&);
+
+        //! libxml2 I/O read callback: copies the next chunk of the mapped file.
+        static int read_(void* context, char* buffer, int len);
+
+    private:
+
+        const char* data_;     //!< The content of the mapped file.
+        std::size_t size_;     //!< The size of the mapped file.
+        std::size_t offset_;   //!< The offset of the next chunk to read.
+#ifdef XTREE_WIN32
+        void*       file_;     //!< The Win32 file handle.
+        void*       mapping_;  //!< The Win32 file mapping handle.
+#endif
+
+    };
+
+
+}  // namespace xtree::detail
+}  // namespace xtree
+
+
+#ifdef XTREE_MSVC
+#  pragma warning(pop)  // noncopyable warnings
+#endif
+
+//! \endcond
+
+
+#endif  // XTREE_MAPPED_FILE_HPP_20111004__
+
@@ -0,0 +1,151 @@
+//
+// Created by ZHENG Zhong on 2011-10-18.
+//
+
+#ifndef XTREE_RECORD_EXECUTOR_HPP_20111018__
+#define XTREE_RECORD_EXECUTOR_HPP_20111018__
+
+#include "xtree/config.hpp"
+#include "xtree/xml_base.hpp"
+#include "xtree/document.hpp"
+#include "xtree/subtree_splitter.hpp"
+#include "xtree/unused_arg.hpp"
+
+#if defined(XTREE_GNUC) && XTREE_GNUC >= 4
+#  pragma GCC diagnostic ignored "-Wdeprecated-declarations"  // std::auto_ptr is deprecated.
+#endif
+
+#include <cstddef>
+#include <memory>
+
+
+namespace xtree {
+
+
+    //! \cond DEV
+    namespace detail {
+        class record_executor_state;
+    }
+    //! \endcond
+
+
+    //! This class defines the interface for processing the records dispatched by a
+    //! record_executor. User should derive from this class to provide the processing functions.
+    class XTREE_DECL record_processor
+    {
+
+    public:
+
+        explicit record_processor();
+
+        virtual ~record_processor() = 0;
+
+        //! Processes a record. This function is invoked on a worker thread, and may be invoked
+        //! concurrently on different records: it should be thread-safe.
+        //! \param record  the record document.
+        //! \param index   the index of the record.
+        virtual void process(document& record, std::size_t index) = 0;
+
+        //! Receives a record once processed. This function is invoked on the thread feeding the
+        //! executor, never concurrently: in ordered mode, the records are received in the order
+        //! in which they have been submitted. The record is destroyed when this function returns.
+        //! \param record  the record document.
+        //! \param index   the index of the record.
+        virtual void complete(document& record, std::size_t index)
+        {
+            // Do nothing.
+            detail::unused_arg(record);
+            detail::unused_arg(index);
+        }
+
+    };
+
+
+    //! This class represents an executor dispatching record documents to a pool of worker
+    //! threads. It is a subtree handler, so that the records materialized by a subtree_splitter
+    //! are processed in parallel while the splitter goes on parsing:
+    //!
+    //! \code
+    //! xtree::subtree_splitter splitter("/feed/record");
+    //! xtree::record_executor executor(processor);
+    //! splitter.set_subtree_handler(&executor);
+    //! splitter.parse_file("feed.xml");
+    //! executor.finish();
+    //! \endcode
+    //!
+    //! The number of records in flight (submitted but not completed yet) is bounded: when the
+    //! limit is reached, submitting a record blocks until a record is completed. This keeps the
+    //! memory bounded when the processing is slower than the parsing.
+    //!
+    //! If processing or completing a record throws an exception, the records in flight are
+    //! discarded, and the exception is rethrown to the thread feeding the executor, by the next
+    //! call to subtree() or finish(). The executor is then ready to be used again.
+    //!
+    //! Without C++11 support (see XTREE_HAS_CXX11), the records are processed and completed on
+    //! the thread feeding the executor, as soon as they are submitted.
+    class XTREE_DECL record_executor: public subtree_handler, private xml_base
+    {
+
+    public:
+
+        //! Constructs a record executor and starts its worker threads.
+        //! \param processor      the record processor.
+        //! \param thread_count   the number of worker threads, or 0 to use one thread per core.
+        //! \param max_in_flight  the maximum number of records in flight, or 0 to use twice the
+        //!                       number of worker threads.
+        //! \param ordered        whether the records should be completed in submission order.
+        explicit record_executor(record_processor& processor,
+                                 std::size_t thread_count = 0,
+                                 std::size_t max_in_flight = 0,
+                                 bool ordered = false);
+
+        //! Stops the worker threads, and discards the records in flight.
+        ~record_executor();
+
+        //! Returns the number of worker threads.
+        std::size_t thread_count() const;
+
+        //! Returns the maximum number of records in flight.
+        std::size_t max_in_flight() const;
+
+        //! Returns whether the records are completed in submission order.
+        bool ordered() const;
+
+        //! Returns the number of records completed since the executor is constructed.
+        std::size_t completed() const;
+
+        //! Submits a record to the worker threads. The records already processed are completed
+        //! on the calling thread. If the maximum number of records in flight is reached, this
+        //! function blocks until a record is completed.
+        //! \param doc    the record document.
+        //! \param index  the index of the record.
+        //! \throws ...  any exception thrown by the record processor.
+        virtual void subtree(std::auto_ptr<document> doc, std::size_t index);
+
+        //! Waits for all the records in flight to be processed, and completes them on the
+        //! calling thread.
+        //! \throws ...  any exception thrown by the record processor.
+        void finish();
+
+    private:
+
+        //! Non-implemented copy constructor.
+        record_executor(const record_executor&);
+
+        //! Non-implemented copy assignment.
+        record_executor& operator=(const record_executor&);
+
+    private:
+
+        record_processor&              processor_;  //!< The record processor.
+        detail::record_executor_state* state_;      //!< The worker threads and queues.
+        std::size_t                    completed_;  //!< The number of records completed.
+
+    };
+
+
+}  // namespace xtree
+
+
+#endif  // XTREE_RECORD_EXECUTOR_HPP_20111018__
+
@@ -21,7 +21,17 @@ namespace xtree {
 
     public:
 
-        explicit sax_attribute(int index, const xmlChar** attrs);
+        //! Constructs an attribute from libxml2's SAX2 attribute array.
+        //! \param index       the index of the attribute in the array.
+        //! \param attrs       the attribute array (5 pointers per attribute).
+        //! \param namespaces  if false, the name is the QName and the prefix and URI are empty.
+        explicit sax_attribute(int index, const xmlChar** attrs, bool namespaces = true);
+
+        //! Constructs an attribute from its name, prefix, URI and value.
+        explicit sax_attribute(const std::string& name,
+                               const std::string& prefix,
+                               const std::string& uri,
+                               const std::string& value);
 
         const std::string& name() const
         {
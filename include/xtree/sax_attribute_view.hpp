@@ -0,0 +1,275 @@
+//
+// Created by ZHENG Zhong on 2011-10-12.
+//
+
+#ifndef XTREE_SAX_ATTRIBUTE_VIEW_HPP_20111012__
+#define XTREE_SAX_ATTRIBUTE_VIEW_HPP_20111012__
+
+#include "xtree/config.hpp"
+#include "xtree/libxml2_fwd.hpp"
+#include "xtree/sax_string_view.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+
+
+namespace xtree {
+
+
+    //! This class represents a non-owning view of an XML attribute during the SAX parsing. It
+    //! refers to the attribute array of libxml2 (5 pointers per attribute: local name, prefix,
+    //! URI, value begin and value end), and the string views are built only when accessed. The
+    //! attribute view is only valid during the SAX callback receiving it.
+    class sax_attribute_view
+    {
+
+    public:
+
+        //! Constructs an attribute view.
+        //! \param attr  pointer to the 5 pointers of the attribute in libxml2's attribute array.
+        explicit sax_attribute_view(const xmlChar* const* attr): attr_(attr)
+        {
+            assert(attr_ != 0);
+        }
+
+        // Use auto-generated copy constructor.
+        // Use auto-generated copy assignment.
+        // Use auto-generated destructor.
+
+        //! Returns the local name of the attribute.
+        sax_string_view name() const
+        {
+            return sax_string_view(chars_(attr_[0]));
+        }
+
+        //! Returns the namespace prefix of the attribute, empty if none.
+        sax_string_view prefix() const
+        {
+            return sax_string_view(chars_(attr_[1]));
+        }
+
+        //! Returns the namespace URI of the attribute, empty if none.
+        sax_string_view uri() const
+        {
+            return sax_string_view(chars_(attr_[2]));
+        }
+
+        //! Returns the value of the attribute (not null-terminated).
+        sax_string_view value() const
+        {
+            return sax_string_view( chars_(attr_[3]),
+                                    static_cast<std::size_t>(attr_[4] - attr_[3]) );
+        }
+
+    private:
+
+        static const char* chars_(const xmlChar* chars)
+        {
+            return reinterpret_cast<const char*>(chars);
+        }
+
+    private:
+
+        const xmlChar* const* attr_;  //!< The attribute in libxml2's attribute array.
+
+    };
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+    //! This class represents a non-owning view of the attributes of an element during the SAX
+    //! parsing. It does not allocate any memory: attribute views are built on the fly from the
+    //! attribute array of libxml2. The view is only valid during the SAX callback receiving it.
+    class sax_attribute_view_list
+    {
+
+    public:
+
+        //! Iterator over the attribute views (a random access iterator yielding values).
+        class const_iterator
+        {
+
+        public:
+
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef sax_attribute_view              value_type;
+            typedef std::ptrdiff_t                  difference_type;
+            typedef const sax_attribute_view*       pointer;
+            typedef sax_attribute_view              reference;
+
+            explicit const_iterator(const xmlChar* const* attr = 0): attr_(attr)
+            {
+                // Do nothing.
+            }
+
+            sax_attribute_view operator*() const
+            {
+                return sax_attribute_view(attr_);
+            }
+
+            sax_attribute_view operator[](difference_type n) const
+            {
+                return sax_attribute_view(attr_ + n * 5);
+            }
+
+            const_iterator& operator++()
+            {
+                attr_ += 5;
+                return *this;
+            }
+
+            const_iterator operator++(int)
+            {
+                const_iterator tmp(*this);
+                attr_ += 5;
+                return tmp;
+            }
+
+            const_iterator& operator--()
+            {
+                attr_ -= 5;
+                return *this;
+            }
+
+            const_iterator operator--(int)
+            {
+                const_iterator tmp(*this);
+                attr_ -= 5;
+                return tmp;
+            }
+
+            const_iterator& operator+=(difference_type n)
+            {
+                attr_ += n * 5;
+                return *this;
+            }
+
+            const_iterator& operator-=(difference_type n)
+            {
+                attr_ -= n * 5;
+                return *this;
+            }
+
+            const_iterator operator+(difference_type n) const
+            {
+                return const_iterator(attr_ + n * 5);
+            }
+
+            const_iterator operator-(difference_type n) const
+            {
+                return const_iterator(attr_ - n * 5);
+            }
+
+            difference_type operator-(const const_iterator& rhs) const
+            {
+                return (attr_ - rhs.attr_) / 5;
+            }
+
+            bool operator==(const const_iterator& rhs) const
+            {
+                return (attr_ == rhs.attr_);
+            }
+
+            bool operator!=(const const_iterator& rhs) const
+            {
+                return (attr_ != rhs.attr_);
+            }
+
+            bool operator<(const const_iterator& rhs) const
+            {
+                return (attr_ < rhs.attr_);
+            }
+
+        private:
+
+            const xmlChar* const* attr_;  //!< The current attribute in libxml2's attribute array.
+
+        };
+
+        typedef std::size_t size_type;
+
+        //! Constructs an attribute view list.
+        //! \param attrs  the attribute array of libxml2, may be null if size is 0.
+        //! \param size   the number of attributes.
+        explicit sax_attribute_view_list(const xmlChar* const* attrs, int size)
+        : attrs_(attrs), size_(size > 0 ? static_cast<size_type>(size) : 0)
+        {
+            // Do nothing.
+        }
+
+        // Use auto-generated copy constructor.
+        // Use auto-generated copy assignment.
+        // Use auto-generated destructor.
+
+        size_type size() const
+        {
+            return size_;
+        }
+
+        bool empty() const
+        {
+            return (size_ == 0);
+        }
+
+        const_iterator begin() const
+        {
+            return const_iterator(attrs_);
+        }
+
+        const_iterator end() const
+        {
+            return const_iterator(attrs_ + size_ * 5);
+        }
+
+        sax_attribute_view operator[](size_type index) const
+        {
+            assert(index < size_);
+            return sax_attribute_view(attrs_ + index * 5);
+        }
+
+        //! Finds an attribute by its local name, ignoring its namespace.
+        //! \param name  the local name of the attribute.
+        //! \return iterator to the attribute found, or end() if not found.
+        const_iterator find(const char* name) const
+        {
+            for (const_iterator i = begin(); i != end(); ++i)
+            {
+                if ((*i).name() == name)
+                {
+                    return i;
+                }
+            }
+            return end();
+        }
+
+        //! Finds an attribute by its local name and namespace URI.
+        //! \param name  the local name of the attribute.
+        //! \param uri   the namespace URI of the attribute, empty for no namespace.
+        //! \return iterator to the attribute found, or end() if not found.
+        const_iterator find(const char* name, const char* uri) const
+        {
+            for (const_iterator i = begin(); i != end(); ++i)
+            {
+                if ((*i).name() == name && (*i).uri() == uri)
+                {
+                    return i;
+                }
+            }
+            return end();
+        }
+
+    private:
+
+        const xmlChar* const* attrs_;  //!< The attribute array of libxml2.
+        size_type             size_;   //!< The number of attributes.
+
+    };
+
+
+}  // namespace xtree
+
+
+#endif  // XTREE_SAX_ATTRIBUTE_VIEW_HPP_20111012__
+
@@ -0,0 +1,157 @@
+//
+// Created by ZHENG Zhong on 2011-10-17.
+//
+
+#ifndef XTREE_SAX_EVENT_BUFFER_HPP_20111017__
+#define XTREE_SAX_EVENT_BUFFER_HPP_20111017__
+
+#include "xtree/config.hpp"
+#include "xtree/document.hpp"
+#include "xtree/sax_handler.hpp"
+
+#if defined(XTREE_GNUC) && XTREE_GNUC >= 4
+#  pragma GCC diagnostic ignored "-Wdeprecated-declarations"  // std::auto_ptr is deprecated.
+#endif
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace xtree {
+
+
+    //! This class represents a SAX content handler which records the SAX events it receives into
+    //! a compact binary buffer, so that they can be replayed later, into any other content
+    //! handler and as many times as needed. This makes it possible to fan one XML input out to
+    //! several consumers while tokenizing it only once.
+    //!
+    //! The events are recorded into contiguous memory: the names (local names, prefixes and
+    //! namespace URIs) are interned, so that each distinct name is stored only once, and the
+    //! character data and attribute values are appended to a text arena.
+    //!
+    //! Example:
+    //!
+    //! \code
+    //! xtree::sax_event_buffer buffer;
+    //! xtree::sax_parser parser;
+    //! parser.set_content_handler(&buffer);
+    //! parser.parse_file("huge.xml");
+    //! buffer.replay(first_handler);
+    //! buffer.replay(second_handler);
+    //! std::auto_ptr<xtree::document> doc = buffer.replay_document();
+    //! \endcode
+    class XTREE_DECL sax_event_buffer: public sax_content_handler
+    {
+
+    public:
+
+        //! Constructs an empty event buffer.
+        explicit sax_event_buffer();
+
+        //! Destructor.
+        ~sax_event_buffer();
+
+        //! Returns whether no event has been recorded.
+        bool empty() const
+        {
+            return (size_ == 0);
+        }
+
+        //! Returns the number of events recorded.
+        std::size_t size() const
+        {
+            return size_;
+        }
+
+        //! Returns the number of distinct names recorded.
+        std::size_t name_count() const
+        {
+            return names_.size();
+        }
+
+        //! Returns the number of bytes of character data and attribute values recorded.
+        std::size_t text_size() const
+        {
+            return text_.size();
+        }
+
+        //! Discards all the events recorded. The memory is kept for the next recording.
+        void clear();
+
+        //! Replays all the events recorded into a content handler, in order.
+        //! \param handler  the content handler receiving the events.
+        void replay(sax_content_handler& handler) const;
+
+        //! Replays all the events recorded into a dom_builder, and returns the document built.
+        //! The document is allocated from a memory region if document regions are enabled.
+        //! \return the document built.
+        //! \throws bad_dom_operation  if the events recorded do not form a document.
+        std::auto_ptr<document> replay_document() const;
+
+        //! Records the beginning of the document.
+        virtual void start_document();
+
+        //! Records the end of the document.
+        virtual void end_document();
+
+        //! Records the beginning of an element, with its attributes.
+        virtual void start_element(const std::string& name,
+                                   const std::string& prefix,
+                                   const std::string& uri,
+                                   const sax_attribute_list& attrs);
+
+        //! Records the end of an element.
+        virtual void end_element(const std::string& name,
+                                 const std::string& prefix,
+                                 const std::string& uri);
+
+        //! Records text.
+        virtual void characters(const char* chars, int length);
+
+        //! Records a CDATA block.
+        virtual void cdata_block(const char* chars, int length);
+
+        //! Records ignorable whitespaces.
+        virtual void ignorable_whitespace(const char* chars, int length);
+
+        //! Records a comment.
+        virtual void comment(const char* chars);
+
+    private:
+
+        //! Non-implemented copy constructor.
+        sax_event_buffer(const sax_event_buffer&);
+
+        //! Non-implemented copy assignment.
+        sax_event_buffer& operator=(const sax_event_buffer&);
+
+        //! Returns the index of a name in the name table, adding the name if not found.
+        std::size_t intern_(const std::string& name);
+
+        //! Appends characters (and a null character) to the text arena.
+        void store_(const char* chars, std::size_t length);
+
+        //! Records an event carrying characters.
+        void record_chars_(std::size_t type, const char* chars, std::size_t length);
+
+    private:
+
+        typedef std::map<std::string, std::size_t> name_index_map;
+
+        std::vector<std::size_t> events_;   //!< The events and their fields, as integers.
+        std::size_t              size_;     //!< The number of events recorded.
+        std::vector<std::string> names_;    //!< The distinct names, in order of appearance.
+        name_index_map           indices_;  //!< The indices of the names in the name table.
+        std::vector<char>        text_;     //!< The text arena.
+
+    };
+
+
+}  // namespace xtree
+
+
+#endif  // XTREE_SAX_EVENT_BUFFER_HPP_20111017__
+
@@ -38,6 +38,125 @@ namespace xtree {
     //! \}
 
 
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+    //! This struct scopes the features of the SAX parsers. Each feature is a bit flag, most of
+    //! them mapping directly to a libxml2 parser option.
+    struct sax_feature
+    {
+        enum type
+        {
+            //! Whether the content handler receives namespace prefixes and URIs. If disabled,
+            //! the content handler receives qualified names (e.g. "x:item") with empty prefixes
+            //! and URIs, which saves building the URI strings of every element and attribute.
+            //! The view handler always receives the names as reported by libxml2.
+            namespaces = 1 << 0,
+            //! Whether the content handler receives the namespace declarations (xmlns and
+            //! xmlns:* attributes) as attributes, after the other attributes of the element.
+            namespace_prefixes = 1 << 1,
+            //! Whether to substitute entities (XML_PARSE_NOENT).
+            substitute_entities = 1 << 2,
+            //! Whether to load the external DTD subset (XML_PARSE_DTDLOAD).
+            load_external_dtd = 1 << 3,
+            //! Whether to relax the hardcoded limits of libxml2 on huge documents (XML_PARSE_HUGE).
+            huge = 1 << 4,
+            //! Whether to forbid network access, e.g. to fetch an external DTD (XML_PARSE_NONET).
+            no_network = 1 << 5
+        };
+    };
+
+
+    //! This class represents a set of SAX parser features. It is a small value type: testing a
+    //! feature is a bit test, and the set is converted to libxml2 parser options once per parsing.
+    class sax_feature_set
+    {
+
+    public:
+
+        //! The default features: namespaces, substitute_entities and load_external_dtd.
+        static const unsigned int default_bits = ( sax_feature::namespaces
+                                                 | sax_feature::substitute_entities
+                                                 | sax_feature::load_external_dtd );
+
+        //! Constructs a feature set.
+        //! \param bits  the bits of the features enabled, defaults to the default features.
+        explicit sax_feature_set(unsigned int bits = default_bits): bits_(bits)
+        {
+            // Do nothing.
+        }
+
+        // Use auto-generated copy constructor.
+        // Use auto-generated copy assignment.
+        // Use auto-generated destructor.
+
+        //! Returns whether a feature is enabled.
+        bool test(sax_feature::type feature) const
+        {
+            return ((bits_ & feature) != 0);
+        }
+
+        //! Enables or disables a feature.
+        //! \param feature  the feature to enable or disable.
+        //! \param enable   true to enable, false to disable.
+        //! \return this feature set.
+        sax_feature_set& set(sax_feature::type feature, bool enable = true)
+        {
+            bits_ = (enable ? (bits_ | feature) : (bits_ & ~static_cast<unsigned int>(feature)));
+            return *this;
+        }
+
+        //! Disables a feature.
+        //! \param feature  the feature to disable.
+        //! \return this feature set.
+        sax_feature_set& reset(sax_feature::type feature)
+        {
+            return set(feature, false);
+        }
+
+        //! Returns the bits of the features enabled.
+        unsigned int bits() const
+        {
+            return bits_;
+        }
+
+        bool operator==(const sax_feature_set& rhs) const
+        {
+            return (bits_ == rhs.bits_);
+        }
+
+        bool operator!=(const sax_feature_set& rhs) const
+        {
+            return (bits_ != rhs.bits_);
+        }
+
+    private:
+
+        unsigned int bits_;  //!< The bits of the features enabled.
+
+    };
+
+
+    //! \cond DEV
+
+    namespace detail {
+
+        //! Finds the feature named by a SAX2 standard feature name (see the constants above).
+        //! \param name     the SAX2 standard feature name.
+        //! \param feature  receives the feature found.
+        //! \return true if the feature is found, false otherwise.
+        XTREE_DECL bool find_sax_feature(const std::string& name, sax_feature::type& feature);
+
+        //! Converts a feature set to libxml2 parser options (a combination of xmlParserOption).
+        //! \param features  the feature set.
+        //! \return the libxml2 parser options.
+        XTREE_DECL int to_libxml2_parser_options(const sax_feature_set& features);
+
+    }  // namespace xtree::detail
+
+    //! \endcond
+
+
 }  // namespace xtree
 
 
@@ -7,7 +7,9 @@
 
 #include "xtree/config.hpp"
 #include "xtree/sax_attribute_list.hpp"
+#include "xtree/sax_attribute_view.hpp"
 #include "xtree/sax_error_info.hpp"
+#include "xtree/sax_string_view.hpp"
 #include "xtree/unused_arg.hpp"
 
 #include <string>
@@ -118,6 +120,101 @@ namespace xtree {
     ////////////////////////////////////////////////////////////////////////////////////////////////
 
 
+    //! This class defines an alternative interface for handling XML content, which does not
+    //! allocate any memory: names, texts and attributes are passed as non-owning views into the
+    //! buffers of libxml2, and attributes are only decoded when accessed. The views are only
+    //! valid during the callback receiving them. User should derive from this class to provide
+    //! customized handling functions.
+    class XTREE_DECL sax_view_handler
+    {
+
+    public:
+
+        explicit sax_view_handler();
+
+        virtual ~sax_view_handler() = 0;
+
+        //! Receives notification of the beginning of an XML document.
+        virtual void start_document()
+        {
+            // Do nothing.
+        }
+
+        //! Receives notification of the end of an XML document.
+        virtual void end_document()
+        {
+            // Do nothing.
+        }
+
+        //! Receives notification of the beginning of an element.
+        //! \param name    the local name of this element.
+        //! \param prefix  the namespace prefix of this element, empty if none.
+        //! \param uri     the namespace URI of this element, empty if none.
+        //! \param attrs   the attributes of this element.
+        virtual void start_element(const sax_string_view& name,
+                                   const sax_string_view& prefix,
+                                   const sax_string_view& uri,
+                                   const sax_attribute_view_list& attrs)
+        {
+            // Do nothing.
+            detail::unused_arg(name);
+            detail::unused_arg(prefix);
+            detail::unused_arg(uri);
+            detail::unused_arg(attrs);
+        }
+
+        //! Receives notification of the end of an element.
+        //! \param name    the local name of this element.
+        //! \param prefix  the namespace prefix of this element, empty if none.
+        //! \param uri     the namespace URI of this element, empty if none.
+        virtual void end_element(const sax_string_view& name,
+                                 const sax_string_view& prefix,
+                                 const sax_string_view& uri)
+        {
+            // Do nothing.
+            detail::unused_arg(name);
+            detail::unused_arg(prefix);
+            detail::unused_arg(uri);
+        }
+
+        //! Receives notification of text.
+        //! \param chars  the text content.
+        virtual void characters(const sax_string_view& chars)
+        {
+            // Do nothing.
+            detail::unused_arg(chars);
+        }
+
+        //! Receives notification of a CData block.
+        //! \param chars  the CData block content.
+        virtual void cdata_block(const sax_string_view& chars)
+        {
+            // Do nothing.
+            detail::unused_arg(chars);
+        }
+
+        //! Receives notification of ignorable whitespace.
+        //! \param chars  the ignorable whitespace content.
+        virtual void ignorable_whitespace(const sax_string_view& chars)
+        {
+            // Do nothing.
+            detail::unused_arg(chars);
+        }
+
+        //! Receives notification of a comment.
+        //! \param chars  the comment content.
+        virtual void comment(const sax_string_view& chars)
+        {
+            // Do nothing.
+            detail::unused_arg(chars);
+        }
+
+    };
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+
     //! This class defines the interface for handling SAX errors. It defines callback functions
     //! that will be invoked by the XML SAX parser. User should derive from this class to provide
     //! customized handling functions.
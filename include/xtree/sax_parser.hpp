@@ -8,9 +8,10 @@
 #include "xtree/config.hpp"
 #include "xtree/xml_base.hpp"
 #include "xtree/sax_handler.hpp"
+#include "xtree/sax_features.hpp"
 #include "xtree/libxml2_fwd.hpp"
 
-#include <set>
+#include <cstddef>
 #include <string>
 
 
@@ -21,7 +22,17 @@ namespace xtree {
 
     namespace detail {
 
-        //! Initializes a libxml2 SAX2 handler with all the callback functions registered.
+        //! Receives the document type declaration: creates the document of the libxml2 parser
+        //! context if not yet created, and lets libxml2 store the internal subset in it.
+        //! \param context  the libxml2 parser context.
+        void libxml2_internal_subset(void* context,
+                                     const xmlChar* name,
+                                     const xmlChar* external_id,
+                                     const xmlChar* system_id);
+
+        //! Initializes a libxml2 SAX2 handler with all the callback functions registered. The
+        //! callbacks expect the libxml2 parser context as user data, and the SAX parser stored
+        //! in its _private field. The document type declaration is handled by libxml2.
         //! See: http://www.xmlsoft.org/html/libxml-tree.html#xmlSAXHandler
         //! \param handler  the libxml2 SAX2 handler to initialize.
         void initialize_libxml2_sax2_handler(xmlSAXHandler& handler);
@@ -58,16 +69,52 @@ namespace xtree {
 
         void set_error_handler(sax_error_handler* handler);
 
+        //! Sets the view handler, which receives non-owning views into the buffers of libxml2
+        //! instead of strings. If both a content handler and a view handler are set, both of them
+        //! are notified (the view handler first). The strings and the attribute list passed to
+        //! the content handler are only built if a content handler is set.
+        //! \param handler  the view handler, may be null.
+        void set_view_handler(sax_view_handler* handler);
+
         //! Sets the value to a feature flag to enable or disable the feature.
-        //! \param name    the name of the feature.
+        //! \param name    the SAX2 standard name of the feature (see sax_features.hpp).
         //! \param enable  the value of the feature to set, true to enable, false to disable.
+        //! \throws sax_error  if the feature name is unknown.
         void set_feature(const std::string& name, bool enable);
 
         //! Returns the value of a feature flag (true means enabled, false means disabled).
-        //! \param name  the name of the feature.
-        //! \return true if this feature is enabled, false otherwise.
+        //! \param name  the SAX2 standard name of the feature (see sax_features.hpp).
+        //! \return true if this feature is enabled, false otherwise (or if it is unknown).
         bool get_feature(const std::string& name) const;
 
+        //! Enables or disables a feature.
+        //! \param feature  the feature to enable or disable.
+        //! \param enable   true to enable, false to disable.
+        void set_feature(sax_feature::type feature, bool enable);
+
+        //! Returns whether a feature is enabled.
+        //! \param feature  the feature.
+        //! \return true if this feature is enabled, false otherwise.
+        bool get_feature(sax_feature::type feature) const;
+
+        //! Sets all the features at once. Defaults to sax_feature_set().
+        //! \param features  the features to set.
+        void set_features(const sax_feature_set& features);
+
+        //! Returns the features.
+        //! \return the features.
+        const sax_feature_set& get_features() const;
+
+        //! Sets whether to map the XML file to memory in parse_file(), instead of reading it with
+        //! libxml2's buffered file reader. Compressed files, and files which cannot be mapped, are
+        //! still read by libxml2's file reader. Defaults to false.
+        //! \param flag  true to map the XML file to memory, false otherwise.
+        void set_memory_map(bool flag);
+
+        //! Returns whether to map the XML file to memory in parse_file().
+        //! \return true if the XML file is mapped to memory, false otherwise.
+        bool get_memory_map() const;
+
         //! Parses an XML file and invokes SAX callbacks.
         //! \param file_name  the XML file name.
         void parse_file(const std::string& file_name);
@@ -76,6 +123,30 @@ namespace xtree {
         //! \param str  the XML string to parse.
         void parse_string(const char* str);
 
+        //! Parses a memory buffer containing the XML and invokes SAX callbacks. The buffer does
+        //! not need to be null-terminated: it can be a slice of a larger buffer.
+        //! \param data  pointer to the XML to parse.
+        //! \param size  the size of the XML in bytes.
+        void parse_buffer(const char* data, std::size_t size);
+
+        //! Parses a contiguous range of characters containing the XML and invokes SAX callbacks.
+        //! The range should provide empty(), size() and operator[], and hold its characters
+        //! contiguously (e.g. std::string, std::vector<char>).
+        //! \param range  the contiguous range of characters containing the XML to parse.
+        template<class ContiguousRange>
+        void parse_buffer(const ContiguousRange& range)
+        {
+            if (range.empty())
+            {
+                parse_buffer(static_cast<const char*>(0), 0);
+            }
+            else
+            {
+                parse_buffer(reinterpret_cast<const char*>(&range[0]),
+                             range.size() * sizeof(range[0]));
+            }
+        }
+
     private:
 
         ////////////////////////////////////////////////////////////////////////////////////////////
@@ -119,8 +190,8 @@ namespace xtree {
 
         //! \}
 
-        //! Casts the context pointer to the SAX parser.
-        //! \param context  pointer to the context pointer.
+        //! Returns the SAX parser stored in the libxml2 parser context.
+        //! \param context  the libxml2 parser context.
         //! \return the SAX parser.
         static sax_parser& get_sax_parser(void* context);
 
@@ -140,9 +211,11 @@ namespace xtree {
 
     private:
 
-        std::set<std::string> features_;         //!< SAX2 features.
-        sax_content_handler*  content_handler_;  //!< Pointer to content handler.
-        sax_error_handler*    error_handler_;    //!< Pointer to error handler.
+        sax_feature_set      features_;         //!< SAX2 features.
+        sax_content_handler* content_handler_;  //!< Pointer to content handler.
+        sax_error_handler*   error_handler_;    //!< Pointer to error handler.
+        sax_view_handler*    view_handler_;     //!< Pointer to view handler.
+        bool                 memory_map_;       //!< Whether to map the XML file to memory.
 
     };
 
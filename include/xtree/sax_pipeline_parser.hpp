@@ -0,0 +1,150 @@
+//
+// Created by ZHENG Zhong on 2011-10-16.
+//
+
+#ifndef XTREE_SAX_PIPELINE_PARSER_HPP_20111016__
+#define XTREE_SAX_PIPELINE_PARSER_HPP_20111016__
+
+#include "xtree/config.hpp"
+#include "xtree/xml_base.hpp"
+#include "xtree/sax_features.hpp"
+#include "xtree/sax_handler.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+namespace xtree {
+
+
+    //! This class represents a pipelined XML SAX parser, which parses the XML and invokes the
+    //! handlers on two different threads. A parser thread tokenizes the XML with libxml2 and
+    //! encodes the SAX events into blocks of memory, which are passed through a lock-free
+    //! single-producer single-consumer ring to the calling thread. The calling thread decodes
+    //! the events and replays them into the content handler and the error handler, in order,
+    //! while the parser thread goes on parsing. This is useful when the handlers do expensive
+    //! work per event (or per record): on a multi-core machine, the parsing is nearly free.
+    //!
+    //! The handlers are always invoked on the calling thread, so they need not be thread-safe.
+    //! The blocks are recycled from one document to the next: once warmed up, the pipeline does
+    //! not allocate memory besides the strings passed to the content handler.
+    //!
+    //! Without C++11 support (see XTREE_HAS_CXX11), the parsing is not pipelined: the events are
+    //! dispatched on the calling thread by a sax_parser.
+    //!
+    //! Note that the namespace_prefixes feature is not supported by this parser.
+    class XTREE_DECL sax_pipeline_parser: private xml_base
+    {
+
+    public:
+
+        //! The default size of the blocks of encoded events, in bytes.
+        static const std::size_t default_block_size = 64 * 1024;
+
+        //! The default number of blocks in flight between the parser thread and the handlers.
+        static const std::size_t default_block_count = 8;
+
+        //! Constructs a pipelined SAX parser.
+        //! \param block_size   the size of the blocks of encoded events, in bytes: events are
+        //!                     passed to the calling thread block by block.
+        //! \param block_count  the number of blocks in flight: if the handlers are slower than
+        //!                     the parsing, the parser thread waits for a block to be replayed.
+        explicit sax_pipeline_parser(std::size_t block_size = default_block_size,
+                                     std::size_t block_count = default_block_count);
+
+        //! Destructor.
+        ~sax_pipeline_parser();
+
+        //! Sets the content handler.
+        //! \param handler  the content handler, may be null.
+        void set_content_handler(sax_content_handler* handler);
+
+        //! Sets the error handler.
+        //! \param handler  the error handler, may be null.
+        void set_error_handler(sax_error_handler* handler);
+
+        //! Enables or disables a feature (see sax_parser::set_feature()).
+        //! \param feature  the feature to enable or disable.
+        //! \param enable   true to enable, false to disable.
+        void set_feature(sax_feature::type feature, bool enable);
+
+        //! Returns whether a feature is enabled.
+        //! \param feature  the feature.
+        //! \return true if this feature is enabled, false otherwise.
+        bool get_feature(sax_feature::type feature) const;
+
+        //! Sets all the features at once. Defaults to sax_feature_set().
+        //! \param features  the features to set.
+        void set_features(const sax_feature_set& features);
+
+        //! Returns the features.
+        //! \return the features.
+        const sax_feature_set& get_features() const;
+
+        //! Parses an XML file and invokes the handlers on the calling thread. This function
+        //! returns when all the events have been replayed.
+        //! \param file_name  the XML file name.
+        //! \throws sax_error  if fail to parse the XML file. The events preceding the error are
+        //!                    replayed before the exception is thrown.
+        //! \throws ...        any exception thrown by the handlers: the parsing is cancelled.
+        void parse_file(const std::string& file_name);
+
+        //! Parses a string containing the XML and invokes the handlers on the calling thread.
+        //! \param str  the XML string to parse.
+        //! \throws sax_error  if fail to parse the XML string.
+        void parse_string(const char* str);
+
+        //! Parses a memory buffer containing the XML and invokes the handlers on the calling
+        //! thread. The buffer should remain valid until this function returns.
+        //! \param data  pointer to the XML to parse.
+        //! \param size  the size of the XML in bytes.
+        //! \throws sax_error  if fail to parse the XML buffer.
+        void parse_buffer(const char* data, std::size_t size);
+
+        //! Parses a contiguous range of characters containing the XML and invokes the handlers
+        //! on the calling thread (see sax_parser::parse_buffer()).
+        //! \param range  the contiguous range of characters containing the XML to parse.
+        //! \throws sax_error  if fail to parse the XML buffer.
+        template<class ContiguousRange>
+        void parse_buffer(const ContiguousRange& range)
+        {
+            if (range.empty())
+            {
+                parse_buffer(static_cast<const char*>(0), 0);
+            }
+            else
+            {
+                parse_buffer(reinterpret_cast<const char*>(&range[0]),
+                             range.size() * sizeof(range[0]));
+            }
+        }
+
+    private:
+
+        //! Non-implemented copy constructor.
+        sax_pipeline_parser(const sax_pipeline_parser&);
+
+        //! Non-implemented copy assignment.
+        sax_pipeline_parser& operator=(const sax_pipeline_parser&);
+
+        //! Parses an XML file (if file_name is not null) or a memory buffer.
+        void parse_(const std::string* file_name, const char* data, std::size_t size);
+
+    private:
+
+        std::size_t                     block_size_;       //!< The size of the blocks.
+        std::size_t                     block_count_;      //!< The number of blocks in flight.
+        sax_feature_set                 features_;         //!< The features.
+        sax_content_handler*            content_handler_;  //!< Pointer to content handler.
+        sax_error_handler*              error_handler_;    //!< Pointer to error handler.
+        std::vector<std::vector<char> > blocks_;           //!< The blocks of encoded events.
+
+    };
+
+
+}  // namespace xtree
+
+
+#endif  // XTREE_SAX_PIPELINE_PARSER_HPP_20111016__
+
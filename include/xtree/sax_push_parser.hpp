@@ -0,0 +1,203 @@
+//
+// Created by ZHENG Zhong on 2011-10-10.
+//
+
+#ifndef XTREE_SAX_PUSH_PARSER_HPP_20111010__
+#define XTREE_SAX_PUSH_PARSER_HPP_20111010__
+
+#include "xtree/config.hpp"
+#include "xtree/xml_base.hpp"
+#include "xtree/sax_features.hpp"
+#include "xtree/sax_handler.hpp"
+#include "xtree/sax_parser.hpp"
+#include "xtree/libxml2_fwd.hpp"
+
+#include <cstddef>
+#include <vector>
+
+
+namespace xtree {
+
+
+    //! This class represents an incremental (push-mode) XML SAX parser. The XML is fed to the
+    //! parser chunk by chunk as it arrives, and the SAX callbacks are invoked as soon as the
+    //! corresponding XML has been fed.
+    //!
+    //! The content handler may control the parsing from its callbacks:
+    //! - stop() ends the parsing early: the rest of the XML is ignored, and no more callbacks are
+    //!   invoked (not even end_document()). This is useful when the handler has found what it
+    //!   needs in an unbounded stream.
+    //! - pause() suspends the parsing, e.g. to apply back-pressure: the XML fed while paused
+    //!   (including the unparsed part of the current chunk) is kept by the parser, and it will be
+    //!   parsed when resume() is called. Note that libxml2 cannot be interrupted in the middle of
+    //!   a chunk: chunks are parsed in slices (see set_slice_size()), and the pause takes effect
+    //!   at the end of the current slice. More callbacks may thus be invoked after pause().
+    //!
+    //! After finish() returns, or after an error is thrown, the parser is ready to parse another
+    //! document: its libxml2 parser context is reset and reused.
+    class XTREE_DECL sax_push_parser: private xml_base
+    {
+
+    public:
+
+        //! The default size of the slices in which the chunks are parsed.
+        static const std::size_t default_slice_size = 64 * 1024;
+
+        //! Default constructor.
+        explicit sax_push_parser();
+
+        //! Destructor.
+        ~sax_push_parser();
+
+        //! Sets the content handler.
+        //! \param handler  the content handler, may be null.
+        void set_content_handler(sax_content_handler* handler);
+
+        //! Sets the error handler.
+        //! \param handler  the error handler, may be null.
+        void set_error_handler(sax_error_handler* handler);
+
+        //! Sets the view handler (see sax_parser::set_view_handler()).
+        //! \param handler  the view handler, may be null.
+        void set_view_handler(sax_view_handler* handler);
+
+        //! Enables or disables a feature (see sax_parser::set_feature()). The features are applied
+        //! when the parser starts parsing a new document.
+        //! \param feature  the feature to enable or disable.
+        //! \param enable   true to enable, false to disable.
+        void set_feature(sax_feature::type feature, bool enable);
+
+        //! Returns whether a feature is enabled.
+        //! \param feature  the feature.
+        //! \return true if this feature is enabled, false otherwise.
+        bool get_feature(sax_feature::type feature) const;
+
+        //! Sets all the features at once. Defaults to sax_feature_set().
+        //! \param features  the features to set.
+        void set_features(const sax_feature_set& features);
+
+        //! Returns the features.
+        //! \return the features.
+        const sax_feature_set& get_features() const;
+
+        //! Sets the size of the slices in which the chunks are parsed, which is the granularity
+        //! of pause(). A smaller size makes pause() take effect sooner, at the cost of more calls
+        //! to libxml2. Defaults to default_slice_size.
+        //! \param size  the size of the slices in bytes, or 0 to parse each chunk in one call.
+        void set_slice_size(std::size_t size);
+
+        //! Returns the size of the slices in which the chunks are parsed.
+        //! \return the size of the slices in bytes, or 0 if each chunk is parsed in one call.
+        std::size_t get_slice_size() const
+        {
+            return slice_size_;
+        }
+
+        //! Feeds a chunk of XML to the parser, and invokes the SAX callbacks. The chunk may end
+        //! anywhere, including in the middle of a tag or a multi-byte character. If the parser is
+        //! paused, the chunk is kept until resume() is called. If the parser is stopped, the
+        //! chunk is ignored.
+        //! \param data  pointer to the chunk of XML.
+        //! \param size  the size of the chunk in bytes.
+        //! \throws sax_error  if the XML fed so far is not well-formed. The current document is
+        //!                    discarded, and the parser is ready to parse another document. The
+        //!                    same applies to any exception thrown by a callback.
+        void feed(const char* data, std::size_t size);
+
+        //! Notifies the parser that the whole XML has been fed. If the parser has been stopped,
+        //! this function simply resets the parser.
+        //! \throws sax_error          if nothing has been fed, or if the XML is not well-formed.
+        //!                            The parser is ready to parse another document.
+        //! \throws bad_dom_operation  if the parser is paused, or if called from a callback.
+        void finish();
+
+        //! Discards the document being parsed, if any. The parser is ready to parse another
+        //! document. This function should not be called from a callback.
+        void reset();
+
+        //! Stops the parsing. This function is typically called from a callback.
+        void stop();
+
+        //! Pauses the parsing. This function is typically called from a callback.
+        void pause();
+
+        //! Resumes the parsing, and parses the XML kept while paused. If called from a callback,
+        //! this function simply cancels the pause.
+        //! \throws sax_error  if the XML fed so far is not well-formed.
+        void resume();
+
+        //! Returns whether a document is being parsed (i.e. some chunks have been fed since the
+        //! last call to finish() or reset()).
+        //! \return true if a document is being parsed, false otherwise.
+        bool started() const
+        {
+            return started_;
+        }
+
+        //! Returns whether the parsing is paused.
+        //! \return true if the parsing is paused, false otherwise.
+        bool paused() const
+        {
+            return paused_;
+        }
+
+        //! Returns whether the parsing has been stopped.
+        //! \return true if the parsing has been stopped, false otherwise.
+        bool stopped() const
+        {
+            return stopped_;
+        }
+
+    private:
+
+        //! Non-implemented copy constructor.
+        sax_push_parser(const sax_push_parser&);
+
+        //! Non-implemented copy assignment.
+        sax_push_parser& operator=(const sax_push_parser&);
+
+        //! Starts parsing a new document: creates or resets the libxml2 parser context. The parser
+        //! context is re-created if the parser options have changed, since some of them (such as
+        //! XML_PARSE_HUGE) cannot be cleared once applied to a parser context.
+        //! \throws sax_error  if fail to create the parser context.
+        void start_();
+
+        //! Parses a chunk slice by slice, until the chunk is consumed or the parsing is paused
+        //! or stopped.
+        //! \param data  pointer to the chunk.
+        //! \param size  the size of the chunk.
+        //! \return the number of bytes consumed.
+        //! \throws sax_error  if the XML is not well-formed.
+        std::size_t parse_slices_(const char* data, std::size_t size);
+
+        //! Feeds a slice to the libxml2 parser context, and checks the result.
+        //! \param data       pointer to the slice, may be null if size is 0.
+        //! \param size       the size of the slice.
+        //! \param terminate  whether this is the last slice.
+        //! \throws sax_error  if the XML is not well-formed.
+        void parse_chunk_(const char* data, int size, bool terminate);
+
+        //! Frees the libxml2 parser context, which cannot be reused after a callback has thrown,
+        //! and resets the parser.
+        void discard_context_();
+
+    private:
+
+        sax_parser        parser_;      //!< The SAX parser dispatching the libxml2 callbacks.
+        xmlParserCtxt*    context_;     //!< The libxml2 push parser context.
+        int               options_;     //!< The libxml2 parser options applied to the context.
+        std::vector<char> pending_;     //!< The XML kept while paused.
+        std::size_t       slice_size_;  //!< The size of the slices, or 0 for whole chunks.
+        bool              started_;     //!< Whether a document is being parsed.
+        bool              parsing_;     //!< Whether libxml2 is parsing (i.e. in a callback).
+        bool              paused_;      //!< Whether the parsing is paused.
+        bool              stopped_;     //!< Whether the parsing has been stopped.
+
+    };
+
+
+}  // namespace xtree
+
+
+#endif  // XTREE_SAX_PUSH_PARSER_HPP_20111010__
+
@@ -0,0 +1,198 @@
+//
+// Created by ZHENG Zhong on 2011-10-12.
+//
+
+#ifndef XTREE_SAX_STRING_VIEW_HPP_20111012__
+#define XTREE_SAX_STRING_VIEW_HPP_20111012__
+
+#include "xtree/config.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+
+namespace xtree {
+
+
+    //! This class represents a non-owning view (pointer and length) of a string during the SAX
+    //! parsing. It typically points to a buffer owned by libxml2, thus it is only valid during
+    //! the SAX callback receiving it: call str() to keep a copy of the string. Note that the
+    //! characters viewed are not necessarily null-terminated.
+    class sax_string_view
+    {
+
+    public:
+
+        typedef const char* const_iterator;
+
+        //! Constructs an empty string view.
+        explicit sax_string_view(): data_(""), size_(0)
+        {
+            // Do nothing.
+        }
+
+        //! Constructs a string view of a null-terminated string.
+        //! \param str  the null-terminated string, or null for an empty string view.
+        explicit sax_string_view(const char* str)
+        : data_(str != 0 ? str : ""), size_(str != 0 ? std::strlen(str) : 0)
+        {
+            // Do nothing.
+        }
+
+        //! Constructs a string view of a range of characters.
+        //! \param data  pointer to the characters, or null for an empty string view.
+        //! \param size  the number of characters.
+        explicit sax_string_view(const char* data, std::size_t size)
+        : data_(data != 0 ? data : ""), size_(data != 0 ? size : 0)
+        {
+            // Do nothing.
+        }
+
+        // Use auto-generated copy constructor.
+        // Use auto-generated copy assignment.
+        // Use auto-generated destructor.
+
+        //! Returns the pointer to the characters, never null.
+        const char* data() const
+        {
+            return data_;
+        }
+
+        //! Returns the number of characters.
+        std::size_t size() const
+        {
+            return size_;
+        }
+
+        //! Returns the number of characters.
+        std::size_t length() const
+        {
+            return size_;
+        }
+
+        //! Returns whether the string view is empty.
+        bool empty() const
+        {
+            return (size_ == 0);
+        }
+
+        const_iterator begin() const
+        {
+            return data_;
+        }
+
+        const_iterator end() const
+        {
+            return data_ + size_;
+        }
+
+        char operator[](std::size_t index) const
+        {
+            return data_[index];
+        }
+
+        //! Returns a copy of the string viewed.
+        std::string str() const
+        {
+            return std::string(data_, size_);
+        }
+
+        //! Compares the string viewed with another string view.
+        bool equals(const sax_string_view& rhs) const
+        {
+            return (size_ == rhs.size_ && std::memcmp(data_, rhs.data_, size_) == 0);
+        }
+
+        //! Compares the string viewed with a null-terminated string.
+        bool equals(const char* rhs) const
+        {
+            return ( rhs != 0
+                  && std::strncmp(data_, rhs, size_) == 0
+                  && rhs[size_] == '\0' );
+        }
+
+        //! Compares the string viewed with a string.
+        bool equals(const std::string& rhs) const
+        {
+            return (rhs.size() == size_ && rhs.compare(0, size_, data_, size_) == 0);
+        }
+
+    private:
+
+        const char* data_;  //!< The characters viewed.
+        std::size_t size_;  //!< The number of characters.
+
+    };
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    //! \name Comparison and Output Operators
+    //! \{
+
+
+    inline bool operator==(const sax_string_view& lhs, const sax_string_view& rhs)
+    {
+        return lhs.equals(rhs);
+    }
+
+    inline bool operator!=(const sax_string_view& lhs, const sax_string_view& rhs)
+    {
+        return !lhs.equals(rhs);
+    }
+
+    inline bool operator==(const sax_string_view& lhs, const char* rhs)
+    {
+        return lhs.equals(rhs);
+    }
+
+    inline bool operator!=(const sax_string_view& lhs, const char* rhs)
+    {
+        return !lhs.equals(rhs);
+    }
+
+    inline bool operator==(const char* lhs, const sax_string_view& rhs)
+    {
+        return rhs.equals(lhs);
+    }
+
+    inline bool operator!=(const char* lhs, const sax_string_view& rhs)
+    {
+        return !rhs.equals(lhs);
+    }
+
+    inline bool operator==(const sax_string_view& lhs, const std::string& rhs)
+    {
+        return lhs.equals(rhs);
+    }
+
+    inline bool operator!=(const sax_string_view& lhs, const std::string& rhs)
+    {
+        return !lhs.equals(rhs);
+    }
+
+    inline bool operator==(const std::string& lhs, const sax_string_view& rhs)
+    {
+        return rhs.equals(lhs);
+    }
+
+    inline bool operator!=(const std::string& lhs, const sax_string_view& rhs)
+    {
+        return !rhs.equals(lhs);
+    }
+
+    inline std::ostream& operator<<(std::ostream& os, const sax_string_view& view)
+    {
+        return os.write(view.data(), static_cast<std::streamsize>(view.size()));
+    }
+
+
+    //! \}
+
+
+}  // namespace xtree
+
+
+#endif  // XTREE_SAX_STRING_VIEW_HPP_20111012__
+
@@ -0,0 +1,148 @@
+//
+// Created by ZHENG Zhong on 2011-10-16.
+//
+
+#ifndef XTREE_SPSC_RING_HPP_20111016__
+#define XTREE_SPSC_RING_HPP_20111016__
+
+#include "xtree/config.hpp"
+
+#ifdef XTREE_HAS_CXX11
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+
+//! \cond DEV
+
+namespace xtree {
+namespace detail {
+
+
+    //! This class template represents a bounded lock-free single-producer single-consumer ring.
+    //! Exactly one thread may call try_push(), and exactly one (other) thread may call try_pop().
+    //! The capacity is rounded up to a power of 2.
+    template<class T>
+    class spsc_ring
+    {
+
+    public:
+
+        explicit spsc_ring(std::size_t capacity): slots_(round_up_(capacity)), head_(0), tail_(0)
+        {
+            // Do nothing.
+        }
+
+        //! Returns the maximum number of items in the ring.
+        std::size_t capacity() const
+        {
+            return slots_.size();
+        }
+
+        //! Pushes an item to the ring (producer thread only).
+        //! \param item  the item to push.
+        //! \return true if the item is pushed, false if the ring is full.
+        bool try_push(const T& item)
+        {
+            std::size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - head_.load(std::memory_order_acquire) == slots_.size())
+            {
+                return false;
+            }
+            slots_[tail & (slots_.size() - 1)] = item;
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        //! Pops an item from the ring (consumer thread only).
+        //! \param item  receives the item popped.
+        //! \return true if an item is popped, false if the ring is empty.
+        bool try_pop(T& item)
+        {
+            std::size_t head = head_.load(std::memory_order_relaxed);
+            if (head == tail_.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            item = slots_[head & (slots_.size() - 1)];
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+
+        //! Non-implemented copy constructor.
+        spsc_ring(const spsc_ring&);
+
+        //! Non-implemented copy assignment.
+        spsc_ring& operator=(const spsc_ring&);
+
+        static std::size_t round_up_(std::size_t capacity)
+        {
+            std::size_t size = 1;
+            while (size < capacity)
+            {
+                size *= 2;
+            }
+            return size;
+        }
+
+    private:
+
+        // The indices are kept on separate cache lines, to avoid false sharing.
+        std::vector<T>           slots_;     //!< The slots, whose number is a power of 2.
+        char                     padding1_[64];
+        std::atomic<std::size_t> head_;      //!< The index of the next item to pop.
+        char                     padding2_[64];
+        std::atomic<std::size_t> tail_;      //!< The index of the next item to push.
+
+    };
+
+
+    //! This class implements the waiting strategy of a thread waiting on a lock-free structure:
+    //! it yields the processor a few times, then sleeps for short periods.
+    class spin_backoff
+    {
+
+    public:
+
+        explicit spin_backoff(): count_(0)
+        {
+            // Do nothing.
+        }
+
+        void wait()
+        {
+            if (count_ < 64)
+            {
+                ++count_;
+                std::this_thread::yield();
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+
+    private:
+
+        unsigned int count_;
+
+    };
+
+
+}  // namespace xtree::detail
+}  // namespace xtree
+
+//! \endcond
+
+
+#endif  // XTREE_HAS_CXX11
+
+
+#endif  // XTREE_SPSC_RING_HPP_20111016__
+
@@ -0,0 +1,317 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#ifndef XTREE_STREAM_PATTERN_HPP_20111019__
+#define XTREE_STREAM_PATTERN_HPP_20111019__
+
+#include "xtree/config.hpp"
+#include "xtree/xml_base.hpp"
+#include "xtree/libxml2_fwd.hpp"
+#include "xtree/sax_attribute_list.hpp"
+#include "xtree/sax_handler.hpp"
+#include "xtree/xpath.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+namespace xtree {
+
+
+    class XTREE_DECL xml_reader;
+    class XTREE_DECL stream_matcher;
+
+
+    //! This class represents a compiled streamable XPath pattern, built on libxml2's xmlPattern
+    //! streaming API. Unlike an xpath, which is evaluated against a fully built DOM, a stream
+    //! pattern is matched against the elements reported by a SAX parser or an xml_reader one by
+    //! one (see stream_matcher), so that elements may be selected from XML of any size without
+    //! building a document.
+    //!
+    //! The pattern is a subset of XPath selecting elements:
+    //! - location paths on the child and descendant axes, such as "/feed/record", "//record",
+    //!   "/feed//item" or "/feed/*", with namespace prefixes registered as for an xpath;
+    //! - unions of such paths, such as "/feed/record | /feed/deleted";
+    //! - simple predicates on the attributes of the last step, such as "//item[@id]",
+    //!   "//item[@type='book']" or "//item[@x:type!='book']".
+    //!
+    //! Relative paths are evaluated from the document node: "record" only matches a root
+    //! element named record. A stream pattern is not modified by matching: it may be shared by
+    //! several matchers, in several threads.
+    class XTREE_DECL stream_pattern: private xml_base
+    {
+
+        friend class stream_matcher;
+
+    public:
+
+        //! Compiles a stream pattern.
+        //! \param str  the pattern.
+        //! \throws xpath_error  if the pattern is not valid or not streamable.
+        explicit stream_pattern(const std::string& str);
+
+        //! Compiles a stream pattern using a namespace prefix.
+        //! \param str     the pattern.
+        //! \param prefix  the namespace prefix used in the pattern.
+        //! \param uri     the namespace URI.
+        //! \throws xpath_error  if the pattern is not valid or not streamable.
+        explicit stream_pattern(const std::string& str,
+                                const std::string& prefix,
+                                const std::string& uri);
+
+        //! Compiles a stream pattern using namespace prefixes.
+        //! \param str       the pattern.
+        //! \param registry  the namespace prefixes used in the pattern, mapped to their URIs.
+        //! \throws xpath_error  if the pattern is not valid or not streamable.
+        explicit stream_pattern(const std::string& str, const xpath::xmlns_registry& registry);
+
+        //! Destructor.
+        ~stream_pattern();
+
+        //! Returns the pattern string.
+        const std::string& str() const
+        {
+            return str_;
+        }
+
+    private:
+
+        //! The operators of attribute predicates.
+        enum predicate_op
+        {
+            attr_exists,     //!< [@name]
+            attr_equal,      //!< [@name='value']
+            attr_not_equal   //!< [@name!='value']
+        };
+
+        //! A predicate on an attribute of the matching element.
+        struct attr_predicate
+        {
+            std::string  name;   //!< The attribute local name.
+            std::string  uri;    //!< The attribute namespace URI, empty for no namespace.
+            predicate_op op;     //!< The operator.
+            std::string  value;  //!< The value compared to, if any.
+        };
+
+        //! A path of the pattern union.
+        struct branch
+        {
+            xmlPattern*                 raw;         //!< The compiled path, without predicates.
+            std::vector<attr_predicate> predicates;  //!< The predicates of the last step.
+        };
+
+        //! Non-implemented copy constructor.
+        stream_pattern(const stream_pattern&);
+
+        //! Non-implemented copy assignment.
+        stream_pattern& operator=(const stream_pattern&);
+
+        //! Compiles the pattern string.
+        void compile_(const xpath::xmlns_registry& registry);
+
+        //! Compiles a path of the pattern union.
+        void compile_branch_(const std::string& str, const xpath::xmlns_registry& registry);
+
+        //! Frees the compiled paths.
+        void free_();
+
+    private:
+
+        std::string         str_;       //!< The pattern string.
+        std::vector<branch> branches_;  //!< The paths of the pattern union.
+
+    };
+
+
+    //! This class defines the interface for handling the elements matched by a stream_matcher in
+    //! SAX mode. User should derive from this class to process the matching elements.
+    class XTREE_DECL stream_match_handler
+    {
+
+    public:
+
+        explicit stream_match_handler();
+
+        virtual ~stream_match_handler() = 0;
+
+        //! Receives notification of the beginning of an element matching the pattern.
+        //! \param name    the local name of this element.
+        //! \param prefix  the namespace prefix of this element.
+        //! \param uri     the namespace URI of this element.
+        //! \param attrs   the attribute list associated with this element.
+        virtual void start_match(const std::string& name,
+                                 const std::string& prefix,
+                                 const std::string& uri,
+                                 const sax_attribute_list& attrs) = 0;
+
+        //! Receives notification of the end of an element matching the pattern.
+        //! \param name    the local name of this element.
+        //! \param prefix  the namespace prefix of this element.
+        //! \param uri     the namespace URI of this element.
+        virtual void end_match(const std::string& name,
+                               const std::string& prefix,
+                               const std::string& uri)
+        {
+            // Do nothing.
+            detail::unused_arg(name);
+            detail::unused_arg(prefix);
+            detail::unused_arg(uri);
+        }
+
+    };
+
+
+    //! This class matches a stream_pattern against the elements of an XML document, as they are
+    //! reported by a parser. It drives either a SAX parser, as its content handler:
+    //!
+    //! \code
+    //! xtree::stream_pattern pattern("//item[@type='book']");
+    //! xtree::stream_matcher matcher(pattern);
+    //! matcher.set_match_handler(&my_match_handler);
+    //! xtree::sax_parser parser;
+    //! parser.set_content_handler(&matcher);
+    //! parser.parse_file("huge.xml");
+    //! \endcode
+    //!
+    //! or an xml_reader, which it moves from one matching element to the next:
+    //!
+    //! \code
+    //! xtree::xml_reader reader;
+    //! reader.open_file("huge.xml");
+    //! xtree::stream_matcher matcher(pattern);
+    //! while (matcher.next(reader))
+    //! {
+    //!     xtree::basic_node_ptr<xtree::element> item = reader.expand();
+    //!     // ...
+    //!     matcher.skip(reader);  // skip the item subtree.
+    //! }
+    //! \endcode
+    //!
+    //! In SAX mode, the events are forwarded to the content handler set on the matcher, if any,
+    //! which may call in_match() to know whether it receives the content of a matching element.
+    //! The SAX parser should report namespaces (the default) for namespaced patterns to match.
+    //! A stream matcher should not be used by several threads at once.
+    class XTREE_DECL stream_matcher: public sax_content_handler, private xml_base
+    {
+
+    public:
+
+        //! Constructs a stream matcher.
+        //! \param pattern  the stream pattern, which should outlive the matcher.
+        //! \throws internal_dom_error  if fail to create the libxml2 stream contexts.
+        explicit stream_matcher(const stream_pattern& pattern);
+
+        //! Destructor.
+        ~stream_matcher();
+
+        //! Returns the stream pattern.
+        const stream_pattern& pattern() const
+        {
+            return pattern_;
+        }
+
+        //! Sets the match handler, which receives the matching elements in SAX mode.
+        //! \param handler  the match handler, may be null.
+        void set_match_handler(stream_match_handler* handler);
+
+        //! Sets the content handler, which receives all the SAX events in SAX mode.
+        //! \param handler  the content handler, may be null.
+        void set_content_handler(sax_content_handler* handler);
+
+        //! Resets the matching state to the beginning of a document. This function is called
+        //! automatically by start_document() in SAX mode, and should be called before reading
+        //! another XML with the same matcher in pull mode.
+        void reset();
+
+        //! Moves an xml_reader to the next element matching the pattern (pull mode).
+        //! \param reader  the xml_reader, positioned before the next element to match.
+        //! \return true if the reader is positioned on a matching element, false if the end of
+        //!         the XML is reached.
+        //! \throws dom_error  if the XML is not well-formed.
+        bool next(xml_reader& reader);
+
+        //! Moves an xml_reader past the subtree of its current element (pull mode). This function
+        //! should be called instead of xml_reader::next_sibling(), so that the node following
+        //! the subtree is matched by the next call to next().
+        //! \param reader  the xml_reader, positioned on an element.
+        //! \throws dom_error  if the XML is not well-formed.
+        void skip(xml_reader& reader);
+
+        //! Returns the number of matching elements since the last reset.
+        std::size_t count() const
+        {
+            return count_;
+        }
+
+        //! Returns whether the current SAX event belongs to a matching element (or one of its
+        //! descendants).
+        bool in_match() const
+        {
+            return (open_matches_ > 0);
+        }
+
+        //! \name SAX content handler functions
+        //! \{
+
+        virtual void start_document();
+
+        virtual void end_document();
+
+        virtual void start_element(const std::string& name,
+                                   const std::string& prefix,
+                                   const std::string& uri,
+                                   const sax_attribute_list& attrs);
+
+        virtual void end_element(const std::string& name,
+                                 const std::string& prefix,
+                                 const std::string& uri);
+
+        virtual void characters(const char* chars, int length);
+
+        virtual void cdata_block(const char* chars, int length);
+
+        virtual void ignorable_whitespace(const char* chars, int length);
+
+        virtual void comment(const char* chars);
+
+        //! \}
+
+    private:
+
+        //! Non-implemented copy constructor.
+        stream_matcher(const stream_matcher&);
+
+        //! Non-implemented copy assignment.
+        stream_matcher& operator=(const stream_matcher&);
+
+        //! Pushes an element to the streams, and returns whether it matches the pattern.
+        template<class Attributes>
+        bool push_(const std::string& name, const std::string& uri, const Attributes& attrs);
+
+        //! Pops elements from the streams until the given number of elements remain.
+        void pop_(std::size_t depth);
+
+        //! Frees the libxml2 stream contexts.
+        void free_streams_();
+
+    private:
+
+        const stream_pattern&       pattern_;          //!< The stream pattern.
+        std::vector<xmlStreamCtxt*> streams_;          //!< The streams, one per pattern path.
+        std::vector<bool>           matches_;          //!< Whether each open element matches.
+        stream_match_handler*       match_handler_;    //!< Pointer to match handler.
+        sax_content_handler*        content_handler_;  //!< Pointer to content handler.
+        std::size_t                 open_matches_;     //!< The number of open matching elements.
+        std::size_t                 count_;            //!< The number of matching elements.
+        bool                        pending_;          //!< Whether the reader node is unmatched.
+
+    };
+
+
+}  // namespace xtree
+
+
+#endif  // XTREE_STREAM_PATTERN_HPP_20111019__
+
@@ -0,0 +1,198 @@
+//
+// Created by ZHENG Zhong on 2011-10-17.
+//
+
+#ifndef XTREE_SUBTREE_SPLITTER_HPP_20111017__
+#define XTREE_SUBTREE_SPLITTER_HPP_20111017__
+
+#include "xtree/config.hpp"
+#include "xtree/xml_base.hpp"
+#include "xtree/document.hpp"
+#include "xtree/sax_features.hpp"
+#include "xtree/sax_handler.hpp"
+
+#if defined(XTREE_GNUC) && XTREE_GNUC >= 4
+#  pragma GCC diagnostic ignored "-Wdeprecated-declarations"  // std::auto_ptr is deprecated.
+#endif
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace xtree {
+
+
+    //! \cond DEV
+    namespace detail {
+        class basic_sax_parser_base;
+    }
+    //! \endcond
+
+
+    //! This class defines the interface for handling the subtrees materialized by a
+    //! subtree_splitter. User should derive from this class to process the subtrees.
+    class XTREE_DECL subtree_handler
+    {
+
+    public:
+
+        explicit subtree_handler();
+
+        virtual ~subtree_handler() = 0;
+
+        //! Receives a subtree, materialized as a standalone document whose root element is the
+        //! subtree element. The document is destroyed when this function returns, unless the
+        //! handler takes its ownership.
+        //! \param doc    the subtree document.
+        //! \param index  the index of the subtree in the XML, starting from 0.
+        virtual void subtree(std::auto_ptr<document> doc, std::size_t index) = 0;
+
+    };
+
+
+    //! This class represents a streaming XML splitter, which parses record-oriented XML such as
+    //! <tt>\<feed\>\<record/\>...\<record/\>\</feed\></tt> in SAX mode, and materializes each
+    //! subtree matching an element path as a standalone document. Each document is handed to a
+    //! subtree handler, and destroyed afterwards: the memory remains bounded by the size of one
+    //! subtree, whatever the size of the XML, while the DOM and XPath API is available for each
+    //! subtree.
+    //!
+    //! The element path is an absolute path of element local names, such as "/feed/record",
+    //! where "*" matches any element. Elements outside the matching subtrees are skipped
+    //! without building any node. The namespaces declared on the ancestors of a subtree and used
+    //! in the subtree are declared in the subtree document (see dom_builder).
+    //!
+    //! Note that document memory regions are not used by the splitter, since each subtree is
+    //! built across several SAX callbacks.
+    class XTREE_DECL subtree_splitter: private xml_base
+    {
+
+    public:
+
+        //! Constructs a subtree splitter.
+        //! \param path  the absolute path of the subtree elements, such as "/feed/record".
+        //! \throws sax_error  if the path is not valid.
+        explicit subtree_splitter(const std::string& path);
+
+        //! Destructor.
+        ~subtree_splitter();
+
+        //! Sets the subtree handler.
+        //! \param handler  the subtree handler, may be null.
+        void set_subtree_handler(subtree_handler* handler);
+
+        //! Sets the error handler.
+        //! \param handler  the error handler, may be null.
+        void set_error_handler(sax_error_handler* handler);
+
+        //! Enables or disables a feature. The namespaces and namespace_prefixes features have
+        //! no effect: the subtrees are always built with namespaces.
+        //! \param feature  the feature to enable or disable.
+        //! \param enable   true to enable, false to disable.
+        void set_feature(sax_feature::type feature, bool enable);
+
+        //! Returns whether a feature is enabled.
+        //! \param feature  the feature.
+        //! \return true if this feature is enabled, false otherwise.
+        bool get_feature(sax_feature::type feature) const;
+
+        //! Sets all the features at once. Defaults to sax_feature_set().
+        //! \param features  the features to set.
+        void set_features(const sax_feature_set& features);
+
+        //! Returns the features.
+        //! \return the features.
+        const sax_feature_set& get_features() const;
+
+        //! Returns the element path of the subtrees.
+        //! \return the element path of the subtrees.
+        const std::string& path() const
+        {
+            return path_;
+        }
+
+        //! Stops the splitting. This function is typically called from the subtree handler: the
+        //! rest of the XML is ignored, and no more subtrees are materialized.
+        void stop();
+
+        //! Returns whether the last (or current) parsing has been stopped.
+        //! \return true if the parsing has been stopped, false otherwise.
+        bool stopped() const
+        {
+            return stopped_;
+        }
+
+        //! Returns the number of subtrees materialized by the last (or current) parsing.
+        //! \return the number of subtrees materialized.
+        std::size_t count() const
+        {
+            return count_;
+        }
+
+        //! Parses an XML file, and invokes the subtree handler for each matching subtree.
+        //! \param file_name  the XML file name.
+        //! \throws sax_error  if fail to parse the XML file. The subtrees preceding the error
+        //!                    have already been handed to the subtree handler.
+        void parse_file(const std::string& file_name);
+
+        //! Parses a string containing the XML.
+        //! \param str  the XML string to parse.
+        //! \throws sax_error  if fail to parse the XML string.
+        void parse_string(const char* str);
+
+        //! Parses a memory buffer containing the XML.
+        //! \param data  pointer to the XML to parse.
+        //! \param size  the size of the XML in bytes.
+        //! \throws sax_error  if fail to parse the XML buffer.
+        void parse_buffer(const char* data, std::size_t size);
+
+        //! Parses a contiguous range of characters containing the XML (see
+        //! sax_parser::parse_buffer()).
+        //! \param range  the contiguous range of characters containing the XML to parse.
+        //! \throws sax_error  if fail to parse the XML buffer.
+        template<class ContiguousRange>
+        void parse_buffer(const ContiguousRange& range)
+        {
+            if (range.empty())
+            {
+                parse_buffer(static_cast<const char*>(0), 0);
+            }
+            else
+            {
+                parse_buffer(reinterpret_cast<const char*>(&range[0]),
+                             range.size() * sizeof(range[0]));
+            }
+        }
+
+    private:
+
+        //! Non-implemented copy constructor.
+        subtree_splitter(const subtree_splitter&);
+
+        //! Non-implemented copy assignment.
+        subtree_splitter& operator=(const subtree_splitter&);
+
+        //! Parses an XML file (if file_name is not null) or a memory buffer.
+        void parse_(const std::string* file_name, const char* data, std::size_t size);
+
+    private:
+
+        std::string                    path_;              //!< The element path.
+        std::vector<std::string>       steps_;             //!< The element names in the path.
+        sax_feature_set                features_;          //!< The features.
+        subtree_handler*               subtree_handler_;   //!< Pointer to subtree handler.
+        sax_error_handler*             error_handler_;     //!< Pointer to error handler.
+        detail::basic_sax_parser_base* parser_;            //!< The parser during parsing.
+        std::size_t                    count_;             //!< The number of subtrees.
+        bool                           stopped_;           //!< Whether stopped.
+
+    };
+
+
+}  // namespace xtree
+
+
+#endif  // XTREE_SUBTREE_SPLITTER_HPP_20111017__
+
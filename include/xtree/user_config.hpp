@@ -7,5 +7,9 @@
 
 // User-defined configurations to control the building process.
 
+// Define XTREE_NO_CXX11 to disable the features relying on C++11 threads, atomics and thread-local
+// storage (e.g. the pool allocator for libxml2), even if the compiler supports C++11.
+// #define XTREE_NO_CXX11
+
 #endif // XTREE_USER_CONFIG_HPP_20080703__
 
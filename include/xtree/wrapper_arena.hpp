@@ -0,0 +1,264 @@
+//
+// Created by ZHENG Zhong on 2011-09-20.
+//
+
+#ifndef XTREE_WRAPPER_ARENA_HPP_20110920__
+#define XTREE_WRAPPER_ARENA_HPP_20110920__
+
+#include "xtree/config.hpp"
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#ifdef XTREE_HAS_CXX11
+#  include <atomic>
+#endif
+
+
+//! \cond DEV
+
+#ifdef XTREE_MSVC
+#  pragma warning(push)
+#  pragma warning(disable: 4511 4512)  // noncopyable warnings
+#endif
+
+namespace xtree {
+namespace detail {
+
+
+    //! This class represents a bump/slab memory arena serving the node wrappers of a document.
+    //! Memory is carved out of large chunks, and the blocks freed individually are recycled by
+    //! per-size free lists. All the memory is released in one shot when the arena is destroyed.
+    //!
+    //! An arena is reference-counted: it is owned by a document, and it may also be retained by
+    //! the other documents which have adopted nodes (thus wrappers) from the owner document.
+    //! The arena itself is not thread-safe, except for the reference counting functions (and only
+    //! with C++11 support).
+    class wrapper_arena
+    {
+
+    public:
+
+        //! Creates a new arena, with a reference count of 1.
+        //! \return the new arena.
+        static wrapper_arena* create();
+
+        //! Increments the reference count.
+        void add_ref();
+
+        //! Decrements the reference count, and destroys the arena if it drops to 0.
+        void release();
+
+        //! Retains another arena, which will be kept alive as long as this arena is alive.
+        //! \param other  the arena to retain. Nothing happens if it is this arena.
+        void retain(wrapper_arena* other);
+
+        //! Allocates a memory block.
+        //! \param size  the size of the memory block.
+        //! \return the memory block allocated, never null.
+        //! \throws std::bad_alloc  if fail to allocate memory.
+        void* allocate(std::size_t size);
+
+        //! Returns a memory block to this arena so that it can be reused.
+        //! \param p     the memory block allocated by this arena.
+        //! \param size  the size of the memory block.
+        void deallocate(void* p, std::size_t size);
+
+        //! Returns the total size of memory chunks reserved by this arena.
+        //! \return the total size of memory chunks reserved by this arena.
+        std::size_t reserved_bytes() const
+        {
+            return reserved_bytes_;
+        }
+
+    private:
+
+        //! Private constructor: use create() instead.
+        explicit wrapper_arena();
+
+        //! Private destructor: use release() instead.
+        ~wrapper_arena();
+
+        //! Non-implemented copy constructor.
+        wrapper_arena(const wrapper_arena&);
+
+        //! Non-implemented copy assignment.
+        wrapper_arena& operator=(const wrapper_arena&);
+
+        //! Allocates a new chunk large enough to hold a block of the given size.
+        //! \param size  the size of the memory block to hold.
+        void grow_(std::size_t size);
+
+    private:
+
+        //! Alignment (and granularity) of the memory blocks.
+        static const std::size_t alignment = sizeof(double);
+
+        //! Maximum size of the memory blocks recycled by the free lists.
+        static const std::size_t max_recycled_size = 256;
+
+        //! Size of the first memory chunk.
+        static const std::size_t initial_chunk_size = 4096;
+
+        //! Maximum size of the memory chunks (except those holding a large block).
+        static const std::size_t max_chunk_size = 1024 * 1024;
+
+        //! A memory block in a free list.
+        struct free_block
+        {
+            free_block* next;
+        };
+
+#ifdef XTREE_HAS_CXX11
+        std::atomic<long>           ref_count_;         //!< The reference count.
+#else
+        long                        ref_count_;         //!< The reference count.
+#endif
+        std::vector<char*>          chunks_;            //!< Memory chunks.
+        char*                       current_;           //!< Current position in the last chunk.
+        char*                       limit_;             //!< End of the last chunk.
+        std::size_t                 next_chunk_size_;   //!< Size of the next chunk to allocate.
+        std::size_t                 reserved_bytes_;    //!< Total size of memory chunks.
+        free_block*                 free_lists_[max_recycled_size / alignment + 1];
+        std::vector<wrapper_arena*> retained_;          //!< Other arenas retained by this one.
+
+    };
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // wrapper allocation functions
+    //
+
+
+    //! Allocates memory for a wrapper object. The memory block is prefixed by a header recording
+    //! the arena which the memory comes from, so that it can be freed properly later.
+    //! \param arena  the arena to allocate from, or null to allocate from the heap.
+    //! \param size   the size of the wrapper object.
+    //! \return the memory allocated for the wrapper object.
+    //! \throws std::bad_alloc  if fail to allocate memory.
+    void* allocate_wrapper(wrapper_arena* arena, std::size_t size);
+
+
+    //! Returns the arena which a wrapper object is allocated from.
+    //! \param p  the wrapper object allocated by allocate_wrapper().
+    //! \return the arena, or null if the wrapper object is allocated from the heap.
+    wrapper_arena* get_wrapper_arena(const void* p);
+
+
+    //! Frees the memory of a wrapper object allocated by allocate_wrapper().
+    //! \param p      the wrapper object allocated by allocate_wrapper().
+    //! \param size   the size of the wrapper object.
+    //! \param owner  the arena of the document currently owning the wrapper, if any.
+    void free_wrapper(void* p, std::size_t size, wrapper_arena* owner);
+
+
+    //! Creates a wrapper object, using the arena if not null, or the heap otherwise.
+    //! \param arena  the arena to allocate from, or null to allocate from the heap.
+    //! \param raw    the underlying libxml2 object to wrap.
+    //! \return the wrapper object created.
+    template<class T, class Raw>
+    T* new_wrapper(wrapper_arena* arena, Raw* raw)
+    {
+        void* p = allocate_wrapper(arena, sizeof(T));
+        try
+        {
+            return new(p) T(raw);
+        }
+        catch (...)
+        {
+            free_wrapper(p, sizeof(T), arena);
+            throw;
+        }
+    }
+
+
+    //! Deletes a wrapper object created by new_wrapper(). If the wrapper comes from the arena of
+    //! the document owning it, it is destructed and its memory is recycled by the arena. If the
+    //! wrapper comes from another arena (e.g. the document owning it is being destructed, or the
+    //! wrapper was created before its node was adopted by the current document), the wrapper is
+    //! simply dropped: wrapper destructors do not release any resource, and the memory will be
+    //! released together with the arena.
+    //! \param p      the wrapper object to delete.
+    //! \param owner  the arena of the document currently owning the wrapper, if any.
+    template<class T>
+    void delete_wrapper(T* p, wrapper_arena* owner)
+    {
+        wrapper_arena* arena = get_wrapper_arena(p);
+        if (arena == 0 || arena == owner)
+        {
+            p->~T();
+            free_wrapper(p, sizeof(T), owner);
+        }
+    }
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // wrapper_arena_scope
+    //
+
+
+    //! This class makes a wrapper arena reachable while a libxml2 document is being built, before
+    //! it is wrapped by a document object. The node wrappers created during this period (e.g. by
+    //! the parser when lazy node wrappers are disabled) are then allocated from the arena, which
+    //! is handed over to the document object afterwards. Without C++11 support, this class does
+    //! nothing and these wrappers are allocated from the heap.
+    class wrapper_arena_scope
+    {
+
+    public:
+
+        //! Makes this scope the current wrapper arena scope of the calling thread. The arena is
+        //! created on first use.
+        explicit wrapper_arena_scope();
+
+        //! Makes this scope the current wrapper arena scope of the calling thread, serving the
+        //! wrappers from an arena owned by the caller. This is used by the builders which create
+        //! a libxml2 document over several calls: the arena is not released by this scope.
+        //! \param arena  the arena owned by the caller, may be null.
+        explicit wrapper_arena_scope(wrapper_arena* arena);
+
+        //! Restores the previous scope of the calling thread, and releases the arena if it has
+        //! not been detached.
+        ~wrapper_arena_scope();
+
+        //! Detaches the arena from this scope. The caller is responsible for releasing the arena.
+        //! The arena remains reachable from the calling thread until this scope is destructed.
+        //! \return the arena, or null if no arena has been created.
+        wrapper_arena* detach();
+
+        //! Returns the arena of the current wrapper arena scope of the calling thread.
+        //! \param create  whether to create the arena if the current scope does not have one yet.
+        //! \return the arena, or null if there is no current scope or no arena.
+        static wrapper_arena* current(bool create);
+
+    private:
+
+        //! Non-implemented copy constructor.
+        wrapper_arena_scope(const wrapper_arena_scope&);
+
+        //! Non-implemented copy assignment.
+        wrapper_arena_scope& operator=(const wrapper_arena_scope&);
+
+    private:
+
+        wrapper_arena*       arena_;     //!< The arena, created on first use.
+        wrapper_arena_scope* previous_;  //!< The previous scope of the calling thread.
+        bool                 detached_;  //!< Whether the arena has been detached.
+
+    };
+
+
+}  // namespace xtree::detail
+}  // namespace xtree
+
+
+#ifdef XTREE_MSVC
+#  pragma warning(pop)  // noncopyable warnings
+#endif
+
+//! \endcond
+
+
+#endif  // XTREE_WRAPPER_ARENA_HPP_20110920__
+
@@ -0,0 +1,261 @@
+//
+// Created by ZHENG Zhong on 2011-10-18.
+//
+
+#ifndef XTREE_XML_READER_HPP_20111018__
+#define XTREE_XML_READER_HPP_20111018__
+
+#include "xtree/config.hpp"
+#include "xtree/xml_base.hpp"
+#include "xtree/basic_node_ptr.hpp"
+#include "xtree/sax_features.hpp"
+#include "xtree/libxml2_fwd.hpp"
+
+#include <cstddef>
+#include <string>
+
+
+//! \cond DEV
+
+namespace xtree {
+namespace detail {
+
+    class wrapper_arena;
+
+}  // namespace xtree::detail
+}  // namespace xtree
+
+//! \endcond
+
+
+namespace xtree {
+
+
+    class XTREE_DECL element;
+
+
+    //! The types of the nodes reported by xml_reader.
+    enum reader_node_t
+    {
+        reader_none = 0,     //!< No current node: the reader is not positioned yet, or at end.
+        reader_element,      //!< The beginning of an element.
+        reader_end_element,  //!< The end of an element (not reported for empty elements).
+        reader_text,         //!< Text.
+        reader_cdata,        //!< A CDATA section.
+        reader_whitespace,   //!< Whitespace, significant or not.
+        reader_comment,      //!< A comment.
+        reader_instruction,  //!< A processing instruction.
+        reader_doctype,      //!< The document type declaration.
+        reader_other         //!< Any other node (entity reference, XML declaration...).
+    };
+
+
+    //! This class represents a pull XML parser built on libxml2's xmlTextReader. Instead of
+    //! receiving callbacks, the client code moves a cursor forward through the nodes of the XML
+    //! document by calling next(), and inspects the current node. Only the current node (and its
+    //! ancestors) is kept in memory, so the memory remains bounded as with a SAX parser, while
+    //! the client code remains a simple loop:
+    //!
+    //! \code
+    //! xtree::xml_reader reader;
+    //! reader.open_file("feed.xml");
+    //! while (reader.next())
+    //! {
+    //!     if (reader.node_type() == xtree::reader_element && reader.local_name() == "record")
+    //!     {
+    //!         xtree::basic_node_ptr<xtree::element> record = reader.expand();
+    //!         // ... use the DOM API on the record ...
+    //!         reader.next_sibling();  // skip the record subtree.
+    //!     }
+    //! }
+    //! \endcode
+    //!
+    //! Unlike next(), next_sibling() skips the whole subtree of the current node. The libxml2
+    //! reader is reused from one document to the next. The node wrappers created while reading
+    //! are allocated from a wrapper arena, which recycles them as the cursor moves forward.
+    class XTREE_DECL xml_reader: private xml_base
+    {
+
+    public:
+
+        //! Constructs an XML reader.
+        explicit xml_reader();
+
+        //! Destructor: closes the reader.
+        ~xml_reader();
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        //! \name Features
+        //! \{
+
+        //! Enables or disables a feature. The namespaces and namespace_prefixes features have
+        //! no effect. The features are applied by the next call to an open function.
+        //! \param feature  the feature to enable or disable.
+        //! \param enable   true to enable, false to disable.
+        void set_feature(sax_feature::type feature, bool enable);
+
+        //! Returns whether a feature is enabled.
+        //! \param feature  the feature.
+        //! \return true if this feature is enabled, false otherwise.
+        bool get_feature(sax_feature::type feature) const;
+
+        //! Sets all the features at once. Defaults to sax_feature_set().
+        //! \param features  the features to set.
+        void set_features(const sax_feature_set& features);
+
+        //! Returns the features.
+        //! \return the features.
+        const sax_feature_set& get_features() const;
+
+        //! \}
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        //! \name Opening and Closing
+        //! \{
+
+        //! Opens an XML file for reading. The reader is positioned before the first node.
+        //! \param file_name  the XML file name.
+        //! \throws dom_error  if fail to open the XML file.
+        void open_file(const std::string& file_name);
+
+        //! Opens a string containing the XML for reading. The string should remain valid until
+        //! the reader is closed or another XML is opened.
+        //! \param str  the XML string.
+        //! \throws dom_error  if fail to open the XML string.
+        void open_string(const char* str);
+
+        //! Opens a memory buffer containing the XML for reading. The buffer should remain valid
+        //! until the reader is closed or another XML is opened.
+        //! \param data  pointer to the XML.
+        //! \param size  the size of the XML in bytes.
+        //! \throws dom_error  if fail to open the XML buffer.
+        void open_buffer(const char* data, std::size_t size);
+
+        //! Closes the XML being read, if any. The reader can open another XML afterwards.
+        void close();
+
+        //! Returns whether an XML is opened.
+        bool is_open() const
+        {
+            return opened_;
+        }
+
+        //! \}
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        //! \name Cursor Movement
+        //! \{
+
+        //! Moves to the next node in document order.
+        //! \return true if moved to the next node, false if the end of the XML is reached.
+        //! \throws dom_error  if the XML is not well-formed, or if no XML is opened.
+        bool next();
+
+        //! Moves to the next sibling of the current node, skipping its subtree without reporting
+        //! any of its nodes.
+        //! \return true if moved to the next sibling, false if the end of the XML is reached.
+        //! \throws dom_error  if the XML is not well-formed, or if no XML is opened.
+        bool next_sibling();
+
+        //! \}
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        //! \name Current Node Access
+        //! \{
+
+        //! Returns the type of the current node.
+        reader_node_t node_type() const;
+
+        //! Returns the depth of the current node, starting from 0 for the root element.
+        int depth() const;
+
+        //! Returns the QName of the current node.
+        std::string name() const;
+
+        //! Returns the local name of the current node.
+        std::string local_name() const;
+
+        //! Returns the namespace prefix of the current node.
+        std::string prefix() const;
+
+        //! Returns the namespace URI of the current node.
+        std::string uri() const;
+
+        //! Returns the value of the current node: the content of a text, CDATA section, comment
+        //! or processing instruction, or an empty string for other node types.
+        std::string value() const;
+
+        //! Returns whether the current node is an empty element, such as <tt>\<a/\></tt>: no
+        //! end element is reported for an empty element.
+        bool is_empty_element() const;
+
+        //! Returns the number of attributes of the current node.
+        int attr_count() const;
+
+        //! Returns the value of an attribute of the current node by QName.
+        //! \param qname  the attribute QName.
+        //! \return the attribute value, or an empty string if the attribute does not exist.
+        std::string attr(const std::string& qname) const;
+
+        //! Returns the value of an attribute of the current node by name and namespace URI.
+        //! \param name  the attribute local name.
+        //! \param uri   the attribute namespace URI, or an empty string for no namespace.
+        //! \return the attribute value, or an empty string if the attribute does not exist.
+        std::string attr(const std::string& name, const std::string& uri) const;
+
+        //! Returns whether the current node has an attribute of a given name and namespace URI.
+        //! \param name  the attribute local name.
+        //! \param uri   the attribute namespace URI, or an empty string for no namespace.
+        bool has_attr(const std::string& name, const std::string& uri) const;
+
+        //! Returns the value of an attribute of the current node by index.
+        //! \param index  the index of the attribute, from 0 to attr_count() - 1.
+        //! \return the attribute value, or an empty string if the index is out of range.
+        std::string attr(int index) const;
+
+        //! Reads the whole subtree of the current element into memory, and returns a transient
+        //! element wrapper for it. The element remains valid until the cursor is moved: call
+        //! next_sibling() to move past the subtree. The element does not belong to a document
+        //! object, so element::doc() should not be called on it, and it should not be modified.
+        //! \return the current element, or null if the current node is not an element.
+        //! \throws dom_error  if the XML is not well-formed.
+        basic_node_ptr<element> expand();
+
+        //! \}
+
+    private:
+
+        //! Non-implemented copy constructor.
+        xml_reader(const xml_reader&);
+
+        //! Non-implemented copy assignment.
+        xml_reader& operator=(const xml_reader&);
+
+        //! Prepares the reader after an XML is opened.
+        void on_open_(bool opened, const std::string& what);
+
+        //! Checks the return value of a libxml2 reader function moving the cursor.
+        bool check_move_(int ret);
+
+        //! Throws dom_error if no XML is opened.
+        void check_open_(const char* what) const;
+
+        //! Receives the libxml2 errors.
+        static void on_error_(void* context, xmlError* err);
+
+    private:
+
+        xmlTextReader*         reader_;    //!< The libxml2 reader, reused from one XML to the next.
+        sax_feature_set        features_;  //!< The features.
+        bool                   opened_;    //!< Whether an XML is opened.
+        std::string            error_;     //!< The message of the first error.
+        detail::wrapper_arena* arena_;     //!< The arena of the XML opened, or null.
+
+    };
+
+
+}  // namespace xtree
+
+
+#endif  // XTREE_XML_READER_HPP_20111018__
+
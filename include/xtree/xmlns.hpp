@@ -21,6 +21,17 @@ namespace xtree {
     class XTREE_DECL element;
 
 
+    //! \cond DEV
+
+    namespace detail {
+
+        class wrapper_arena;
+
+    }  // namespace xtree::detail
+
+    //! \endcond
+
+
     //! This class represents an XML namespace declaration attached to an element.
     class XTREE_DECL xmlns: private xml_base
     {
@@ -29,9 +40,16 @@ namespace xtree {
 
         //! \cond DEV
 
-        static xmlns* get_or_create(xmlNs* px);
+        //! Returns the wrapper of a libxml2 namespace, creating it from an arena if necessary.
+        //! \param px     the libxml2 namespace, may be null.
+        //! \param arena  the arena of the document owning the namespace, or null for the heap.
+        //! \return the wrapper, or null if the libxml2 namespace is null.
+        static xmlns* get_or_create(xmlNs* px, detail::wrapper_arena* arena);
 
-        static void delete_private(xmlNs* px);
+        //! Deletes the wrapper of a libxml2 namespace, if any.
+        //! \param px     the libxml2 namespace.
+        //! \param owner  the arena of the document owning the namespace, if any.
+        static void delete_private(xmlNs* px, detail::wrapper_arena* owner);
 
         //! \endcond
 
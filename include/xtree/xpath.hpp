@@ -3,6 +3,7 @@
 
 #include "xtree/config.hpp"
 #include "xtree/libxml2_fwd.hpp"
+#include "xtree/xpath_cache.hpp"
 
 #include <map>
 #include <string>
@@ -11,7 +12,17 @@
 namespace xtree {
 
 
-    //! This class wraps a compiled XPath expression.
+    //! This class wraps a compiled XPath expression. The compiled expressions are looked up in a
+    //! process-wide cache (see set_xpath_cache_capacity()), so that constructing an xpath object
+    //! from the same expression and XML namespaces again does not compile it again.
+    //!
+    //! The compiled expression is reference-counted: copying an xpath object shares its compiled
+    //! expression, so that xpath objects can be passed by value and stored in containers cheaply.
+    //!
+    //! The same xpath object may be evaluated by several threads at once, on different documents.
+    //! Libxml2 caches in the compiled expression the functions it resolves while evaluating it:
+    //! an expression which may call functions is therefore evaluated on private copies of the
+    //! compiled expression, each copy being used by one evaluation at a time.
     class XTREE_DECL xpath
     {
 
@@ -43,34 +54,39 @@ namespace xtree {
         //! \param registry  the XML namespace registry.
         xpath(const std::string& str, const xmlns_registry& registry);
 
-        //! Copy constructor.
+        //! Copy constructor: shares the compiled XPath expression.
         xpath(const xpath& rhs);
 
-        //! Copy assignment.
+        //! Copy assignment: shares the compiled XPath expression.
         xpath& operator=(const xpath& rhs);
 
-        //! Destructs the compiled XPath and frees its underlying object.
+#ifdef XTREE_HAS_CXX11
+
+        //! Move constructor. The moved-from xpath object may only be destructed or assigned.
+        xpath(xpath&& rhs);
+
+        //! Move assignment. The moved-from xpath object may only be destructed or assigned.
+        xpath& operator=(xpath&& rhs);
+
+#endif  // XTREE_HAS_CXX11
+
+        //! Destructs the xpath object, and frees the compiled XPath if it is no longer shared.
         ~xpath();
 
+        //! Swaps this xpath object with another one.
+        //! \param rhs  the xpath object to swap with.
+        void swap(xpath& rhs);
+
         //! Registers an XML namespace. If the namespace prefix already exists, the mapping URI
-        //! will be overwritten.
+        //! will be overwritten. The compiled expression is looked up again for the new registry.
         //! \param prefix  the XML namespace prefix to register.
         //! \param uri     the XML namespace URI to register.
-        void register_xmlns(const std::string& prefix, const std::string& uri)
-        {
-            registry_[prefix] = uri;
-        }
+        void register_xmlns(const std::string& prefix, const std::string& uri);
 
         //! Registers XML namespaces. If one namespace prefix already exists, the mapping URI
-        //! will be overwritten.
+        //! will be overwritten. The compiled expression is looked up again for the new registry.
         //! \param registry  the XML namespace registry.
-        void register_xmlns(const xmlns_registry& registry)
-        {
-            for (xmlns_registry::const_iterator i = registry.begin(); i != registry.end(); ++i)
-            {
-                registry_[i->first] = i->second;
-            }
-        }
+        void register_xmlns(const xmlns_registry& registry);
 
         //! Returns the XML namespace registry.
         //! \return the XML namespace registry.
@@ -92,7 +108,14 @@ namespace xtree {
         //! client code.
         const xmlXPathCompExpr* raw() const
         {
-            return raw_;
+            return detail::get_raw_xpath(compiled_);
+        }
+
+        //! Returns the shared compiled XPath expression. This function should NOT be called by
+        //! client code.
+        detail::compiled_xpath* compiled() const
+        {
+            return compiled_;
         }
 
         //! Initializes the underlying libxml2 xpath object. This function is used by constructors.
@@ -101,9 +124,9 @@ namespace xtree {
 
     private:
 
-        std::string       str_;       //!< The string representation of the XPath expression.
-        xmlns_registry    registry_;  //!< The XML namespace registry.
-        xmlXPathCompExpr* raw_;       //!< The underlying libxml2 XPath object.
+        std::string             str_;       //!< The string representation of the expression.
+        xmlns_registry          registry_;  //!< The XML namespace registry.
+        detail::compiled_xpath* compiled_;  //!< The compiled XPath expression.
 
     };
 
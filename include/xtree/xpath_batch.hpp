@@ -0,0 +1,154 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#ifndef XTREE_XPATH_BATCH_HPP_20111019__
+#define XTREE_XPATH_BATCH_HPP_20111019__
+
+#include "xtree/config.hpp"
+#include "xtree/types.hpp"
+#include "xtree/xpath.hpp"
+#include "xtree/xpath_value.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+namespace xtree {
+
+
+    class XTREE_DECL document;
+    class XTREE_DECL element;
+    class XTREE_DECL xpath_evaluator;
+
+
+    //! This class represents a batch of XPath expressions, evaluated together from the same
+    //! context node by a single call. All the expressions of the batch share the same evaluation
+    //! context, so that the context is set up and the XML namespaces are registered only once:
+    //!
+    //! \code
+    //! xtree::xpath_batch batch;
+    //! std::size_t id = batch.add("string(@id)");
+    //! std::size_t price = batch.add("sum(item/price)", xtree::number_result);
+    //! std::vector<xtree::xpath_value> values;
+    //! batch.eval(*order, values);
+    //! // values[id].str, values[price].number...
+    //! \endcode
+    //!
+    //! The result of each expression is converted to the requested type, as by the XPath
+    //! functions string(), number() and boolean(): a node set is converted to the string value
+    //! of its first node, for instance.
+    //!
+    //! Expressions sharing a location path prefix may be grouped: the group path is evaluated
+    //! once, and the expressions of the group are evaluated from the first element it selects.
+    //! If the group path selects no element, the expressions of the group evaluate to an empty
+    //! string, NaN or false, as if they were applied to an empty node set.
+    //!
+    //! An xpath_batch is not modified by evaluation: once built, the same batch may be evaluated
+    //! by several threads at once, on different documents, as its xpath objects may.
+    class XTREE_DECL xpath_batch
+    {
+
+    public:
+
+        //! The group index of the expressions which do not belong to a group.
+        static const std::size_t no_group = static_cast<std::size_t>(-1);
+
+        //! Constructs an empty XPath batch.
+        explicit xpath_batch();
+
+        //! Destructor.
+        ~xpath_batch();
+
+        //! Adds a group of expressions sharing a location path prefix.
+        //! \param path  the location path of the group, relative to the context node.
+        //! \return the index of the group.
+        std::size_t add_group(const xpath& path);
+
+        //! Adds an XPath expression to the batch.
+        //! \param expr   the XPath expression, relative to the group element if any.
+        //! \param type   the requested value type: boolean_result, number_result or
+        //!               string_result.
+        //! \param group  the index of the group of the expression, or no_group.
+        //! \return the index of the expression, which is also the index of its value.
+        //! \throws bad_dom_operation  if the type or the group is invalid.
+        std::size_t add(const xpath& expr,
+                        xpath_result_t type = string_result,
+                        std::size_t group = no_group);
+
+        //! Returns the number of XPath expressions.
+        std::size_t size() const
+        {
+            return fields_.size();
+        }
+
+        //! Returns the number of groups.
+        std::size_t group_count() const
+        {
+            return groups_.size();
+        }
+
+        //! Returns an XPath expression of the batch.
+        //! \param index  the index of the expression.
+        //! \return the XPath expression.
+        const xpath& at(std::size_t index) const
+        {
+            return fields_.at(index).expr;
+        }
+
+        //! Evaluates all the expressions from the context node of an XPath evaluator. The context
+        //! node of the evaluator is restored when this function returns.
+        //! \param evaluator  the XPath evaluator.
+        //! \param values     output argument to hold the values, one per expression.
+        //! \throws xpath_error  if an XPath expression fails to evaluate.
+        void eval(xpath_evaluator& evaluator, std::vector<xpath_value>& values) const;
+
+        //! Evaluates all the expressions from a document.
+        //! \param doc     the document.
+        //! \param values  output argument to hold the values, one per expression.
+        //! \throws xpath_error  if an XPath expression fails to evaluate.
+        void eval(document& doc, std::vector<xpath_value>& values) const;
+
+        //! Evaluates all the expressions from an element.
+        //! \param elem    the element.
+        //! \param values  output argument to hold the values, one per expression.
+        //! \throws xpath_error  if an XPath expression fails to evaluate.
+        void eval(element& elem, std::vector<xpath_value>& values) const;
+
+    private:
+
+        //! An XPath expression of the batch.
+        struct field
+        {
+            xpath          expr;   //!< The XPath expression.
+            xpath_result_t type;   //!< The requested value type.
+            std::size_t    group;  //!< The group index, or no_group.
+        };
+
+        //! A group of XPath expressions.
+        struct field_group
+        {
+            xpath                    path;    //!< The location path of the group.
+            std::vector<std::size_t> fields;  //!< The indexes of the expressions of the group.
+        };
+
+        //! Evaluates some expressions from the current context node of an XPath evaluator.
+        void eval_fields_(xpath_evaluator& evaluator,
+                          const std::vector<std::size_t>& indexes,
+                          std::vector<xpath_value>& values) const;
+
+    private:
+
+        std::vector<field>       fields_;     //!< The XPath expressions.
+        std::vector<field_group> groups_;     //!< The groups of expressions.
+        std::vector<std::size_t> ungrouped_;  //!< The indexes of the ungrouped expressions.
+
+    };
+
+
+}  // namespace xtree
+
+
+#endif  // XTREE_XPATH_BATCH_HPP_20111019__
+
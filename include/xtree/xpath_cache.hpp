@@ -0,0 +1,160 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#ifndef XTREE_XPATH_CACHE_HPP_20111019__
+#define XTREE_XPATH_CACHE_HPP_20111019__
+
+#include "xtree/config.hpp"
+#include "xtree/libxml2_fwd.hpp"
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+
+namespace xtree {
+
+
+    //! This struct holds the statistics of the compiled XPath cache.
+    struct xpath_cache_stats
+    {
+
+        unsigned long long hits;       //!< Number of XPath expressions found in the cache.
+        unsigned long long misses;     //!< Number of XPath expressions compiled.
+        unsigned long long evictions;  //!< Number of compiled XPath expressions evicted.
+        std::size_t        size;       //!< Number of compiled XPath expressions in the cache.
+        std::size_t        capacity;   //!< Maximum number of compiled XPath expressions.
+
+        explicit xpath_cache_stats(): hits(0), misses(0), evictions(0), size(0), capacity(0)
+        {
+            // Do nothing.
+        }
+
+    };
+
+
+    //! \name Compiled XPath Cache Functions
+    //! \{
+
+
+    //! Sets the capacity of the compiled XPath cache. The cache is shared by all the threads: an
+    //! xpath object constructed from an expression and a namespace registry found in the cache
+    //! shares the compiled expression instead of compiling it again. When the cache is full, the
+    //! least recently used expression is evicted. Setting the capacity to 0 disables the cache.
+    //! By default, the capacity is 256.
+    //! \param capacity  the maximum number of compiled XPath expressions in the cache.
+    XTREE_DECL void set_xpath_cache_capacity(std::size_t capacity);
+
+
+    //! Returns the capacity of the compiled XPath cache.
+    //! \return the maximum number of compiled XPath expressions in the cache.
+    XTREE_DECL std::size_t get_xpath_cache_capacity();
+
+
+    //! Returns the statistics of the compiled XPath cache.
+    //! \return the statistics of the compiled XPath cache.
+    XTREE_DECL xpath_cache_stats get_xpath_cache_stats();
+
+
+    //! Evicts all the compiled XPath expressions from the cache, and resets the statistics. The
+    //! xpath objects constructed from the cache remain valid.
+    XTREE_DECL void clear_xpath_cache();
+
+
+    //! \}
+
+
+}  // namespace xtree
+
+
+//! \cond DEV
+
+
+namespace xtree {
+namespace detail {
+
+
+    //! A reference-counted compiled XPath expression, shared by the cache and the xpath objects.
+    class compiled_xpath;
+
+
+    //! The XML namespace registry of an XPath expression (same as xpath::xmlns_registry).
+    typedef std::map<std::string, std::string> xmlns_registry;
+
+
+    //! Returns a compiled XPath expression, from the cache or newly compiled. The caller owns a
+    //! reference to the compiled expression, and should release it by release_compiled_xpath().
+    //! \param str       the XPath expression.
+    //! \param registry  the XML namespace registry of the XPath expression.
+    //! \return the compiled XPath expression, never null.
+    //! \throws xpath_error  if fail to compile the XPath expression.
+    XTREE_DECL compiled_xpath* compile_xpath(const std::string& str,
+                                             const xmlns_registry& registry);
+
+
+    //! Adds a reference to a compiled XPath expression.
+    //! \param compiled  the compiled XPath expression.
+    XTREE_DECL void add_ref_compiled_xpath(compiled_xpath* compiled);
+
+
+    //! Releases a reference to a compiled XPath expression, and frees it if it was the last one.
+    //! \param compiled  the compiled XPath expression, may be null.
+    XTREE_DECL void release_compiled_xpath(compiled_xpath* compiled);
+
+
+    //! Evaluates a compiled XPath expression in a libxml2 XPath context. Libxml2 caches the
+    //! functions it resolves in the compiled expression: if the expression may call functions, it
+    //! is evaluated on a copy that no concurrent evaluation uses, so that they do not race on
+    //! this cache.
+    //! \param compiled  the compiled XPath expression.
+    //! \param ctxt      the libxml2 XPath context.
+    //! \return the XPath result, or null on error.
+    XTREE_DECL xmlXPathObject* eval_compiled_xpath(compiled_xpath* compiled, xmlXPathContext* ctxt);
+
+
+    //! Records the namespace URI and local name of a function resolved by libxml2 while
+    //! evaluating a compiled XPath expression. Libxml2 resolves each function call once and caches
+    //! the result in the compiled expression: the namespace URI it then passes to the function
+    //! points into the XPath context used for the resolution, which may be destroyed since
+    //! compiled expressions are shared. The function name, on the other hand, is owned by the
+    //! compiled expression, and its address is passed both to the lookup and to the call. The
+    //! records are freed with the compiled expression.
+    //! \param compiled    the compiled XPath expression.
+    //! \param name        the function name owned by the compiled expression.
+    //! \param uri         the namespace URI of the function.
+    //! \param local_name  the local name of the function.
+    XTREE_DECL void add_resolved_function(compiled_xpath* compiled,
+                                          const xmlChar* name,
+                                          const std::string& uri,
+                                          const std::string& local_name);
+
+
+    //! Finds the namespace URI and local name of a function resolved by libxml2 while evaluating
+    //! a compiled XPath expression.
+    //! \param compiled    the compiled XPath expression.
+    //! \param name        the function name owned by the compiled expression.
+    //! \param uri         output argument to hold the namespace URI of the function.
+    //! \param local_name  output argument to hold the local name of the function.
+    //! \return true if the function has been resolved, false otherwise.
+    XTREE_DECL bool find_resolved_function(const compiled_xpath* compiled,
+                                           const xmlChar* name,
+                                           std::string& uri,
+                                           std::string& local_name);
+
+
+    //! Returns the underlying libxml2 object of a compiled XPath expression.
+    //! \param compiled  the compiled XPath expression.
+    //! \return the underlying libxml2 object.
+    XTREE_DECL const xmlXPathCompExpr* get_raw_xpath(const compiled_xpath* compiled);
+
+
+}  // namespace xtree::detail
+}  // namespace xtree
+
+
+//! \endcond
+
+
+#endif  // XTREE_XPATH_CACHE_HPP_20111019__
+
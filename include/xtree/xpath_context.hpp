@@ -8,7 +8,9 @@
 #include "xtree/config.hpp"
 #include "xtree/libxml2_fwd.hpp"
 
+#include <map>
 #include <string>
+#include <utility>
 
 
 //! \cond DEV
@@ -18,6 +20,8 @@ namespace xtree {
 
     class XTREE_DECL xpath;
     class XTREE_DECL xpath_result;
+    class XTREE_DECL xpath_variables;
+    class XTREE_DECL xpath_function;
 
 }  // namespace xtree
 
@@ -29,6 +33,9 @@ namespace xtree {
 namespace detail {
 
 
+    class compiled_xpath;
+
+
     //! This class wraps a libxml2 xmlXPathContext object. It should not be used by client code.
     class XTREE_DECL xpath_context
     {
@@ -43,7 +50,48 @@ namespace detail {
         //! Destructor.
         ~xpath_context();
 
-        //! Evaluates an XPath expression.
+        //! Rebinds the context to another document, keeping the XML namespaces, the variables and
+        //! the functions registered. The context node is reset to the document.
+        //! \param px_doc  the libxml2 document on which XPath expressions are evaluated.
+        void set_doc(xmlDoc* px_doc);
+
+        //! Sets the node from which XPath expressions are evaluated.
+        //! \param px_node  the libxml2 node, or null to evaluate from the document.
+        void set_node(xmlNode* px_node);
+
+        //! Registers copies of XPath variables, replacing the variables registered previously.
+        //! \param vars  the XPath variables, or null to unregister all the variables.
+        void set_variables(const xpath_variables* vars);
+
+        //! Registers an XPath extension function to the context. It takes precedence over a
+        //! global function of the same name.
+        //! \param name  the local name of the function.
+        //! \param uri   the namespace URI of the function, or an empty string for no namespace.
+        //! \param fn    the function, or null to unregister the function.
+        void set_function(const std::string& name, const std::string& uri, xpath_function* fn);
+
+        //! Finds an XPath extension function registered to the context, or globally.
+        //! \param name  the local name of the function.
+        //! \param uri   the namespace URI of the function, or an empty string for no namespace.
+        //! \return the function, or null if not found.
+        xpath_function* find_function(const std::string& name, const std::string& uri) const;
+
+        //! Records the error of an XPath extension function, to be reported by eval().
+        //! \param message  the error message.
+        void set_function_error(const std::string& message)
+        {
+            function_error_ = message;
+        }
+
+        //! Returns the compiled expression being evaluated, which records the functions resolved.
+        //! \return the compiled expression, or null if no expression is being evaluated.
+        compiled_xpath* current_xpath() const
+        {
+            return current_xpath_;
+        }
+
+        //! Evaluates an XPath expression. The XML namespaces of the expression are registered
+        //! to the context unless they have been registered already by a previous evaluation.
         //! \param expr    the XPath expression to evaluate.
         //! \param result  output argument to hold XPath results.
         void eval(const xpath& expr, xpath_result& result);
@@ -58,7 +106,14 @@ namespace detail {
 
     private:
 
-        xmlXPathContext* raw_;  //!< Raw pointer to the underlying xmlXPathContext object.
+        typedef std::map<std::pair<std::string, std::string>, xpath_function*> function_map;
+
+        xmlXPathContext*                   raw_;             //!< The xmlXPathContext object.
+        xmlNode*                           node_;            //!< The node to evaluate from.
+        std::map<std::string, std::string> xmlns_;           //!< The XML namespaces registered.
+        function_map                       functions_;       //!< The extension functions.
+        std::string                        function_error_;  //!< The extension function error.
+        compiled_xpath*                    current_xpath_;   //!< The expression being evaluated.
 
     };
 
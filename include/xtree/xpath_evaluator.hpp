@@ -0,0 +1,162 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#ifndef XTREE_XPATH_EVALUATOR_HPP_20111019__
+#define XTREE_XPATH_EVALUATOR_HPP_20111019__
+
+#include "xtree/config.hpp"
+#include "xtree/xml_base.hpp"
+#include "xtree/basic_node_ptr.hpp"
+#include "xtree/xpath_context.hpp"
+
+#include <string>
+
+
+namespace xtree {
+
+
+    class XTREE_DECL document;
+    class XTREE_DECL element;
+    class XTREE_DECL xpath;
+    class XTREE_DECL xpath_result;
+    class XTREE_DECL xpath_variables;
+    class XTREE_DECL xpath_function;
+    class XTREE_DECL node_set;
+
+
+    //! This class represents a reusable XPath evaluation context bound to a document. Evaluating
+    //! an XPath expression on a document or an element creates a new libxml2 evaluation context
+    //! and registers the XML namespaces of the expression on every call. An XPath evaluator keeps
+    //! its evaluation context and the XML namespaces registered from one evaluation to the next,
+    //! which pays off when many small expressions are evaluated against the same document:
+    //!
+    //! \code
+    //! xtree::xpath_evaluator evaluator(*doc);
+    //! for (xtree::element_iterator i = ...)
+    //! {
+    //!     evaluator.set_context_node(*i);
+    //!     std::string title = evaluator.eval_string(title_expr);
+    //!     // ...
+    //! }
+    //! \endcode
+    //!
+    //! An XPath evaluator should not be used by several threads at once.
+    class XTREE_DECL xpath_evaluator: private xml_base
+    {
+
+    public:
+
+        //! Constructs an XPath evaluator bound to a document. The context node is the document.
+        //! \param doc  the document, which should outlive the XPath evaluator.
+        explicit xpath_evaluator(document& doc);
+
+        //! Destructor.
+        ~xpath_evaluator();
+
+        //! Returns the document to which this XPath evaluator is bound.
+        document& doc()
+        {
+            return doc_;
+        }
+
+        //! Const version of doc().
+        const document& doc() const
+        {
+            return doc_;
+        }
+
+        //! Sets the context node from which XPath expressions are evaluated.
+        //! \param elem  the context node, which should belong to the document.
+        //! \throws bad_dom_operation  if the element does not belong to the document.
+        void set_context_node(element& elem);
+
+        //! Resets the context node to the document.
+        void reset_context_node();
+
+        //! Returns the context node.
+        //! \return the context node, or null if the context node is the document.
+        basic_node_ptr<element> context_node()
+        {
+            return context_node_;
+        }
+
+        //! Binds XPath variables to the evaluator, replacing the variables bound previously. The
+        //! variables are copied: this function should be called again once they are modified.
+        //! \param vars  the XPath variables.
+        //! \throws xpath_error  if fail to bind a variable.
+        void set_variables(const xpath_variables& vars);
+
+        //! Unbinds all the XPath variables from the evaluator.
+        void clear_variables();
+
+        //! Registers an XPath extension function to the evaluator. It takes precedence over a
+        //! global function of the same name.
+        //! \param name  the local name of the function.
+        //! \param uri   the namespace URI of the function, or an empty string for no namespace.
+        //! \param fn    the function, which should outlive its registration.
+        void register_function(const std::string& name, const std::string& uri, xpath_function& fn);
+
+        //! Registers an XPath extension function without namespace to the evaluator.
+        //! \param name  the name of the function.
+        //! \param fn    the function, which should outlive its registration.
+        void register_function(const std::string& name, xpath_function& fn);
+
+        //! Unregisters an XPath extension function from the evaluator.
+        //! \param name  the local name of the function.
+        //! \param uri   the namespace URI of the function, or an empty string for no namespace.
+        void unregister_function(const std::string& name, const std::string& uri = std::string());
+
+        //! Evaluates an XPath expression from the context node.
+        //! \param expr    the XPath expression.
+        //! \param result  the generic XPath result.
+        //! \throws xpath_error  if the XPath expression is invalid.
+        void eval(const xpath& expr, xpath_result& result);
+
+        //! Evaluates an XPath expression from the context node to a boolean.
+        //! \param expr  the XPath expression.
+        //! \return the boolean result.
+        //! \throws xpath_error  if the XPath expression is invalid.
+        bool eval_boolean(const xpath& expr);
+
+        //! Evaluates an XPath expression from the context node to a number.
+        //! \param expr  the XPath expression.
+        //! \return the number result.
+        //! \throws xpath_error  if the XPath expression is invalid.
+        double eval_number(const xpath& expr);
+
+        //! Evaluates an XPath expression from the context node to a string.
+        //! \param expr  the XPath expression.
+        //! \return the string result.
+        //! \throws xpath_error  if the XPath expression is invalid.
+        std::string eval_string(const xpath& expr);
+
+        //! Evaluates an XPath expression from the context node to a node set. This is an alias
+        //! to eval().
+        //! \param expr   the XPath expression.
+        //! \param nodes  the result node set.
+        //! \throws xpath_error  if the XPath expression is invalid.
+        void select_nodes(const xpath& expr, node_set& nodes);
+
+    private:
+
+        //! Non-implemented copy constructor.
+        xpath_evaluator(const xpath_evaluator&);
+
+        //! Non-implemented copy assignment.
+        xpath_evaluator& operator=(const xpath_evaluator&);
+
+    private:
+
+        document&               doc_;           //!< The document.
+        basic_node_ptr<element> context_node_;  //!< The context node, or null for the document.
+        detail::xpath_context   context_;       //!< The libxml2 XPath evaluation context.
+
+    };
+
+
+}  // namespace xtree
+
+
+#endif  // XTREE_XPATH_EVALUATOR_HPP_20111019__
+
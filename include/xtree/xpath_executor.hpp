@@ -0,0 +1,203 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#ifndef XTREE_XPATH_EXECUTOR_HPP_20111019__
+#define XTREE_XPATH_EXECUTOR_HPP_20111019__
+
+#include "xtree/config.hpp"
+#include "xtree/xml_base.hpp"
+#include "xtree/types.hpp"
+#include "xtree/xpath_value.hpp"
+
+#include <cstddef>
+#include <vector>
+
+
+namespace xtree {
+
+
+    class XTREE_DECL document;
+    class XTREE_DECL xpath;
+    class XTREE_DECL xpath_result;
+
+
+    //! \cond DEV
+    namespace detail {
+
+        class xpath_executor_state;
+
+        //! Returns the document referred to by an element of a document range.
+        inline document& deref_document(document& doc)
+        {
+            return doc;
+        }
+
+        //! Returns the document referred to by an element of a document range.
+        inline document& deref_document(document* doc)
+        {
+            return *doc;
+        }
+
+        //! Returns the document referred to by an element of a document range: this overload
+        //! accepts the smart pointers to documents.
+        template<class Ptr>
+        document& deref_document(const Ptr& ptr)
+        {
+            return *ptr;
+        }
+
+    }  // namespace xtree::detail
+    //! \endcond
+
+
+    //! This class defines the interface for processing the XPath results of the documents
+    //! dispatched by an xpath_executor. User should derive from this class to provide the
+    //! processing function.
+    class XTREE_DECL xpath_result_processor
+    {
+
+    public:
+
+        explicit xpath_result_processor();
+
+        virtual ~xpath_result_processor() = 0;
+
+        //! Processes the XPath result of a document. This function is invoked on a worker thread,
+        //! and may be invoked concurrently on different documents: it should be thread-safe. The
+        //! result is destroyed when this function returns.
+        //! \param doc     the document.
+        //! \param index   the index of the document in the range.
+        //! \param result  the XPath result evaluated on the document.
+        virtual void process(document& doc, std::size_t index, xpath_result& result) = 0;
+
+    };
+
+
+    //! This class evaluates the same XPath expression on a collection of independent documents,
+    //! in parallel on a pool of worker threads:
+    //!
+    //! \code
+    //! std::vector<xtree::document*> docs = ...;
+    //! xtree::xpath_executor executor;
+    //! std::vector<xtree::xpath_value> titles;
+    //! executor.eval(docs.begin(), docs.end(), "/book/title", xtree::string_result, titles);
+    //! \endcode
+    //!
+    //! The compiled expression is shared by all the worker threads, which evaluate it in parallel
+    //! (see xpath for the expressions calling functions). Each worker thread keeps its own XPath
+    //! evaluation context from one document to the next, and from one call to the next, so that
+    //! the XML namespaces of the expression are registered once per thread. The worker threads
+    //! are started by the constructor, and reused by every call.
+    //!
+    //! The documents of a range should be distinct: a document is not thread-safe, and is only
+    //! accessed by the worker thread evaluating the expression on it. The documents may be given
+    //! as references, raw pointers or smart pointers.
+    //!
+    //! If evaluating the expression or processing a result throws an exception, the documents not
+    //! evaluated yet are skipped, and the exception is rethrown to the calling thread once the
+    //! documents being evaluated are done.
+    //!
+    //! An xpath_executor may be used by several threads at once: their calls are run one after
+    //! the other on the worker threads. A processor should not use the executor invoking it,
+    //! though, as the call would wait for the call invoking the processor to return.
+    //!
+    //! Without C++11 support (see XTREE_HAS_CXX11), the expression is evaluated on the calling
+    //! thread, one document after the other.
+    class XTREE_DECL xpath_executor: private xml_base
+    {
+
+    public:
+
+        //! Constructs an XPath executor and starts its worker threads.
+        //! \param thread_count  the number of worker threads, or 0 to use one thread per core.
+        explicit xpath_executor(std::size_t thread_count = 0);
+
+        //! Stops the worker threads.
+        ~xpath_executor();
+
+        //! Returns the number of worker threads.
+        std::size_t thread_count() const;
+
+        //! Evaluates an XPath expression on each document of a range, and passes the results to
+        //! a processor on the worker threads. This function returns once all the results have
+        //! been processed.
+        //! \param first      the beginning of the document range.
+        //! \param last       the end of the document range.
+        //! \param expr       the XPath expression.
+        //! \param processor  the XPath result processor.
+        //! \throws xpath_error  if the XPath expression fails to evaluate.
+        //! \throws ...          any exception thrown by the processor.
+        template<class InputIterator>
+        void eval(InputIterator first,
+                  InputIterator last,
+                  const xpath& expr,
+                  xpath_result_processor& processor)
+        {
+            std::vector<document*> docs;
+            collect_(first, last, docs);
+            eval_(docs, expr, processor);
+        }
+
+        //! Evaluates an XPath expression on each document of a range, and converts the results
+        //! to the requested type, as by the XPath functions string(), number() and boolean().
+        //! \param first   the beginning of the document range.
+        //! \param last    the end of the document range.
+        //! \param expr    the XPath expression.
+        //! \param type    the requested value type: boolean_result, number_result or
+        //!                string_result.
+        //! \param values  output argument to hold the values, one per document.
+        //! \throws bad_dom_operation  if the type is invalid.
+        //! \throws xpath_error        if the XPath expression fails to evaluate.
+        template<class InputIterator>
+        void eval(InputIterator first,
+                  InputIterator last,
+                  const xpath& expr,
+                  xpath_result_t type,
+                  std::vector<xpath_value>& values)
+        {
+            std::vector<document*> docs;
+            collect_(first, last, docs);
+            eval_(docs, expr, type, values);
+        }
+
+    private:
+
+        //! Non-implemented copy constructor.
+        xpath_executor(const xpath_executor&);
+
+        //! Non-implemented copy assignment.
+        xpath_executor& operator=(const xpath_executor&);
+
+        //! Collects the documents of a range.
+        template<class InputIterator>
+        void collect_(InputIterator first, InputIterator last, std::vector<document*>& docs)
+        {
+            for (; first != last; ++first)
+            {
+                docs.push_back(&detail::deref_document(*first));
+            }
+        }
+
+        //! Evaluates an XPath expression on documents, passing the results to a processor.
+        void eval_(const std::vector<document*>& docs,
+                   const xpath& expr,
+                   xpath_result_processor& processor);
+
+        //! Evaluates an XPath expression on documents, converting the results to values.
+        void eval_(const std::vector<document*>& docs,
+                   const xpath& expr,
+                   xpath_result_t type,
+                   std::vector<xpath_value>& values);
+
+    private:
+
+        detail::xpath_executor_state* state_;  //!< The worker threads and the current job.
+
+    };
+
+
+}  // namespace xtree
+
+
+#endif  // XTREE_XPATH_EXECUTOR_HPP_20111019__
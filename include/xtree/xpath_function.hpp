@@ -0,0 +1,181 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#ifndef XTREE_XPATH_FUNCTION_HPP_20111019__
+#define XTREE_XPATH_FUNCTION_HPP_20111019__
+
+#include "xtree/config.hpp"
+#include "xtree/types.hpp"
+#include "xtree/xml_base.hpp"
+#include "xtree/libxml2_fwd.hpp"
+#include "xtree/xpath_value.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+namespace xtree {
+
+
+    class XTREE_DECL node_set;
+
+
+    //! This class holds the arguments passed to an XPath extension function. Each argument may
+    //! be read as any type, converted as by the XPath functions string(), number() and boolean().
+    class XTREE_DECL xpath_function_args: private xml_base
+    {
+
+    public:
+
+        //! \cond DEV
+
+        //! Constructs an empty argument list. This function should NOT be called by client code.
+        explicit xpath_function_args();
+
+        //! Prepends an argument, as arguments are popped from the XPath stack in reverse order.
+        //! This function should NOT be called by client code.
+        //! \param px  the libxml2 XPath object, which is owned by this object.
+        void push_front(xmlXPathObject* px);
+
+        //! \endcond
+
+        //! Destructor.
+        ~xpath_function_args();
+
+        //! Returns the number of arguments.
+        std::size_t size() const
+        {
+            return args_.size();
+        }
+
+        //! Returns the type of an argument.
+        //! \param index  the index of the argument.
+        //! \throws std::out_of_range  if the index is out of range.
+        xpath_result_t type(std::size_t index) const;
+
+        //! Returns an argument converted to a string, as by the XPath function string().
+        //! \param index  the index of the argument.
+        //! \throws std::out_of_range  if the index is out of range.
+        std::string string_at(std::size_t index) const;
+
+        //! Returns an argument converted to a number, as by the XPath function number().
+        //! \param index  the index of the argument.
+        //! \throws std::out_of_range  if the index is out of range.
+        double number_at(std::size_t index) const;
+
+        //! Returns an argument converted to a boolean, as by the XPath function boolean().
+        //! \param index  the index of the argument.
+        //! \throws std::out_of_range  if the index is out of range.
+        bool boolean_at(std::size_t index) const;
+
+        //! Returns a node set argument.
+        //! \param index  the index of the argument.
+        //! \param nodes  output argument to hold the nodes of the argument.
+        //! \throws std::out_of_range  if the index is out of range.
+        //! \throws xpath_error  if the argument is not a node set.
+        void nodes_at(std::size_t index, node_set& nodes) const;
+
+    private:
+
+        //! Non-implemented copy constructor.
+        xpath_function_args(const xpath_function_args&);
+
+        //! Non-implemented copy assignment.
+        xpath_function_args& operator=(const xpath_function_args&);
+
+    private:
+
+        std::vector<xmlXPathObject*> args_;  //!< The arguments, owned by this object.
+
+    };
+
+
+    //! This class defines the interface of XPath extension functions implemented in C++. User
+    //! should derive from this class and register the function to an xpath_evaluator, or globally
+    //! by register_xpath_function(), so that predicates may be evaluated inside the XPath engine
+    //! instead of post-processing large node sets:
+    //!
+    //! \code
+    //! class normalize_upper: public xtree::xpath_function
+    //! {
+    //! public:
+    //!     virtual xtree::xpath_value call(const xtree::xpath_function_args& args)
+    //!     {
+    //!         return xtree::xpath_value(to_upper(trim(args.string_at(0))));
+    //!     }
+    //! };
+    //!
+    //! normalize_upper fn;
+    //! xtree::register_xpath_function("upper", "http://example.com/fn", fn);
+    //! xtree::xpath expr("//item[my:upper(@code)='ABC']", "my", "http://example.com/fn");
+    //! \endcode
+    //!
+    //! A function returns a boolean, a number or a string. An exception thrown by a function
+    //! aborts the evaluation, which fails with an xpath_error carrying the exception message.
+    //! A function registered globally may be called by several threads at once.
+    class XTREE_DECL xpath_function
+    {
+
+    public:
+
+        explicit xpath_function();
+
+        virtual ~xpath_function() = 0;
+
+        //! Calls the function.
+        //! \param args  the arguments of the call.
+        //! \return the value of the call, which should be a boolean, a number or a string.
+        virtual xpath_value call(const xpath_function_args& args) = 0;
+
+    };
+
+
+    //! Registers an XPath extension function globally, for all the evaluations of the process.
+    //! A function registered to an xpath_evaluator takes precedence over a global one of the same
+    //! name. A function without namespace should not have the name of an XPath core function.
+    //! \param name  the local name of the function.
+    //! \param uri   the namespace URI of the function, or an empty string for no namespace.
+    //! \param fn    the function, which should outlive its registration.
+    XTREE_DECL void register_xpath_function(const std::string& name,
+                                            const std::string& uri,
+                                            xpath_function& fn);
+
+    //! Registers an XPath extension function without namespace globally.
+    //! \param name  the name of the function.
+    //! \param fn    the function, which should outlive its registration.
+    XTREE_DECL void register_xpath_function(const std::string& name, xpath_function& fn);
+
+    //! Unregisters a global XPath extension function.
+    //! \param name  the local name of the function.
+    //! \param uri   the namespace URI of the function, or an empty string for no namespace.
+    //! \return true if the function has been unregistered, false if it was not registered.
+    XTREE_DECL bool unregister_xpath_function(const std::string& name,
+                                              const std::string& uri = std::string());
+
+
+    //! \cond DEV
+
+    namespace detail {
+
+
+        //! Finds a global XPath extension function. This function should NOT be called by client
+        //! code.
+        //! \param name  the local name of the function.
+        //! \param uri   the namespace URI of the function, or an empty string for no namespace.
+        //! \return the function, or null if not found.
+        XTREE_DECL xpath_function* find_xpath_function(const std::string& name,
+                                                       const std::string& uri);
+
+
+    }  // namespace xtree::detail
+
+    //! \endcond
+
+
+}  // namespace xtree
+
+
+#endif  // XTREE_XPATH_FUNCTION_HPP_20111019__
+
@@ -0,0 +1,69 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#ifndef XTREE_XPATH_VALUE_HPP_20111019__
+#define XTREE_XPATH_VALUE_HPP_20111019__
+
+#include "xtree/config.hpp"
+#include "xtree/types.hpp"
+
+#include <string>
+
+
+namespace xtree {
+
+
+    //! This struct holds a scalar XPath value: a boolean, a number or a string. It is used for
+    //! the values of an xpath_batch and the return values of XPath extension functions.
+    struct xpath_value
+    {
+
+        xpath_result_t type;     //!< The value type: boolean, number or string.
+        bool           boolean;  //!< The value, if the type is boolean_result.
+        double         number;   //!< The value, if the type is number_result.
+        std::string    str;      //!< The value, if the type is string_result.
+
+        //! Constructs an undefined value.
+        explicit xpath_value(): type(undefined_result), boolean(false), number(0), str()
+        {
+            // Do nothing.
+        }
+
+        //! Constructs a boolean value.
+        explicit xpath_value(bool value)
+        : type(boolean_result), boolean(value), number(0), str()
+        {
+            // Do nothing.
+        }
+
+        //! Constructs a number value.
+        explicit xpath_value(double value)
+        : type(number_result), boolean(false), number(value), str()
+        {
+            // Do nothing.
+        }
+
+        //! Constructs a string value.
+        explicit xpath_value(const std::string& value)
+        : type(string_result), boolean(false), number(0), str(value)
+        {
+            // Do nothing.
+        }
+
+        //! Constructs a string value. This overload prevents string literals from being taken
+        //! as booleans.
+        explicit xpath_value(const char* value)
+        : type(string_result), boolean(false), number(0), str(value)
+        {
+            // Do nothing.
+        }
+
+    };
+
+
+}  // namespace xtree
+
+
+#endif  // XTREE_XPATH_VALUE_HPP_20111019__
+
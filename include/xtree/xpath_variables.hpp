@@ -0,0 +1,129 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#ifndef XTREE_XPATH_VARIABLES_HPP_20111019__
+#define XTREE_XPATH_VARIABLES_HPP_20111019__
+
+#include "xtree/config.hpp"
+#include "xtree/xml_base.hpp"
+#include "xtree/libxml2_fwd.hpp"
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+
+namespace xtree {
+
+
+    class XTREE_DECL node_set;
+
+
+    //! This class holds the values of XPath variables, which are referenced as $name in XPath
+    //! expressions. Binding variables allows one compiled XPath expression to serve every value
+    //! of its parameters, instead of building and compiling a new expression per value:
+    //!
+    //! \code
+    //! xtree::xpath expr("//item[@id=$id]");
+    //! xtree::xpath_variables vars;
+    //! vars.set_string("id", "123");
+    //! xtree::node_set items;
+    //! doc->eval(expr, vars, items);
+    //! \endcode
+    //!
+    //! A variable may hold a string, a number, a boolean or a node set. A node set variable holds
+    //! pointers to the nodes, which should not be destroyed while the variable is in use.
+    class XTREE_DECL xpath_variables: private xml_base
+    {
+
+    public:
+
+        //! Constructs an empty set of XPath variables.
+        explicit xpath_variables();
+
+        //! Destructor.
+        ~xpath_variables();
+
+        //! Sets a string variable.
+        //! \param name   the variable name, without the leading '$'.
+        //! \param value  the variable value.
+        void set_string(const std::string& name, const std::string& value);
+
+        //! Sets a number variable.
+        //! \param name   the variable name, without the leading '$'.
+        //! \param value  the variable value.
+        void set_number(const std::string& name, double value);
+
+        //! Sets a boolean variable.
+        //! \param name   the variable name, without the leading '$'.
+        //! \param value  the variable value.
+        void set_boolean(const std::string& name, bool value);
+
+        //! Sets a node set variable.
+        //! \param name   the variable name, without the leading '$'.
+        //! \param nodes  the nodes of the variable.
+        void set_nodes(const std::string& name, const node_set& nodes);
+
+        //! Removes a variable.
+        //! \param name  the variable name, without the leading '$'.
+        //! \return true if the variable has been removed, false if it does not exist.
+        bool remove(const std::string& name);
+
+        //! Removes all the variables.
+        void clear();
+
+        //! Returns whether a variable exists.
+        //! \param name  the variable name, without the leading '$'.
+        bool contains(const std::string& name) const
+        {
+            return (vars_.find(name) != vars_.end());
+        }
+
+        //! Returns the number of variables.
+        std::size_t size() const
+        {
+            return vars_.size();
+        }
+
+        //! Returns whether there is no variable.
+        bool empty() const
+        {
+            return vars_.empty();
+        }
+
+        //! \cond DEV
+
+        //! Registers copies of all the variables to a libxml2 XPath context, replacing the
+        //! variables registered previously. This function should NOT be called by client code.
+        //! \param px  the libxml2 XPath context.
+        //! \throws xpath_error  if fail to register a variable.
+        void register_to(xmlXPathContext* px) const;
+
+        //! \endcond
+
+    private:
+
+        //! Non-implemented copy constructor.
+        xpath_variables(const xpath_variables&);
+
+        //! Non-implemented copy assignment.
+        xpath_variables& operator=(const xpath_variables&);
+
+        //! Sets a variable.
+        //! \param name   the variable name.
+        //! \param value  the variable value, owned by this object.
+        void set_(const std::string& name, xmlXPathObject* value);
+
+    private:
+
+        std::map<std::string, xmlXPathObject*> vars_;  //!< The variables and their values.
+
+    };
+
+
+}  // namespace xtree
+
+
+#endif  // XTREE_XPATH_VARIABLES_HPP_20111019__
+
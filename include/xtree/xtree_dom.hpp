@@ -10,6 +10,8 @@
 #include "xtree/xtree_dom_fwd.hpp"
 
 #include "xtree/dom_parser.hpp"
+#include "xtree/dom_push_parser.hpp"
+#include "xtree/xml_reader.hpp"
 #include "xtree/document.hpp"
 
 #include "xtree/node.hpp"
@@ -26,6 +28,12 @@
 #include "xtree/xmlns.hpp"
 
 #include "xtree/xpath.hpp"
+#include "xtree/xpath_batch.hpp"
+#include "xtree/xpath_cache.hpp"
+#include "xtree/xpath_evaluator.hpp"
+#include "xtree/xpath_executor.hpp"
+#include "xtree/xpath_function.hpp"
+#include "xtree/xpath_variables.hpp"
 #include "xtree/xpath_result.hpp"
 #include "xtree/xpath_typed_results.hpp"
 #include "xtree/node_set.hpp"
@@ -22,6 +22,8 @@ namespace xtree {
 
 
     class XTREE_DECL dom_parser;
+    class XTREE_DECL dom_push_parser;
+    class XTREE_DECL xml_reader;
 
     class XTREE_DECL node;
     class XTREE_DECL document;
@@ -38,6 +40,13 @@ namespace xtree {
     class XTREE_DECL xmlns;
 
     class XTREE_DECL xpath;
+    class XTREE_DECL xpath_batch;
+    class XTREE_DECL xpath_evaluator;
+    class XTREE_DECL xpath_executor;
+    class XTREE_DECL xpath_result_processor;
+    class XTREE_DECL xpath_function;
+    class XTREE_DECL xpath_function_args;
+    class XTREE_DECL xpath_variables;
     class XTREE_DECL xpath_result;
     class XTREE_DECL xpath_boolean;
     class XTREE_DECL xpath_number;
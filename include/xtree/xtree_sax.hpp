@@ -8,12 +8,22 @@
 
 #include "xtree/config.hpp"
 #include "xtree/xtree_sax_fwd.hpp"
+#include "xtree/basic_sax_parser.hpp"
+#include "xtree/dom_builder.hpp"
+#include "xtree/record_executor.hpp"
 
 #include "xtree/sax_attribute_list.hpp"
+#include "xtree/sax_attribute_view.hpp"
 #include "xtree/sax_error_info.hpp"
+#include "xtree/sax_event_buffer.hpp"
 #include "xtree/sax_features.hpp"
 #include "xtree/sax_handler.hpp"
 #include "xtree/sax_parser.hpp"
+#include "xtree/sax_pipeline_parser.hpp"
+#include "xtree/sax_push_parser.hpp"
+#include "xtree/sax_string_view.hpp"
+#include "xtree/stream_pattern.hpp"
+#include "xtree/subtree_splitter.hpp"
 
 
 #endif  // XTREE_XTREE_SAX_HPP_20110603__
@@ -14,8 +14,23 @@ namespace xtree {
 
 
     class XTREE_DECL sax_parser;
+    class XTREE_DECL sax_push_parser;
+    class XTREE_DECL sax_pipeline_parser;
+    class XTREE_DECL sax_event_buffer;
+    class XTREE_DECL dom_builder;
+    class XTREE_DECL subtree_splitter;
+    class XTREE_DECL subtree_handler;
+    class XTREE_DECL record_executor;
+    class XTREE_DECL record_processor;
+    class XTREE_DECL stream_pattern;
+    class XTREE_DECL stream_matcher;
+    class XTREE_DECL stream_match_handler;
+
+    template<class Handler> class basic_sax_parser;
+    template<class Derived> class basic_sax_handler;
 
     class XTREE_DECL sax_content_handler;
+    class XTREE_DECL sax_view_handler;
     class XTREE_DECL sax_error_handler;
     class XTREE_DECL sax_error_info;
     class XTREE_DECL sax_attribute;
@@ -11,6 +11,7 @@
 #include "xtree/check_rules.hpp"
 #include "xtree/basic_xmlns_ptr.hpp"
 #include "xtree/xmlns.hpp"
+#include "xtree/libxml2_callbacks.hpp"
 #include "xtree/libxml2_utility.hpp"
 
 #include <libxml/tree.h>
@@ -109,13 +110,15 @@ namespace xtree {
 
     basic_xmlns_ptr<xmlns> attribute::get_xmlns()
     {
-        return basic_xmlns_ptr<xmlns>(xmlns::get_or_create(raw()->ns));
+        detail::wrapper_arena* arena = detail::get_owner_arena(raw(), true);
+        return basic_xmlns_ptr<xmlns>(xmlns::get_or_create(raw()->ns, arena));
     }
 
 
     basic_xmlns_ptr<const xmlns> attribute::get_xmlns() const
     {
-        return basic_xmlns_ptr<const xmlns>(xmlns::get_or_create(raw()->ns));
+        detail::wrapper_arena* arena = detail::get_owner_arena(raw(), true);
+        return basic_xmlns_ptr<const xmlns>(xmlns::get_or_create(raw()->ns, arena));
     }
 
 
@@ -169,11 +172,12 @@ namespace xtree {
     {
         if (px != 0 && px->type == XML_ATTRIBUTE_NODE)
         {
-            if (px->_private == 0)
+            const void* wrapper = detail::get_or_create_private(px);
+            if (wrapper == 0)
             {
                 throw internal_dom_error("fail to cast xmlNode to attribute: _private is null");
             }
-            return static_cast<const attribute*>(px->_private);
+            return static_cast<const attribute*>(wrapper);
         }
         else
         {
@@ -191,7 +195,7 @@ namespace xtree {
     {
         if (raw()->prev != 0)
         {
-            return static_cast<const attribute*>(raw()->prev->_private);
+            return static_cast<const attribute*>(detail::get_or_create_private(raw()->prev));
         }
         else
         {
@@ -204,7 +208,7 @@ namespace xtree {
     {
         if (raw()->next != 0)
         {
-            return static_cast<const attribute*>(raw()->next->_private);
+            return static_cast<const attribute*>(detail::get_or_create_private(raw()->next));
         }
         else
         {
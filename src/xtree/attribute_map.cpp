@@ -13,6 +13,7 @@
 #include "xtree/xmlns.hpp"
 #include "xtree/check_rules.hpp"
 #include "xtree/unused_arg.hpp"
+#include "xtree/libxml2_callbacks.hpp"
 #include "xtree/libxml2_utility.hpp"
 
 #include <libxml/tree.h>
@@ -179,7 +180,7 @@ namespace xtree {
 
     const element& attribute_map::owner() const
     {
-        const element* owner = static_cast<const element*>(raw()->_private);
+        const element* owner = static_cast<const element*>(detail::get_or_create_private(raw()));
         assert(owner != 0 && "Owner element should not be null.");
         return *owner;
     }
@@ -189,7 +190,7 @@ namespace xtree {
     {
         if (raw()->properties != 0)
         {
-            return static_cast<const attribute*>(raw()->properties->_private);
+            return static_cast<const attribute*>(detail::get_or_create_private(raw()->properties));
         }
         else
         {
@@ -230,7 +231,7 @@ namespace xtree {
         const attribute* found = 0;
         for (const xmlAttr* i = raw()->properties; found == 0 && i != 0; i = i->next)
         {
-            const attribute* attr = static_cast<const attribute*>(i->_private);
+            const attribute* attr = static_cast<const attribute*>(detail::get_or_create_private(i));
             if (attr->name() == name && attr->uri() == uri)
             {
                 found = attr;
@@ -267,7 +268,7 @@ namespace xtree {
             throw internal_dom_error(what);
         }
         // Return the new attribute.
-        return static_cast<attribute*>(px->_private);
+        return static_cast<attribute*>(detail::get_or_create_private(px));
     }
 
 
@@ -0,0 +1,268 @@
+//
+// Created by ZHENG Zhong on 2011-10-14.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/basic_sax_parser.hpp"
+#include "xtree/sax_error_info.hpp"
+#include "xtree/sax_parser.hpp"  // for detail::libxml2_internal_subset()
+#include "xtree/exceptions.hpp"
+
+#include <libxml/parser.h>
+#include <libxml/parserInternals.h>  // for xmlCreateFileParserCtxt()
+#include <libxml/SAX2.h>
+#include <libxml/xmlerror.h>
+
+#include <cassert>
+#include <climits>  // for INT_MAX
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+
+namespace xtree {
+namespace detail {
+
+
+    namespace {
+
+
+        //! This class frees the libxml2 parser context being parsed when going out of scope,
+        //! even if a callback throws, and resets the pointer to it.
+        class parsing_context_guard
+        {
+
+        public:
+
+            explicit parsing_context_guard(xmlParserCtxt*& context): context_(context)
+            {
+                // Do nothing.
+            }
+
+            ~parsing_context_guard()
+            {
+                if (context_->myDoc != 0)
+                {
+                    xmlFreeDoc(context_->myDoc);
+                    context_->myDoc = 0;
+                }
+                xmlFreeParserCtxt(context_);
+                context_ = 0;
+            }
+
+        private:
+
+            //! Non-implemented copy constructor.
+            parsing_context_guard(const parsing_context_guard&);
+
+            //! Non-implemented copy assignment.
+            parsing_context_guard& operator=(const parsing_context_guard&);
+
+        private:
+
+            xmlParserCtxt*& context_;  //!< Reference to the parser context being parsed.
+
+        };
+
+
+        ////////////////////////////////////////////////////////////////////////////////////////
+        // Libxml2 callback functions handling the document type declaration: they forward the
+        // calls to libxml2's SAX2 implementation with the libxml2 parser context.
+        //
+
+
+        xmlParserCtxt* get_context(void* user_data)
+        {
+            xmlParserCtxt* context = static_cast<basic_sax_parser_base*>(user_data)->context();
+            assert(context != 0 && "libxml2 parser context should not be null during parsing");
+            return context;
+        }
+
+
+        void internal_subset(void* user_data,
+                             const xmlChar* name,
+                             const xmlChar* external_id,
+                             const xmlChar* system_id)
+        {
+            libxml2_internal_subset(get_context(user_data), name, external_id, system_id);
+        }
+
+
+        void external_subset(void* user_data,
+                             const xmlChar* name,
+                             const xmlChar* external_id,
+                             const xmlChar* system_id)
+        {
+            xmlSAX2ExternalSubset(get_context(user_data), name, external_id, system_id);
+        }
+
+
+        void entity_decl(void* user_data,
+                         const xmlChar* name,
+                         int type,
+                         const xmlChar* public_id,
+                         const xmlChar* system_id,
+                         xmlChar* content)
+        {
+            xmlSAX2EntityDecl(get_context(user_data), name, type, public_id, system_id, content);
+        }
+
+
+        xmlEntityPtr get_entity(void* user_data, const xmlChar* name)
+        {
+            return xmlSAX2GetEntity(get_context(user_data), name);
+        }
+
+
+        xmlEntityPtr get_parameter_entity(void* user_data, const xmlChar* name)
+        {
+            return xmlSAX2GetParameterEntity(get_context(user_data), name);
+        }
+
+
+        xmlParserInputPtr resolve_entity(void* user_data,
+                                         const xmlChar* public_id,
+                                         const xmlChar* system_id)
+        {
+            return xmlSAX2ResolveEntity(get_context(user_data), public_id, system_id);
+        }
+
+
+    }  // anonymous namespace
+
+
+    basic_sax_parser_base::basic_sax_parser_base(): features_(), context_(0), stopped_(false)
+    {
+        // Do nothing.
+    }
+
+
+    basic_sax_parser_base::~basic_sax_parser_base()
+    {
+        assert(context_ == 0 && "basic_sax_parser should not be destroyed during parsing");
+    }
+
+
+    void basic_sax_parser_base::stop()
+    {
+        if (context_ != 0 && !stopped_)
+        {
+            stopped_ = true;
+            xmlStopParser(context_);
+        }
+    }
+
+
+    void basic_sax_parser_base::parse_file_(const sax_callback_table& callbacks,
+                                            const std::string& file_name)
+    {
+        xmlParserCtxt* context = xmlCreateFileParserCtxt(file_name.c_str());
+        if (context == 0)
+        {
+            throw sax_error("Fail to parse " + file_name + ": unable to create parser context");
+        }
+        parse_in_context_(context, callbacks, file_name);
+    }
+
+
+    void basic_sax_parser_base::parse_buffer_(const sax_callback_table& callbacks,
+                                              const char* data,
+                                              std::size_t size)
+    {
+        if (data == 0)
+        {
+            throw sax_error("Fail to parse buffer: buffer is null");
+        }
+        if (size > static_cast<std::size_t>(INT_MAX))
+        {
+            throw sax_error("Fail to parse buffer: buffer is too large");
+        }
+        xmlParserCtxt* context = xmlCreateMemoryParserCtxt(data, static_cast<int>(size));
+        if (context == 0)
+        {
+            throw sax_error("Fail to parse buffer: unable to create parser context");
+        }
+        parse_in_context_(context, callbacks, "buffer");
+    }
+
+
+    basic_sax_parser_base::error_level_t basic_sax_parser_base::get_error_level_(
+        const xmlError* err
+    )
+    {
+        assert(err != 0);
+        switch (err->level)
+        {
+        case XML_ERR_WARNING:
+            return warning_level;
+        case XML_ERR_ERROR:
+            return error_level;
+        default:
+            // Consider any other level as a fatal error.
+            return fatal_level;
+        }
+    }
+
+
+    sax_error_info basic_sax_parser_base::get_error_info_(const xmlError* err)
+    {
+        assert(err != 0);
+        return sax_error_info(err->message, err->file, err->line, 0);
+    }
+
+
+    void basic_sax_parser_base::parse_in_context_(xmlParserCtxt* context,
+                                                  const sax_callback_table& callbacks,
+                                                  const std::string& what)
+    {
+        assert(context != 0 && context->sax != 0);
+        if (context_ != 0)
+        {
+            xmlFreeParserCtxt(context);
+            throw bad_dom_operation("basic_sax_parser does not support nested parsing");
+        }
+        // Replace the default SAX handler (owned by the parser context) with the callbacks of
+        // the handler class: the events not handled are left null, and libxml2 skips them.
+        xmlSAXHandler& sax = *context->sax;
+        std::memset(&sax, 0, sizeof(xmlSAXHandler));
+        sax.internalSubset = &internal_subset;
+        sax.externalSubset = &external_subset;
+        sax.entityDecl = &entity_decl;
+        sax.getEntity = &get_entity;
+        sax.getParameterEntity = &get_parameter_entity;
+        sax.resolveEntity = &resolve_entity;
+        sax.startDocument = callbacks.start_document;
+        sax.endDocument = callbacks.end_document;
+        sax.startElementNs = callbacks.start_element_ns;
+        sax.endElementNs = callbacks.end_element_ns;
+        sax.characters = callbacks.characters;
+        sax.cdataBlock = callbacks.cdata_block;
+        sax.ignorableWhitespace = callbacks.ignorable_whitespace;
+        sax.comment = callbacks.comment;
+        sax.serror = callbacks.structured_error;
+        sax.initialized = XML_SAX2_MAGIC;  // Use Libxml2 SAX2!
+        context->userData = this;
+        xmlCtxtUseOptions(context, to_libxml2_parser_options(features_));
+        // Parse the document. The parser context is freed even if a callback throws.
+        context_ = context;
+        stopped_ = false;
+        parsing_context_guard guard(context_);
+        xmlParseDocument(context);
+        // If the parsing has been stopped by the handler, this is not an error.
+        if (!stopped_ && !context->wellFormed)
+        {
+            std::ostringstream oss;
+            oss << "Fail to parse " << what << ": xmlParseDocument returned "
+                << (context->errNo != 0 ? context->errNo : -1);
+            throw sax_error(oss.str());
+        }
+    }
+
+
+}  // namespace xtree::detail
+}  // namespace xtree
+
@@ -7,6 +7,7 @@
 #endif
 
 #include "xtree/child_node.hpp"
+#include "xtree/libxml2_callbacks.hpp"
 #include "xtree/libxml2_utility.hpp"
 
 #include <libxml/tree.h>
@@ -75,11 +76,12 @@ namespace xtree {
                         || px->type == XML_PI_NODE
                         || px->type == XML_COMMENT_NODE) )
         {
-            if (px->_private == 0)
+            const void* wrapper = detail::get_or_create_private(px);
+            if (wrapper == 0)
             {
                 throw internal_dom_error("fail to cast xmlNode to child_node: _private is null");
             }
-            return static_cast<const child_node*>(px->_private);
+            return static_cast<const child_node*>(wrapper);
         }
         else
         {
@@ -97,7 +99,7 @@ namespace xtree {
     {
         if (raw()->prev != 0)
         {
-            return static_cast<const child_node*>(raw()->prev->_private);
+            return static_cast<const child_node*>(detail::get_or_create_private(raw()->prev));
         }
         else
         {
@@ -110,7 +112,7 @@ namespace xtree {
     {
         if (raw()->next != 0)
         {
-            return static_cast<const child_node*>(raw()->next->_private);
+            return static_cast<const child_node*>(detail::get_or_create_private(raw()->next));
         }
         else
         {
@@ -17,6 +17,7 @@
 #include "xtree/xmlns.hpp"
 
 #include "xtree/check_rules.hpp"
+#include "xtree/libxml2_callbacks.hpp"
 #include "xtree/libxml2_utility.hpp"
 
 #include <libxml/tree.h>
@@ -169,7 +170,7 @@ namespace xtree {
     {
         detail::check_qname(qname);
         xmlNode* px = insert_(end(), create_element_(qname));
-        return basic_node_ptr<element>( static_cast<element*>(px->_private) );
+        return basic_node_ptr<element>( static_cast<element*>(detail::get_or_create_private(px)) );
     }
 
 
@@ -179,7 +180,7 @@ namespace xtree {
         detail::check_qname(qname);
         detail::check_uri(uri);
         xmlNode* px = insert_(end(), create_element_(qname, uri));
-        return basic_node_ptr<element>( static_cast<element*>(px->_private) );
+        return basic_node_ptr<element>( static_cast<element*>(detail::get_or_create_private(px)) );
     }
 
 
@@ -188,28 +189,28 @@ namespace xtree {
     {
         detail::check_local_part(name);
         xmlNode* px = insert_(end(), create_element_(name, ns));
-        return basic_node_ptr<element>( static_cast<element*>(px->_private) );
+        return basic_node_ptr<element>( static_cast<element*>(detail::get_or_create_private(px)) );
     }
 
 
     basic_node_ptr<text> child_node_list::push_back_text(const std::string& value)
     {
         xmlNode* px = insert_(end(), create_text_(value));
-        return basic_node_ptr<text>( static_cast<text*>(px->_private) );
+        return basic_node_ptr<text>( static_cast<text*>(detail::get_or_create_private(px)) );
     }
 
 
     basic_node_ptr<text> child_node_list::push_back_cdata(const std::string& value)
     {
         xmlNode* px = insert_(end(), create_cdata_(value));
-        return basic_node_ptr<text>( static_cast<text*>(px->_private) );
+        return basic_node_ptr<text>( static_cast<text*>(detail::get_or_create_private(px)) );
     }
 
 
     basic_node_ptr<comment> child_node_list::push_back_comment(const std::string& value)
     {
         xmlNode* px = insert_(end(), create_comment_(value));
-        return basic_node_ptr<comment>( static_cast<comment*>(px->_private) );
+        return basic_node_ptr<comment>( static_cast<comment*>(detail::get_or_create_private(px)) );
     }
 
 
@@ -217,7 +218,9 @@ namespace xtree {
                                                                        const std::string& value)
     {
         xmlNode* px = insert_(end(), create_instruction_(target, value));
-        return basic_node_ptr<instruction>( static_cast<instruction*>(px->_private) );
+        return basic_node_ptr<instruction>(
+            static_cast<instruction*>(detail::get_or_create_private(px))
+        );
     }
 
 
@@ -225,14 +228,18 @@ namespace xtree {
     {
         xmlNode* px = child.clone_raw(true);  // recursive clone: never returns null.
         px = insert_(end(), px);
-        return basic_node_ptr<child_node>( static_cast<child_node*>(px->_private) );
+        return basic_node_ptr<child_node>(
+            static_cast<child_node*>(detail::get_or_create_private(px))
+        );
     }
 
 
     basic_node_ptr<child_node> child_node_list::push_back_adopt(child_node& child)
     {
         xmlNode* px = insert_(end(), child.raw());
-        return basic_node_ptr<child_node>( static_cast<child_node*>(px->_private) );
+        return basic_node_ptr<child_node>(
+            static_cast<child_node*>(detail::get_or_create_private(px))
+        );
     }
 
 
@@ -248,7 +255,7 @@ namespace xtree {
     {
         detail::check_qname(qname);
         xmlNode* px = insert_(begin(), create_element_(qname));
-        return basic_node_ptr<element>( static_cast<element*>(px->_private) );
+        return basic_node_ptr<element>( static_cast<element*>(detail::get_or_create_private(px)) );
     }
 
 
@@ -258,7 +265,7 @@ namespace xtree {
         detail::check_qname(qname);
         detail::check_uri(uri);
         xmlNode* px = insert_(begin(), create_element_(qname, uri));
-        return basic_node_ptr<element>( static_cast<element*>(px->_private) );
+        return basic_node_ptr<element>( static_cast<element*>(detail::get_or_create_private(px)) );
     }
 
 
@@ -267,28 +274,28 @@ namespace xtree {
     {
         detail::check_local_part(name);
         xmlNode* px = insert_(begin(), create_element_(name, ns));
-        return basic_node_ptr<element>( static_cast<element*>(px->_private) );
+        return basic_node_ptr<element>( static_cast<element*>(detail::get_or_create_private(px)) );
     }
 
 
     basic_node_ptr<text> child_node_list::push_front_text(const std::string& value)
     {
         xmlNode* px = insert_(begin(), create_text_(value));
-        return basic_node_ptr<text>( static_cast<text*>(px->_private) );
+        return basic_node_ptr<text>( static_cast<text*>(detail::get_or_create_private(px)) );
     }
 
 
     basic_node_ptr<text> child_node_list::push_front_cdata(const std::string& value)
     {
         xmlNode* px = insert_(begin(), create_cdata_(value));
-        return basic_node_ptr<text>( static_cast<text*>(px->_private) );
+        return basic_node_ptr<text>( static_cast<text*>(detail::get_or_create_private(px)) );
     }
 
 
     basic_node_ptr<comment> child_node_list::push_front_comment(const std::string& value)
     {
         xmlNode* px = insert_(begin(), create_comment_(value));
-        return basic_node_ptr<comment>( static_cast<comment*>(px->_private) );
+        return basic_node_ptr<comment>( static_cast<comment*>(detail::get_or_create_private(px)) );
     }
 
 
@@ -296,7 +303,9 @@ namespace xtree {
                                                                         const std::string& value)
     {
         xmlNode* px = insert_(begin(), create_instruction_(target, value));
-        return basic_node_ptr<instruction>( static_cast<instruction*>(px->_private) );
+        return basic_node_ptr<instruction>(
+            static_cast<instruction*>(detail::get_or_create_private(px))
+        );
     }
 
 
@@ -304,14 +313,18 @@ namespace xtree {
     {
         xmlNode* px = child.clone_raw(true);  // recursive clone: never returns null.
         px = insert_(begin(), px);
-        return basic_node_ptr<child_node>( static_cast<child_node*>(px->_private) );
+        return basic_node_ptr<child_node>(
+            static_cast<child_node*>(detail::get_or_create_private(px))
+        );
     }
 
 
     basic_node_ptr<child_node> child_node_list::push_front_adopt(child_node& child)
     {
         xmlNode* px = insert_(begin(), child.raw());
-        return basic_node_ptr<child_node>( static_cast<child_node*>(px->_private) );
+        return basic_node_ptr<child_node>(
+            static_cast<child_node*>(detail::get_or_create_private(px))
+        );
     }
 
 
@@ -366,7 +379,7 @@ namespace xtree {
     {
         detail::check_qname(qname);
         xmlNode* px = insert_(pos, create_element_(qname));
-        return basic_node_ptr<element>( static_cast<element*>(px->_private) );
+        return basic_node_ptr<element>( static_cast<element*>(detail::get_or_create_private(px)) );
     }
 
 
@@ -377,7 +390,7 @@ namespace xtree {
         detail::check_qname(qname);
         detail::check_uri(uri);
         xmlNode* px = insert_(pos, create_element_(qname, uri));
-        return basic_node_ptr<element>( static_cast<element*>(px->_private) );
+        return basic_node_ptr<element>( static_cast<element*>(detail::get_or_create_private(px)) );
     }
 
 
@@ -387,21 +400,21 @@ namespace xtree {
     {
         detail::check_local_part(name);
         xmlNode* px = insert_(pos, create_element_(name, ns));
-        return basic_node_ptr<element>( static_cast<element*>(px->_private) );
+        return basic_node_ptr<element>( static_cast<element*>(detail::get_or_create_private(px)) );
     }
 
 
     basic_node_ptr<text> child_node_list::insert_text(iterator pos, const std::string& value)
     {
         xmlNode* px = insert_(pos, create_text_(value));
-        return basic_node_ptr<text>( static_cast<text*>(px->_private) );
+        return basic_node_ptr<text>( static_cast<text*>(detail::get_or_create_private(px)) );
     }
 
 
     basic_node_ptr<text> child_node_list::insert_cdata(iterator pos, const std::string& value)
     {
         xmlNode* px = insert_(pos, create_cdata_(value));
-        return basic_node_ptr<text>( static_cast<text*>(px->_private) );
+        return basic_node_ptr<text>( static_cast<text*>(detail::get_or_create_private(px)) );
     }
 
 
@@ -409,7 +422,7 @@ namespace xtree {
                                                             const std::string& value)
     {
         xmlNode* px = insert_(pos, create_comment_(value));
-        return basic_node_ptr<comment>( static_cast<comment*>(px->_private) );
+        return basic_node_ptr<comment>( static_cast<comment*>(detail::get_or_create_private(px)) );
     }
 
 
@@ -418,7 +431,9 @@ namespace xtree {
                                                                     const std::string& value)
     {
         xmlNode* px = insert_(pos, create_instruction_(target, value));
-        return basic_node_ptr<instruction>( static_cast<instruction*>(px->_private) );
+        return basic_node_ptr<instruction>(
+            static_cast<instruction*>(detail::get_or_create_private(px))
+        );
     }
 
 
@@ -426,7 +441,7 @@ namespace xtree {
     {
         xmlNode* px = child.clone_raw(true);  // recursive clone: never returns null.
         px = insert_(pos, px);
-        return iterator( static_cast<child_node*>(px->_private) );
+        return iterator( static_cast<child_node*>(detail::get_or_create_private(px)) );
     }
 
 
@@ -436,7 +451,7 @@ namespace xtree {
         {
             xmlNode* px = i->clone_raw(true);  // recursive clone: never returns null.
             px = insert_(pos, px);
-            pos = iterator( static_cast<child_node*>(px->_private) );
+            pos = iterator( static_cast<child_node*>(detail::get_or_create_private(px)) );
             ++pos;
         }
     }
@@ -445,7 +460,7 @@ namespace xtree {
     child_node_list::iterator child_node_list::insert_adopt(iterator pos, child_node& child)
     {
         xmlNode* px = insert_(pos, child.raw());
-        return iterator( static_cast<child_node*>(px->_private) );
+        return iterator( static_cast<child_node*>(detail::get_or_create_private(px)) );
     }
 
 
@@ -454,7 +469,7 @@ namespace xtree {
         for (iterator i = first; i != last; )
         {
             xmlNode* px = insert_(pos, (i++)->raw());
-            pos = iterator( static_cast<child_node*>(px->_private) );
+            pos = iterator( static_cast<child_node*>(detail::get_or_create_private(px)) );
             ++pos;
         }
     }
@@ -517,7 +532,7 @@ namespace xtree {
     {
         if (raw_->type == XML_ELEMENT_NODE)
         {
-            return static_cast<const element*>(raw_->_private);
+            return static_cast<const element*>(detail::get_or_create_private(raw_));
         }
         else
         {
@@ -530,7 +545,7 @@ namespace xtree {
     {
         if (raw_->children != 0)
         {
-            return static_cast<const child_node*>(raw_->children->_private);
+            return static_cast<const child_node*>(detail::get_or_create_private(raw_->children));
         }
         else
         {
@@ -552,6 +567,16 @@ namespace xtree {
     {
         // Check the ownership of the iterator parameter.
         check_ownership_(pos);
+        // If the child node is adopted from another document, keep its wrappers alive.
+        if ( child->doc != 0
+          && child->doc != raw_->doc
+          && child->doc->_private != 0
+          && raw_->doc != 0
+          && raw_->doc->_private != 0 )
+        {
+            document* target = static_cast<document*>(raw_->doc->_private);
+            target->share_wrapper_arena(*static_cast<const document*>(child->doc->_private));
+        }
         // Unlink the child node from its previous owner.
         xmlUnlinkNode(child);
         // Insert the libxml2 node to this child node list.
@@ -7,6 +7,7 @@
 #endif
 
 #include "xtree/comment.hpp"
+#include "xtree/libxml2_callbacks.hpp"
 
 #include <libxml/tree.h>
 #include <cassert>
@@ -32,11 +33,12 @@ namespace xtree {
     {
         if (px != 0 && px->type == XML_COMMENT_NODE)
         {
-            if (px->_private == 0)
+            const void* wrapper = detail::get_or_create_private(px);
+            if (wrapper == 0)
             {
                 throw internal_dom_error("fail to cast xmlNode to comment: _private is null");
             }
-            return static_cast<const comment*>(px->_private);
+            return static_cast<const comment*>(wrapper);
         }
         else
         {
@@ -21,6 +21,9 @@
 #include "xtree/node_set.hpp"
 
 #include "xtree/check_rules.hpp"
+#include "xtree/wrapper_arena.hpp"
+#include "xtree/libxml2_memory.hpp"
+#include "xtree/libxml2_callbacks.hpp"
 #include "xtree/libxml2_utility.hpp"
 
 #include <libxml/tree.h>
@@ -39,7 +42,10 @@ namespace xtree {
     //! \{
 
 
-    document::document(xmlDoc* px): node(reinterpret_cast<xmlNode*>(px)), children_(px)
+    document::document(xmlDoc* px): node(reinterpret_cast<xmlNode*>(px))
+                                  , children_(px)
+                                  , arena_(0)
+                                  , region_(0)
     {
         px->_private = this;
     }
@@ -47,9 +53,19 @@ namespace xtree {
 
     document::~document()
     {
+        // Detach this document from the libxml2 document before freeing it: the node wrappers
+        // allocated from the arena are then dropped without being destructed and freed one by
+        // one, since the whole arena is released afterwards.
         xmlDoc* px = raw_doc();
         px->_private = 0;
         xmlFreeDoc(px);
+        if (arena_ != 0)
+        {
+            arena_->release();
+            arena_ = 0;
+        }
+        detail::release_memory_region(region_);
+        region_ = 0;
     }
 
 
@@ -193,6 +209,14 @@ namespace xtree {
     }
 
 
+    void document::eval(const xpath& expr, const xpath_variables& vars, xpath_result& result)
+    {
+        detail::xpath_context context(raw_doc(), 0);
+        context.set_variables(&vars);
+        context.eval(expr, result);
+    }
+
+
     bool document::eval_boolean(const xpath& expr) const
     {
         xpath_boolean result;
@@ -229,6 +253,47 @@ namespace xtree {
     //! \}
 
 
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    //! \name Node Wrapper Memory Management
+    //! \{
+
+
+    detail::wrapper_arena* document::get_wrapper_arena()
+    {
+        if (arena_ == 0)
+        {
+            arena_ = detail::wrapper_arena::create();
+        }
+        return arena_;
+    }
+
+
+    void document::share_wrapper_arena(const document& source)
+    {
+        if (&source != this && source.arena_ != 0)
+        {
+            get_wrapper_arena()->retain(source.arena_);
+        }
+    }
+
+
+    void document::attach_wrapper_arena(detail::wrapper_arena* arena)
+    {
+        assert(arena_ == 0 && "document should not have a wrapper arena yet");
+        arena_ = arena;
+    }
+
+
+    void document::attach_memory_region(detail::memory_region* region)
+    {
+        assert(region_ == 0 && "document should not have a memory region attached yet");
+        region_ = region;
+    }
+
+
+    //! \}
+
+
     ////////////////////////////////////////////////////////////////////////////////////////////////
     //! \name Private Functions
     //! \{
@@ -239,7 +304,7 @@ namespace xtree {
         const xmlNode* px = xmlDocGetRootElement( const_cast<xmlDoc*>(raw_doc()) );
         if (px != 0)
         {
-            return static_cast<const element*>(px->_private);
+            return static_cast<const element*>(detail::get_or_create_private(px));
         }
         else
         {
@@ -251,6 +316,11 @@ namespace xtree {
     basic_node_ptr<element> document::reset_root_(xmlNode* px)
     {
         assert(px != 0 && px->type == XML_ELEMENT_NODE);
+        // If the element is adopted from another document, keep its wrappers alive.
+        if (px->doc != 0 && px->doc != raw_doc() && px->doc->_private != 0)
+        {
+            share_wrapper_arena(*static_cast<const document*>(px->doc->_private));
+        }
         // Reset root element, and free the old one.
         xmlNode* px_old = xmlDocSetRootElement(raw_doc(), px);
         if (px_old != 0)
@@ -266,7 +336,7 @@ namespace xtree {
             throw internal_dom_error("fail to reconciliate xmlns on the root element");
         }
         // Return the new root element.
-        return basic_node_ptr<element>( static_cast<element*>(px->_private) );
+        return basic_node_ptr<element>( static_cast<element*>(detail::get_or_create_private(px)) );
     }
 
 
@@ -308,12 +378,17 @@ namespace xtree {
 
     std::auto_ptr<document> clone_document(const document& doc)
     {
+        detail::memory_region_scope region_scope;
+        detail::wrapper_arena_scope arena_scope;
         xmlDoc* px = xmlCopyDoc(const_cast<xmlDoc*>(doc.raw_doc()), 1);
         if (px == 0)
         {
             throw internal_dom_error("fail to clone libxml2 document: xmlCopyDoc() returned null");
         }
-        return std::auto_ptr<document>(new document(px));
+        std::auto_ptr<document> cloned(new document(px));
+        cloned->attach_wrapper_arena(arena_scope.detach());
+        cloned->attach_memory_region(region_scope.detach());
+        return cloned;
     }
 
 
@@ -0,0 +1,292 @@
+//
+// Created by ZHENG Zhong on 2011-10-17.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/dom_builder.hpp"
+#include "xtree/document.hpp"
+#include "xtree/exceptions.hpp"
+#include "xtree/sax_attribute_list.hpp"
+#include "xtree/libxml2_utility.hpp"
+#include "xtree/wrapper_arena.hpp"
+
+#include <libxml/tree.h>
+
+#include <memory>
+#include <string>
+
+
+namespace xtree {
+
+
+    namespace {
+
+
+        //! The namespace URI of the namespace declaration attributes.
+        const char* const XMLNS_URI = "http://www.w3.org/2000/xmlns/";
+
+
+    }  // anonymous namespace
+
+
+    dom_builder::dom_builder(): doc_(0), current_(0), arena_(0)
+    {
+        // Do nothing.
+    }
+
+
+    dom_builder::~dom_builder()
+    {
+        free_document_();
+    }
+
+
+    std::auto_ptr<document> dom_builder::release()
+    {
+        if (doc_ == 0)
+        {
+            throw bad_dom_operation("fail to release document: no document has been built");
+        }
+        std::auto_ptr<document> doc(new document(doc_));
+        doc->attach_wrapper_arena(arena_);
+        doc_ = 0;
+        current_ = 0;
+        arena_ = 0;
+        return doc;
+    }
+
+
+    void dom_builder::start_document()
+    {
+        free_document_();
+        arena_ = detail::wrapper_arena::create();
+        doc_ = xmlNewDoc(detail::to_xml_chars("1.0"));
+        if (doc_ == 0)
+        {
+            throw internal_dom_error("fail to create libxml2 document: xmlNewDoc returned null");
+        }
+    }
+
+
+    void dom_builder::end_document()
+    {
+        if (current_ != 0)
+        {
+            throw bad_dom_operation("fail to build document: some elements are not closed");
+        }
+    }
+
+
+    void dom_builder::start_element(const std::string& name,
+                                    const std::string& prefix,
+                                    const std::string& uri,
+                                    const sax_attribute_list& attrs)
+    {
+        if (doc_ == 0)
+        {
+            start_document();
+        }
+        if (current_ == 0 && xmlDocGetRootElement(doc_) != 0)
+        {
+            throw bad_dom_operation("fail to build document: more than one root element");
+        }
+        detail::wrapper_arena_scope arena_scope(arena_);
+        xmlNode* px = xmlNewDocNode(doc_, 0, detail::to_xml_chars(name.c_str()), 0);
+        if (px == 0)
+        {
+            std::string what = "fail to create libxml2 element node for " + name;
+            throw internal_dom_error(what);
+        }
+        append_(px);
+        current_ = px;
+        // Namespace declarations reported as attributes (see the namespace_prefixes feature) are
+        // declared on the element first, so that the element and its attributes may use them.
+        for (sax_attribute_list::const_iterator i = attrs.begin(); i != attrs.end(); ++i)
+        {
+            if (i->uri() == XMLNS_URI)
+            {
+                declare_xmlns_(i->prefix().empty() ? std::string() : i->name(), i->value());
+            }
+        }
+        // Put the element under its namespace. If the element is not under any namespace while
+        // a default namespace is in scope, undeclare the default namespace.
+        if (!uri.empty())
+        {
+            xmlSetNs(px, get_xmlns_(prefix, uri));
+        }
+        else if (prefix.empty())
+        {
+            xmlNs* ns = xmlSearchNs(doc_, px, 0);
+            if (ns != 0 && ns->href != 0 && ns->href[0] != '\0')
+            {
+                xmlNewNs(px, detail::to_xml_chars(""), 0);
+            }
+        }
+        // Create the attributes. Unprefixed attributes are never under any namespace.
+        for (sax_attribute_list::const_iterator i = attrs.begin(); i != attrs.end(); ++i)
+        {
+            if (i->uri() == XMLNS_URI)
+            {
+                continue;
+            }
+            xmlNs* ns = ( (i->prefix().empty() || i->uri().empty())
+                        ? 0
+                        : get_xmlns_(i->prefix(), i->uri()) );
+            xmlAttr* attr = xmlNewNsProp( px,
+                                          ns,
+                                          detail::to_xml_chars(i->name().c_str()),
+                                          detail::to_xml_chars(i->value().c_str()) );
+            if (attr == 0)
+            {
+                std::string what = "fail to create attribute " + i->name()
+                                 + ": xmlNewNsProp returned null";
+                throw internal_dom_error(what);
+            }
+        }
+    }
+
+
+    void dom_builder::end_element(const std::string& name,
+                                  const std::string&,
+                                  const std::string&)
+    {
+        if (current_ == 0)
+        {
+            std::string what = "fail to build document: unexpected end of element " + name;
+            throw bad_dom_operation(what);
+        }
+        current_ = (current_->parent != 0 && current_->parent->type == XML_ELEMENT_NODE)
+                 ? current_->parent
+                 : 0;
+    }
+
+
+    void dom_builder::characters(const char* chars, int length)
+    {
+        if (current_ != 0)
+        {
+            detail::wrapper_arena_scope arena_scope(arena_);
+            xmlNode* px = xmlNewDocTextLen(doc_, detail::to_xml_chars(chars), length);
+            if (px == 0)
+            {
+                throw internal_dom_error("fail to create libxml2 text node");
+            }
+            append_(px);  // Adjacent text nodes are merged by libxml2.
+        }
+    }
+
+
+    void dom_builder::cdata_block(const char* chars, int length)
+    {
+        if (current_ != 0)
+        {
+            detail::wrapper_arena_scope arena_scope(arena_);
+            xmlNode* px = xmlNewCDataBlock(doc_, detail::to_xml_chars(chars), length);
+            if (px == 0)
+            {
+                throw internal_dom_error("fail to create libxml2 CDATA node");
+            }
+            append_(px);
+        }
+    }
+
+
+    void dom_builder::ignorable_whitespace(const char* chars, int length)
+    {
+        characters(chars, length);
+    }
+
+
+    void dom_builder::comment(const char* chars)
+    {
+        if (doc_ == 0)
+        {
+            start_document();
+        }
+        detail::wrapper_arena_scope arena_scope(arena_);
+        xmlNode* px = xmlNewDocComment(doc_, detail::to_xml_chars(chars));
+        if (px == 0)
+        {
+            throw internal_dom_error("fail to create libxml2 comment node");
+        }
+        append_(px);
+    }
+
+
+    void dom_builder::free_document_()
+    {
+        // The wrappers allocated from the arena are dropped with the libxml2 document, and their
+        // memory is released together with the arena.
+        if (doc_ != 0)
+        {
+            xmlFreeDoc(doc_);
+            doc_ = 0;
+        }
+        if (arena_ != 0)
+        {
+            arena_->release();
+            arena_ = 0;
+        }
+        current_ = 0;
+    }
+
+
+    void dom_builder::append_(xmlNode* px)
+    {
+        xmlNode* added = ( current_ != 0
+                         ? xmlAddChild(current_, px)
+                         : xmlAddChild(reinterpret_cast<xmlNode*>(doc_), px) );
+        if (added == 0)
+        {
+            xmlFreeNode(px);
+            throw internal_dom_error("fail to build document: xmlAddChild returned null");
+        }
+    }
+
+
+    void dom_builder::declare_xmlns_(const std::string& prefix, const std::string& uri)
+    {
+        // The xml prefix is bound implicitly, and libxml2 refuses to declare it.
+        if (prefix == "xml")
+        {
+            return;
+        }
+        const xmlChar* xml_prefix = (prefix.empty() ? 0 : detail::to_xml_chars(prefix.c_str()));
+        for (xmlNs* ns = current_->nsDef; ns != 0; ns = ns->next)
+        {
+            if (xmlStrEqual(ns->prefix, xml_prefix))
+            {
+                return;
+            }
+        }
+        if (xmlNewNs(current_, detail::to_xml_chars(uri.c_str()), xml_prefix) == 0)
+        {
+            std::string what = "fail to declare libxml2 namespace " + prefix + "=" + uri;
+            throw internal_dom_error(what);
+        }
+    }
+
+
+    xmlNs* dom_builder::get_xmlns_(const std::string& prefix, const std::string& uri)
+    {
+        const xmlChar* xml_prefix = (prefix.empty() ? 0 : detail::to_xml_chars(prefix.c_str()));
+        xmlNs* ns = xmlSearchNs(doc_, current_, xml_prefix);
+        if (ns != 0 && ns->href != 0 && uri == detail::to_chars(ns->href))
+        {
+            return ns;
+        }
+        ns = xmlNewNs(current_, detail::to_xml_chars(uri.c_str()), xml_prefix);
+        if (ns == 0)
+        {
+            std::string what = "fail to create libxml2 namespace for " + prefix + "=" + uri;
+            throw internal_dom_error(what);
+        }
+        return ns;
+    }
+
+
+}  // namespace xtree
+
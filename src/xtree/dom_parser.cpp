@@ -11,14 +11,19 @@
 #include "xtree/basic_node_ptr.hpp"
 #include "xtree/exceptions.hpp"
 #include "xtree/libxml2_utility.hpp"
+#include "xtree/libxml2_memory.hpp"
+#include "xtree/mapped_file.hpp"
+#include "xtree/wrapper_arena.hpp"
 
-#include <libxml/globals.h>          // used by set_global_variables
 #include <libxml/nanohttp.h>         // for xmlNanoHTTPScanProxy()
 #include <libxml/parserInternals.h>  // for xmlCreateFileParserCtxt()
 #include <libxml/parser.h>
+#include <libxml/SAX2.h>             // for xmlSAXVersion()
 #include <libxml/tree.h>
 
 #include <cassert>
+#include <climits>  // for INT_MAX
+#include <cstddef>
 #include <cstdlib>  // for std::getenv()
 #include <cstring>
 #include <memory>
@@ -29,59 +34,60 @@
 namespace xtree {
 
 
-    namespace {
-
+    namespace detail {
 
-        //! This class manages the libxml2's global variables. On construction, it saves the
-        //! original values and sets the values that we want. On destruction, it restores the
-        //! original values.
-        class set_global_variables
+        void init_dom_parser_context(xmlParserCtxt* context, int options)
         {
-
-        public:
-
-            explicit set_global_variables(): indent_tree_output_(0), keep_blanks_default_(0)
+            assert(context != 0 && "init_dom_parser_context() called with null parser context");
+            // Restore the default SAX2 handler first: xmlCtxtUseOptions() only alters the handler
+            // for the options given, so the options of a previous parsing might remain.
+            if (context->sax != 0)
             {
-                indent_tree_output_  = xmlIndentTreeOutput;
-                keep_blanks_default_ = xmlKeepBlanksDefault(0);
+                xmlSAXVersion(context->sax, 2);
             }
-
-            //! Destructor: restores the original value to libxml2.
-            ~set_global_variables()
+            xmlCtxtUseOptions(context, options);
+            if (context->sax != 0)
             {
-                xmlIndentTreeOutput = indent_tree_output_;
-                xmlKeepBlanksDefault(keep_blanks_default_);
+                context->sax->warning = 0;  // Shut up for all warnings.
+                context->sax->error   = 0;  // Shut up for all errors.
             }
+            context->_private         = 0;  // Private data: not so necessary at this moment.
+            context->linenumbers      = 1;  // Set line number (this is the default anyway).
+            context->validate         = 0;  // Turn off validation.
+            context->vctxt.error      = 0;  // Clear the validator's error callback.
+            context->vctxt.warning    = 0;  // Clear the validator's warning callback.
+        }
 
-        private:
-
-            //! Non-implemented copy constructor.
-            set_global_variables(const set_global_variables&);
-
-            //! Non-implemented copy assignment.
-            set_global_variables& operator=(const set_global_variables&);
-
-        private:
+    }  // namespace xtree::detail
 
-            int indent_tree_output_;   //!< Original value for whether to keep blank nodes.
-            int keep_blanks_default_;  //!< Original value for indent tree output.
 
-        };
+    namespace {
 
 
+        //! This class manages a libxml2 parser context used for DOM parsing. On destruction, the
+        //! parser context is freed, or reset if it is reusable.
         class dom_parser_context_wrapper
         {
 
         public:
 
-            explicit dom_parser_context_wrapper(xmlParserCtxt* px): raw_(px)
+            explicit dom_parser_context_wrapper(xmlParserCtxt* px, bool reusable = false)
+                : raw_(px)
+                , reusable_(reusable)
             {
                 // Do nothing.
             }
 
             ~dom_parser_context_wrapper()
             {
-                if (raw_ != 0)
+                if (raw_ != 0 && reusable_)
+                {
+                    // Free the inputs and the document if any, but keep the dictionary.
+                    raw_->_private = 0;
+                    xmlCtxtReset(raw_);
+                    raw_ = 0;
+                }
+                else if (raw_ != 0)
                 {
                     raw_->_private = 0;
                     if (raw_->myDoc != 0)
@@ -99,6 +105,74 @@ namespace xtree {
                 return raw_;
             }
 
+            //! Prepares the parser context to parse an XML file: pushes the file as the input of
+            //! the reusable parser context, or creates a new parser context if not reusable.
+            //! \return true on success, false on failure.
+            bool open_file(const std::string& file_name)
+            {
+                if (!reusable_)
+                {
+                    assert(raw_ == 0);
+                    raw_ = xmlCreateFileParserCtxt(file_name.c_str());
+                    return (raw_ != 0);
+                }
+                xmlParserInput* input = xmlLoadExternalEntity(file_name.c_str(), 0, raw_);
+                if (input == 0)
+                {
+                    return false;
+                }
+                inputPush(raw_, input);
+                return true;
+            }
+
+            //! Prepares the parser context to parse a file mapped to memory: pushes the mapped file
+            //! as the input of the parser context, creating a new parser context if not reusable.
+            //! \return true on success, false on failure.
+            bool open_mapped_file(detail::mapped_file& file, const std::string& file_name)
+            {
+                if (!reusable_)
+                {
+                    assert(raw_ == 0);
+                    raw_ = xmlNewParserCtxt();
+                    if (raw_ == 0)
+                    {
+                        return false;
+                    }
+                }
+                return file.push_input(raw_, file_name);
+            }
+
+            //! Prepares the parser context to parse a memory block: pushes the memory block as
+            //! the input of the reusable parser context, or creates a new parser context if not
+            //! reusable. The memory block does not need to be null-terminated. Note that libxml2
+            //! (before 2.11) relies on a null-terminated input, so the memory block is not wrapped
+            //! by a static input buffer: it is copied once to the input buffer of libxml2.
+            //! \return true on success, false on failure.
+            bool open_memory(const char* str, int size)
+            {
+                if (!reusable_)
+                {
+                    assert(raw_ == 0);
+                    raw_ = xmlCreateMemoryParserCtxt(str, size);
+                    return (raw_ != 0);
+                }
+                xmlParserInputBuffer* buffer = xmlParserInputBufferCreateMem(
+                    str, size, XML_CHAR_ENCODING_NONE
+                );
+                if (buffer == 0)
+                {
+                    return false;
+                }
+                xmlParserInput* input = xmlNewIOInputStream(raw_, buffer, XML_CHAR_ENCODING_NONE);
+                if (input == 0)
+                {
+                    xmlFreeParserInputBuffer(buffer);
+                    return false;
+                }
+                inputPush(raw_, input);
+                return true;
+            }
+
         private:
 
             //! Non-implemented copy constructor.
@@ -109,44 +183,22 @@ namespace xtree {
 
         private:
 
-            xmlParserCtxt* raw_;
+            xmlParserCtxt* raw_;       //!< The libxml2 parser context.
+            bool           reusable_;  //!< Whether the parser context is reused.
 
         };
 
 
-        //! Deactivate any non-standards-compliant libxml1 features. These are deactivated by
-        //! default, but if we don't deactivate them for each context then some other code which
-        //! uses a global function, such as xmlKeepBlanksDefault(), could cause this to use the
-        //! wrong settings.
-        //! \param context  the libxml2 parser context to initialize.
-        void init_dom_parser_context(xmlParserCtxt* context)
-        {
-            assert(context != 0 && "init_dom_parser_context() called with null parser context");
-            if (context->sax != 0)
-            {
-                context->sax->warning = 0;  // Shut up for all warnings.
-                context->sax->error   = 0;  // Shut up for all errors.
-            }
-            context->_private         = 0;  // Private data: not so necessary at this moment.
-            context->linenumbers      = 1;  // Set line number (this is the default anyway).
-            context->validate         = 0;  // Turn off validation.
-            context->vctxt.error      = 0;  // Clear the validator's error callback.
-            context->vctxt.warning    = 0;  // Clear the validator's warning callback.
-            context->replaceEntities  = 1;  // Replace entities automatically.
-        }
-
-
         //! Parse an xml document under the libxml2 parser context, and returns the _xmlDoc object.
         //! \param context  the libxml2 parser context under which the xml document is parsed.
+        //! \param options  the libxml2 parser options (a combination of xmlParserOption).
         //! \return pointer to _xmlDoc object, never null.
         //! \throws dom_error if the XML is not well-formed, or if an error occurs.
-        xmlDoc* parse_in_context(xmlParserCtxt* context)
+        xmlDoc* parse_in_context(xmlParserCtxt* context, int options)
         {
             assert(context != 0 && "parse_in_context() called with null parser context");
-            // Overwrite global configuration value.
-            set_global_variables global_variables;
             // Initialize libxml2 parser context.
-            init_dom_parser_context(context);
+            detail::init_dom_parser_context(context, options);
             // Parse xml document under the parser context and check return code.
             int ret_code = xmlParseDocument(context);
             if (ret_code != 0 || context->errNo != 0)
@@ -207,7 +259,11 @@ namespace xtree {
     //
 
 
-    dom_parser::dom_parser()
+    dom_parser::dom_parser(): keep_blanks_(false)
+                            , substitute_entities_(true)
+                            , load_external_dtd_(true)
+                            , memory_map_(false)
+                            , context_(0)
     {
         // Do nothing.
     }
@@ -215,16 +271,79 @@ namespace xtree {
 
     dom_parser::~dom_parser()
     {
-        // Do nothing.
+        if (context_ != 0)
+        {
+            xmlFreeParserCtxt(context_);
+            context_ = 0;
+        }
+    }
+
+
+    void dom_parser::set_keep_blanks(bool flag)
+    {
+        keep_blanks_ = flag;
+    }
+
+
+    bool dom_parser::get_keep_blanks() const
+    {
+        return keep_blanks_;
+    }
+
+
+    void dom_parser::set_substitute_entities(bool flag)
+    {
+        substitute_entities_ = flag;
+    }
+
+
+    bool dom_parser::get_substitute_entities() const
+    {
+        return substitute_entities_;
+    }
+
+
+    void dom_parser::set_load_external_dtd(bool flag)
+    {
+        load_external_dtd_ = flag;
+    }
+
+
+    bool dom_parser::get_load_external_dtd() const
+    {
+        return load_external_dtd_;
+    }
+
+
+    void dom_parser::set_memory_map(bool flag)
+    {
+        memory_map_ = flag;
+    }
+
+
+    bool dom_parser::get_memory_map() const
+    {
+        return memory_map_;
     }
 
 
     std::auto_ptr<document> dom_parser::parse_file(const std::string& file_name)
     {
-        set_global_variables global_variables;
-        // Create a libxml2 parser context for parsing the xml file.
-        dom_parser_context_wrapper context( xmlCreateFileParserCtxt(file_name.c_str()) );
-        if (context.get() == 0)
+        // Allocate the libxml2 document from a memory region if document regions are enabled.
+        detail::memory_region_scope region_scope;
+        // Allocate the node wrappers created while parsing from the document's wrapper arena.
+        detail::wrapper_arena_scope arena_scope;
+        // Map the xml file to memory if required. Compressed files are left to libxml2's file
+        // reader. The mapped file should outlive the parser context.
+        detail::mapped_file mapped;
+        bool use_mapped = ( memory_map_ && mapped.open(file_name) && !mapped.compressed() );
+        // Prepare a libxml2 parser context for parsing the xml file.
+        dom_parser_context_wrapper context( reusable_context_(region_scope),
+                                            !region_scope.active() );
+        bool opened = ( use_mapped
+                      ? context.open_mapped_file(mapped, file_name)
+                      : context.open_file(file_name) );
+        if (!opened)
         {
             std::string what = "fail to parse xml file " + file_name + ": "
                              + "unable to create libxml2 parser context";
@@ -232,44 +351,74 @@ namespace xtree {
         }
         if (context.get()->directory == 0)
         {
-            const xmlChar* dir = detail::to_xml_chars(xmlParserGetDirectory(file_name.c_str()));
-            context.get()->directory = const_cast<char*>(detail::to_chars(xmlStrdup(dir)));
+            context.get()->directory = xmlParserGetDirectory(file_name.c_str());
         }
         // Parse xml file under the constructed parser context.
-        xmlDoc* px = parse_in_context(context.get());
+        xmlDoc* px = parse_in_context(context.get(), options_());
         assert(px != 0);
-        return std::auto_ptr<document>(new document(px));
+        std::auto_ptr<document> doc(new document(px));
+        doc->attach_wrapper_arena(arena_scope.detach());
+        doc->attach_memory_region(region_scope.detach());
+        return doc;
     }
 
 
     std::auto_ptr<document> dom_parser::parse_string(const char* str)
     {
-        set_global_variables global_variables;
-        // Create a libxml2 parser context for parsing the xml string.
         if (str == 0)
         {
             throw dom_error("fail to parse xml string: string is null");
         }
-        int size = static_cast<int>(std::strlen(str));
+        std::size_t size = std::strlen(str);
         if (size == 0)
         {
             throw dom_error("fail to parse xml string: string is empty");
         }
-        dom_parser_context_wrapper context( xmlCreateMemoryParserCtxt(str, size) );
-        if (context.get() == 0)
+        return parse_buffer(str, size);
+    }
+
+
+    std::auto_ptr<document> dom_parser::parse_buffer(const char* data, std::size_t size)
+    {
+        // Allocate the libxml2 document from a memory region if document regions are enabled.
+        detail::memory_region_scope region_scope;
+        // Allocate the node wrappers created while parsing from the document's wrapper arena.
+        detail::wrapper_arena_scope arena_scope;
+        // Prepare a libxml2 parser context for parsing the xml buffer.
+        if (data == 0)
+        {
+            throw dom_error("fail to parse xml buffer: buffer is null");
+        }
+        if (size == 0)
+        {
+            throw dom_error("fail to parse xml buffer: buffer is empty");
+        }
+        if (size > static_cast<std::size_t>(INT_MAX))
         {
-            throw dom_error("Fail to parse xml string: unable to create libxml2 parser context");
+            throw dom_error("fail to parse xml buffer: buffer is too large");
         }
-        // Parse xml string under the constructed parser context.
-        xmlDoc* px = parse_in_context(context.get());
+        dom_parser_context_wrapper context( reusable_context_(region_scope),
+                                            !region_scope.active() );
+        if (!context.open_memory(data, static_cast<int>(size)))
+        {
+            throw dom_error("Fail to parse xml buffer: unable to create libxml2 parser context");
+        }
+        // Parse xml buffer under the constructed parser context.
+        xmlDoc* px = parse_in_context(context.get(), options_());
         assert(px != 0);
-        return std::auto_ptr<document>(new document(px));
+        std::auto_ptr<document> doc(new document(px));
+        doc->attach_wrapper_arena(arena_scope.detach());
+        doc->attach_memory_region(region_scope.detach());
+        return doc;
     }
 
 
     std::auto_ptr<document> dom_parser::parse_url(const std::string& url, const std::string& proxy)
     {
-        set_global_variables global_variables;
+        // Allocate the libxml2 document from a memory region if document regions are enabled.
+        detail::memory_region_scope region_scope;
+        // Allocate the node wrappers created while parsing from the document's wrapper arena.
+        detail::wrapper_arena_scope arena_scope;
         // Create a libxml2 parser context for parsing the xml string.
         if (url.empty())
         {
@@ -284,9 +433,77 @@ namespace xtree {
             throw dom_error("Fail to parse remote xml: unable to create libxml2 parser context");
         }
         // Parse remote xml under the constructed parser context.
-        xmlDoc* px = parse_in_context(context.get());
+        xmlDoc* px = parse_in_context(context.get(), options_());
         assert(px != 0);
-        return std::auto_ptr<document>(new document(px));
+        std::auto_ptr<document> doc(new document(px));
+        doc->attach_wrapper_arena(arena_scope.detach());
+        doc->attach_memory_region(region_scope.detach());
+        return doc;
+    }
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // thread-local DOM parser
+    //
+
+
+#ifdef XTREE_HAS_CXX11
+
+
+    dom_parser& get_thread_dom_parser()
+    {
+        thread_local dom_parser parser;
+        return parser;
+    }
+
+
+#endif  // XTREE_HAS_CXX11
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // dom_parser :: private functions
+    //
+
+
+    xmlParserCtxt* dom_parser::reusable_context_(const detail::memory_region_scope& region_scope)
+    {
+        // When the document is allocated from a memory region, do not reuse the parser context:
+        // its dictionary and buffers would keep the memory region alive.
+        if (region_scope.active())
+        {
+            return 0;
+        }
+        if (context_ == 0)
+        {
+            context_ = xmlNewParserCtxt();
+            if (context_ == 0)
+            {
+                throw internal_dom_error("fail to create libxml2 parser context");
+            }
+        }
+        return context_;
+    }
+
+
+    int dom_parser::options_() const
+    {
+        // Do not intern element and attribute names in the document's dictionary: nodes may be
+        // moved to another document (see reset_root_adopt() or push_back_adopt()), and libxml2
+        // does not copy the names out of the dictionary of the source document in this case.
+        int options = XML_PARSE_NODICT;
+        if (!keep_blanks_)
+        {
+            options |= XML_PARSE_NOBLANKS;
+        }
+        if (substitute_entities_)
+        {
+            options |= XML_PARSE_NOENT;
+        }
+        if (load_external_dtd_)
+        {
+            options |= XML_PARSE_DTDLOAD;
+        }
+        return options;
     }
 
 
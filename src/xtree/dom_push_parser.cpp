@@ -0,0 +1,172 @@
+//
+// Created by ZHENG Zhong on 2011-10-08.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/dom_push_parser.hpp"
+#include "xtree/dom_parser.hpp"
+#include "xtree/document.hpp"
+#include "xtree/exceptions.hpp"
+#include "xtree/libxml2_utility.hpp"
+#include "xtree/wrapper_arena.hpp"
+
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+
+#include <algorithm>
+#include <cassert>
+#include <climits>  // for INT_MAX
+#include <cstddef>
+#include <memory>
+#include <string>
+
+
+namespace xtree {
+
+
+    dom_push_parser::dom_push_parser(): options_(dom_parser().options_())
+                                      , context_(0)
+                                      , started_(false)
+                                      , arena_(0)
+    {
+        // Do nothing.
+    }
+
+
+    dom_push_parser::dom_push_parser(const dom_parser& parser): options_(parser.options_())
+                                                              , context_(0)
+                                                              , started_(false)
+                                                              , arena_(0)
+    {
+        // Do nothing.
+    }
+
+
+    dom_push_parser::~dom_push_parser()
+    {
+        reset();
+        if (context_ != 0)
+        {
+            xmlFreeParserCtxt(context_);
+            context_ = 0;
+        }
+    }
+
+
+    void dom_push_parser::feed(const char* data, std::size_t size)
+    {
+        if (data == 0 && size > 0)
+        {
+            throw dom_error("fail to parse xml chunk: chunk is null");
+        }
+        if (!started_)
+        {
+            start_();
+        }
+        // xmlParseChunk() takes the chunk size as an int: split the chunk if it is too large.
+        while (size > 0)
+        {
+            std::size_t chunk_size = std::min(size, static_cast<std::size_t>(INT_MAX));
+            parse_chunk_(data, static_cast<int>(chunk_size), false);
+            data += chunk_size;
+            size -= chunk_size;
+        }
+    }
+
+
+    std::auto_ptr<document> dom_push_parser::finish()
+    {
+        if (!started_)
+        {
+            throw dom_error("fail to parse xml chunks: nothing has been fed");
+        }
+        parse_chunk_(0, 0, true);
+        if (context_->myDoc == 0)
+        {
+            reset();
+            throw dom_error("fail to parse xml chunks: null document returned");
+        }
+        // Take the xml document parsed, and reset the parser context for the next document.
+        xmlDoc* px = context_->myDoc;
+        detail::wrapper_arena* arena = arena_;
+        context_->myDoc = 0;
+        arena_ = 0;
+        reset();
+        std::auto_ptr<document> doc(new document(px));
+        doc->attach_wrapper_arena(arena);
+        return doc;
+    }
+
+
+    void dom_push_parser::reset()
+    {
+        if (context_ != 0)
+        {
+            if (context_->myDoc != 0)
+            {
+                xmlFreeDoc(context_->myDoc);
+                context_->myDoc = 0;
+            }
+            // Free the inputs but keep the parser context (and its dictionary) for reuse.
+            xmlCtxtReset(context_);
+        }
+        // The wrappers allocated from the arena have been dropped with the libxml2 document.
+        if (arena_ != 0)
+        {
+            arena_->release();
+            arena_ = 0;
+        }
+        started_ = false;
+    }
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // private functions
+    //
+
+
+    void dom_push_parser::start_()
+    {
+        assert(!started_);
+        if (context_ == 0)
+        {
+            context_ = xmlCreatePushParserCtxt(0, 0, 0, 0, 0);
+            if (context_ == 0)
+            {
+                throw internal_dom_error("fail to create libxml2 push parser context");
+            }
+        }
+        else if (xmlCtxtResetPush(context_, 0, 0, 0, 0) != 0)
+        {
+            throw internal_dom_error("fail to reset libxml2 push parser context");
+        }
+        detail::init_dom_parser_context(context_, options_);
+        arena_ = detail::wrapper_arena::create();
+        started_ = true;
+    }
+
+
+    void dom_push_parser::parse_chunk_(const char* data, int size, bool terminate)
+    {
+        assert(started_ && context_ != 0);
+        int ret_code = 0;
+        {
+            // Allocate the node wrappers created while parsing from the document's arena.
+            detail::wrapper_arena_scope arena_scope(arena_);
+            ret_code = xmlParseChunk(context_, data, size, (terminate ? 1 : 0));
+        }
+        if (ret_code != 0 || context_->errNo != 0)
+        {
+            std::string what = "fail to parse xml chunk using libxml2: "
+                             + detail::build_error_message(context_->lastError);
+            reset();
+            throw dom_error(what);
+        }
+    }
+
+
+}  // namespace xtree
+
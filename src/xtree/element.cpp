@@ -17,6 +17,7 @@
 #include "xtree/node_set.hpp"
 
 #include "xtree/check_rules.hpp"
+#include "xtree/libxml2_callbacks.hpp"
 #include "xtree/libxml2_utility.hpp"
 
 #include <libxml/tree.h>
@@ -171,13 +172,15 @@ namespace xtree {
 
     basic_xmlns_ptr<xmlns> element::get_xmlns()
     {
-        return basic_xmlns_ptr<xmlns>(xmlns::get_or_create(raw()->ns));
+        detail::wrapper_arena* arena = detail::get_owner_arena(raw(), true);
+        return basic_xmlns_ptr<xmlns>(xmlns::get_or_create(raw()->ns, arena));
     }
 
 
     basic_xmlns_ptr<const xmlns> element::get_xmlns() const
     {
-        return basic_xmlns_ptr<const xmlns>(xmlns::get_or_create(raw()->ns));
+        detail::wrapper_arena* arena = detail::get_owner_arena(raw(), true);
+        return basic_xmlns_ptr<const xmlns>(xmlns::get_or_create(raw()->ns, arena));
     }
 
 
@@ -214,6 +217,14 @@ namespace xtree {
     }
 
 
+    void element::eval(const xpath& expr, const xpath_variables& vars, xpath_result& result)
+    {
+        detail::xpath_context context(raw()->doc, raw());
+        context.set_variables(&vars);
+        context.eval(expr, result);
+    }
+
+
     bool element::eval_boolean(const xpath& expr) const
     {
         xpath_boolean result;
@@ -259,11 +270,12 @@ namespace xtree {
     {
         if (px != 0 && px->type == XML_ELEMENT_NODE)
         {
-            if (px->_private == 0)
+            const void* wrapper = detail::get_or_create_private(px);
+            if (wrapper == 0)
             {
                 throw internal_dom_error("fail to cast xmlNode to element: _private is null");
             }
-            return static_cast<const element*>(px->_private);
+            return static_cast<const element*>(wrapper);
         }
         else
         {
@@ -283,7 +295,8 @@ namespace xtree {
                                           : detail::to_chars(i->prefix) );
             if (declared_prefix == prefix)
             {
-                return std::make_pair(xmlns::get_or_create(i), false);
+                xmlns* declared = xmlns::get_or_create(i, detail::get_owner_arena(raw(), true));
+                return std::make_pair(declared, false);
             }
         }
         // Create (declare) a new libxml2 xmlNs on the element.
@@ -304,13 +317,13 @@ namespace xtree {
             throw internal_dom_error("fail to reconciliate xmlns on this element");
         }
         // Return the libxml2 xmlNs.
-        return std::make_pair(xmlns::get_or_create(px), true);
+        return std::make_pair(xmlns::get_or_create(px, detail::get_owner_arena(raw(), true)), true);
     }
 
 
     const xmlns* element::get_first_xmlns_() const
     {
-        return xmlns::get_or_create(raw()->nsDef);
+        return xmlns::get_or_create(raw()->nsDef, detail::get_owner_arena(raw(), true));
     }
 
 
@@ -319,7 +332,7 @@ namespace xtree {
         xmlNs* px = xmlSearchNs( raw()->doc,
                                  const_cast<xmlNode*>(raw()),
                                  prefix.empty() ? 0 : detail::to_xml_chars(prefix.c_str()) );
-        return xmlns::get_or_create(px);
+        return xmlns::get_or_create(px, detail::get_owner_arena(raw(), true));
     }
 
 
@@ -328,53 +341,48 @@ namespace xtree {
         xmlNs* px = xmlSearchNsByHref( raw()->doc,
                                        const_cast<xmlNode*>(raw()),
                                        detail::to_xml_chars(uri.c_str()) );
-        return xmlns::get_or_create(px);
+        return xmlns::get_or_create(px, detail::get_owner_arena(raw(), true));
     }
 
 
     const element* element::find_first_elem_() const
     {
-        const element* found = 0;
-        for (const xmlNode* i = raw()->children; found == 0 && i != 0; i = i->next)
+        const xmlNode* i = raw()->children;
+        while (i != 0 && i->type != XML_ELEMENT_NODE)
         {
-            if (i->type == XML_ELEMENT_NODE)
-            {
-                found = static_cast<const element*>(i->_private);
-            }
+            i = i->next;
         }
-        return found;
+        return (i != 0 ? static_cast<const element*>(detail::get_or_create_private(i)) : 0);
     }
 
 
     const element* element::find_last_elem_() const
     {
-        const element* found = 0;
+        // Locate the last libxml2 element first, so that no wrapper is created for the elements
+        // we only pass by (see lazy node wrappers).
+        const xmlNode* last = 0;
         for (const xmlNode* i = raw()->children; i != 0; i = i->next)
         {
             if (i->type == XML_ELEMENT_NODE)
             {
-                found = static_cast<const element*>(i->_private);
+                last = i;
             }
         }
-        return found;
+        return (last != 0 ? static_cast<const element*>(detail::get_or_create_private(last)) : 0);
     }
 
 
     const element* element::find_elem_by_name_(const std::string& name) const
     {
-        const element* found = 0;
-        for (const xmlNode* i = raw()->children; found == 0 && i != 0; i = i->next)
+        const xmlChar* raw_name = detail::to_xml_chars(name.c_str());
+        for (const xmlNode* i = raw()->children; i != 0; i = i->next)
         {
-            if (i->type == XML_ELEMENT_NODE)
+            if (i->type == XML_ELEMENT_NODE && xmlStrEqual(i->name, raw_name))
             {
-                const element* child = static_cast<const element*>(i->_private);
-                if (child->name() == name)
-                {
-                    found = child;
-                }
+                return static_cast<const element*>(detail::get_or_create_private(i));
             }
         }
-        return found;
+        return 0;
     }
 
 
@@ -392,13 +400,12 @@ namespace xtree {
         const element* found = 0;
         for (const xmlNode* i = raw()->children; found == 0 && i != 0; i = i->next)
         {
-            if (i->type == XML_ELEMENT_NODE)
+            if (i->type == XML_ELEMENT_NODE && detail::to_chars(i->name) == name)
             {
-                const element* child = static_cast<const element*>(i->_private);
-                if (child->name() == name)
-                {
-                    found = child->find_elem_by_path_(rest);
-                }
+                const element* child =
+                    static_cast<const element*>(detail::get_or_create_private(i));
+
+                found = child->find_elem_by_path_(rest);
             }
         }
         return found;
@@ -407,19 +414,19 @@ namespace xtree {
 
     const element* element::find_elem_(const std::string& name, const std::string& uri) const
     {
-        const element* found = 0;
-        for (const xmlNode* i = raw()->children; found == 0 && i != 0; i = i->next)
+        const xmlChar* raw_name = detail::to_xml_chars(name.c_str());
+        for (const xmlNode* i = raw()->children; i != 0; i = i->next)
         {
-            if (i->type == XML_ELEMENT_NODE)
+            if (i->type == XML_ELEMENT_NODE && xmlStrEqual(i->name, raw_name))
             {
-                const element* child = static_cast<const element*>(i->_private);
-                if (child->name() == name && child->uri() == uri)
+                const xmlChar* href = (i->ns != 0 ? i->ns->href : 0);
+                if (uri == (href != 0 ? detail::to_chars(href) : ""))
                 {
-                    found = child;
+                    return static_cast<const element*>(detail::get_or_create_private(i));
                 }
             }
         }
-        return found;
+        return 0;
     }
 
 
@@ -432,7 +439,7 @@ namespace xtree {
         }
         if (prev != 0)
         {
-            return static_cast<const element*>(prev->_private);
+            return static_cast<const element*>(detail::get_or_create_private(prev));
         }
         else
         {
@@ -450,7 +457,7 @@ namespace xtree {
         }
         if (next != 0)
         {
-            return static_cast<const element*>(next->_private);
+            return static_cast<const element*>(detail::get_or_create_private(next));
         }
         else
         {
@@ -7,6 +7,7 @@
 #endif
 
 #include "xtree/instruction.hpp"
+#include "xtree/libxml2_callbacks.hpp"
 
 #include <libxml/tree.h>
 #include <string>
@@ -31,11 +32,12 @@ namespace xtree {
     {
         if (px != 0 && px->type == XML_PI_NODE)
         {
-            if (px->_private == 0)
+            const void* wrapper = detail::get_or_create_private(px);
+            if (wrapper == 0)
             {
                 throw internal_dom_error("fail to cast xmlNode to instruction: _private is null");
             }
-            return static_cast<const instruction*>(px->_private);
+            return static_cast<const instruction*>(wrapper);
         }
         else
         {
@@ -7,12 +7,15 @@
 #endif
 
 #include "xtree/libxml2_callbacks.hpp"
+#include "xtree/libxml2_globals.hpp"
 #include "xtree/attribute.hpp"
 #include "xtree/element.hpp"
 #include "xtree/text.hpp"
 #include "xtree/comment.hpp"
 #include "xtree/instruction.hpp"
+#include "xtree/document.hpp"
 #include "xtree/xmlns.hpp"
+#include "xtree/wrapper_arena.hpp"
 
 #include <libxml/tree.h>
 #include <cassert>
@@ -25,6 +28,36 @@ namespace detail {
     namespace {
 
 
+        //! Creates the wrapper object for a libxml2 node. The wrapper is allocated from the arena
+        //! of the document owning the node, or of the document being parsed, if any; or from the
+        //! heap otherwise.
+        //! \param px  the libxml2 node to wrap.
+        //! \return the wrapper object, or null if the node type is not supported.
+        void* create_private(xmlNode* px)
+        {
+            wrapper_arena* arena = get_owner_arena(px, true);
+            switch (px->type)
+            {
+            case XML_ATTRIBUTE_NODE:
+                return new_wrapper<attribute>(arena, px);
+            case XML_ELEMENT_NODE:
+                return new_wrapper<element>(arena, px);
+            case XML_TEXT_NODE:
+            case XML_CDATA_SECTION_NODE:
+                return new_wrapper<text>(arena, px);
+            case XML_COMMENT_NODE:
+                return new_wrapper<comment>(arena, px);
+            case XML_PI_NODE:
+                return new_wrapper<instruction>(arena, px);
+                //case XML_DTD_NODE:
+                //case XML_ENTITY_REF_NODE:
+            default:
+                // TODO: Unsupported node types.
+                return 0;
+            }
+        }
+
+
         template<class T>
         void delete_private(xmlNode* px)
         {
@@ -33,7 +66,7 @@ namespace detail {
             {
                 for (xmlNs* ns = px->nsDef; ns != 0; ns = ns->next)
                 {
-                    xmlns::delete_private(ns);
+                    xmlns::delete_private(ns, get_owner_arena(px, false));
                 }
             }
             // Delete the wrapper object for this node.
@@ -43,7 +76,7 @@ namespace detail {
             // pointer to be non-null.
             if (wrapper != 0)
             {
-                delete wrapper;
+                delete_wrapper(wrapper, get_owner_arena(px, false));
                 px->_private = 0;
             }
         }
@@ -55,35 +88,32 @@ namespace detail {
     ////////////////////////////////////////////////////////////////////////////////////////////////
 
 
+    wrapper_arena* get_owner_arena(const xmlNode* px, bool create)
+    {
+        if (px->doc == 0 || px->doc->_private == 0)
+        {
+            // The node is being built (e.g. parsed): libxml2 may not have set its document yet,
+            // and the document is not wrapped yet.
+            return wrapper_arena_scope::current(create);
+        }
+        document* owner = static_cast<document*>(px->doc->_private);
+        return (create ? owner->get_wrapper_arena() : owner->find_wrapper_arena());
+    }
+
+
+    wrapper_arena* get_owner_arena(const xmlAttr* px, bool create)
+    {
+        return get_owner_arena(reinterpret_cast<const xmlNode*>(px), create);
+    }
+
+
     void on_node_construct(xmlNode* px)
     {
-        switch (px->type)
+        // Document wrapper will be created by the parser. If lazy node wrappers are enabled, the
+        // other wrappers will be created on first access by get_or_create_private().
+        if (px->type != XML_DOCUMENT_NODE && !libxml2_globals::get_lazy_node_wrappers())
         {
-        case XML_DOCUMENT_NODE:
-            // Do nothing: the document wrapper will be created by the parser.
-            break;
-        case XML_ATTRIBUTE_NODE:
-            px->_private = new attribute(px);
-            break;
-        case XML_ELEMENT_NODE:
-            px->_private = new element(px);
-            break;
-        case XML_TEXT_NODE:
-        case XML_CDATA_SECTION_NODE:
-            px->_private = new text(px);
-            break;
-        case XML_COMMENT_NODE:
-            px->_private = new comment(px);
-            break;
-        case XML_PI_NODE:
-            px->_private = new instruction(px);
-            break;
-            //case XML_DTD_NODE:
-            //case XML_ENTITY_REF_NODE:
-        default:
-            // TODO: Unsupported node types.
-            px->_private = 0;
-            break;
+            px->_private = create_private(px);
         }
     }
 
@@ -119,6 +149,26 @@ namespace detail {
     }
 
 
+    void* get_or_create_private(const xmlNode* px)
+    {
+        assert(px != 0 && "get_or_create_private() called with null node");
+        // The wrapper is merely a cache attached to the libxml2 node: creating it on demand does
+        // not change the logical state of the node, so we cast away the constness here.
+        xmlNode* mutable_px = const_cast<xmlNode*>(px);
+        if (mutable_px->_private == 0 && mutable_px->type != XML_DOCUMENT_NODE)
+        {
+            mutable_px->_private = create_private(mutable_px);
+        }
+        return mutable_px->_private;
+    }
+
+
+    void* get_or_create_private(const xmlAttr* px)
+    {
+        return get_or_create_private(reinterpret_cast<const xmlNode*>(px));
+    }
+
+
 } // namespace xtree::detail
 } // namespace xtree
 
@@ -22,6 +22,26 @@ namespace detail {
     }
 
 
+    void libxml2_globals::initialize(libxml2_allocator_t allocator)
+    {
+        // The allocator should be installed before libxml2 allocates any memory.
+        set_allocator(allocator);
+        instance();
+    }
+
+
+    void libxml2_globals::set_allocator(libxml2_allocator_t allocator)
+    {
+        install_libxml2_allocator(allocator);
+    }
+
+
+    libxml2_allocator_t libxml2_globals::get_allocator()
+    {
+        return get_libxml2_allocator();
+    }
+
+
     void libxml2_globals::set_cleanup_parser(bool flag)
     {
         instance().cleanup_parser_ = flag;
@@ -34,11 +54,37 @@ namespace detail {
     }
 
 
+    void libxml2_globals::set_lazy_node_wrappers(bool flag)
+    {
+        instance().lazy_node_wrappers_ = flag;
+    }
+
+
+    bool libxml2_globals::get_lazy_node_wrappers()
+    {
+        return instance().lazy_node_wrappers_;
+    }
+
+
+    void libxml2_globals::set_document_regions(bool flag)
+    {
+        instance().document_regions_ = flag;
+    }
+
+
+    bool libxml2_globals::get_document_regions()
+    {
+        return instance().document_regions_;
+    }
+
+
     libxml2_globals::libxml2_globals(): old_register_node_fn_(0)
                                       , old_deregister_node_fn_(0)
                                       , old_thr_def_register_node_fn_(0)
                                       , old_thr_def_deregister_node_fn_(0)
                                       , cleanup_parser_(false)
+                                      , lazy_node_wrappers_(false)
+                                      , document_regions_(false)
     {
         // Initialize libxml2 resources.
         LIBXML_TEST_VERSION;
@@ -48,9 +94,8 @@ namespace detail {
         old_deregister_node_fn_ = xmlDeregisterNodeDefault(&on_node_destruct);
         old_thr_def_register_node_fn_ = xmlThrDefRegisterNodeDefault(&on_node_construct);
         old_thr_def_deregister_node_fn_ = xmlThrDefDeregisterNodeDefault(&on_node_destruct);
-        // Libxml2 global initialization.
-        xmlSubstituteEntitiesDefault(1);
-        xmlLoadExtDtdDefaultValue = 1;
+        // Note: parsing options (such as entity substitution) are NOT set through libxml2's
+        // global variables, but applied to each parser context by the parsers.
     }
 
 
@@ -98,6 +143,30 @@ namespace xtree {
     }
 
 
+    void initialize_libxml2(libxml2_allocator_t allocator)
+    {
+        detail::libxml2_globals::initialize(allocator);
+    }
+
+
+    void set_libxml2_allocator(libxml2_allocator_t allocator)
+    {
+        detail::libxml2_globals::set_allocator(allocator);
+    }
+
+
+    libxml2_allocator_t get_libxml2_allocator()
+    {
+        return detail::libxml2_globals::get_allocator();
+    }
+
+
+    libxml2_memory_stats get_libxml2_memory_stats()
+    {
+        return detail::get_libxml2_memory_stats();
+    }
+
+
     void set_libxml2_cleanup_parser(bool flag)
     {
         detail::libxml2_globals::set_cleanup_parser(flag);
@@ -110,6 +179,30 @@ namespace xtree {
     }
 
 
+    void set_lazy_node_wrappers(bool flag)
+    {
+        detail::libxml2_globals::set_lazy_node_wrappers(flag);
+    }
+
+
+    bool get_lazy_node_wrappers()
+    {
+        return detail::libxml2_globals::get_lazy_node_wrappers();
+    }
+
+
+    void set_libxml2_document_regions(bool flag)
+    {
+        detail::libxml2_globals::set_document_regions(flag);
+    }
+
+
+    bool get_libxml2_document_regions()
+    {
+        return detail::libxml2_globals::get_document_regions();
+    }
+
+
 }  // namespace xtree
 
 
@@ -0,0 +1,937 @@
+//
+// Created by ZHENG Zhong on 2011-09-27.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/libxml2_memory.hpp"
+#include "xtree/libxml2_globals.hpp"
+#include "xtree/exceptions.hpp"
+
+#include <libxml/xmlmemory.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifdef XTREE_HAS_CXX11
+#  include <atomic>
+#  include <cstdint>
+#  include <mutex>
+#endif
+
+
+namespace xtree {
+namespace detail {
+
+
+#ifdef XTREE_HAS_CXX11
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // pool allocator internals
+    //
+    // Small memory blocks (up to max_small_size bytes) are carved out of 64KB slabs, each slab
+    // being dedicated to one size class. Freed blocks are cached in a per-thread free list for
+    // each size class, and batches of blocks are moved between the thread caches and the central
+    // free lists (one mutex per size class) as necessary. Larger blocks go to malloc/free.
+    //
+    // A page map (a two-level radix tree indexed by slab addresses, like tcmalloc's) records the
+    // size class of every slab, so that the size class of a block can be found on free/realloc.
+    // A block which does not belong to any slab is a block allocated by malloc, either before
+    // the pool allocator is installed or because it is a large block: it is released by free().
+    //
+
+
+    namespace {
+
+
+        const std::size_t slab_shift = 16;
+        const std::size_t slab_size = static_cast<std::size_t>(1) << slab_shift;
+        const std::size_t slabs_per_chunk = 16;
+
+        const std::size_t small_class_count = 28;
+        const std::size_t max_small_size = 1024;
+        const std::size_t max_cache_bytes = 32 * 1024;
+
+        const std::size_t max_region_block_size = 4096;
+        const std::size_t region_block_header_size = 16;
+        const std::size_t region_slab_header_size = 16;
+        const unsigned char region_tag = 0xFF;
+
+        const unsigned int address_bits = (sizeof(void*) == 8 ? 48 : 32);
+        const unsigned int leaf_bits = 16;
+        const unsigned int root_bits = address_bits - slab_shift - leaf_bits;
+
+
+        //! Returns the size class index of a small memory block: sizes up to 256 bytes are
+        //! rounded up to multiples of 16, and sizes up to 1024 bytes to multiples of 64.
+        inline std::size_t size_class(std::size_t size)
+        {
+            assert(size > 0 && size <= max_small_size);
+            return (size <= 256 ? (size + 15) / 16 - 1 : 15 + (size - 256 + 63) / 64);
+        }
+
+
+        //! Returns the block size of a size class.
+        inline std::size_t class_size(std::size_t index)
+        {
+            assert(index < small_class_count);
+            return (index < 16 ? (index + 1) * 16 : 256 + (index - 15) * 64);
+        }
+
+
+        //! Returns the maximum number of blocks of a size class kept in a thread cache.
+        inline std::size_t max_cached_count(std::size_t index)
+        {
+            std::size_t count = max_cache_bytes / class_size(index);
+            return (count < 16 ? 16 : (count > 256 ? 256 : count));
+        }
+
+
+        //! Rounds up a size to a multiple of 16.
+        inline std::size_t align16(std::size_t size)
+        {
+            return (size + 15) & ~static_cast<std::size_t>(15);
+        }
+
+
+        //! Increments a counter owned by the calling thread (other threads may read it).
+        inline void bump(std::atomic<unsigned long long>& counter, unsigned long long value)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + value,
+                          std::memory_order_relaxed);
+        }
+
+
+        struct free_block
+        {
+            free_block* next;
+        };
+
+
+        struct memory_counters
+        {
+            std::atomic<unsigned long long> allocations;
+            std::atomic<unsigned long long> deallocations;
+            std::atomic<unsigned long long> reallocations;
+            std::atomic<unsigned long long> allocated_bytes;
+        };
+
+
+        struct thread_cache
+        {
+            free_block*     heads[small_class_count];   //!< Cached free blocks per size class.
+            std::size_t     counts[small_class_count];  //!< Number of cached free blocks.
+            memory_counters counters;                   //!< Statistics of this thread.
+            thread_cache*   prev;
+            thread_cache*   next;
+        };
+
+
+        struct central_list
+        {
+            std::mutex  mutex;
+            free_block* head;     //!< Free blocks returned by the thread caches.
+            char*       current;  //!< Current position in the slab being carved.
+            char*       limit;    //!< End of the slab being carved.
+        };
+
+
+        struct pool_state
+        {
+            std::mutex      slab_mutex;      //!< Guards the slabs and the page map leaves.
+            free_block*     free_slabs;      //!< Slabs released by memory regions.
+            char*           chunk_current;   //!< Current position in the chunk being carved.
+            char*           chunk_limit;     //!< End of the chunk being carved.
+            central_list    centrals[small_class_count];
+            std::mutex      stats_mutex;     //!< Guards the thread cache registry.
+            thread_cache*   caches;          //!< Registered thread caches.
+            memory_counters retired;         //!< Statistics of the threads gone.
+            std::atomic<unsigned long long> reserved_bytes;
+            std::atomic<unsigned long long> regions;
+        };
+
+
+        struct page_map_leaf
+        {
+            std::atomic<unsigned char> tags[static_cast<std::size_t>(1) << leaf_bits];
+        };
+
+
+        //! The page map root. A slab tag is 0 if the slab does not belong to the pool, the size
+        //! class index plus 1 for a slab of small blocks, or region_tag for a region slab.
+        std::atomic<page_map_leaf*> page_map_root[static_cast<std::size_t>(1) << root_bits];
+
+
+        //! The pool allocator state, created on installation and never destroyed: libxml2 may
+        //! free memory until the very end of the process.
+        pool_state* pool = 0;
+
+
+        //! The thread cache of the calling thread. This pointer is trivially destructible, so it
+        //! remains usable after the thread-local objects are destroyed at thread exit.
+        thread_local thread_cache* current_cache = 0;
+
+        //! Whether the thread cache of the calling thread has been destroyed (at thread exit).
+        thread_local bool cache_destroyed = false;
+
+        //! The current memory region of the calling thread.
+        thread_local memory_region* current_region = 0;
+
+
+        inline std::uintptr_t slab_index(const void* p)
+        {
+            return reinterpret_cast<std::uintptr_t>(p) >> slab_shift;
+        }
+
+
+        inline bool is_mappable(std::uintptr_t index)
+        {
+            return (static_cast<unsigned long long>(index) >> (root_bits + leaf_bits)) == 0;
+        }
+
+
+        //! Returns the tag of the slab containing a memory block.
+        unsigned char find_tag(const void* p)
+        {
+            std::uintptr_t index = slab_index(p);
+            if (!is_mappable(index))
+            {
+                return 0;
+            }
+            page_map_leaf* leaf = page_map_root[index >> leaf_bits].load(std::memory_order_acquire);
+            if (leaf == 0)
+            {
+                return 0;
+            }
+            const std::size_t mask = (static_cast<std::size_t>(1) << leaf_bits) - 1;
+            return leaf->tags[index & mask].load(std::memory_order_acquire);
+        }
+
+
+        //! Sets the tag of a slab. The slab mutex should be locked by the caller.
+        bool set_tag(const char* slab, unsigned char tag)
+        {
+            std::uintptr_t index = slab_index(slab);
+            assert(is_mappable(index));
+            std::atomic<page_map_leaf*>& root = page_map_root[index >> leaf_bits];
+            page_map_leaf* leaf = root.load(std::memory_order_relaxed);
+            if (leaf == 0)
+            {
+                leaf = new (std::nothrow) page_map_leaf();
+                if (leaf == 0)
+                {
+                    return false;
+                }
+                root.store(leaf, std::memory_order_release);
+            }
+            const std::size_t mask = (static_cast<std::size_t>(1) << leaf_bits) - 1;
+            leaf->tags[index & mask].store(tag, std::memory_order_release);
+            return true;
+        }
+
+
+        //! Acquires a slab from the system (or from the slabs released by memory regions), and
+        //! tags it in the page map.
+        //! \return the slab, or null if fail to allocate memory.
+        char* acquire_slab(unsigned char tag)
+        {
+            std::lock_guard<std::mutex> lock(pool->slab_mutex);
+            char* slab = 0;
+            if (pool->free_slabs != 0)
+            {
+                slab = reinterpret_cast<char*>(pool->free_slabs);
+                pool->free_slabs = pool->free_slabs->next;
+            }
+            else
+            {
+                if (pool->chunk_current == pool->chunk_limit)
+                {
+                    std::size_t chunk_size = slab_size * (slabs_per_chunk + 1);
+                    char* raw = static_cast<char*>(std::malloc(chunk_size));
+                    if (raw == 0)
+                    {
+                        return 0;
+                    }
+                    std::uintptr_t first = (reinterpret_cast<std::uintptr_t>(raw) + slab_size - 1)
+                                         & ~static_cast<std::uintptr_t>(slab_size - 1);
+                    std::uintptr_t last = first + slab_size * slabs_per_chunk - 1;
+                    if (!is_mappable(last >> slab_shift))
+                    {
+                        std::free(raw);
+                        return 0;
+                    }
+                    pool->chunk_current = reinterpret_cast<char*>(first);
+                    pool->chunk_limit = pool->chunk_current + slab_size * slabs_per_chunk;
+                    pool->reserved_bytes.fetch_add(chunk_size, std::memory_order_relaxed);
+                }
+                slab = pool->chunk_current;
+                pool->chunk_current += slab_size;
+            }
+            if (!set_tag(slab, tag))
+            {
+                free_block* block = reinterpret_cast<free_block*>(slab);
+                block->next = pool->free_slabs;
+                pool->free_slabs = block;
+                return 0;
+            }
+            return slab;
+        }
+
+
+        //! Releases a slab so that it can be reused for another size class or region.
+        void release_slab(char* slab)
+        {
+            std::lock_guard<std::mutex> lock(pool->slab_mutex);
+            set_tag(slab, 0);
+            free_block* block = reinterpret_cast<free_block*>(slab);
+            block->next = pool->free_slabs;
+            pool->free_slabs = block;
+        }
+
+
+        //! Fetches a batch of free blocks of a size class from the central free list, carving new
+        //! blocks out of slabs as necessary.
+        //! \param index    the size class index.
+        //! \param count    the number of blocks wanted.
+        //! \param fetched  output: the number of blocks actually fetched.
+        //! \return the linked list of blocks fetched, or null if fail to allocate memory.
+        free_block* fetch_blocks(std::size_t index, std::size_t count, std::size_t& fetched)
+        {
+            central_list& central = pool->centrals[index];
+            const std::size_t size = class_size(index);
+            std::lock_guard<std::mutex> lock(central.mutex);
+            free_block* head = 0;
+            fetched = 0;
+            while (fetched < count && central.head != 0)
+            {
+                free_block* block = central.head;
+                central.head = block->next;
+                block->next = head;
+                head = block;
+                ++fetched;
+            }
+            while (fetched < count)
+            {
+                if (static_cast<std::size_t>(central.limit - central.current) < size)
+                {
+                    char* slab = acquire_slab(static_cast<unsigned char>(index + 1));
+                    if (slab == 0)
+                    {
+                        break;
+                    }
+                    central.current = slab;
+                    central.limit = slab + slab_size / size * size;
+                }
+                free_block* block = reinterpret_cast<free_block*>(central.current);
+                central.current += size;
+                block->next = head;
+                head = block;
+                ++fetched;
+            }
+            return head;
+        }
+
+
+        //! Returns a linked list of free blocks to the central free list.
+        void return_blocks(std::size_t index, free_block* head, free_block* tail)
+        {
+            central_list& central = pool->centrals[index];
+            std::lock_guard<std::mutex> lock(central.mutex);
+            tail->next = central.head;
+            central.head = head;
+        }
+
+
+        //! Moves a number of cached free blocks of a size class to the central free list.
+        void release_cached_blocks(thread_cache* cache, std::size_t index, std::size_t count)
+        {
+            assert(count > 0 && count <= cache->counts[index]);
+            free_block* head = cache->heads[index];
+            free_block* tail = head;
+            for (std::size_t i = 1; i < count; ++i)
+            {
+                tail = tail->next;
+            }
+            cache->heads[index] = tail->next;
+            cache->counts[index] -= count;
+            return_blocks(index, head, tail);
+        }
+
+
+        void add_counters(memory_counters& to, const memory_counters& from)
+        {
+            to.allocations.fetch_add(from.allocations.load(), std::memory_order_relaxed);
+            to.deallocations.fetch_add(from.deallocations.load(), std::memory_order_relaxed);
+            to.reallocations.fetch_add(from.reallocations.load(), std::memory_order_relaxed);
+            to.allocated_bytes.fetch_add(from.allocated_bytes.load(), std::memory_order_relaxed);
+        }
+
+
+        void destroy_thread_cache(thread_cache* cache)
+        {
+            for (std::size_t index = 0; index < small_class_count; ++index)
+            {
+                if (cache->counts[index] > 0)
+                {
+                    release_cached_blocks(cache, index, cache->counts[index]);
+                }
+            }
+            std::lock_guard<std::mutex> lock(pool->stats_mutex);
+            add_counters(pool->retired, cache->counters);
+            if (cache->prev != 0)
+            {
+                cache->prev->next = cache->next;
+            }
+            else
+            {
+                pool->caches = cache->next;
+            }
+            if (cache->next != 0)
+            {
+                cache->next->prev = cache->prev;
+            }
+            delete cache;
+        }
+
+
+        //! This class destroys the thread cache of the calling thread at thread exit.
+        class thread_cache_owner
+        {
+
+        public:
+
+            explicit thread_cache_owner(): cache_(0)
+            {
+                // Do nothing.
+            }
+
+            ~thread_cache_owner()
+            {
+                current_cache = 0;
+                cache_destroyed = true;
+                if (cache_ != 0)
+                {
+                    destroy_thread_cache(cache_);
+                    cache_ = 0;
+                }
+            }
+
+            void reset(thread_cache* cache)
+            {
+                cache_ = cache;
+            }
+
+        private:
+
+            //! Non-implemented copy constructor.
+            thread_cache_owner(const thread_cache_owner&);
+
+            //! Non-implemented copy assignment.
+            thread_cache_owner& operator=(const thread_cache_owner&);
+
+        private:
+
+            thread_cache* cache_;
+
+        };
+
+
+        thread_local thread_cache_owner cache_owner;
+
+
+        //! Returns the thread cache of the calling thread, creating it on first call.
+        //! \return the thread cache, or null if the calling thread is exiting.
+        thread_cache* get_thread_cache()
+        {
+            thread_cache* cache = current_cache;
+            if (cache == 0 && !cache_destroyed)
+            {
+                cache = new (std::nothrow) thread_cache();
+                if (cache != 0)
+                {
+                    std::lock_guard<std::mutex> lock(pool->stats_mutex);
+                    cache->next = pool->caches;
+                    if (pool->caches != 0)
+                    {
+                        pool->caches->prev = cache;
+                    }
+                    pool->caches = cache;
+                }
+                cache_owner.reset(cache);
+                current_cache = cache;
+            }
+            return cache;
+        }
+
+
+        void count_allocation(std::size_t size)
+        {
+            thread_cache* cache = get_thread_cache();
+            if (cache != 0)
+            {
+                bump(cache->counters.allocations, 1);
+                bump(cache->counters.allocated_bytes, size);
+            }
+            else
+            {
+                pool->retired.allocations.fetch_add(1, std::memory_order_relaxed);
+                pool->retired.allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+            }
+        }
+
+
+        void count_reallocation(std::size_t size)
+        {
+            thread_cache* cache = get_thread_cache();
+            if (cache != 0)
+            {
+                bump(cache->counters.reallocations, 1);
+                bump(cache->counters.allocated_bytes, size);
+            }
+            else
+            {
+                pool->retired.reallocations.fetch_add(1, std::memory_order_relaxed);
+                pool->retired.allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+            }
+        }
+
+
+        void count_deallocation()
+        {
+            thread_cache* cache = get_thread_cache();
+            if (cache != 0)
+            {
+                bump(cache->counters.deallocations, 1);
+            }
+            else
+            {
+                pool->retired.deallocations.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+
+    }  // anonymous namespace
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // memory_region
+    //
+
+
+    //! This class represents a memory region: small memory blocks are carved out of slabs one
+    //! after another, and never reused. The region is reference-counted by its owner (typically
+    //! a document) and by every live memory block, so that its slabs are released once the owner
+    //! has released it and all the memory blocks have been freed. Memory blocks are allocated
+    //! by the thread which the region is current for, but they may be freed by any thread.
+    class memory_region
+    {
+
+    public:
+
+        explicit memory_region(): ref_count_(1), slabs_(0), current_(0), limit_(0)
+        {
+            // Do nothing.
+        }
+
+        void add_ref()
+        {
+            ref_count_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void release()
+        {
+            if (ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                destroy_();
+            }
+        }
+
+        //! Allocates a memory block from this region.
+        //! \return the memory block, or null if fail to allocate memory.
+        void* allocate(std::size_t size)
+        {
+            std::size_t total = region_block_header_size + align16(size);
+            if (static_cast<std::size_t>(limit_ - current_) < total)
+            {
+                char* slab = acquire_slab(region_tag);
+                if (slab == 0)
+                {
+                    return 0;
+                }
+                // The slab header records the region and links the slabs of the region.
+                reinterpret_cast<memory_region**>(slab)[0] = this;
+                reinterpret_cast<char**>(slab)[1] = slabs_;
+                slabs_ = slab;
+                current_ = slab + region_slab_header_size;
+                limit_ = slab + slab_size;
+            }
+            *reinterpret_cast<std::size_t*>(current_) = size;
+            void* p = current_ + region_block_header_size;
+            current_ += total;
+            add_ref();
+            return p;
+        }
+
+        //! Frees a memory block allocated from a region.
+        static void deallocate(void* p)
+        {
+            std::uintptr_t slab = reinterpret_cast<std::uintptr_t>(p)
+                                & ~static_cast<std::uintptr_t>(slab_size - 1);
+            reinterpret_cast<memory_region**>(slab)[0]->release();
+        }
+
+        //! Returns the size of a memory block allocated from a region.
+        static std::size_t block_size(const void* p)
+        {
+            const char* header = static_cast<const char*>(p) - region_block_header_size;
+            return *reinterpret_cast<const std::size_t*>(header);
+        }
+
+    private:
+
+        //! Non-implemented copy constructor.
+        memory_region(const memory_region&);
+
+        //! Non-implemented copy assignment.
+        memory_region& operator=(const memory_region&);
+
+        void destroy_()
+        {
+            while (slabs_ != 0)
+            {
+                char* slab = slabs_;
+                slabs_ = reinterpret_cast<char**>(slab)[1];
+                release_slab(slab);
+            }
+            delete this;
+        }
+
+    private:
+
+        std::atomic<long> ref_count_;  //!< Owner references plus live memory blocks.
+        char*             slabs_;      //!< The last slab of this region.
+        char*             current_;    //!< Current position in the last slab.
+        char*             limit_;      //!< End of the last slab.
+
+    };
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // pool allocator functions installed to libxml2
+    //
+
+
+    namespace {
+
+
+        void* allocate_(std::size_t size)
+        {
+            memory_region* region = current_region;
+            if (region != 0 && size <= max_region_block_size)
+            {
+                void* p = region->allocate(size);
+                if (p != 0)
+                {
+                    return p;
+                }
+            }
+            if (size > max_small_size)
+            {
+                return std::malloc(size);
+            }
+            std::size_t index = size_class(size);
+            thread_cache* cache = get_thread_cache();
+            free_block* block = 0;
+            if (cache != 0)
+            {
+                if (cache->heads[index] == 0)
+                {
+                    std::size_t fetched = 0;
+                    cache->heads[index] = fetch_blocks(index, max_cached_count(index) / 2, fetched);
+                    cache->counts[index] = fetched;
+                }
+                block = cache->heads[index];
+                if (block != 0)
+                {
+                    cache->heads[index] = block->next;
+                    --cache->counts[index];
+                }
+            }
+            else
+            {
+                std::size_t fetched = 0;
+                block = fetch_blocks(index, 1, fetched);
+            }
+            return (block != 0 ? block : std::malloc(size));
+        }
+
+
+        void free_(void* p)
+        {
+            unsigned char tag = find_tag(p);
+            if (tag == 0)
+            {
+                std::free(p);
+            }
+            else if (tag == region_tag)
+            {
+                memory_region::deallocate(p);
+            }
+            else
+            {
+                std::size_t index = tag - 1;
+                free_block* block = static_cast<free_block*>(p);
+                thread_cache* cache = get_thread_cache();
+                if (cache != 0)
+                {
+                    block->next = cache->heads[index];
+                    cache->heads[index] = block;
+                    if (++cache->counts[index] > max_cached_count(index))
+                    {
+                        release_cached_blocks(cache, index, cache->counts[index] / 2);
+                    }
+                }
+                else
+                {
+                    return_blocks(index, block, block);
+                }
+            }
+        }
+
+
+        void* XMLCALL pool_malloc(std::size_t size)
+        {
+            size = (size > 0 ? size : 1);
+            count_allocation(size);
+            return allocate_(size);
+        }
+
+
+        void XMLCALL pool_free(void* p)
+        {
+            if (p != 0)
+            {
+                count_deallocation();
+                free_(p);
+            }
+        }
+
+
+        void* XMLCALL pool_realloc(void* p, std::size_t size)
+        {
+            if (p == 0)
+            {
+                return pool_malloc(size);
+            }
+            size = (size > 0 ? size : 1);
+            count_reallocation(size);
+            unsigned char tag = find_tag(p);
+            if (tag == 0)
+            {
+                return std::realloc(p, size);
+            }
+            std::size_t old_size = ( tag == region_tag
+                                   ? memory_region::block_size(p)
+                                   : class_size(tag - 1) );
+            if (size <= old_size)
+            {
+                return p;
+            }
+            void* q = allocate_(size);
+            if (q != 0)
+            {
+                std::memcpy(q, p, old_size);
+                free_(p);
+            }
+            return q;
+        }
+
+
+        char* XMLCALL pool_strdup(const char* str)
+        {
+            std::size_t size = std::strlen(str) + 1;
+            char* p = static_cast<char*>(pool_malloc(size));
+            if (p != 0)
+            {
+                std::memcpy(p, str, size);
+            }
+            return p;
+        }
+
+
+        std::mutex& install_mutex()
+        {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+
+    }  // anonymous namespace
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // public functions
+    //
+
+
+    void install_libxml2_allocator(libxml2_allocator_t allocator)
+    {
+        std::lock_guard<std::mutex> lock(install_mutex());
+        if (allocator == libxml2_pool_allocator)
+        {
+            if (pool == 0)
+            {
+                // xmlGcMemSetup() installs xmlMallocAtomic together with all the functions
+                // installed by xmlMemSetup().
+                pool = new pool_state();
+                int ret_code = xmlGcMemSetup(&pool_free,
+                                             &pool_malloc,
+                                             &pool_malloc,
+                                             &pool_realloc,
+                                             &pool_strdup);
+                if (ret_code != 0)
+                {
+                    delete pool;
+                    pool = 0;
+                    throw internal_dom_error("fail to install libxml2 pool allocator");
+                }
+            }
+        }
+        else if (pool != 0)
+        {
+            throw bad_dom_operation("fail to install libxml2 allocator: pool allocator installed");
+        }
+    }
+
+
+    libxml2_allocator_t get_libxml2_allocator()
+    {
+        return (pool != 0 ? libxml2_pool_allocator : libxml2_malloc_allocator);
+    }
+
+
+    libxml2_memory_stats get_libxml2_memory_stats()
+    {
+        libxml2_memory_stats stats;
+        if (pool != 0)
+        {
+            memory_counters total = {};
+            std::lock_guard<std::mutex> lock(pool->stats_mutex);
+            add_counters(total, pool->retired);
+            for (thread_cache* cache = pool->caches; cache != 0; cache = cache->next)
+            {
+                add_counters(total, cache->counters);
+            }
+            stats.allocations = total.allocations.load();
+            stats.deallocations = total.deallocations.load();
+            stats.reallocations = total.reallocations.load();
+            stats.allocated_bytes = total.allocated_bytes.load();
+            stats.reserved_bytes = pool->reserved_bytes.load();
+            stats.regions = pool->regions.load();
+        }
+        return stats;
+    }
+
+
+    void release_memory_region(memory_region* region)
+    {
+        if (region != 0)
+        {
+            region->release();
+        }
+    }
+
+
+    memory_region_scope::memory_region_scope(): region_(0), previous_(0), detached_(false)
+    {
+        if (pool != 0 && libxml2_globals::get_document_regions())
+        {
+            region_ = new memory_region();
+            pool->regions.fetch_add(1, std::memory_order_relaxed);
+            previous_ = current_region;
+            current_region = region_;
+        }
+    }
+
+
+    memory_region_scope::~memory_region_scope()
+    {
+        if (region_ != 0)
+        {
+            current_region = previous_;
+            if (!detached_)
+            {
+                region_->release();
+            }
+            region_ = 0;
+        }
+    }
+
+
+#else  // !XTREE_HAS_CXX11
+
+
+    class memory_region
+    {
+        // Memory regions are not supported without C++11.
+    };
+
+
+    void install_libxml2_allocator(libxml2_allocator_t allocator)
+    {
+        if (allocator != libxml2_malloc_allocator)
+        {
+            throw bad_dom_operation("libxml2 pool allocator requires C++11 support");
+        }
+    }
+
+
+    libxml2_allocator_t get_libxml2_allocator()
+    {
+        return libxml2_malloc_allocator;
+    }
+
+
+    libxml2_memory_stats get_libxml2_memory_stats()
+    {
+        return libxml2_memory_stats();
+    }
+
+
+    void release_memory_region(memory_region* region)
+    {
+        assert(region == 0);
+    }
+
+
+    memory_region_scope::memory_region_scope(): region_(0), previous_(0), detached_(false)
+    {
+        // Do nothing.
+    }
+
+
+    memory_region_scope::~memory_region_scope()
+    {
+        // Do nothing.
+    }
+
+
+#endif  // XTREE_HAS_CXX11
+
+
+    memory_region* memory_region_scope::detach()
+    {
+        detached_ = true;
+        return region_;
+    }
+
+
+}  // namespace xtree::detail
+}  // namespace xtree
+
@@ -7,8 +7,10 @@
 #endif
 
 #include "xtree/libxml2_utility.hpp"
+#include "xtree/xpath_value.hpp"
 
 #include <libxml/xmlerror.h>
+#include <libxml/xpath.h>
 
 #include <sstream>
 #include <string>
@@ -947,6 +949,35 @@ namespace detail {
     }
 
 
+    void convert_xpath_result(xmlXPathObject* result, xpath_result_t type, xpath_value& value)
+    {
+        value.type = type;
+        switch (type)
+        {
+        case boolean_result:
+            value.boolean = (result != 0 && xmlXPathCastToBoolean(result) != 0);
+            break;
+        case number_result:
+            value.number = (result != 0 ? xmlXPathCastToNumber(result) : xmlXPathNAN);
+            break;
+        case string_result:
+            value.str.clear();
+            if (result != 0)
+            {
+                xmlChar* chars = xmlXPathCastToString(result);
+                if (chars != 0)
+                {
+                    value.str = to_chars(chars);
+                    xmlFree(chars);
+                }
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+
 }  // namespace xtree::detail
 }  // namespace xtree
 
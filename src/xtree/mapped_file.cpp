@@ -0,0 +1,243 @@
+//
+// Created by ZHENG Zhong on 2011-10-04.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/mapped_file.hpp"
+#include "xtree/libxml2_utility.hpp"
+
+#include <libxml/parser.h>
+#include <libxml/parserInternals.h>  // for inputPush()
+#include <libxml/uri.h>              // for xmlCanonicPath()
+#include <libxml/xmlIO.h>
+
+#ifdef XTREE_WIN32
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+
+namespace xtree {
+namespace detail {
+
+
+    mapped_file::mapped_file(): data_(0)
+                              , size_(0)
+                              , offset_(0)
+#ifdef XTREE_WIN32
+                              , file_(0)
+                              , mapping_(0)
+#endif
+    {
+        // Do nothing.
+    }
+
+
+    mapped_file::~mapped_file()
+    {
+        close();
+    }
+
+
+#ifdef XTREE_WIN32
+
+
+    bool mapped_file::open(const std::string& file_name)
+    {
+        close();
+        HANDLE file = ::CreateFileA( file_name.c_str(),
+                                     GENERIC_READ,
+                                     FILE_SHARE_READ,
+                                     0,
+                                     OPEN_EXISTING,
+                                     FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                                     0 );
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        DWORD size_high = 0;
+        DWORD size_low = ::GetFileSize(file, &size_high);
+        unsigned long long size = (static_cast<unsigned long long>(size_high) << 32) | size_low;
+        if ( (size_low == INVALID_FILE_SIZE && ::GetLastError() != NO_ERROR)
+          || size == 0
+          || size != static_cast<std::size_t>(size) )
+        {
+            ::CloseHandle(file);
+            return false;
+        }
+        HANDLE mapping = ::CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+        if (mapping == 0)
+        {
+            ::CloseHandle(file);
+            return false;
+        }
+        void* data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (data == 0)
+        {
+            ::CloseHandle(mapping);
+            ::CloseHandle(file);
+            return false;
+        }
+        file_ = file;
+        mapping_ = mapping;
+        data_ = static_cast<const char*>(data);
+        size_ = static_cast<std::size_t>(size);
+        offset_ = 0;
+        return true;
+    }
+
+
+    void mapped_file::close()
+    {
+        if (data_ != 0)
+        {
+            ::UnmapViewOfFile(data_);
+            ::CloseHandle(static_cast<HANDLE>(mapping_));
+            ::CloseHandle(static_cast<HANDLE>(file_));
+            data_ = 0;
+            size_ = 0;
+            offset_ = 0;
+            file_ = 0;
+            mapping_ = 0;
+        }
+    }
+
+
+#else  // !XTREE_WIN32
+
+
+    bool mapped_file::open(const std::string& file_name)
+    {
+        close();
+        int fd = ::open(file_name.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat st;
+        if ( ::fstat(fd, &st) != 0
+          || !S_ISREG(st.st_mode)
+          || st.st_size <= 0
+          || static_cast<unsigned long long>(st.st_size) != static_cast<std::size_t>(st.st_size) )
+        {
+            ::close(fd);
+            return false;
+        }
+        std::size_t size = static_cast<std::size_t>(st.st_size);
+        void* data = ::mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // The mapping remains valid after the file descriptor is closed.
+        ::close(fd);
+        if (data == MAP_FAILED)
+        {
+            return false;
+        }
+#ifdef MADV_SEQUENTIAL
+        // The parser reads the file once from the beginning to the end: let the kernel read
+        // ahead aggressively, and drop the pages behind.
+        ::madvise(data, size, MADV_SEQUENTIAL);
+#endif
+        data_ = static_cast<const char*>(data);
+        size_ = size;
+        offset_ = 0;
+        return true;
+    }
+
+
+    void mapped_file::close()
+    {
+        if (data_ != 0)
+        {
+            ::munmap(const_cast<char*>(data_), size_);
+            data_ = 0;
+            size_ = 0;
+            offset_ = 0;
+        }
+    }
+
+
+#endif  // XTREE_WIN32
+
+
+    bool mapped_file::compressed() const
+    {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(data_);
+        // gzip: 1F 8B.
+        if (size_ >= 2 && p[0] == 0x1F && p[1] == 0x8B)
+        {
+            return true;
+        }
+        // xz: FD 37 7A 58 5A 00.
+        if (size_ >= 6 && std::memcmp(p, "\xFD" "7zXZ\0", 6) == 0)
+        {
+            return true;
+        }
+        // lzma (legacy .lzma format, with the default properties): 5D 00 00.
+        if (size_ >= 3 && p[0] == 0x5D && p[1] == 0x00 && p[2] == 0x00)
+        {
+            return true;
+        }
+        return false;
+    }
+
+
+    bool mapped_file::push_input(xmlParserCtxt* context, const std::string& file_name)
+    {
+        assert(context != 0 && is_open());
+        offset_ = 0;
+        xmlParserInputBuffer* buffer = xmlParserInputBufferCreateIO(
+            &mapped_file::read_, 0, this, XML_CHAR_ENCODING_NONE
+        );
+        if (buffer == 0)
+        {
+            return false;
+        }
+        xmlParserInput* input = xmlNewIOInputStream(context, buffer, XML_CHAR_ENCODING_NONE);
+        if (input == 0)
+        {
+            xmlFreeParserInputBuffer(buffer);
+            return false;
+        }
+        // Set the file name so that the document URL and the base of relative URIs are known.
+        input->filename = to_chars(xmlCanonicPath(to_xml_chars(file_name.c_str())));
+        inputPush(context, input);
+        return true;
+    }
+
+
+    int mapped_file::read_(void* context, char* buffer, int len)
+    {
+        mapped_file& file = *static_cast<mapped_file*>(context);
+        if (len <= 0)
+        {
+            return 0;
+        }
+        std::size_t count = std::min(file.size_ - file.offset_, static_cast<std::size_t>(len));
+        std::memcpy(buffer, file.data_ + file.offset_, count);
+        file.offset_ += count;
+        return static_cast<int>(count);
+    }
+
+
+}  // namespace xtree::detail
+}  // namespace xtree
+
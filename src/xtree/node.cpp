@@ -9,6 +9,7 @@
 #include "xtree/node.hpp"
 #include "xtree/exceptions.hpp"
 #include "xtree/document.hpp"
+#include "xtree/libxml2_callbacks.hpp"
 #include "xtree/libxml2_utility.hpp"
 
 #include <libxml/tree.h>
@@ -245,7 +246,7 @@ namespace xtree {
         {
             throw internal_dom_error("Fail to clone node: xmlDocCopyNode() returned null");
         }
-        else if (px->_private == 0)
+        else if (detail::get_or_create_private(px) == 0)
         {
             throw internal_dom_error("Fail to clone node: the cloned node has null _private");
         }
@@ -266,11 +267,12 @@ namespace xtree {
     {
         if (px != 0)
         {
-            if (px->_private == 0)
+            const void* wrapper = detail::get_or_create_private(px);
+            if (wrapper == 0)
             {
                 throw internal_dom_error("fail to cast xmlNode to node: _private is null");
             }
-            return static_cast<const node*>(px->_private);
+            return static_cast<const node*>(wrapper);
         }
         else
         {
@@ -283,7 +285,7 @@ namespace xtree {
     {
         if (raw()->parent != 0 && raw()->parent->type == XML_ELEMENT_NODE)
         {
-            return static_cast<const element*>(raw()->parent->_private);
+            return static_cast<const element*>(detail::get_or_create_private(raw()->parent));
         }
         else
         {
@@ -296,7 +298,7 @@ namespace xtree {
     {
         if (raw()->prev != 0)
         {
-            return static_cast<const node*>(raw()->prev->_private);
+            return static_cast<const node*>(detail::get_or_create_private(raw()->prev));
         }
         else
         {
@@ -309,7 +311,7 @@ namespace xtree {
     {
         if (raw()->next != 0)
         {
-            return static_cast<const node*>(raw()->next->_private);
+            return static_cast<const node*>(detail::get_or_create_private(raw()->next));
         }
         else
         {
@@ -9,6 +9,7 @@
 #include "xtree/node_set.hpp"
 #include "xtree/exceptions.hpp"
 #include "xtree/node.hpp"
+#include "xtree/libxml2_callbacks.hpp"
 
 #include <libxml/tree.h>
 #include <libxml/xpath.h>
@@ -68,7 +69,7 @@ namespace xtree {
         {
             throw xpath_error("current() called on invalid position");
         }
-        return static_cast<node*>( nodes_->nodeTab[index_]->_private );
+        return static_cast<node*>(detail::get_or_create_private(nodes_->nodeTab[index_]));
     }
 
 
@@ -138,7 +139,7 @@ namespace xtree {
         {
             throw xpath_error("current() called on invalid position");
         }
-        return static_cast<element*>( nodes_->nodeTab[index_]->_private );
+        return static_cast<element*>(detail::get_or_create_private(nodes_->nodeTab[index_]));
     }
 
 
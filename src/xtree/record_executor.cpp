@@ -0,0 +1,481 @@
+//
+// Created by ZHENG Zhong on 2011-10-18.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/record_executor.hpp"
+#include "xtree/document.hpp"
+
+#include <cstddef>
+#include <memory>
+
+#ifdef XTREE_HAS_CXX11
+#  include <algorithm>
+#  include <condition_variable>
+#  include <deque>
+#  include <exception>
+#  include <map>
+#  include <mutex>
+#  include <thread>
+#  include <utility>
+#  include <vector>
+#endif
+
+
+namespace xtree {
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // record_processor
+    //
+
+
+    record_processor::record_processor()
+    {
+        // Do nothing.
+    }
+
+
+    record_processor::~record_processor()
+    {
+        // Do nothing.
+    }
+
+
+#ifdef XTREE_HAS_CXX11
+
+
+    namespace detail {
+
+
+        //! A record submitted to the executor.
+        struct record_task
+        {
+            document*   doc;       //!< The record document, owned by the executor.
+            std::size_t index;     //!< The index of the record.
+            std::size_t sequence;  //!< The submission sequence number.
+        };
+
+
+        //! This class holds the worker threads and the queues of the records in flight. All the
+        //! members are guarded by the mutex, except the worker threads.
+        class record_executor_state
+        {
+
+        public:
+
+            explicit record_executor_state(record_processor& processor,
+                                           std::size_t& completed,
+                                           std::size_t thread_count,
+                                           std::size_t max_in_flight,
+                                           bool ordered)
+            : processor_(processor)
+            , completed_(completed)
+            , max_in_flight_(max_in_flight)
+            , ordered_(ordered)
+            , mutex_()
+            , work_ready_()
+            , done_ready_()
+            , pending_()
+            , done_()
+            , in_flight_(0)
+            , next_sequence_(0)
+            , next_completion_(0)
+            , error_()
+            , stopping_(false)
+            , workers_()
+            {
+                try
+                {
+                    for (std::size_t i = 0; i < thread_count; ++i)
+                    {
+                        workers_.push_back(std::thread(&record_executor_state::work_, this));
+                    }
+                }
+                catch (...)
+                {
+                    shutdown_();
+                    throw;
+                }
+            }
+
+            ~record_executor_state()
+            {
+                shutdown_();
+                for (std::deque<record_task>::iterator i = pending_.begin();
+                     i != pending_.end();
+                     ++i)
+                {
+                    delete i->doc;
+                }
+                for (std::map<std::size_t, record_task>::iterator i = done_.begin();
+                     i != done_.end();
+                     ++i)
+                {
+                    delete i->second.doc;
+                }
+            }
+
+            std::size_t thread_count() const
+            {
+                return workers_.size();
+            }
+
+            std::size_t max_in_flight() const
+            {
+                return max_in_flight_;
+            }
+
+            bool ordered() const
+            {
+                return ordered_;
+            }
+
+            //! Submits a record, completing the records processed, and waiting for a record to
+            //! be completed if there are too many records in flight.
+            void submit(std::auto_ptr<document> doc, std::size_t index)
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                for (;;)
+                {
+                    if (error_)
+                    {
+                        rethrow_error_(lock);
+                    }
+                    record_task task;
+                    if (take_done_(task))
+                    {
+                        complete_(lock, task);
+                    }
+                    else if (in_flight_ < max_in_flight_)
+                    {
+                        break;
+                    }
+                    else
+                    {
+                        done_ready_.wait(lock);
+                    }
+                }
+                record_task task = { doc.get(), index, next_sequence_++ };
+                pending_.push_back(task);
+                doc.release();
+                ++in_flight_;
+                work_ready_.notify_one();
+            }
+
+            //! Waits for all the records in flight, and completes them.
+            void finish()
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (in_flight_ > 0 || error_)
+                {
+                    if (error_)
+                    {
+                        rethrow_error_(lock);
+                    }
+                    record_task task;
+                    if (take_done_(task))
+                    {
+                        complete_(lock, task);
+                    }
+                    else
+                    {
+                        done_ready_.wait(lock);
+                    }
+                }
+            }
+
+        private:
+
+            //! The body of the worker threads.
+            void work_()
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                for (;;)
+                {
+                    while (!stopping_ && pending_.empty())
+                    {
+                        work_ready_.wait(lock);
+                    }
+                    if (stopping_)
+                    {
+                        return;
+                    }
+                    record_task task = pending_.front();
+                    pending_.pop_front();
+                    // Process the record, unless an error has occurred.
+                    if (!error_)
+                    {
+                        lock.unlock();
+                        try
+                        {
+                            processor_.process(*task.doc, task.index);
+                        }
+                        catch (...)
+                        {
+                            lock.lock();
+                            if (!error_)
+                            {
+                                error_ = std::current_exception();
+                            }
+                            lock.unlock();
+                        }
+                        lock.lock();
+                    }
+                    done_.insert(std::make_pair(task.sequence, task));
+                    done_ready_.notify_all();
+                }
+            }
+
+            //! Stops and joins the worker threads.
+            void shutdown_()
+            {
+                {
+                    std::lock_guard<std::mutex> guard(mutex_);
+                    stopping_ = true;
+                }
+                work_ready_.notify_all();
+                for (std::vector<std::thread>::iterator i = workers_.begin();
+                     i != workers_.end();
+                     ++i)
+                {
+                    i->join();
+                }
+                workers_.clear();
+            }
+
+            //! Takes the next record to complete, if any.
+            bool take_done_(record_task& task)
+            {
+                std::map<std::size_t, record_task>::iterator i = ( ordered_
+                                                                 ? done_.find(next_completion_)
+                                                                 : done_.begin() );
+                if (i == done_.end())
+                {
+                    return false;
+                }
+                task = i->second;
+                done_.erase(i);
+                ++next_completion_;
+                return true;
+            }
+
+            //! Completes a record on the calling thread, with the mutex unlocked.
+            void complete_(std::unique_lock<std::mutex>& lock, const record_task& task)
+            {
+                std::auto_ptr<document> doc(task.doc);
+                --in_flight_;
+                if (error_)
+                {
+                    return;
+                }
+                lock.unlock();
+                try
+                {
+                    processor_.complete(*doc, task.index);
+                }
+                catch (...)
+                {
+                    lock.lock();
+                    if (!error_)
+                    {
+                        error_ = std::current_exception();
+                    }
+                    return;
+                }
+                doc.reset();
+                lock.lock();
+                ++completed_;
+            }
+
+            //! Discards all the records in flight, resets the error, and rethrows it.
+            void rethrow_error_(std::unique_lock<std::mutex>& lock)
+            {
+                // The pending records are not processed: they are discarded right away.
+                for (std::deque<record_task>::iterator i = pending_.begin();
+                     i != pending_.end();
+                     ++i)
+                {
+                    delete i->doc;
+                    --in_flight_;
+                }
+                pending_.clear();
+                // Wait for the records being processed, and discard them as well.
+                while (in_flight_ > 0)
+                {
+                    record_task task;
+                    if (take_done_(task))
+                    {
+                        delete task.doc;
+                        --in_flight_;
+                    }
+                    else if (!done_.empty())
+                    {
+                        // In ordered mode, the next record has been discarded already.
+                        next_completion_ = done_.begin()->first;
+                    }
+                    else
+                    {
+                        done_ready_.wait(lock);
+                    }
+                }
+                std::exception_ptr error = error_;
+                error_ = std::exception_ptr();
+                next_sequence_ = 0;
+                next_completion_ = 0;
+                std::rethrow_exception(error);
+            }
+
+        private:
+
+            record_processor&                  processor_;        //!< The record processor.
+            std::size_t&                       completed_;        //!< The records completed.
+            std::size_t                        max_in_flight_;    //!< The max records in flight.
+            bool                               ordered_;          //!< Whether ordered.
+            std::mutex                         mutex_;            //!< Guards the members below.
+            std::condition_variable            work_ready_;       //!< Signals pending records.
+            std::condition_variable            done_ready_;       //!< Signals processed records.
+            std::deque<record_task>            pending_;          //!< The records to process.
+            std::map<std::size_t, record_task> done_;             //!< The records processed.
+            std::size_t                        in_flight_;        //!< The records in flight.
+            std::size_t                        next_sequence_;    //!< The next submission.
+            std::size_t                        next_completion_;  //!< The next completion.
+            std::exception_ptr                 error_;            //!< The first error.
+            bool                               stopping_;         //!< Whether stopping.
+            std::vector<std::thread>           workers_;          //!< The worker threads.
+
+        };
+
+
+    }  // namespace xtree::detail
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // record_executor
+    //
+
+
+    record_executor::record_executor(record_processor& processor,
+                                     std::size_t thread_count,
+                                     std::size_t max_in_flight,
+                                     bool ordered)
+    : processor_(processor), state_(0), completed_(0)
+    {
+        if (thread_count == 0)
+        {
+            thread_count = std::max(std::thread::hardware_concurrency(), 1U);
+        }
+        if (max_in_flight == 0)
+        {
+            max_in_flight = 2 * thread_count;
+        }
+        state_ = new detail::record_executor_state( processor,
+                                                    completed_,
+                                                    thread_count,
+                                                    max_in_flight,
+                                                    ordered );
+    }
+
+
+    record_executor::~record_executor()
+    {
+        delete state_;
+        state_ = 0;
+    }
+
+
+    std::size_t record_executor::thread_count() const
+    {
+        return state_->thread_count();
+    }
+
+
+    std::size_t record_executor::max_in_flight() const
+    {
+        return state_->max_in_flight();
+    }
+
+
+    bool record_executor::ordered() const
+    {
+        return state_->ordered();
+    }
+
+
+    void record_executor::subtree(std::auto_ptr<document> doc, std::size_t index)
+    {
+        state_->submit(doc, index);
+    }
+
+
+    void record_executor::finish()
+    {
+        state_->finish();
+    }
+
+
+#else  // !XTREE_HAS_CXX11
+
+
+    record_executor::record_executor(record_processor& processor,
+                                     std::size_t,
+                                     std::size_t,
+                                     bool)
+    : processor_(processor), state_(0), completed_(0)
+    {
+        // Do nothing.
+    }
+
+
+    record_executor::~record_executor()
+    {
+        // Do nothing.
+    }
+
+
+    std::size_t record_executor::thread_count() const
+    {
+        return 0;
+    }
+
+
+    std::size_t record_executor::max_in_flight() const
+    {
+        return 1;
+    }
+
+
+    bool record_executor::ordered() const
+    {
+        return true;
+    }
+
+
+    void record_executor::subtree(std::auto_ptr<document> doc, std::size_t index)
+    {
+        processor_.process(*doc, index);
+        processor_.complete(*doc, index);
+        ++completed_;
+    }
+
+
+    void record_executor::finish()
+    {
+        // Do nothing.
+    }
+
+
+#endif  // XTREE_HAS_CXX11
+
+
+    std::size_t record_executor::completed() const
+    {
+        return completed_;
+    }
+
+
+}  // namespace xtree
+
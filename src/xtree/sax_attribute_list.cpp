@@ -18,20 +18,31 @@
 namespace xtree {
 
 
-    sax_attribute::sax_attribute(int index, const xmlChar** attrs)
+    sax_attribute::sax_attribute(int index, const xmlChar** attrs, bool namespaces)
     : name_(), prefix_(), uri_(), value_()
     {
-        name_ = ( attrs[index * 5] != 0
-                ? detail::to_chars(attrs[index * 5])
-                : std::string() );
-        prefix_ = ( attrs[index * 5 + 1] != 0
-                  ? detail::to_chars(attrs[index * 5 + 1])
-                  : std::string() );
-        uri_ = ( attrs[index * 5 + 2] != 0
-               ? detail::to_chars(attrs[index * 5 + 2])
-               : std::string() );
-        value_ = std::string( detail::to_chars(attrs[index * 5 + 3]),
-                              detail::to_chars(attrs[index * 5 + 4]) );
+        const xmlChar** attr = attrs + index * 5;
+        if (namespaces)
+        {
+            name_ = (attr[0] != 0 ? detail::to_chars(attr[0]) : std::string());
+            prefix_ = (attr[1] != 0 ? detail::to_chars(attr[1]) : std::string());
+            uri_ = (attr[2] != 0 ? detail::to_chars(attr[2]) : std::string());
+        }
+        else
+        {
+            name_ = detail::build_qname(attr[1], attr[0]);
+        }
+        value_ = std::string(detail::to_chars(attr[3]), detail::to_chars(attr[4]));
+    }
+
+
+    sax_attribute::sax_attribute(const std::string& name,
+                                 const std::string& prefix,
+                                 const std::string& uri,
+                                 const std::string& value)
+    : name_(name), prefix_(prefix), uri_(uri), value_(value)
+    {
+        // Do nothing.
     }
 
 
@@ -0,0 +1,256 @@
+//
+// Created by ZHENG Zhong on 2011-10-17.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/sax_event_buffer.hpp"
+#include "xtree/dom_builder.hpp"
+#include "xtree/document.hpp"
+#include "xtree/exceptions.hpp"
+#include "xtree/sax_attribute_list.hpp"
+#include "xtree/libxml2_memory.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace xtree {
+
+
+    namespace {
+
+
+        //! The types of the events recorded. Each event is recorded as its type followed by its
+        //! fields, where names are indices in the name table, and characters are offsets and
+        //! lengths in the text arena:
+        //!
+        //! - start_document, end_document: no field.
+        //! - start_element: name, prefix, uri, attribute count, then for each attribute: name,
+        //!   prefix, uri, value offset, value length.
+        //! - end_element: name, prefix, uri.
+        //! - characters, cdata_block, ignorable_whitespace, comment: offset, length.
+        enum sax_event_type_t
+        {
+            start_document_event,
+            end_document_event,
+            start_element_event,
+            end_element_event,
+            characters_event,
+            cdata_block_event,
+            ignorable_whitespace_event,
+            comment_event
+        };
+
+
+    }  // anonymous namespace
+
+
+    sax_event_buffer::sax_event_buffer(): events_(), size_(0), names_(), indices_(), text_()
+    {
+        // Do nothing.
+    }
+
+
+    sax_event_buffer::~sax_event_buffer()
+    {
+        // Do nothing.
+    }
+
+
+    void sax_event_buffer::clear()
+    {
+        events_.clear();
+        size_ = 0;
+        names_.clear();
+        indices_.clear();
+        text_.clear();
+    }
+
+
+    void sax_event_buffer::replay(sax_content_handler& handler) const
+    {
+        const char* text = (text_.empty() ? 0 : &text_[0]);
+        sax_attribute_list attrs;
+        std::vector<std::size_t>::const_iterator i = events_.begin();
+        while (i != events_.end())
+        {
+            std::size_t type = *i++;
+            switch (type)
+            {
+            case start_document_event:
+                handler.start_document();
+                break;
+            case end_document_event:
+                handler.end_document();
+                break;
+            case start_element_event:
+                {
+                    const std::string& name = names_[i[0]];
+                    const std::string& prefix = names_[i[1]];
+                    const std::string& uri = names_[i[2]];
+                    std::size_t count = i[3];
+                    i += 4;
+                    attrs.clear();
+                    for (std::size_t n = 0; n < count; ++n, i += 5)
+                    {
+                        attrs.push_back(sax_attribute( names_[i[0]],
+                                                       names_[i[1]],
+                                                       names_[i[2]],
+                                                       std::string(text + i[3], i[4]) ));
+                    }
+                    handler.start_element(name, prefix, uri, attrs);
+                }
+                break;
+            case end_element_event:
+                handler.end_element(names_[i[0]], names_[i[1]], names_[i[2]]);
+                i += 3;
+                break;
+            case characters_event:
+                handler.characters(text + i[0], static_cast<int>(i[1]));
+                i += 2;
+                break;
+            case cdata_block_event:
+                handler.cdata_block(text + i[0], static_cast<int>(i[1]));
+                i += 2;
+                break;
+            case ignorable_whitespace_event:
+                handler.ignorable_whitespace(text + i[0], static_cast<int>(i[1]));
+                i += 2;
+                break;
+            case comment_event:
+                handler.comment(text + i[0]);
+                i += 2;
+                break;
+            default:
+                assert(! "unexpected SAX event type");
+                throw internal_dom_error("fail to replay SAX events: unexpected event type");
+            }
+        }
+    }
+
+
+    std::auto_ptr<document> sax_event_buffer::replay_document() const
+    {
+        // Allocate the libxml2 document from a memory region if document regions are enabled.
+        detail::memory_region_scope region_scope;
+        dom_builder builder;
+        replay(builder);
+        std::auto_ptr<document> doc = builder.release();
+        doc->attach_memory_region(region_scope.detach());
+        return doc;
+    }
+
+
+    void sax_event_buffer::start_document()
+    {
+        events_.push_back(start_document_event);
+        ++size_;
+    }
+
+
+    void sax_event_buffer::end_document()
+    {
+        events_.push_back(end_document_event);
+        ++size_;
+    }
+
+
+    void sax_event_buffer::start_element(const std::string& name,
+                                         const std::string& prefix,
+                                         const std::string& uri,
+                                         const sax_attribute_list& attrs)
+    {
+        events_.push_back(start_element_event);
+        events_.push_back(intern_(name));
+        events_.push_back(intern_(prefix));
+        events_.push_back(intern_(uri));
+        events_.push_back(attrs.size());
+        for (sax_attribute_list::const_iterator i = attrs.begin(); i != attrs.end(); ++i)
+        {
+            events_.push_back(intern_(i->name()));
+            events_.push_back(intern_(i->prefix()));
+            events_.push_back(intern_(i->uri()));
+            events_.push_back(text_.size());
+            events_.push_back(i->value().size());
+            store_(i->value().data(), i->value().size());
+        }
+        ++size_;
+    }
+
+
+    void sax_event_buffer::end_element(const std::string& name,
+                                       const std::string& prefix,
+                                       const std::string& uri)
+    {
+        events_.push_back(end_element_event);
+        events_.push_back(intern_(name));
+        events_.push_back(intern_(prefix));
+        events_.push_back(intern_(uri));
+        ++size_;
+    }
+
+
+    void sax_event_buffer::characters(const char* chars, int length)
+    {
+        record_chars_(characters_event, chars, static_cast<std::size_t>(length));
+    }
+
+
+    void sax_event_buffer::cdata_block(const char* chars, int length)
+    {
+        record_chars_(cdata_block_event, chars, static_cast<std::size_t>(length));
+    }
+
+
+    void sax_event_buffer::ignorable_whitespace(const char* chars, int length)
+    {
+        record_chars_(ignorable_whitespace_event, chars, static_cast<std::size_t>(length));
+    }
+
+
+    void sax_event_buffer::comment(const char* chars)
+    {
+        record_chars_(comment_event, chars, (chars != 0 ? std::strlen(chars) : 0));
+    }
+
+
+    std::size_t sax_event_buffer::intern_(const std::string& name)
+    {
+        name_index_map::const_iterator i = indices_.find(name);
+        if (i != indices_.end())
+        {
+            return i->second;
+        }
+        std::size_t index = names_.size();
+        names_.push_back(name);
+        indices_.insert(name_index_map::value_type(name, index));
+        return index;
+    }
+
+
+    void sax_event_buffer::store_(const char* chars, std::size_t length)
+    {
+        text_.insert(text_.end(), chars, chars + length);
+        text_.push_back('\0');  // So that comments can be replayed as null-terminated strings.
+    }
+
+
+    void sax_event_buffer::record_chars_(std::size_t type, const char* chars, std::size_t length)
+    {
+        events_.push_back(type);
+        events_.push_back(text_.size());
+        events_.push_back(length);
+        store_(chars, length);
+        ++size_;
+    }
+
+
+}  // namespace xtree
+
@@ -0,0 +1,76 @@
+//
+// Created by ZHENG Zhong on 2011-10-15.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/sax_features.hpp"
+
+#include <libxml/parser.h>
+
+#include <string>
+
+
+namespace xtree {
+
+
+    const unsigned int sax_feature_set::default_bits;
+
+
+namespace detail {
+
+
+    bool find_sax_feature(const std::string& name, sax_feature::type& feature)
+    {
+        if (name == sax_namespaces)
+        {
+            feature = sax_feature::namespaces;
+        }
+        else if (name == sax_namespace_prefixes)
+        {
+            feature = sax_feature::namespace_prefixes;
+        }
+        else if (name == sax_external_general_entities)
+        {
+            feature = sax_feature::substitute_entities;
+        }
+        else if (name == sax_external_parameter_entities)
+        {
+            feature = sax_feature::load_external_dtd;
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+
+
+    int to_libxml2_parser_options(const sax_feature_set& features)
+    {
+        int options = 0;
+        if (features.test(sax_feature::substitute_entities))
+        {
+            options |= XML_PARSE_NOENT;
+        }
+        if (features.test(sax_feature::load_external_dtd))
+        {
+            options |= XML_PARSE_DTDLOAD;
+        }
+        if (features.test(sax_feature::huge))
+        {
+            options |= XML_PARSE_HUGE;
+        }
+        if (features.test(sax_feature::no_network))
+        {
+            options |= XML_PARSE_NONET;
+        }
+        return options;
+    }
+
+
+}  // namespace xtree::detail
+}  // namespace xtree
+
@@ -20,6 +20,18 @@ namespace xtree {
     }
 
 
+    sax_view_handler::sax_view_handler()
+    {
+        // Do nothing.
+    }
+
+
+    sax_view_handler::~sax_view_handler()
+    {
+        // Do nothing.
+    }
+
+
     sax_error_handler::sax_error_handler()
     {
         // Do nothing.
@@ -4,15 +4,22 @@
 
 #include "xtree/sax_parser.hpp"
 #include "xtree/sax_attribute_list.hpp"
+#include "xtree/sax_attribute_view.hpp"
 #include "xtree/sax_error_info.hpp"
 #include "xtree/sax_features.hpp"
+#include "xtree/sax_string_view.hpp"
 #include "xtree/exceptions.hpp"
 #include "xtree/libxml2_utility.hpp"
+#include "xtree/mapped_file.hpp"
 
 #include <libxml/parser.h>
+#include <libxml/parserInternals.h>  // for xmlCreateFileParserCtxt()
+#include <libxml/SAX2.h>
 #include <libxml/xmlerror.h>
 
 #include <cassert>
+#include <climits>  // for INT_MAX
+#include <cstddef>
 #include <cstring>
 #include <memory>
 #include <sstream>
@@ -24,9 +31,31 @@ namespace xtree {
 
     namespace detail {
 
+        void libxml2_internal_subset(void* context,
+                                     const xmlChar* name,
+                                     const xmlChar* external_id,
+                                     const xmlChar* system_id)
+        {
+            xmlParserCtxt* ctxt = static_cast<xmlParserCtxt*>(context);
+            // The entity declarations are stored in the document, which is only created when
+            // the XML has a document type declaration.
+            if (ctxt->myDoc == 0)
+            {
+                xmlSAX2StartDocument(ctxt);
+            }
+            xmlSAX2InternalSubset(ctxt, name, external_id, system_id);
+        }
+
         void initialize_libxml2_sax2_handler(xmlSAXHandler& handler)
         {
             std::memset(&handler, 0, sizeof(xmlSAXHandler));
+            // Let libxml2 handle the document type declaration, so that entities are resolved.
+            handler.internalSubset = &libxml2_internal_subset;
+            handler.externalSubset = &xmlSAX2ExternalSubset;
+            handler.entityDecl = &xmlSAX2EntityDecl;
+            handler.getEntity = &xmlSAX2GetEntity;
+            handler.getParameterEntity = &xmlSAX2GetParameterEntity;
+            handler.resolveEntity = &xmlSAX2ResolveEntity;
             handler.startDocument = &sax_parser::start_document;
             handler.endDocument = &sax_parser::end_document;
             handler.startElementNs = &sax_parser::start_element_ns;
@@ -42,14 +71,164 @@ namespace xtree {
     }  // namespace xtree::detail
 
 
+    namespace {
+
+
+        //! This class manages a libxml2 parser context used for SAX parsing.
+        class sax_parser_context_wrapper
+        {
+
+        public:
+
+            explicit sax_parser_context_wrapper(xmlParserCtxt* px): raw_(px)
+            {
+                // Do nothing.
+            }
+
+            ~sax_parser_context_wrapper()
+            {
+                if (raw_ != 0)
+                {
+                    xmlFreeParserCtxt(raw_);
+                    raw_ = 0;
+                }
+            }
+
+            xmlParserCtxt* get()
+            {
+                return raw_;
+            }
+
+        private:
+
+            //! Non-implemented copy constructor.
+            sax_parser_context_wrapper(const sax_parser_context_wrapper&);
+
+            //! Non-implemented copy assignment.
+            sax_parser_context_wrapper& operator=(const sax_parser_context_wrapper&);
+
+        private:
+
+            xmlParserCtxt* raw_;
+
+        };
+
+
+        //! Creates a libxml2 parser context to parse a file mapped to memory.
+        //! \param file       the file mapped to memory, which should outlive the parser context.
+        //! \param file_name  the name of the file.
+        //! \return the libxml2 parser context, or null on failure.
+        xmlParserCtxt* create_mapped_file_parser_context(detail::mapped_file& file,
+                                                         const std::string& file_name)
+        {
+            xmlParserCtxt* context = xmlNewParserCtxt();
+            if (context == 0)
+            {
+                return 0;
+            }
+            if (!file.push_input(context, file_name))
+            {
+                xmlFreeParserCtxt(context);
+                return 0;
+            }
+            if (context->directory == 0)
+            {
+                context->directory = xmlParserGetDirectory(file_name.c_str());
+            }
+            return context;
+        }
+
+
+        //! Parses an XML document under the libxml2 parser context, invoking the SAX2 callbacks of
+        //! the SAX parser. The parsing options are applied to the parser context, instead of
+        //! relying on libxml2's global variables which are shared by all the threads.
+        //! \param context    the libxml2 parser context.
+        //! \param parser     the SAX parser receiving the callbacks.
+        //! \param options    the libxml2 parser options (a combination of xmlParserOption).
+        //! \return 0 if the XML is well-formed, an error code otherwise.
+        int parse_in_context(xmlParserCtxt* context, sax_parser* parser, int options)
+        {
+            assert(context != 0 && context->sax != 0);
+            // Replace the default SAX handler (owned by the parser context) with the SAX2 one.
+            detail::initialize_libxml2_sax2_handler(*context->sax);
+            context->userData = context;
+            context->_private = parser;
+            xmlCtxtUseOptions(context, options);
+            xmlParseDocument(context);
+            if (context->myDoc != 0)
+            {
+                xmlFreeDoc(context->myDoc);
+                context->myDoc = 0;
+            }
+            if (context->wellFormed)
+            {
+                return 0;
+            }
+            return (context->errNo != 0 ? context->errNo : -1);
+        }
+
+
+        //! Appends the namespace declarations of an element to a SAX attribute list. If the
+        //! namespaces feature is enabled, the declarations are bound to the xmlns namespace
+        //! (e.g. name "x", prefix "xmlns"), as in DOM level 2; otherwise, their names are QNames
+        //! (e.g. "xmlns:x").
+        //! \param sax_attrs       the SAX attribute list.
+        //! \param nb_xmlns_attrs  the number of namespace declarations.
+        //! \param xmlns_attrs     the namespace declarations (pairs of prefix and URI).
+        //! \param namespaces      whether the namespaces feature is enabled.
+        void add_xmlns_attributes(sax_attribute_list& sax_attrs,
+                                  int nb_xmlns_attrs,
+                                  const xmlChar** xmlns_attrs,
+                                  bool namespaces)
+        {
+            const char* const XMLNS = "xmlns";
+            const char* const XMLNS_URI = "http://www.w3.org/2000/xmlns/";
+            for (int i = 0; i < nb_xmlns_attrs; ++i)
+            {
+                const xmlChar* prefix = xmlns_attrs[i * 2];
+                std::string uri = (xmlns_attrs[i * 2 + 1] != 0
+                                   ? detail::to_chars(xmlns_attrs[i * 2 + 1])
+                                   : std::string());
+                if (prefix == 0)
+                {
+                    sax_attrs.push_back(sax_attribute(
+                        XMLNS, std::string(), (namespaces ? XMLNS_URI : ""), uri
+                    ));
+                }
+                else if (namespaces)
+                {
+                    sax_attrs.push_back(sax_attribute(
+                        detail::to_chars(prefix), XMLNS, XMLNS_URI, uri
+                    ));
+                }
+                else
+                {
+                    sax_attrs.push_back(sax_attribute(
+                        detail::build_qname(detail::to_xml_chars(XMLNS), prefix),
+                        std::string(),
+                        std::string(),
+                        uri
+                    ));
+                }
+            }
+        }
+
+
+    }  // anonymous namespace
+
+
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // sax_parser :: constructor / destructor
     //
 
 
-    sax_parser::sax_parser(): features_(), content_handler_(0), error_handler_(0)
+    sax_parser::sax_parser(): features_()
+                            , content_handler_(0)
+                            , error_handler_(0)
+                            , view_handler_(0)
+                            , memory_map_(false)
     {
-        features_.insert(sax_namespaces);
+        // Do nothing.
     }
 
 
@@ -76,34 +255,87 @@ namespace xtree {
     }
 
 
+    void sax_parser::set_view_handler(sax_view_handler* handler)
+    {
+        view_handler_ = handler;
+    }
+
+
     void sax_parser::set_feature(const std::string& name, bool enable)
     {
-        if (enable)
+        sax_feature::type feature;
+        if (!detail::find_sax_feature(name, feature))
         {
-            features_.insert(name);
-        }
-        else
-        {
-            features_.erase(name);
+            throw sax_error("Unknown SAX feature: " + name);
         }
+        features_.set(feature, enable);
     }
 
 
     bool sax_parser::get_feature(const std::string& name) const
     {
-        return (features_.find(name) != features_.end());
+        sax_feature::type feature;
+        return (detail::find_sax_feature(name, feature) && features_.test(feature));
+    }
+
+
+    void sax_parser::set_feature(sax_feature::type feature, bool enable)
+    {
+        features_.set(feature, enable);
+    }
+
+
+    bool sax_parser::get_feature(sax_feature::type feature) const
+    {
+        return features_.test(feature);
+    }
+
+
+    void sax_parser::set_features(const sax_feature_set& features)
+    {
+        features_ = features;
+    }
+
+
+    const sax_feature_set& sax_parser::get_features() const
+    {
+        return features_;
+    }
+
+
+    void sax_parser::set_memory_map(bool flag)
+    {
+        memory_map_ = flag;
+    }
+
+
+    bool sax_parser::get_memory_map() const
+    {
+        return memory_map_;
     }
 
 
     void sax_parser::parse_file(const std::string& file_name)
     {
-        xmlSAXHandler handler;
-        detail::initialize_libxml2_sax2_handler(handler);
-        int ret = xmlSAXUserParseFile(&handler, this, file_name.c_str());
+        // Map the XML file to memory if required. Compressed files are left to libxml2's file
+        // reader. The mapped file should outlive the parser context.
+        detail::mapped_file mapped;
+        bool use_mapped = ( memory_map_ && mapped.open(file_name) && !mapped.compressed() );
+        sax_parser_context_wrapper context(
+            use_mapped ? create_mapped_file_parser_context(mapped, file_name)
+                       : xmlCreateFileParserCtxt(file_name.c_str())
+        );
+        if (context.get() == 0)
+        {
+            throw sax_error("Fail to parse " + file_name + ": unable to create parser context");
+        }
+        int ret = parse_in_context(context.get(),
+                                   this,
+                                   detail::to_libxml2_parser_options(features_));
         if (ret != 0)
         {
             std::ostringstream oss;
-            oss << "Fail to parse " << file_name << ": xmlSAXUserParseFile returned " << ret;
+            oss << "Fail to parse " << file_name << ": xmlParseDocument returned " << ret;
             throw sax_error(oss.str());
         }
     }
@@ -111,15 +343,39 @@ namespace xtree {
 
     void sax_parser::parse_string(const char* str)
     {
-        xmlSAXHandler handler;
-        detail::initialize_libxml2_sax2_handler(handler);
-        int ret = xmlSAXUserParseMemory(&handler, this, str, std::strlen(str));
+        if (str == 0)
+        {
+            throw sax_error("Fail to parse string: string is null");
+        }
+        parse_buffer(str, std::strlen(str));
+    }
+
+
+    void sax_parser::parse_buffer(const char* data, std::size_t size)
+    {
+        if (data == 0)
+        {
+            throw sax_error("Fail to parse buffer: buffer is null");
+        }
+        if (size > static_cast<std::size_t>(INT_MAX))
+        {
+            throw sax_error("Fail to parse buffer: buffer is too large");
+        }
+        sax_parser_context_wrapper context(
+            xmlCreateMemoryParserCtxt(data, static_cast<int>(size))
+        );
+        if (context.get() == 0)
+        {
+            throw sax_error("Fail to parse buffer: unable to create parser context");
+        }
+        int ret = parse_in_context(context.get(),
+                                   this,
+                                   detail::to_libxml2_parser_options(features_));
         if (ret != 0)
         {
             std::ostringstream oss;
-            oss << "Fail to parse string: xmlSAXUserParseMemory returned " << ret;
+            oss << "Fail to parse buffer: xmlParseDocument returned " << ret;
             throw sax_error(oss.str());
-
         }
     }
 
@@ -132,6 +388,10 @@ namespace xtree {
     void sax_parser::start_document(void* context)
     {
         sax_parser& p = get_sax_parser(context);
+        if (p.view_handler_ != 0)
+        {
+            p.view_handler_->start_document();
+        }
         if (p.content_handler_ != 0)
         {
             p.content_handler_->start_document();
@@ -142,6 +402,10 @@ namespace xtree {
     void sax_parser::end_document(void* context)
     {
         sax_parser& p = get_sax_parser(context);
+        if (p.view_handler_ != 0)
+        {
+            p.view_handler_->end_document();
+        }
         if (p.content_handler_ != 0)
         {
             p.content_handler_->end_document();
@@ -153,28 +417,59 @@ namespace xtree {
                                       const xmlChar* name,
                                       const xmlChar* prefix,
                                       const xmlChar* uri,
-                                      int ,
-                                      const xmlChar** ,
+                                      int nb_xmlns_attrs,
+                                      const xmlChar** xmlns_attrs,
                                       int nb_attrs,
                                       int ,
                                       const xmlChar** attrs)
     {
         sax_parser& p = get_sax_parser(context);
-        // Convert attrs array into a SAX attribute list.
-        sax_attribute_list sax_attrs;
-        for (int i = 0; i < nb_attrs; ++i)
+        // Call view handler's callback: no memory is allocated.
+        if (p.view_handler_ != 0)
         {
-            sax_attrs.push_back(sax_attribute(i, attrs));
+            p.view_handler_->start_element(
+                sax_string_view(detail::to_chars(name)),
+                sax_string_view(detail::to_chars(prefix)),
+                sax_string_view(detail::to_chars(uri)),
+                sax_attribute_view_list(attrs, nb_attrs)
+            );
         }
         // Call content handler's callback.
         if (p.content_handler_ != 0)
         {
-            p.content_handler_->start_element(
-                (name != 0 ? detail::to_chars(name) : std::string()),
-                (prefix != 0 ? detail::to_chars(prefix) : std::string()),
-                (uri != 0 ? detail::to_chars(uri) : std::string()),
-                sax_attrs
-            );
+            // Convert attrs array into a SAX attribute list. Unless required, do not build the
+            // namespace URIs (nor the namespace declarations) which are seldom used.
+            bool namespaces = p.features_.test(sax_feature::namespaces);
+            bool prefixes = p.features_.test(sax_feature::namespace_prefixes);
+            sax_attribute_list sax_attrs;
+            sax_attrs.reserve( (nb_attrs > 0 ? nb_attrs : 0)
+                             + (prefixes && nb_xmlns_attrs > 0 ? nb_xmlns_attrs : 0) );
+            for (int i = 0; i < nb_attrs; ++i)
+            {
+                sax_attrs.push_back(sax_attribute(i, attrs, namespaces));
+            }
+            if (prefixes)
+            {
+                add_xmlns_attributes(sax_attrs, nb_xmlns_attrs, xmlns_attrs, namespaces);
+            }
+            if (namespaces)
+            {
+                p.content_handler_->start_element(
+                    (name != 0 ? detail::to_chars(name) : std::string()),
+                    (prefix != 0 ? detail::to_chars(prefix) : std::string()),
+                    (uri != 0 ? detail::to_chars(uri) : std::string()),
+                    sax_attrs
+                );
+            }
+            else
+            {
+                p.content_handler_->start_element(
+                    detail::build_qname(prefix, name),
+                    std::string(),
+                    std::string(),
+                    sax_attrs
+                );
+            }
         }
     }
 
@@ -185,20 +480,41 @@ namespace xtree {
                                     const xmlChar* uri)
     {
         sax_parser& p = get_sax_parser(context);
-        if (p.content_handler_ != 0)
+        if (p.view_handler_ != 0)
         {
-            p.content_handler_->end_element(
-                (name != 0 ? detail::to_chars(name) : std::string()),
-                (prefix != 0 ? detail::to_chars(prefix) : std::string()),
-                (uri != 0 ? detail::to_chars(uri) : std::string())
+            p.view_handler_->end_element(
+                sax_string_view(detail::to_chars(name)),
+                sax_string_view(detail::to_chars(prefix)),
+                sax_string_view(detail::to_chars(uri))
             );
         }
+        if (p.content_handler_ != 0)
+        {
+            if (p.features_.test(sax_feature::namespaces))
+            {
+                p.content_handler_->end_element(
+                    (name != 0 ? detail::to_chars(name) : std::string()),
+                    (prefix != 0 ? detail::to_chars(prefix) : std::string()),
+                    (uri != 0 ? detail::to_chars(uri) : std::string())
+                );
+            }
+            else
+            {
+                p.content_handler_->end_element(detail::build_qname(prefix, name),
+                                                std::string(),
+                                                std::string());
+            }
+        }
     }
 
 
     void sax_parser::characters(void* context, const xmlChar* chars, int length)
     {
         sax_parser& p = get_sax_parser(context);
+        if (p.view_handler_ != 0)
+        {
+            p.view_handler_->characters(sax_string_view(detail::to_chars(chars), length));
+        }
         if (p.content_handler_ != 0)
         {
             p.content_handler_->characters(detail::to_chars(chars), length);
@@ -209,6 +525,10 @@ namespace xtree {
     void sax_parser::cdata_block(void* context, const xmlChar* chars, int length)
     {
         sax_parser& p = get_sax_parser(context);
+        if (p.view_handler_ != 0)
+        {
+            p.view_handler_->cdata_block(sax_string_view(detail::to_chars(chars), length));
+        }
         if (p.content_handler_ != 0)
         {
             p.content_handler_->cdata_block(detail::to_chars(chars), length);
@@ -219,6 +539,12 @@ namespace xtree {
     void sax_parser::ignorable_whitespace(void* context, const xmlChar* chars, int length)
     {
         sax_parser& p = get_sax_parser(context);
+        if (p.view_handler_ != 0)
+        {
+            p.view_handler_->ignorable_whitespace(
+                sax_string_view(detail::to_chars(chars), length)
+            );
+        }
         if (p.content_handler_ != 0)
         {
             p.content_handler_->ignorable_whitespace(detail::to_chars(chars), length);
@@ -229,6 +555,10 @@ namespace xtree {
     void sax_parser::comment(void* context, const xmlChar* chars)
     {
         sax_parser& p = get_sax_parser(context);
+        if (p.view_handler_ != 0)
+        {
+            p.view_handler_->comment(sax_string_view(detail::to_chars(chars)));
+        }
         if (p.content_handler_ != 0)
         {
             p.content_handler_->comment(detail::to_chars(chars));
@@ -265,7 +595,9 @@ namespace xtree {
     sax_parser& sax_parser::get_sax_parser(void* context)
     {
         assert(context != 0 && "SAX2 context pointer should not be null");
-        return *(static_cast<sax_parser*>(context));
+        void* parser = static_cast<xmlParserCtxt*>(context)->_private;
+        assert(parser != 0 && "SAX parser should be stored in the parser context");
+        return *(static_cast<sax_parser*>(parser));
     }
 
 
@@ -0,0 +1,933 @@
+//
+// Created by ZHENG Zhong on 2011-10-16.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/sax_pipeline_parser.hpp"
+#include "xtree/basic_sax_parser.hpp"
+#include "xtree/sax_attribute_list.hpp"
+#include "xtree/sax_error_info.hpp"
+#include "xtree/sax_parser.hpp"
+#include "xtree/sax_string_view.hpp"
+#include "xtree/spsc_ring.hpp"
+#include "xtree/exceptions.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef XTREE_HAS_CXX11
+#  include <atomic>
+#  include <exception>
+#  include <functional>
+#  include <thread>
+#endif
+
+
+namespace xtree {
+
+
+    const std::size_t sax_pipeline_parser::default_block_size;
+    const std::size_t sax_pipeline_parser::default_block_count;
+
+
+#ifdef XTREE_HAS_CXX11
+
+
+    namespace {
+
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // event encoding
+        //
+        // Each event is encoded as a type byte followed by its fields. Strings are encoded as a
+        // 32-bit length followed by the characters and a null character, so that they can be
+        // passed to the handlers without being copied.
+        //
+
+
+        enum sax_event_type_t
+        {
+            start_document_event = 1,
+            end_document_event,
+            start_element_event,
+            end_element_event,
+            characters_event,
+            cdata_block_event,
+            ignorable_whitespace_event,
+            comment_event,
+            warning_event,
+            error_event,
+            fatal_event,
+            end_of_stream_event
+        };
+
+
+        //! The status of the parsing, encoded in the end-of-stream event.
+        enum sax_stream_status_t
+        {
+            stream_succeeded,  //!< The XML has been parsed successfully.
+            stream_failed,     //!< The XML is not well-formed: a message follows.
+            stream_aborted     //!< An exception has been thrown by the parser thread.
+        };
+
+
+        //! This class appends encoded events to a block.
+        class sax_event_writer
+        {
+
+        public:
+
+            explicit sax_event_writer(std::vector<char>& block): block_(block)
+            {
+                // Do nothing.
+            }
+
+            void put_byte(int value)
+            {
+                block_.push_back(static_cast<char>(value));
+            }
+
+            void put_uint32(std::size_t value)
+            {
+                unsigned int u = static_cast<unsigned int>(value);
+                const char* bytes = reinterpret_cast<const char*>(&u);
+                block_.insert(block_.end(), bytes, bytes + sizeof(u));
+            }
+
+            void put_string(const char* data, std::size_t size)
+            {
+                put_uint32(size);
+                block_.insert(block_.end(), data, data + size);
+                block_.push_back('\0');
+            }
+
+            void put_string(const sax_string_view& str)
+            {
+                put_string(str.data(), str.size());
+            }
+
+            //! Puts a QName built from a namespace prefix and a local name.
+            void put_qname(const sax_string_view& prefix, const sax_string_view& name)
+            {
+                if (prefix.empty())
+                {
+                    put_string(name);
+                }
+                else
+                {
+                    put_uint32(prefix.size() + 1 + name.size());
+                    block_.insert(block_.end(), prefix.begin(), prefix.end());
+                    block_.push_back(':');
+                    block_.insert(block_.end(), name.begin(), name.end());
+                    block_.push_back('\0');
+                }
+            }
+
+        private:
+
+            std::vector<char>& block_;
+
+        };
+
+
+        //! This class reads encoded events from a block.
+        class sax_event_reader
+        {
+
+        public:
+
+            explicit sax_event_reader(const std::vector<char>& block)
+            : pos_(block.empty() ? 0 : &block[0]), end_(pos_ + block.size())
+            {
+                // Do nothing.
+            }
+
+            bool eof() const
+            {
+                return (pos_ == end_);
+            }
+
+            int get_byte()
+            {
+                assert(pos_ < end_);
+                return static_cast<unsigned char>(*pos_++);
+            }
+
+            std::size_t get_uint32()
+            {
+                assert(pos_ + sizeof(unsigned int) <= end_);
+                unsigned int u = 0;
+                std::memcpy(&u, pos_, sizeof(u));
+                pos_ += sizeof(u);
+                return u;
+            }
+
+            //! Gets a string: the characters returned are null-terminated, and point to the block.
+            const char* get_string(std::size_t& size)
+            {
+                size = get_uint32();
+                const char* chars = pos_;
+                pos_ += size + 1;
+                assert(pos_ <= end_);
+                return chars;
+            }
+
+            void get_string(std::string& str)
+            {
+                std::size_t size = 0;
+                const char* chars = get_string(size);
+                str.assign(chars, size);
+            }
+
+        private:
+
+            const char* pos_;
+            const char* end_;
+
+        };
+
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // pipeline
+        //
+
+
+        //! This class holds the state shared by the parser thread and the calling thread: the
+        //! rings of full and free blocks, the cancellation flag, and the exception thrown by the
+        //! parser thread. Since the rings are as large as the number of blocks, pushing a block
+        //! never fails.
+        class sax_pipeline
+        {
+
+        public:
+
+            explicit sax_pipeline(std::vector<std::vector<char> >& blocks)
+            : full_(blocks.size()), free_(blocks.size()), cancelled_(false), exception_()
+            {
+                for (std::size_t i = 0; i < blocks.size(); ++i)
+                {
+                    blocks[i].clear();
+                    free_.try_push(&blocks[i]);
+                }
+            }
+
+            //! Returns a free block to fill (parser thread), or null if cancelled.
+            std::vector<char>* acquire()
+            {
+                std::vector<char>* block = 0;
+                detail::spin_backoff backoff;
+                while (!free_.try_pop(block))
+                {
+                    if (cancelled())
+                    {
+                        return 0;
+                    }
+                    backoff.wait();
+                }
+                return block;
+            }
+
+            //! Passes a block filled with events to the calling thread (parser thread).
+            void publish(std::vector<char>* block)
+            {
+                bool pushed = full_.try_push(block);
+                assert(pushed && "the ring of full blocks should never be full");
+                (void) pushed;
+            }
+
+            //! Returns the next block of events to replay (calling thread).
+            std::vector<char>* next()
+            {
+                std::vector<char>* block = 0;
+                detail::spin_backoff backoff;
+                while (!full_.try_pop(block))
+                {
+                    backoff.wait();
+                }
+                return block;
+            }
+
+            //! Gives a replayed block back to the parser thread (calling thread).
+            void recycle(std::vector<char>* block)
+            {
+                block->clear();  // The capacity is kept.
+                bool pushed = free_.try_push(block);
+                assert(pushed && "the ring of free blocks should never be full");
+                (void) pushed;
+            }
+
+            void cancel()
+            {
+                cancelled_.store(true, std::memory_order_relaxed);
+            }
+
+            bool cancelled() const
+            {
+                return cancelled_.load(std::memory_order_relaxed);
+            }
+
+            //! Sets the exception thrown by the parser thread, before the end-of-stream event is
+            //! published (which makes it visible to the calling thread).
+            void set_exception(std::exception_ptr exception)
+            {
+                exception_ = exception;
+            }
+
+            std::exception_ptr exception() const
+            {
+                return exception_;
+            }
+
+        private:
+
+            detail::spsc_ring<std::vector<char>*> full_;       //!< The blocks to replay.
+            detail::spsc_ring<std::vector<char>*> free_;       //!< The blocks to fill.
+            std::atomic<bool>                     cancelled_;  //!< Whether cancelled.
+            std::exception_ptr                    exception_;  //!< The parser thread exception.
+
+        };
+
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // parser thread
+        //
+
+
+        //! This handler encodes the SAX events into blocks, on the parser thread.
+        class sax_event_encoder: public basic_sax_handler<sax_event_encoder>
+        {
+
+        public:
+
+            typedef basic_sax_parser<sax_event_encoder> parser_type;
+
+            explicit sax_event_encoder(sax_pipeline& pipeline,
+                                       std::size_t block_size,
+                                       bool content,
+                                       bool errors,
+                                       bool namespaces)
+            : pipeline_(pipeline)
+            , block_size_(block_size)
+            , content_(content)
+            , errors_(errors)
+            , namespaces_(namespaces)
+            , parser_(0)
+            , block_(0)
+            {
+                // Do nothing.
+            }
+
+            void set_parser(parser_type* parser)
+            {
+                parser_ = parser;
+            }
+
+            void start_document()
+            {
+                if (begin_(content_))
+                {
+                    sax_event_writer(*block_).put_byte(start_document_event);
+                }
+            }
+
+            void end_document()
+            {
+                if (begin_(content_))
+                {
+                    sax_event_writer(*block_).put_byte(end_document_event);
+                }
+            }
+
+            void start_element(const sax_string_view& name,
+                               const sax_string_view& prefix,
+                               const sax_string_view& uri,
+                               const sax_attribute_view_list& attrs)
+            {
+                if (begin_(content_))
+                {
+                    sax_event_writer writer(*block_);
+                    writer.put_byte(start_element_event);
+                    put_name_(writer, name, prefix, uri);
+                    writer.put_uint32(attrs.size());
+                    for (sax_attribute_view_list::const_iterator i = attrs.begin();
+                         i != attrs.end();
+                         ++i)
+                    {
+                        sax_attribute_view attr = *i;
+                        put_name_(writer, attr.name(), attr.prefix(), attr.uri());
+                        writer.put_string(attr.value());
+                    }
+                }
+            }
+
+            void end_element(const sax_string_view& name,
+                             const sax_string_view& prefix,
+                             const sax_string_view& uri)
+            {
+                if (begin_(content_))
+                {
+                    sax_event_writer writer(*block_);
+                    writer.put_byte(end_element_event);
+                    put_name_(writer, name, prefix, uri);
+                }
+            }
+
+            void characters(const sax_string_view& chars)
+            {
+                put_chars_(characters_event, chars);
+            }
+
+            void cdata_block(const sax_string_view& chars)
+            {
+                put_chars_(cdata_block_event, chars);
+            }
+
+            void ignorable_whitespace(const sax_string_view& chars)
+            {
+                put_chars_(ignorable_whitespace_event, chars);
+            }
+
+            void comment(const sax_string_view& chars)
+            {
+                put_chars_(comment_event, chars);
+            }
+
+            void warning(const sax_error_info& info)
+            {
+                put_error_(warning_event, info);
+            }
+
+            void error(const sax_error_info& info)
+            {
+                put_error_(error_event, info);
+            }
+
+            void fatal(const sax_error_info& info)
+            {
+                put_error_(fatal_event, info);
+            }
+
+            //! Publishes the end-of-stream event and the last block.
+            //! \param status   the status of the parsing.
+            //! \param message  the error message if the parsing has failed.
+            void finish(sax_stream_status_t status, const std::string& message)
+            {
+                if (begin_(true))
+                {
+                    sax_event_writer writer(*block_);
+                    writer.put_byte(end_of_stream_event);
+                    writer.put_byte(status);
+                    writer.put_string(message.data(), message.size());
+                    pipeline_.publish(block_);
+                    block_ = 0;
+                }
+            }
+
+        private:
+
+            //! Makes sure there is room for the next event in the current block, publishing the
+            //! current block if it is full. If the pipeline is cancelled, stops the parser.
+            //! \param wanted  whether the next event is wanted by the handlers.
+            //! \return true if the event should be encoded, false otherwise.
+            bool begin_(bool wanted)
+            {
+                if (pipeline_.cancelled())
+                {
+                    if (parser_ != 0)
+                    {
+                        parser_->stop();
+                    }
+                    return false;
+                }
+                if (!wanted)
+                {
+                    return false;
+                }
+                if (block_ != 0 && block_->size() >= block_size_)
+                {
+                    pipeline_.publish(block_);
+                    block_ = 0;
+                }
+                if (block_ == 0)
+                {
+                    block_ = pipeline_.acquire();
+                    if (block_ == 0)
+                    {
+                        return begin_(wanted);  // Cancelled while waiting.
+                    }
+                    block_->reserve(block_size_);
+                }
+                return true;
+            }
+
+            void put_name_(sax_event_writer& writer,
+                           const sax_string_view& name,
+                           const sax_string_view& prefix,
+                           const sax_string_view& uri)
+            {
+                if (namespaces_)
+                {
+                    writer.put_string(name);
+                    writer.put_string(prefix);
+                    writer.put_string(uri);
+                }
+                else
+                {
+                    writer.put_qname(prefix, name);
+                    writer.put_string(0, 0);
+                    writer.put_string(0, 0);
+                }
+            }
+
+            void put_chars_(sax_event_type_t type, const sax_string_view& chars)
+            {
+                if (begin_(content_))
+                {
+                    sax_event_writer writer(*block_);
+                    writer.put_byte(type);
+                    writer.put_string(chars);
+                }
+            }
+
+            void put_error_(sax_event_type_t type, const sax_error_info& info)
+            {
+                if (begin_(errors_))
+                {
+                    sax_event_writer writer(*block_);
+                    writer.put_byte(type);
+                    writer.put_string(info.message().data(), info.message().size());
+                    writer.put_string(info.file().data(), info.file().size());
+                    writer.put_uint32(info.line());
+                    writer.put_uint32(info.column());
+                }
+            }
+
+        private:
+
+            sax_pipeline&      pipeline_;    //!< The pipeline.
+            std::size_t        block_size_;  //!< The size of the blocks.
+            bool               content_;     //!< Whether to encode the content events.
+            bool               errors_;      //!< Whether to encode the error events.
+            bool               namespaces_;  //!< Whether the namespaces feature is enabled.
+            parser_type*       parser_;      //!< The parser invoking this handler.
+            std::vector<char>* block_;       //!< The current block.
+
+        };
+
+
+        //! This function object is run by the parser thread: it parses the XML and encodes the
+        //! SAX events, and always ends the stream unless the pipeline is cancelled.
+        class sax_producer
+        {
+
+        public:
+
+            explicit sax_producer(sax_pipeline& pipeline,
+                                  std::size_t block_size,
+                                  const sax_feature_set& features,
+                                  bool content,
+                                  bool errors,
+                                  const std::string* file_name,
+                                  const char* data,
+                                  std::size_t size)
+            : pipeline_(pipeline)
+            , block_size_(block_size)
+            , features_(features)
+            , content_(content)
+            , errors_(errors)
+            , file_name_(file_name)
+            , data_(data)
+            , size_(size)
+            {
+                // Do nothing.
+            }
+
+            void operator()() const
+            {
+                sax_event_encoder encoder( pipeline_,
+                                           block_size_,
+                                           content_,
+                                           errors_,
+                                           features_.test(sax_feature::namespaces) );
+                try
+                {
+                    sax_event_encoder::parser_type parser(encoder);
+                    parser.set_features(features_);
+                    encoder.set_parser(&parser);
+                    if (file_name_ != 0)
+                    {
+                        parser.parse_file(*file_name_);
+                    }
+                    else
+                    {
+                        parser.parse_buffer(data_, size_);
+                    }
+                    encoder.set_parser(0);
+                }
+                catch (const sax_error& ex)
+                {
+                    encoder.set_parser(0);
+                    encoder.finish(stream_failed, ex.what());
+                    return;
+                }
+                catch (...)
+                {
+                    encoder.set_parser(0);
+                    pipeline_.set_exception(std::current_exception());
+                    encoder.finish(stream_aborted, std::string());
+                    return;
+                }
+                encoder.finish(stream_succeeded, std::string());
+            }
+
+        private:
+
+            sax_pipeline&      pipeline_;
+            std::size_t        block_size_;
+            sax_feature_set    features_;
+            bool               content_;
+            bool               errors_;
+            const std::string* file_name_;
+            const char*        data_;
+            std::size_t        size_;
+
+        };
+
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // calling thread
+        //
+
+
+        //! This class replays the encoded events into the handlers, on the calling thread. The
+        //! strings passed to the content handler are kept and reused from one event to the next.
+        class sax_event_replayer
+        {
+
+        public:
+
+            explicit sax_event_replayer(sax_content_handler* content_handler,
+                                        sax_error_handler* error_handler)
+            : content_handler_(content_handler)
+            , error_handler_(error_handler)
+            , status_(stream_succeeded)
+            , message_()
+            , name_()
+            , prefix_()
+            , uri_()
+            , attrs_()
+            {
+                // Do nothing.
+            }
+
+            //! Replays the events of a block.
+            //! \param block  the block of events.
+            //! \return true if the end of the stream is reached, false otherwise.
+            bool replay(const std::vector<char>& block)
+            {
+                sax_event_reader reader(block);
+                while (!reader.eof())
+                {
+                    int type = reader.get_byte();
+                    if (type == end_of_stream_event)
+                    {
+                        status_ = static_cast<sax_stream_status_t>(reader.get_byte());
+                        reader.get_string(message_);
+                        return true;
+                    }
+                    replay_(type, reader);
+                }
+                return false;
+            }
+
+            sax_stream_status_t status() const
+            {
+                return status_;
+            }
+
+            const std::string& message() const
+            {
+                return message_;
+            }
+
+        private:
+
+            void replay_(int type, sax_event_reader& reader)
+            {
+                std::size_t size = 0;
+                const char* chars = 0;
+                switch (type)
+                {
+                case start_document_event:
+                    content_handler_->start_document();
+                    break;
+                case end_document_event:
+                    content_handler_->end_document();
+                    break;
+                case start_element_event:
+                    {
+                        reader.get_string(name_);
+                        reader.get_string(prefix_);
+                        reader.get_string(uri_);
+                        std::size_t count = reader.get_uint32();
+                        attrs_.clear();
+                        for (std::size_t i = 0; i < count; ++i)
+                        {
+                            std::string name, prefix, uri, value;
+                            reader.get_string(name);
+                            reader.get_string(prefix);
+                            reader.get_string(uri);
+                            reader.get_string(value);
+                            attrs_.push_back(sax_attribute(name, prefix, uri, value));
+                        }
+                        content_handler_->start_element(name_, prefix_, uri_, attrs_);
+                    }
+                    break;
+                case end_element_event:
+                    reader.get_string(name_);
+                    reader.get_string(prefix_);
+                    reader.get_string(uri_);
+                    content_handler_->end_element(name_, prefix_, uri_);
+                    break;
+                case characters_event:
+                    chars = reader.get_string(size);
+                    content_handler_->characters(chars, static_cast<int>(size));
+                    break;
+                case cdata_block_event:
+                    chars = reader.get_string(size);
+                    content_handler_->cdata_block(chars, static_cast<int>(size));
+                    break;
+                case ignorable_whitespace_event:
+                    chars = reader.get_string(size);
+                    content_handler_->ignorable_whitespace(chars, static_cast<int>(size));
+                    break;
+                case comment_event:
+                    chars = reader.get_string(size);
+                    content_handler_->comment(chars);
+                    break;
+                case warning_event:
+                case error_event:
+                case fatal_event:
+                    {
+                        const char* message = reader.get_string(size);
+                        const char* file = reader.get_string(size);
+                        unsigned int line = static_cast<unsigned int>(reader.get_uint32());
+                        unsigned int column = static_cast<unsigned int>(reader.get_uint32());
+                        sax_error_info info(message, file, line, column);
+                        if (type == warning_event)
+                        {
+                            error_handler_->warning(info);
+                        }
+                        else if (type == error_event)
+                        {
+                            error_handler_->error(info);
+                        }
+                        else
+                        {
+                            error_handler_->fatal(info);
+                        }
+                    }
+                    break;
+                default:
+                    throw internal_dom_error("Unexpected SAX event in pipeline");
+                }
+            }
+
+        private:
+
+            sax_content_handler* content_handler_;  //!< The content handler.
+            sax_error_handler*   error_handler_;    //!< The error handler.
+            sax_stream_status_t  status_;           //!< The status of the parsing.
+            std::string          message_;          //!< The error message, if any.
+            std::string          name_;             //!< The current element name.
+            std::string          prefix_;           //!< The current element prefix.
+            std::string          uri_;              //!< The current element URI.
+            sax_attribute_list   attrs_;            //!< The current element attributes.
+
+        };
+
+
+    }  // anonymous namespace
+
+
+#endif  // XTREE_HAS_CXX11
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // sax_pipeline_parser
+    //
+
+
+    sax_pipeline_parser::sax_pipeline_parser(std::size_t block_size, std::size_t block_count)
+    : block_size_(block_size > 0 ? block_size : default_block_size)
+    , block_count_(block_count > 1 ? block_count : 2)
+    , features_()
+    , content_handler_(0)
+    , error_handler_(0)
+    , blocks_()
+    {
+        // Do nothing.
+    }
+
+
+    sax_pipeline_parser::~sax_pipeline_parser()
+    {
+        // Do nothing.
+    }
+
+
+    void sax_pipeline_parser::set_content_handler(sax_content_handler* handler)
+    {
+        content_handler_ = handler;
+    }
+
+
+    void sax_pipeline_parser::set_error_handler(sax_error_handler* handler)
+    {
+        error_handler_ = handler;
+    }
+
+
+    void sax_pipeline_parser::set_feature(sax_feature::type feature, bool enable)
+    {
+        features_.set(feature, enable);
+    }
+
+
+    bool sax_pipeline_parser::get_feature(sax_feature::type feature) const
+    {
+        return features_.test(feature);
+    }
+
+
+    void sax_pipeline_parser::set_features(const sax_feature_set& features)
+    {
+        features_ = features;
+    }
+
+
+    const sax_feature_set& sax_pipeline_parser::get_features() const
+    {
+        return features_;
+    }
+
+
+    void sax_pipeline_parser::parse_file(const std::string& file_name)
+    {
+        parse_(&file_name, 0, 0);
+    }
+
+
+    void sax_pipeline_parser::parse_string(const char* str)
+    {
+        if (str == 0)
+        {
+            throw sax_error("Fail to parse string: string is null");
+        }
+        parse_(0, str, std::strlen(str));
+    }
+
+
+    void sax_pipeline_parser::parse_buffer(const char* data, std::size_t size)
+    {
+        if (data == 0)
+        {
+            throw sax_error("Fail to parse buffer: buffer is null");
+        }
+        parse_(0, data, size);
+    }
+
+
+#ifdef XTREE_HAS_CXX11
+
+
+    void sax_pipeline_parser::parse_(const std::string* file_name,
+                                     const char* data,
+                                     std::size_t size)
+    {
+        if (blocks_.size() != block_count_)
+        {
+            blocks_.resize(block_count_);
+        }
+        sax_pipeline pipeline(blocks_);
+        sax_event_replayer replayer(content_handler_, error_handler_);
+        std::thread producer(sax_producer( pipeline,
+                                           block_size_,
+                                           features_,
+                                           (content_handler_ != 0),
+                                           (error_handler_ != 0),
+                                           file_name,
+                                           data,
+                                           size ));
+        // Replay the events until the end of the stream. If a handler throws, cancel the
+        // parsing: the parser thread stops at the next event.
+        try
+        {
+            bool end = false;
+            while (!end)
+            {
+                std::vector<char>* block = pipeline.next();
+                try
+                {
+                    end = replayer.replay(*block);
+                }
+                catch (...)
+                {
+                    pipeline.recycle(block);
+                    throw;
+                }
+                pipeline.recycle(block);
+            }
+        }
+        catch (...)
+        {
+            pipeline.cancel();
+            producer.join();
+            throw;
+        }
+        producer.join();
+        switch (replayer.status())
+        {
+        case stream_failed:
+            throw sax_error(replayer.message());
+        case stream_aborted:
+            std::rethrow_exception(pipeline.exception());
+        default:
+            break;
+        }
+    }
+
+
+#else  // !XTREE_HAS_CXX11
+
+
+    void sax_pipeline_parser::parse_(const std::string* file_name,
+                                     const char* data,
+                                     std::size_t size)
+    {
+        sax_parser parser;
+        parser.set_content_handler(content_handler_);
+        parser.set_error_handler(error_handler_);
+        parser.set_features(features_);
+        if (file_name != 0)
+        {
+            parser.parse_file(*file_name);
+        }
+        else
+        {
+            parser.parse_buffer(data, size);
+        }
+    }
+
+
+#endif  // XTREE_HAS_CXX11
+
+
+}  // namespace xtree
+
@@ -0,0 +1,318 @@
+//
+// Created by ZHENG Zhong on 2011-10-10.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/sax_push_parser.hpp"
+#include "xtree/sax_parser.hpp"
+#include "xtree/exceptions.hpp"
+
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+
+#include <algorithm>
+#include <cassert>
+#include <climits>  // for INT_MAX
+#include <cstddef>
+#include <sstream>
+#include <vector>
+
+
+namespace xtree {
+
+
+    const std::size_t sax_push_parser::default_slice_size;
+
+
+    sax_push_parser::sax_push_parser(): parser_()
+                                      , context_(0)
+                                      , options_(0)
+                                      , pending_()
+                                      , slice_size_(default_slice_size)
+                                      , started_(false)
+                                      , parsing_(false)
+                                      , paused_(false)
+                                      , stopped_(false)
+    {
+        // Do nothing.
+    }
+
+
+    sax_push_parser::~sax_push_parser()
+    {
+        reset();
+        if (context_ != 0)
+        {
+            xmlFreeParserCtxt(context_);
+            context_ = 0;
+        }
+    }
+
+
+    void sax_push_parser::set_content_handler(sax_content_handler* handler)
+    {
+        parser_.set_content_handler(handler);
+    }
+
+
+    void sax_push_parser::set_error_handler(sax_error_handler* handler)
+    {
+        parser_.set_error_handler(handler);
+    }
+
+
+    void sax_push_parser::set_view_handler(sax_view_handler* handler)
+    {
+        parser_.set_view_handler(handler);
+    }
+
+
+    void sax_push_parser::set_feature(sax_feature::type feature, bool enable)
+    {
+        parser_.set_feature(feature, enable);
+    }
+
+
+    bool sax_push_parser::get_feature(sax_feature::type feature) const
+    {
+        return parser_.get_feature(feature);
+    }
+
+
+    void sax_push_parser::set_features(const sax_feature_set& features)
+    {
+        parser_.set_features(features);
+    }
+
+
+    const sax_feature_set& sax_push_parser::get_features() const
+    {
+        return parser_.get_features();
+    }
+
+
+    void sax_push_parser::set_slice_size(std::size_t size)
+    {
+        slice_size_ = size;
+    }
+
+
+    void sax_push_parser::feed(const char* data, std::size_t size)
+    {
+        if (data == 0 && size > 0)
+        {
+            throw sax_error("Fail to parse chunk: chunk is null");
+        }
+        if (parsing_)
+        {
+            throw bad_dom_operation("sax_push_parser::feed() called from a callback");
+        }
+        if (!started_)
+        {
+            start_();
+        }
+        if (stopped_ || size == 0)
+        {
+            return;
+        }
+        // Keep the chunk if the parser is paused, or if some XML kept is not parsed yet.
+        std::size_t consumed = 0;
+        if (!paused_ && pending_.empty())
+        {
+            consumed = parse_slices_(data, size);
+        }
+        if (!stopped_ && consumed < size)
+        {
+            pending_.insert(pending_.end(), data + consumed, data + size);
+        }
+    }
+
+
+    void sax_push_parser::finish()
+    {
+        if (parsing_)
+        {
+            throw bad_dom_operation("sax_push_parser::finish() called from a callback");
+        }
+        if (paused_)
+        {
+            throw bad_dom_operation("sax_push_parser::finish() called while paused");
+        }
+        if (!started_)
+        {
+            throw sax_error("Fail to parse chunks: nothing has been fed");
+        }
+        if (!stopped_)
+        {
+            parse_chunk_(0, 0, true);
+        }
+        reset();
+    }
+
+
+    void sax_push_parser::reset()
+    {
+        assert(!parsing_ && "sax_push_parser::reset() should not be called from a callback");
+        if (context_ != 0)
+        {
+            if (context_->myDoc != 0)
+            {
+                xmlFreeDoc(context_->myDoc);
+                context_->myDoc = 0;
+            }
+            // Free the inputs but keep the parser context (and its dictionary) for reuse.
+            xmlCtxtReset(context_);
+        }
+        pending_.clear();
+        started_ = false;
+        paused_ = false;
+        stopped_ = false;
+    }
+
+
+    void sax_push_parser::stop()
+    {
+        if (started_ && !stopped_)
+        {
+            stopped_ = true;
+            paused_ = false;
+            pending_.clear();
+            xmlStopParser(context_);
+        }
+    }
+
+
+    void sax_push_parser::pause()
+    {
+        if (started_ && !stopped_)
+        {
+            paused_ = true;
+        }
+    }
+
+
+    void sax_push_parser::resume()
+    {
+        if (!paused_)
+        {
+            return;
+        }
+        paused_ = false;
+        // If called from a callback, libxml2 simply goes on parsing the current slice.
+        if (!parsing_ && !pending_.empty())
+        {
+            std::vector<char> pending;
+            pending.swap(pending_);
+            std::size_t consumed = parse_slices_(&pending[0], pending.size());
+            if (!stopped_ && consumed < pending.size())
+            {
+                pending_.assign(pending.begin() + consumed, pending.end());
+            }
+        }
+    }
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // private functions
+    //
+
+
+    void sax_push_parser::start_()
+    {
+        assert(!started_);
+        int options = detail::to_libxml2_parser_options(parser_.get_features());
+        if (context_ != 0 && options != options_)
+        {
+            xmlFreeParserCtxt(context_);
+            context_ = 0;
+        }
+        if (context_ == 0)
+        {
+            xmlSAXHandler handler;
+            detail::initialize_libxml2_sax2_handler(handler);
+            context_ = xmlCreatePushParserCtxt(&handler, 0, 0, 0, 0);
+            if (context_ == 0)
+            {
+                throw sax_error("Fail to parse chunks: unable to create parser context");
+            }
+        }
+        else if (xmlCtxtResetPush(context_, 0, 0, 0, 0) != 0)
+        {
+            throw sax_error("Fail to parse chunks: unable to reset parser context");
+        }
+        context_->userData = context_;
+        context_->_private = &parser_;
+        xmlCtxtUseOptions(context_, options);
+        options_ = options;
+        started_ = true;
+    }
+
+
+    std::size_t sax_push_parser::parse_slices_(const char* data, std::size_t size)
+    {
+        // xmlParseChunk() takes the slice size as an int: never exceed INT_MAX.
+        std::size_t max_slice = static_cast<std::size_t>(INT_MAX);
+        if (slice_size_ != 0)
+        {
+            max_slice = std::min(slice_size_, max_slice);
+        }
+        std::size_t consumed = 0;
+        while (consumed < size && !paused_ && !stopped_)
+        {
+            std::size_t slice = std::min(size - consumed, max_slice);
+            parse_chunk_(data + consumed, static_cast<int>(slice), false);
+            consumed += slice;
+        }
+        return consumed;
+    }
+
+
+    void sax_push_parser::parse_chunk_(const char* data, int size, bool terminate)
+    {
+        assert(started_ && context_ != 0);
+        parsing_ = true;
+        int ret = 0;
+        try
+        {
+            ret = xmlParseChunk(context_, data, size, (terminate ? 1 : 0));
+        }
+        catch (...)
+        {
+            parsing_ = false;
+            discard_context_();
+            throw;
+        }
+        parsing_ = false;
+        // If the parsing has been stopped by the content handler, this is not an error.
+        if (!stopped_ && !context_->wellFormed)
+        {
+            reset();
+            std::ostringstream oss;
+            oss << "Fail to parse chunk: xmlParseChunk returned " << ret;
+            throw sax_error(oss.str());
+        }
+    }
+
+
+    void sax_push_parser::discard_context_()
+    {
+        // The callback has thrown in the middle of the chunk, leaving libxml2 in an unknown state.
+        if (context_ != 0)
+        {
+            if (context_->myDoc != 0)
+            {
+                xmlFreeDoc(context_->myDoc);
+                context_->myDoc = 0;
+            }
+            xmlFreeParserCtxt(context_);
+            context_ = 0;
+        }
+        reset();
+    }
+
+
+}  // namespace xtree
+
@@ -0,0 +1,602 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/stream_pattern.hpp"
+#include "xtree/exceptions.hpp"
+#include "xtree/libxml2_utility.hpp"
+#include "xtree/xml_reader.hpp"
+
+#include <libxml/pattern.h>
+
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace xtree {
+
+
+    namespace {
+
+
+        //! Trims the whitespace at both ends of a string.
+        std::string trim(const std::string& str)
+        {
+            std::string::size_type begin = str.find_first_not_of(" \t\r\n");
+            if (begin == std::string::npos)
+            {
+                return std::string();
+            }
+            std::string::size_type end = str.find_last_not_of(" \t\r\n");
+            return str.substr(begin, end - begin + 1);
+        }
+
+
+        //! Throws an xpath_error about a stream pattern.
+        void throw_pattern_error(const std::string& str, const std::string& reason)
+        {
+            std::string what = "fail to compile stream pattern '" + str + "': " + reason;
+            throw xpath_error(what);
+        }
+
+
+        //! Splits a pattern into the paths of its union, ignoring the '|' inside predicates.
+        std::vector<std::string> split_union(const std::string& str)
+        {
+            std::vector<std::string> paths;
+            std::string::size_type begin = 0;
+            char quote = 0;
+            int brackets = 0;
+            for (std::string::size_type i = 0; i < str.size(); ++i)
+            {
+                char c = str[i];
+                if (quote != 0)
+                {
+                    quote = (c == quote ? 0 : quote);
+                }
+                else if (c == '\'' || c == '"')
+                {
+                    quote = c;
+                }
+                else if (c == '[')
+                {
+                    ++brackets;
+                }
+                else if (c == ']')
+                {
+                    --brackets;
+                }
+                else if (c == '|' && brackets == 0)
+                {
+                    paths.push_back(trim(str.substr(begin, i - begin)));
+                    begin = i + 1;
+                }
+            }
+            if (quote != 0 || brackets != 0)
+            {
+                throw_pattern_error(str, "unbalanced quotes or brackets");
+            }
+            paths.push_back(trim(str.substr(begin)));
+            return paths;
+        }
+
+
+        //! Returns the value of an attribute reported by a SAX parser.
+        //! \return true if the attribute exists, false otherwise.
+        bool find_attr(const sax_attribute_list& attrs,
+                       const std::string& name,
+                       const std::string& uri,
+                       std::string& value)
+        {
+            for (sax_attribute_list::const_iterator i = attrs.begin(); i != attrs.end(); ++i)
+            {
+                if (i->name() == name && i->uri() == uri)
+                {
+                    value = i->value();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+
+        //! Returns the value of an attribute of the current node of an xml_reader.
+        //! \return true if the attribute exists, false otherwise.
+        bool find_attr(const xml_reader& reader,
+                       const std::string& name,
+                       const std::string& uri,
+                       std::string& value)
+        {
+            if (!reader.has_attr(name, uri))
+            {
+                return false;
+            }
+            value = reader.attr(name, uri);
+            return true;
+        }
+
+
+    }  // anonymous namespace
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // stream_pattern
+    //
+
+
+    stream_pattern::stream_pattern(const std::string& str): str_(str), branches_()
+    {
+        compile_(xpath::xmlns_registry());
+    }
+
+
+    stream_pattern::stream_pattern(const std::string& str,
+                                   const std::string& prefix,
+                                   const std::string& uri)
+    : str_(str), branches_()
+    {
+        xpath::xmlns_registry registry;
+        registry.insert(std::make_pair(prefix, uri));
+        compile_(registry);
+    }
+
+
+    stream_pattern::stream_pattern(const std::string& str, const xpath::xmlns_registry& registry)
+    : str_(str), branches_()
+    {
+        compile_(registry);
+    }
+
+
+    stream_pattern::~stream_pattern()
+    {
+        free_();
+    }
+
+
+    void stream_pattern::compile_(const xpath::xmlns_registry& registry)
+    {
+        try
+        {
+            std::vector<std::string> paths = split_union(str_);
+            for (std::vector<std::string>::const_iterator i = paths.begin(); i != paths.end(); ++i)
+            {
+                compile_branch_(*i, registry);
+            }
+        }
+        catch (...)
+        {
+            free_();
+            throw;
+        }
+    }
+
+
+    void stream_pattern::compile_branch_(const std::string& str,
+                                         const xpath::xmlns_registry& registry)
+    {
+        // Separate the location path from the predicates of its last step.
+        branch b;
+        b.raw = 0;
+        std::string path;
+        std::string::size_type i = 0;
+        while (i < str.size() && str[i] != '[')
+        {
+            path.append(1, str[i++]);
+        }
+        while (i < str.size())
+        {
+            if (str[i] == ' ' || str[i] == '\t')
+            {
+                ++i;
+                continue;
+            }
+            if (str[i] != '[')
+            {
+                throw_pattern_error(str_, "predicates are only supported on the last step");
+            }
+            // Find the end of the predicate, skipping quoted literals.
+            std::string::size_type end = i + 1;
+            char quote = 0;
+            while (end < str.size() && (quote != 0 || str[end] != ']'))
+            {
+                if (quote != 0)
+                {
+                    quote = (str[end] == quote ? 0 : quote);
+                }
+                else if (str[end] == '\'' || str[end] == '"')
+                {
+                    quote = str[end];
+                }
+                ++end;
+            }
+            std::string predicate = trim(str.substr(i + 1, end - i - 1));
+            i = end + 1;
+            // Parse the predicate: @qname, @qname='value' or @qname!='value'.
+            std::string::size_type op_pos = predicate.find_first_of("!=");
+            std::string qname = trim(predicate.substr(0, op_pos));
+            if (qname.size() < 2 || qname[0] != '@')
+            {
+                throw_pattern_error(str_, "unsupported predicate [" + predicate + "]");
+            }
+            attr_predicate pred;
+            std::pair<std::string, std::string> prefix_name = detail::split_qname(qname.substr(1));
+            pred.name = prefix_name.second;
+            if (!prefix_name.first.empty())
+            {
+                xpath::xmlns_registry::const_iterator found = registry.find(prefix_name.first);
+                if (found == registry.end())
+                {
+                    throw_pattern_error(str_, "undefined namespace prefix " + prefix_name.first);
+                }
+                pred.uri = found->second;
+            }
+            if (op_pos == std::string::npos)
+            {
+                pred.op = attr_exists;
+            }
+            else
+            {
+                std::string::size_type value_pos = op_pos + 1;
+                pred.op = attr_equal;
+                if (predicate[op_pos] == '!')
+                {
+                    if (value_pos >= predicate.size() || predicate[value_pos] != '=')
+                    {
+                        throw_pattern_error(str_, "unsupported predicate [" + predicate + "]");
+                    }
+                    pred.op = attr_not_equal;
+                    ++value_pos;
+                }
+                std::string literal = trim(predicate.substr(value_pos));
+                if ( literal.size() < 2
+                  || (literal[0] != '\'' && literal[0] != '"')
+                  || literal[literal.size() - 1] != literal[0] )
+                {
+                    throw_pattern_error(str_, "unsupported predicate [" + predicate + "]");
+                }
+                pred.value = literal.substr(1, literal.size() - 2);
+            }
+            b.predicates.push_back(pred);
+        }
+        path = trim(path);
+        if (path.find('@') != std::string::npos)
+        {
+            throw_pattern_error(str_, "only elements may be selected");
+        }
+        // Compile the location path: the namespaces are passed as (URI, prefix) pairs.
+        std::vector<const xmlChar*> namespaces;
+        typedef xpath::xmlns_registry::const_iterator const_iterator;
+        for (const_iterator j = registry.begin(); j != registry.end(); ++j)
+        {
+            namespaces.push_back(detail::to_xml_chars(j->second.c_str()));
+            namespaces.push_back(detail::to_xml_chars(j->first.c_str()));
+        }
+        namespaces.push_back(0);
+        namespaces.push_back(0);
+        b.raw = xmlPatterncompile( detail::to_xml_chars(path.c_str()),
+                                   0,
+                                   XML_PATTERN_XPATH,
+                                   &namespaces[0] );
+        if (b.raw == 0)
+        {
+            throw_pattern_error(str_, "invalid location path " + path);
+        }
+        if (xmlPatternStreamable(b.raw) != 1)
+        {
+            xmlFreePattern(b.raw);
+            throw_pattern_error(str_, "location path " + path + " is not streamable");
+        }
+        try
+        {
+            branches_.push_back(b);
+        }
+        catch (...)
+        {
+            xmlFreePattern(b.raw);
+            throw;
+        }
+    }
+
+
+    void stream_pattern::free_()
+    {
+        for (std::vector<branch>::iterator i = branches_.begin(); i != branches_.end(); ++i)
+        {
+            xmlFreePattern(i->raw);
+        }
+        branches_.clear();
+    }
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // stream_match_handler
+    //
+
+
+    stream_match_handler::stream_match_handler()
+    {
+        // Do nothing.
+    }
+
+
+    stream_match_handler::~stream_match_handler()
+    {
+        // Do nothing.
+    }
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // stream_matcher
+    //
+
+
+    stream_matcher::stream_matcher(const stream_pattern& pattern)
+    : pattern_(pattern)
+    , streams_()
+    , matches_()
+    , match_handler_(0)
+    , content_handler_(0)
+    , open_matches_(0)
+    , count_(0)
+    , pending_(false)
+    {
+        reset();
+    }
+
+
+    stream_matcher::~stream_matcher()
+    {
+        free_streams_();
+    }
+
+
+    void stream_matcher::set_match_handler(stream_match_handler* handler)
+    {
+        match_handler_ = handler;
+    }
+
+
+    void stream_matcher::set_content_handler(sax_content_handler* handler)
+    {
+        content_handler_ = handler;
+    }
+
+
+    void stream_matcher::reset()
+    {
+        // Libxml2 streams cannot be rewound: create new ones, and push the document node.
+        free_streams_();
+        matches_.clear();
+        open_matches_ = 0;
+        count_ = 0;
+        pending_ = false;
+        typedef std::vector<stream_pattern::branch>::const_iterator const_iterator;
+        for (const_iterator i = pattern_.branches_.begin(); i != pattern_.branches_.end(); ++i)
+        {
+            xmlStreamCtxt* stream = xmlPatternGetStreamCtxt(i->raw);
+            if (stream == 0)
+            {
+                free_streams_();
+                std::string what = "fail to create stream for pattern '" + pattern_.str() + "'";
+                throw internal_dom_error(what);
+            }
+            streams_.push_back(stream);
+            xmlStreamPush(stream, 0, 0);
+        }
+    }
+
+
+    bool stream_matcher::next(xml_reader& reader)
+    {
+        bool moved = (pending_ || reader.next());
+        pending_ = false;
+        for (; moved; moved = reader.next())
+        {
+            // The depth of the reader tells how many of the open elements have been closed,
+            // including those skipped by xml_reader::next_sibling().
+            std::size_t depth = static_cast<std::size_t>(reader.depth());
+            pop_(depth);
+            if (reader.node_type() == reader_element)
+            {
+                bool matched = push_(reader.local_name(), reader.uri(), reader);
+                if (reader.is_empty_element())
+                {
+                    pop_(depth);
+                }
+                if (matched)
+                {
+                    return true;
+                }
+            }
+        }
+        pop_(0);
+        return false;
+    }
+
+
+    void stream_matcher::skip(xml_reader& reader)
+    {
+        pending_ = reader.next_sibling();
+    }
+
+
+    void stream_matcher::start_document()
+    {
+        reset();
+        if (content_handler_ != 0)
+        {
+            content_handler_->start_document();
+        }
+    }
+
+
+    void stream_matcher::end_document()
+    {
+        if (content_handler_ != 0)
+        {
+            content_handler_->end_document();
+        }
+    }
+
+
+    void stream_matcher::start_element(const std::string& name,
+                                       const std::string& prefix,
+                                       const std::string& uri,
+                                       const sax_attribute_list& attrs)
+    {
+        bool matched = push_(name, uri, attrs);
+        if (matched && match_handler_ != 0)
+        {
+            match_handler_->start_match(name, prefix, uri, attrs);
+        }
+        if (content_handler_ != 0)
+        {
+            content_handler_->start_element(name, prefix, uri, attrs);
+        }
+    }
+
+
+    void stream_matcher::end_element(const std::string& name,
+                                     const std::string& prefix,
+                                     const std::string& uri)
+    {
+        if (content_handler_ != 0)
+        {
+            content_handler_->end_element(name, prefix, uri);
+        }
+        if (!matches_.empty() && matches_.back() && match_handler_ != 0)
+        {
+            match_handler_->end_match(name, prefix, uri);
+        }
+        if (!matches_.empty())
+        {
+            pop_(matches_.size() - 1);
+        }
+    }
+
+
+    void stream_matcher::characters(const char* chars, int length)
+    {
+        if (content_handler_ != 0)
+        {
+            content_handler_->characters(chars, length);
+        }
+    }
+
+
+    void stream_matcher::cdata_block(const char* chars, int length)
+    {
+        if (content_handler_ != 0)
+        {
+            content_handler_->cdata_block(chars, length);
+        }
+    }
+
+
+    void stream_matcher::ignorable_whitespace(const char* chars, int length)
+    {
+        if (content_handler_ != 0)
+        {
+            content_handler_->ignorable_whitespace(chars, length);
+        }
+    }
+
+
+    void stream_matcher::comment(const char* chars)
+    {
+        if (content_handler_ != 0)
+        {
+            content_handler_->comment(chars);
+        }
+    }
+
+
+    template<class Attributes>
+    bool stream_matcher::push_(const std::string& name,
+                               const std::string& uri,
+                               const Attributes& attrs)
+    {
+        const xmlChar* ns = (uri.empty() ? 0 : detail::to_xml_chars(uri.c_str()));
+        bool matched = false;
+        for (std::size_t i = 0; i < streams_.size(); ++i)
+        {
+            int ret = xmlStreamPush(streams_[i], detail::to_xml_chars(name.c_str()), ns);
+            if (ret < 0)
+            {
+                std::string what = "fail to match stream pattern '" + pattern_.str() + "'";
+                throw internal_dom_error(what);
+            }
+            if (ret == 0 || matched)
+            {
+                continue;
+            }
+            // The location path matches: check the predicates of the last step.
+            matched = true;
+            const std::vector<stream_pattern::attr_predicate>& predicates =
+                pattern_.branches_[i].predicates;
+            typedef std::vector<stream_pattern::attr_predicate>::const_iterator const_iterator;
+            for (const_iterator j = predicates.begin(); matched && j != predicates.end(); ++j)
+            {
+                std::string value;
+                bool found = find_attr(attrs, j->name, j->uri, value);
+                switch (j->op)
+                {
+                case stream_pattern::attr_exists:
+                    matched = found;
+                    break;
+                case stream_pattern::attr_equal:
+                    matched = (found && value == j->value);
+                    break;
+                case stream_pattern::attr_not_equal:
+                    matched = (found && value != j->value);
+                    break;
+                }
+            }
+        }
+        matches_.push_back(matched);
+        if (matched)
+        {
+            ++open_matches_;
+            ++count_;
+        }
+        return matched;
+    }
+
+
+    void stream_matcher::pop_(std::size_t depth)
+    {
+        while (matches_.size() > depth)
+        {
+            for (std::size_t i = 0; i < streams_.size(); ++i)
+            {
+                xmlStreamPop(streams_[i]);
+            }
+            if (matches_.back())
+            {
+                --open_matches_;
+            }
+            matches_.pop_back();
+        }
+    }
+
+
+    void stream_matcher::free_streams_()
+    {
+        for (std::vector<xmlStreamCtxt*>::iterator i = streams_.begin(); i != streams_.end(); ++i)
+        {
+            xmlFreeStreamCtxt(*i);
+        }
+        streams_.clear();
+    }
+
+
+}  // namespace xtree
+
@@ -0,0 +1,397 @@
+//
+// Created by ZHENG Zhong on 2011-10-17.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/subtree_splitter.hpp"
+#include "xtree/basic_sax_parser.hpp"
+#include "xtree/dom_builder.hpp"
+#include "xtree/document.hpp"
+#include "xtree/exceptions.hpp"
+#include "xtree/sax_attribute_list.hpp"
+#include "xtree/sax_attribute_view.hpp"
+#include "xtree/sax_error_info.hpp"
+#include "xtree/sax_string_view.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace xtree {
+
+
+    namespace {
+
+
+        //! This handler tracks the path of the current element, and forwards the SAX events of
+        //! the matching subtrees to a dom_builder. Outside the matching subtrees, it does not
+        //! copy any string.
+        class subtree_collector: public basic_sax_handler<subtree_collector>
+        {
+
+        public:
+
+            explicit subtree_collector(const std::vector<std::string>& steps,
+                                       subtree_handler* handler,
+                                       sax_error_handler* error_handler,
+                                       std::size_t& count)
+            : steps_(steps)
+            , subtree_handler_(handler)
+            , error_handler_(error_handler)
+            , count_(count)
+            , builder_()
+            , depth_(0)
+            , matched_(0)
+            , subtree_depth_(0)
+            , name_()
+            , prefix_()
+            , uri_()
+            , text_()
+            , attrs_()
+            {
+                // Do nothing.
+            }
+
+            void start_element(const sax_string_view& name,
+                               const sax_string_view& prefix,
+                               const sax_string_view& uri,
+                               const sax_attribute_view_list& attrs)
+            {
+                ++depth_;
+                if (subtree_depth_ == 0)
+                {
+                    // Outside the subtrees: check if the element matches the path.
+                    if (matched_ + 1 != depth_ || depth_ > steps_.size())
+                    {
+                        return;
+                    }
+                    const std::string& step = steps_[depth_ - 1];
+                    if (step != "*" && name != step)
+                    {
+                        return;
+                    }
+                    matched_ = depth_;
+                    if (depth_ < steps_.size())
+                    {
+                        return;
+                    }
+                    subtree_depth_ = depth_;
+                    builder_.start_document();
+                }
+                attrs_.clear();
+                for (sax_attribute_view_list::const_iterator i = attrs.begin();
+                     i != attrs.end();
+                     ++i)
+                {
+                    sax_attribute_view attr = *i;
+                    attrs_.push_back(sax_attribute( attr.name().str(),
+                                                    attr.prefix().str(),
+                                                    attr.uri().str(),
+                                                    attr.value().str() ));
+                }
+                builder_.start_element(assign_(name_, name),
+                                       assign_(prefix_, prefix),
+                                       assign_(uri_, uri),
+                                       attrs_);
+            }
+
+            void end_element(const sax_string_view& name,
+                             const sax_string_view& prefix,
+                             const sax_string_view& uri)
+            {
+                if (subtree_depth_ != 0)
+                {
+                    builder_.end_element(assign_(name_, name),
+                                         assign_(prefix_, prefix),
+                                         assign_(uri_, uri));
+                    if (depth_ == subtree_depth_)
+                    {
+                        subtree_depth_ = 0;
+                        builder_.end_document();
+                        std::auto_ptr<document> doc = builder_.release();
+                        std::size_t index = count_++;
+                        if (subtree_handler_ != 0)
+                        {
+                            subtree_handler_->subtree(doc, index);
+                        }
+                    }
+                }
+                if (matched_ == depth_)
+                {
+                    --matched_;
+                }
+                --depth_;
+            }
+
+            void characters(const sax_string_view& chars)
+            {
+                if (subtree_depth_ != 0)
+                {
+                    builder_.characters(chars.data(), static_cast<int>(chars.size()));
+                }
+            }
+
+            void cdata_block(const sax_string_view& chars)
+            {
+                if (subtree_depth_ != 0)
+                {
+                    builder_.cdata_block(chars.data(), static_cast<int>(chars.size()));
+                }
+            }
+
+            void ignorable_whitespace(const sax_string_view& chars)
+            {
+                if (subtree_depth_ != 0)
+                {
+                    builder_.ignorable_whitespace(chars.data(), static_cast<int>(chars.size()));
+                }
+            }
+
+            void comment(const sax_string_view& chars)
+            {
+                if (subtree_depth_ != 0)
+                {
+                    builder_.comment(assign_(text_, chars).c_str());
+                }
+            }
+
+            void warning(const sax_error_info& info)
+            {
+                if (error_handler_ != 0)
+                {
+                    error_handler_->warning(info);
+                }
+            }
+
+            void error(const sax_error_info& info)
+            {
+                if (error_handler_ != 0)
+                {
+                    error_handler_->error(info);
+                }
+            }
+
+            void fatal(const sax_error_info& info)
+            {
+                if (error_handler_ != 0)
+                {
+                    error_handler_->fatal(info);
+                }
+            }
+
+        private:
+
+            static const std::string& assign_(std::string& str, const sax_string_view& view)
+            {
+                str.assign(view.data(), view.size());
+                return str;
+            }
+
+        private:
+
+            const std::vector<std::string>& steps_;            //!< The element names in the path.
+            subtree_handler*                subtree_handler_;  //!< The subtree handler.
+            sax_error_handler*              error_handler_;    //!< The error handler.
+            std::size_t&                    count_;            //!< The number of subtrees.
+            dom_builder                     builder_;          //!< The builder of the subtrees.
+            std::size_t                     depth_;            //!< The current element depth.
+            std::size_t                     matched_;          //!< The depth matching the path.
+            std::size_t                     subtree_depth_;    //!< The subtree depth, or 0.
+            std::string                     name_;             //!< Reused element name.
+            std::string                     prefix_;           //!< Reused element prefix.
+            std::string                     uri_;              //!< Reused element URI.
+            std::string                     text_;             //!< Reused comment text.
+            sax_attribute_list              attrs_;            //!< Reused attribute list.
+
+        };
+
+
+        //! This class sets a pointer during its lifetime, even if an exception is thrown.
+        template<class T>
+        class pointer_scope
+        {
+
+        public:
+
+            explicit pointer_scope(T*& pointer, T* value): pointer_(pointer)
+            {
+                pointer_ = value;
+            }
+
+            ~pointer_scope()
+            {
+                pointer_ = 0;
+            }
+
+        private:
+
+            T*& pointer_;
+
+        };
+
+
+    }  // anonymous namespace
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // subtree_handler
+    //
+
+
+    subtree_handler::subtree_handler()
+    {
+        // Do nothing.
+    }
+
+
+    subtree_handler::~subtree_handler()
+    {
+        // Do nothing.
+    }
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // subtree_splitter
+    //
+
+
+    subtree_splitter::subtree_splitter(const std::string& path)
+    : path_(path)
+    , steps_()
+    , features_()
+    , subtree_handler_(0)
+    , error_handler_(0)
+    , parser_(0)
+    , count_(0)
+    , stopped_(false)
+    {
+        // Split the path into element names, ignoring the leading slash.
+        std::string::size_type begin = (!path.empty() && path[0] == '/' ? 1 : 0);
+        while (begin <= path.size())
+        {
+            std::string::size_type end = path.find('/', begin);
+            if (end == std::string::npos)
+            {
+                end = path.size();
+            }
+            if (end == begin)
+            {
+                throw sax_error("Invalid subtree path: " + path);
+            }
+            steps_.push_back(path.substr(begin, end - begin));
+            begin = end + 1;
+        }
+    }
+
+
+    subtree_splitter::~subtree_splitter()
+    {
+        // Do nothing.
+    }
+
+
+    void subtree_splitter::set_subtree_handler(subtree_handler* handler)
+    {
+        subtree_handler_ = handler;
+    }
+
+
+    void subtree_splitter::set_error_handler(sax_error_handler* handler)
+    {
+        error_handler_ = handler;
+    }
+
+
+    void subtree_splitter::set_feature(sax_feature::type feature, bool enable)
+    {
+        features_.set(feature, enable);
+    }
+
+
+    bool subtree_splitter::get_feature(sax_feature::type feature) const
+    {
+        return features_.test(feature);
+    }
+
+
+    void subtree_splitter::set_features(const sax_feature_set& features)
+    {
+        features_ = features;
+    }
+
+
+    const sax_feature_set& subtree_splitter::get_features() const
+    {
+        return features_;
+    }
+
+
+    void subtree_splitter::stop()
+    {
+        stopped_ = true;
+        if (parser_ != 0)
+        {
+            parser_->stop();
+        }
+    }
+
+
+    void subtree_splitter::parse_file(const std::string& file_name)
+    {
+        parse_(&file_name, 0, 0);
+    }
+
+
+    void subtree_splitter::parse_string(const char* str)
+    {
+        if (str == 0)
+        {
+            throw sax_error("Fail to parse string: string is null");
+        }
+        parse_(0, str, std::strlen(str));
+    }
+
+
+    void subtree_splitter::parse_buffer(const char* data, std::size_t size)
+    {
+        if (data == 0)
+        {
+            throw sax_error("Fail to parse buffer: buffer is null");
+        }
+        parse_(0, data, size);
+    }
+
+
+    void subtree_splitter::parse_(const std::string* file_name,
+                                  const char* data,
+                                  std::size_t size)
+    {
+        if (parser_ != 0)
+        {
+            throw bad_dom_operation("subtree splitter does not support nested parsing");
+        }
+        count_ = 0;
+        stopped_ = false;
+        subtree_collector collector(steps_, subtree_handler_, error_handler_, count_);
+        basic_sax_parser<subtree_collector> parser(collector);
+        parser.set_features(features_);
+        pointer_scope<detail::basic_sax_parser_base> scope(parser_, &parser);
+        if (file_name != 0)
+        {
+            parser.parse_file(*file_name);
+        }
+        else
+        {
+            parser.parse_buffer(data, size);
+        }
+    }
+
+
+}  // namespace xtree
+
@@ -7,6 +7,7 @@
 #endif
 
 #include "xtree/text.hpp"
+#include "xtree/libxml2_callbacks.hpp"
 
 #include <libxml/tree.h>
 #include <cassert>
@@ -38,11 +39,12 @@ namespace xtree {
     {
         if (px != 0 && (px->type == XML_TEXT_NODE || px->type == XML_CDATA_SECTION_NODE))
         {
-            if (px->_private == 0)
+            const void* wrapper = detail::get_or_create_private(px);
+            if (wrapper == 0)
             {
                 throw internal_dom_error("fail to cast xmlNode to text: _private is null");
             }
-            return static_cast<const text*>(px->_private);
+            return static_cast<const text*>(wrapper);
         }
         else
         {
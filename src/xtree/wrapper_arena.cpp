@@ -0,0 +1,310 @@
+//
+// Created by ZHENG Zhong on 2011-09-20.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/wrapper_arena.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+
+namespace xtree {
+namespace detail {
+
+
+    namespace {
+
+
+        //! The header prefixing every wrapper memory block, recording the arena which the memory
+        //! block comes from. The union ensures that the wrapper object following the header is
+        //! properly aligned.
+        union wrapper_header
+        {
+            wrapper_arena* arena;
+            double         align;
+        };
+
+
+        //! Rounds up a size to the alignment.
+        inline std::size_t align_size(std::size_t size, std::size_t alignment)
+        {
+            return (size + alignment - 1) / alignment * alignment;
+        }
+
+
+#ifdef XTREE_HAS_CXX11
+
+
+        //! The current wrapper arena scope of the calling thread.
+        thread_local wrapper_arena_scope* current_scope = 0;
+
+
+#endif  // XTREE_HAS_CXX11
+
+
+    }  // anonymous namespace
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // wrapper_arena
+    //
+
+
+    const std::size_t wrapper_arena::alignment;
+    const std::size_t wrapper_arena::max_recycled_size;
+    const std::size_t wrapper_arena::initial_chunk_size;
+    const std::size_t wrapper_arena::max_chunk_size;
+
+
+    wrapper_arena* wrapper_arena::create()
+    {
+        return new wrapper_arena();
+    }
+
+
+    void wrapper_arena::add_ref()
+    {
+        ++ref_count_;
+    }
+
+
+    void wrapper_arena::release()
+    {
+        long ref_count = --ref_count_;
+        assert(ref_count >= 0 && "wrapper_arena reference count should not be negative");
+        if (ref_count == 0)
+        {
+            delete this;
+        }
+    }
+
+
+    void wrapper_arena::retain(wrapper_arena* other)
+    {
+        if ( other != 0
+          && other != this
+          && std::find(retained_.begin(), retained_.end(), other) == retained_.end() )
+        {
+            retained_.reserve(retained_.size() + 1);
+            other->add_ref();
+            retained_.push_back(other);
+        }
+    }
+
+
+    void* wrapper_arena::allocate(std::size_t size)
+    {
+        size = align_size(std::max(size, sizeof(free_block)), alignment);
+        // Reuse a recycled memory block if possible.
+        if (size <= max_recycled_size && free_lists_[size / alignment] != 0)
+        {
+            free_block* block = free_lists_[size / alignment];
+            free_lists_[size / alignment] = block->next;
+            return block;
+        }
+        // Otherwise, carve a new memory block out of the current chunk.
+        if (current_ == 0 || static_cast<std::size_t>(limit_ - current_) < size)
+        {
+            grow_(size);
+        }
+        void* p = current_;
+        current_ += size;
+        return p;
+    }
+
+
+    void wrapper_arena::deallocate(void* p, std::size_t size)
+    {
+        size = align_size(std::max(size, sizeof(free_block)), alignment);
+        if (p != 0 && size <= max_recycled_size)
+        {
+            free_block* block = static_cast<free_block*>(p);
+            block->next = free_lists_[size / alignment];
+            free_lists_[size / alignment] = block;
+        }
+        // Large memory blocks are not recycled: they will be released with the arena.
+    }
+
+
+    wrapper_arena::wrapper_arena(): ref_count_(1)
+                                  , chunks_()
+                                  , current_(0)
+                                  , limit_(0)
+                                  , next_chunk_size_(initial_chunk_size)
+                                  , reserved_bytes_(0)
+                                  , retained_()
+    {
+        std::fill(free_lists_, free_lists_ + sizeof(free_lists_) / sizeof(free_lists_[0]),
+                  static_cast<free_block*>(0));
+    }
+
+
+    wrapper_arena::~wrapper_arena()
+    {
+        for (std::vector<char*>::iterator i = chunks_.begin(); i != chunks_.end(); ++i)
+        {
+            ::operator delete(*i);
+        }
+        chunks_.clear();
+        for (std::vector<wrapper_arena*>::iterator i = retained_.begin(); i != retained_.end(); ++i)
+        {
+            (*i)->release();
+        }
+        retained_.clear();
+    }
+
+
+    void wrapper_arena::grow_(std::size_t size)
+    {
+        std::size_t chunk_size = std::max(next_chunk_size_, size);
+        chunks_.reserve(chunks_.size() + 1);
+        char* chunk = static_cast<char*>(::operator new(chunk_size));
+        chunks_.push_back(chunk);
+        current_ = chunk;
+        limit_ = chunk + chunk_size;
+        reserved_bytes_ += chunk_size;
+        next_chunk_size_ = std::min(next_chunk_size_ * 2, max_chunk_size);
+    }
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // wrapper allocation functions
+    //
+
+
+    void* allocate_wrapper(wrapper_arena* arena, std::size_t size)
+    {
+        std::size_t total = sizeof(wrapper_header) + size;
+        void* p = (arena != 0 ? arena->allocate(total) : ::operator new(total));
+        wrapper_header* header = static_cast<wrapper_header*>(p);
+        header->arena = arena;
+        return (header + 1);
+    }
+
+
+    wrapper_arena* get_wrapper_arena(const void* p)
+    {
+        assert(p != 0);
+        const wrapper_header* header = static_cast<const wrapper_header*>(p) - 1;
+        return header->arena;
+    }
+
+
+    void free_wrapper(void* p, std::size_t size, wrapper_arena* owner)
+    {
+        if (p != 0)
+        {
+            wrapper_header* header = static_cast<wrapper_header*>(p) - 1;
+            if (header->arena == 0)
+            {
+                ::operator delete(header);
+            }
+            else if (header->arena == owner)
+            {
+                header->arena->deallocate(header, sizeof(wrapper_header) + size);
+            }
+            // Otherwise, the memory will be released together with the arena.
+        }
+    }
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // wrapper_arena_scope
+    //
+
+
+#ifdef XTREE_HAS_CXX11
+
+
+    wrapper_arena_scope::wrapper_arena_scope(): arena_(0), previous_(0), detached_(false)
+    {
+        previous_ = current_scope;
+        current_scope = this;
+    }
+
+
+    wrapper_arena_scope::wrapper_arena_scope(wrapper_arena* arena): arena_(arena)
+                                                                  , previous_(0)
+                                                                  , detached_(true)
+    {
+        // The arena is owned by the caller: this scope behaves as if it had been detached.
+        previous_ = current_scope;
+        current_scope = this;
+    }
+
+
+    wrapper_arena_scope::~wrapper_arena_scope()
+    {
+        current_scope = previous_;
+        if (arena_ != 0 && !detached_)
+        {
+            arena_->release();
+        }
+        arena_ = 0;
+    }
+
+
+    wrapper_arena* wrapper_arena_scope::current(bool create)
+    {
+        wrapper_arena_scope* scope = current_scope;
+        if (scope == 0)
+        {
+            return 0;
+        }
+        if (scope->arena_ == 0 && create && !scope->detached_)
+        {
+            scope->arena_ = wrapper_arena::create();
+        }
+        return scope->arena_;
+    }
+
+
+#else  // !XTREE_HAS_CXX11
+
+
+    wrapper_arena_scope::wrapper_arena_scope(): arena_(0), previous_(0), detached_(false)
+    {
+        // Do nothing.
+    }
+
+
+    wrapper_arena_scope::wrapper_arena_scope(wrapper_arena* arena): arena_(arena)
+                                                                  , previous_(0)
+                                                                  , detached_(true)
+    {
+        // Do nothing.
+    }
+
+
+    wrapper_arena_scope::~wrapper_arena_scope()
+    {
+        // Do nothing.
+    }
+
+
+    wrapper_arena* wrapper_arena_scope::current(bool)
+    {
+        return 0;
+    }
+
+
+#endif  // XTREE_HAS_CXX11
+
+
+    wrapper_arena* wrapper_arena_scope::detach()
+    {
+        detached_ = true;
+        return arena_;
+    }
+
+
+}  // namespace xtree::detail
+}  // namespace xtree
+
@@ -0,0 +1,401 @@
+//
+// Created by ZHENG Zhong on 2011-10-18.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/xml_reader.hpp"
+#include "xtree/element.hpp"
+#include "xtree/exceptions.hpp"
+#include "xtree/libxml2_callbacks.hpp"
+#include "xtree/libxml2_utility.hpp"
+#include "xtree/wrapper_arena.hpp"
+
+#include <libxml/xmlreader.h>
+
+#include <cassert>
+#include <climits>  // for INT_MAX
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+
+namespace xtree {
+
+
+    namespace {
+
+
+        //! Converts a string returned by libxml2 to std::string, and frees it.
+        //! \param chars  the string returned by libxml2, may be null.
+        //! \return the string, or an empty string if the string returned is null.
+        std::string take_xml_chars(xmlChar* chars)
+        {
+            if (chars == 0)
+            {
+                return std::string();
+            }
+            std::string str = detail::to_chars(chars);
+            xmlFree(chars);
+            return str;
+        }
+
+
+        //! Converts a namespace URI to a libxml2 string.
+        //! \param uri  the namespace URI, or an empty string for no namespace.
+        //! \return the libxml2 string, or null for no namespace.
+        const xmlChar* to_xml_uri(const std::string& uri)
+        {
+            return (uri.empty() ? 0 : detail::to_xml_chars(uri.c_str()));
+        }
+
+
+        //! Converts a constant string returned by libxml2 to std::string.
+        //! \param chars  the string returned by libxml2, may be null.
+        //! \return the string, or an empty string if the string returned is null.
+        std::string copy_xml_chars(const xmlChar* chars)
+        {
+            return (chars != 0 ? std::string(detail::to_chars(chars)) : std::string());
+        }
+
+
+    }  // anonymous namespace
+
+
+    xml_reader::xml_reader(): reader_(0), features_(), opened_(false), error_(), arena_(0)
+    {
+        // Do nothing.
+    }
+
+
+    xml_reader::~xml_reader()
+    {
+        if (reader_ != 0)
+        {
+            xmlFreeTextReader(reader_);
+            reader_ = 0;
+        }
+        if (arena_ != 0)
+        {
+            arena_->release();
+            arena_ = 0;
+        }
+    }
+
+
+    void xml_reader::set_feature(sax_feature::type feature, bool enable)
+    {
+        features_.set(feature, enable);
+    }
+
+
+    bool xml_reader::get_feature(sax_feature::type feature) const
+    {
+        return features_.test(feature);
+    }
+
+
+    void xml_reader::set_features(const sax_feature_set& features)
+    {
+        features_ = features;
+    }
+
+
+    const sax_feature_set& xml_reader::get_features() const
+    {
+        return features_;
+    }
+
+
+    void xml_reader::open_file(const std::string& file_name)
+    {
+        close();
+        int options = detail::to_libxml2_parser_options(features_);
+        bool opened = false;
+        if (reader_ == 0)
+        {
+            reader_ = xmlReaderForFile(file_name.c_str(), 0, options);
+            opened = (reader_ != 0);
+        }
+        else
+        {
+            opened = (xmlReaderNewFile(reader_, file_name.c_str(), 0, options) == 0);
+        }
+        on_open_(opened, "fail to open xml file " + file_name);
+    }
+
+
+    void xml_reader::open_string(const char* str)
+    {
+        if (str == 0)
+        {
+            throw dom_error("fail to open xml string: null string");
+        }
+        open_buffer(str, std::strlen(str));
+    }
+
+
+    void xml_reader::open_buffer(const char* data, std::size_t size)
+    {
+        close();
+        if (data == 0)
+        {
+            throw dom_error("fail to open xml buffer: null buffer");
+        }
+        if (size > static_cast<std::size_t>(INT_MAX))
+        {
+            throw dom_error("fail to open xml buffer: buffer is too large");
+        }
+        int options = detail::to_libxml2_parser_options(features_);
+        int int_size = static_cast<int>(size);
+        bool opened = false;
+        if (reader_ == 0)
+        {
+            reader_ = xmlReaderForMemory(data, int_size, 0, 0, options);
+            opened = (reader_ != 0);
+        }
+        else
+        {
+            opened = (xmlReaderNewMemory(reader_, data, int_size, 0, 0, options) == 0);
+        }
+        on_open_(opened, "fail to open xml buffer");
+    }
+
+
+    void xml_reader::close()
+    {
+        if (opened_)
+        {
+            assert(reader_ != 0);
+            xmlTextReaderClose(reader_);
+            opened_ = false;
+        }
+        // The wrappers allocated from the arena have been dropped with the libxml2 nodes.
+        if (arena_ != 0)
+        {
+            arena_->release();
+            arena_ = 0;
+        }
+        error_.clear();
+    }
+
+
+    bool xml_reader::next()
+    {
+        check_open_("next()");
+        detail::wrapper_arena_scope arena_scope(arena_);
+        return check_move_(xmlTextReaderRead(reader_));
+    }
+
+
+    bool xml_reader::next_sibling()
+    {
+        check_open_("next_sibling()");
+        detail::wrapper_arena_scope arena_scope(arena_);
+        return check_move_(xmlTextReaderNext(reader_));
+    }
+
+
+    reader_node_t xml_reader::node_type() const
+    {
+        if (!opened_)
+        {
+            return reader_none;
+        }
+        switch (xmlTextReaderNodeType(reader_))
+        {
+        case XML_READER_TYPE_NONE:
+            return reader_none;
+        case XML_READER_TYPE_ELEMENT:
+            return reader_element;
+        case XML_READER_TYPE_END_ELEMENT:
+            return reader_end_element;
+        case XML_READER_TYPE_TEXT:
+            return reader_text;
+        case XML_READER_TYPE_CDATA:
+            return reader_cdata;
+        case XML_READER_TYPE_WHITESPACE:
+        case XML_READER_TYPE_SIGNIFICANT_WHITESPACE:
+            return reader_whitespace;
+        case XML_READER_TYPE_COMMENT:
+            return reader_comment;
+        case XML_READER_TYPE_PROCESSING_INSTRUCTION:
+            return reader_instruction;
+        case XML_READER_TYPE_DOCUMENT_TYPE:
+            return reader_doctype;
+        case -1:
+            return reader_none;
+        default:
+            return reader_other;
+        }
+    }
+
+
+    int xml_reader::depth() const
+    {
+        return (opened_ ? xmlTextReaderDepth(reader_) : -1);
+    }
+
+
+    std::string xml_reader::name() const
+    {
+        return (opened_ ? copy_xml_chars(xmlTextReaderConstName(reader_)) : std::string());
+    }
+
+
+    std::string xml_reader::local_name() const
+    {
+        return (opened_ ? copy_xml_chars(xmlTextReaderConstLocalName(reader_)) : std::string());
+    }
+
+
+    std::string xml_reader::prefix() const
+    {
+        return (opened_ ? copy_xml_chars(xmlTextReaderConstPrefix(reader_)) : std::string());
+    }
+
+
+    std::string xml_reader::uri() const
+    {
+        return (opened_ ? copy_xml_chars(xmlTextReaderConstNamespaceUri(reader_)) : std::string());
+    }
+
+
+    std::string xml_reader::value() const
+    {
+        return (opened_ ? copy_xml_chars(xmlTextReaderConstValue(reader_)) : std::string());
+    }
+
+
+    bool xml_reader::is_empty_element() const
+    {
+        return (opened_ && xmlTextReaderIsEmptyElement(reader_) == 1);
+    }
+
+
+    int xml_reader::attr_count() const
+    {
+        int count = (opened_ ? xmlTextReaderAttributeCount(reader_) : 0);
+        return (count > 0 ? count : 0);
+    }
+
+
+    std::string xml_reader::attr(const std::string& qname) const
+    {
+        if (!opened_)
+        {
+            return std::string();
+        }
+        return take_xml_chars(
+            xmlTextReaderGetAttribute(reader_, detail::to_xml_chars(qname.c_str()))
+        );
+    }
+
+
+    std::string xml_reader::attr(const std::string& name, const std::string& uri) const
+    {
+        if (!opened_)
+        {
+            return std::string();
+        }
+        return take_xml_chars( xmlTextReaderGetAttributeNs(reader_,
+                                                           detail::to_xml_chars(name.c_str()),
+                                                           to_xml_uri(uri)) );
+    }
+
+
+    bool xml_reader::has_attr(const std::string& name, const std::string& uri) const
+    {
+        if (!opened_)
+        {
+            return false;
+        }
+        xmlChar* value = xmlTextReaderGetAttributeNs( reader_,
+                                                      detail::to_xml_chars(name.c_str()),
+                                                      to_xml_uri(uri) );
+        if (value == 0)
+        {
+            return false;
+        }
+        xmlFree(value);
+        return true;
+    }
+
+
+    std::string xml_reader::attr(int index) const
+    {
+        if (!opened_ || index < 0 || index >= attr_count())
+        {
+            return std::string();
+        }
+        return take_xml_chars(xmlTextReaderGetAttributeNo(reader_, index));
+    }
+
+
+    basic_node_ptr<element> xml_reader::expand()
+    {
+        check_open_("expand()");
+        if (xmlTextReaderNodeType(reader_) != XML_READER_TYPE_ELEMENT)
+        {
+            return basic_node_ptr<element>();
+        }
+        detail::wrapper_arena_scope arena_scope(arena_);
+        xmlNode* px = xmlTextReaderExpand(reader_);
+        if (px == 0 || !error_.empty())
+        {
+            throw dom_error("fail to expand xml element: " + error_);
+        }
+        assert(px->type == XML_ELEMENT_NODE);
+        return basic_node_ptr<element>( static_cast<element*>(detail::get_or_create_private(px)) );
+    }
+
+
+    void xml_reader::on_open_(bool opened, const std::string& what)
+    {
+        if (!opened)
+        {
+            throw dom_error(what);
+        }
+        opened_ = true;
+        error_.clear();
+        arena_ = detail::wrapper_arena::create();
+        // The error handler is attached to the libxml2 parser context, which may be recreated.
+        xmlTextReaderSetStructuredErrorHandler(reader_, &xml_reader::on_error_, this);
+    }
+
+
+    bool xml_reader::check_move_(int ret)
+    {
+        if (ret < 0 || !error_.empty())
+        {
+            std::string what = "fail to read xml using libxml2: "
+                             + (error_.empty() ? std::string("unknown error") : error_);
+            throw dom_error(what);
+        }
+        return (ret > 0);
+    }
+
+
+    void xml_reader::check_open_(const char* what) const
+    {
+        if (!opened_)
+        {
+            throw dom_error(std::string(what) + " called on xml_reader with no xml opened");
+        }
+    }
+
+
+    void xml_reader::on_error_(void* context, xmlError* err)
+    {
+        xml_reader* self = static_cast<xml_reader*>(context);
+        if (err != 0 && err->level >= XML_ERR_ERROR && self->error_.empty())
+        {
+            self->error_ = detail::build_error_message(*err);
+        }
+    }
+
+
+}  // namespace xtree
+
@@ -9,6 +9,7 @@
 #include "xtree/xmlns.hpp"
 #include "xtree/exceptions.hpp"
 #include "xtree/libxml2_utility.hpp"
+#include "xtree/wrapper_arena.hpp"
 
 #include <libxml/tree.h>
 #include <cassert>
@@ -23,7 +24,7 @@ namespace xtree {
     //
 
 
-    xmlns* xmlns::get_or_create(xmlNs* px)
+    xmlns* xmlns::get_or_create(xmlNs* px, detail::wrapper_arena* arena)
     {
         if (px == 0)
         {
@@ -31,18 +32,18 @@ namespace xtree {
         }
         if (px->_private == 0)
         {
-            px->_private = new xmlns(px);
+            px->_private = detail::new_wrapper<xmlns>(arena, px);
         }
         return static_cast<xmlns*>(px->_private);
     }
 
 
-    void xmlns::delete_private(xmlNs* px)
+    void xmlns::delete_private(xmlNs* px, detail::wrapper_arena* owner)
     {
         if (px != 0 && px->_private != 0)
         {
             xmlns* wrapper = static_cast<xmlns*>(px->_private);
-            delete wrapper;
+            detail::delete_wrapper(wrapper, owner);
             px->_private = 0;
         }
     }
@@ -84,7 +85,8 @@ namespace xtree {
 
     const xmlns* xmlns::next_sibling_() const
     {
-        return get_or_create(raw()->next);
+        // The sibling declarations belong to the same element, thus to the same document.
+        return get_or_create(raw()->next, detail::get_wrapper_arena(this));
     }
 
 
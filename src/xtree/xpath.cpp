@@ -4,32 +4,30 @@
 
 #include "xtree/xpath.hpp"
 #include "xtree/exceptions.hpp"
-#include "xtree/libxml2_utility.hpp"
 
-#include <libxml/xpath.h>
-
-#include <cassert>
+#include <algorithm>
 #include <map>
 #include <string>
+#include <utility>
 
 
 namespace xtree {
 
 
-    xpath::xpath(const std::string& str): str_(str), registry_(), raw_(0)
+    xpath::xpath(const std::string& str): str_(str), registry_(), compiled_(0)
     {
         init_raw_(str);
     }
 
 
-    xpath::xpath(const char* str): str_(str), registry_(), raw_(0)
+    xpath::xpath(const char* str): str_(str), registry_(), compiled_(0)
     {
         init_raw_(str);
     }
 
 
     xpath::xpath(const std::string& str, const std::string& prefix, const std::string& uri)
-    : str_(str), registry_(), raw_(0)
+    : str_(str), registry_(), compiled_(0)
     {
         registry_.insert(std::make_pair(prefix, uri));
         init_raw_(str);
@@ -37,15 +35,16 @@ namespace xtree {
 
 
     xpath::xpath(const std::string& str, const xmlns_registry& registry)
-    : str_(str), registry_(registry), raw_(0)
+    : str_(str), registry_(registry), compiled_(0)
     {
         init_raw_(str);
     }
 
 
-    xpath::xpath(const xpath& rhs): str_(rhs.str_), registry_(rhs.registry_), raw_(0)
+    xpath::xpath(const xpath& rhs)
+    : str_(rhs.str_), registry_(rhs.registry_), compiled_(rhs.compiled_)
     {
-        init_raw_(rhs.str_);
+        detail::add_ref_compiled_xpath(compiled_);
     }
 
 
@@ -53,39 +52,80 @@ namespace xtree {
     {
         if (this != &rhs)
         {
-            init_raw_(rhs.str_);
-            str_ = rhs.str_;
-            registry_ = rhs.registry_;
+            xpath tmp(rhs);
+            swap(tmp);
         }
         return *this;
     }
 
 
-    xpath::~xpath()
+#ifdef XTREE_HAS_CXX11
+
+
+    xpath::xpath(xpath&& rhs)
+    : str_(std::move(rhs.str_)), registry_(std::move(rhs.registry_)), compiled_(rhs.compiled_)
     {
-        assert(raw_ != 0);
-        xmlXPathFreeCompExpr(raw_);
-        raw_ = 0;
+        rhs.compiled_ = 0;
     }
 
 
-    void xpath::init_raw_(const std::string& str)
+    xpath& xpath::operator=(xpath&& rhs)
     {
-        // Compile the XPath expression.
-        xmlXPathCompExpr* px = xmlXPathCompile(detail::to_xml_chars(str.c_str()));
-        if (px == 0)
+        if (this != &rhs)
         {
-            std::string what = "fail to compile XPath expression: " + str;
-            throw xpath_error(what);
+            str_ = std::move(rhs.str_);
+            registry_ = std::move(rhs.registry_);
+            detail::release_compiled_xpath(compiled_);
+            compiled_ = rhs.compiled_;
+            rhs.compiled_ = 0;
         }
-        // Free the underlying XPath expression object as necessary.
-        if (raw_ != 0)
+        return *this;
+    }
+
+
+#endif  // XTREE_HAS_CXX11
+
+
+    xpath::~xpath()
+    {
+        // The compiled XPath is null if this object has been moved from.
+        detail::release_compiled_xpath(compiled_);
+        compiled_ = 0;
+    }
+
+
+    void xpath::swap(xpath& rhs)
+    {
+        str_.swap(rhs.str_);
+        registry_.swap(rhs.registry_);
+        std::swap(compiled_, rhs.compiled_);
+    }
+
+
+    void xpath::register_xmlns(const std::string& prefix, const std::string& uri)
+    {
+        registry_[prefix] = uri;
+        init_raw_(str_);
+    }
+
+
+    void xpath::register_xmlns(const xmlns_registry& registry)
+    {
+        for (xmlns_registry::const_iterator i = registry.begin(); i != registry.end(); ++i)
         {
-            xmlXPathFreeCompExpr(raw_);
-            raw_ = 0;
+            registry_[i->first] = i->second;
         }
-        // Reset raw.
-        raw_ = px;
+        init_raw_(str_);
+    }
+
+
+    void xpath::init_raw_(const std::string& str)
+    {
+        // Get the compiled XPath expression from the cache, or compile it.
+        detail::compiled_xpath* compiled = detail::compile_xpath(str, registry_);
+        // Release the previous compiled XPath expression as necessary.
+        detail::release_compiled_xpath(compiled_);
+        compiled_ = compiled;
     }
 
 
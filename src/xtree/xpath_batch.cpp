@@ -0,0 +1,187 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/xpath_batch.hpp"
+#include "xtree/document.hpp"
+#include "xtree/element.hpp"
+#include "xtree/exceptions.hpp"
+#include "xtree/libxml2_utility.hpp"
+#include "xtree/node_set.hpp"
+#include "xtree/xpath_evaluator.hpp"
+#include "xtree/xpath_result.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+namespace xtree {
+
+
+    namespace {
+
+
+        //! This class saves the context node of an XPath evaluator, and restores it on destruction.
+        class context_node_scope
+        {
+
+        public:
+
+            explicit context_node_scope(xpath_evaluator& evaluator)
+            : evaluator_(evaluator), context_node_(evaluator.context_node())
+            {
+                // Do nothing.
+            }
+
+            ~context_node_scope()
+            {
+                restore();
+            }
+
+            //! Restores the context node saved.
+            void restore()
+            {
+                if (context_node_ != 0)
+                {
+                    evaluator_.set_context_node(*context_node_);
+                }
+                else
+                {
+                    evaluator_.reset_context_node();
+                }
+            }
+
+        private:
+
+            //! Non-implemented copy constructor.
+            context_node_scope(const context_node_scope&);
+
+            //! Non-implemented copy assignment.
+            context_node_scope& operator=(const context_node_scope&);
+
+        private:
+
+            xpath_evaluator&        evaluator_;     //!< The XPath evaluator.
+            basic_node_ptr<element> context_node_;  //!< The context node to restore.
+
+        };
+
+
+    }  // anonymous namespace
+
+
+    const std::size_t xpath_batch::no_group;
+
+
+    xpath_batch::xpath_batch(): fields_(), groups_(), ungrouped_()
+    {
+        // Do nothing.
+    }
+
+
+    xpath_batch::~xpath_batch()
+    {
+        // Do nothing.
+    }
+
+
+    std::size_t xpath_batch::add_group(const xpath& path)
+    {
+        field_group group = { path, std::vector<std::size_t>() };
+        groups_.push_back(group);
+        return groups_.size() - 1;
+    }
+
+
+    std::size_t xpath_batch::add(const xpath& expr, xpath_result_t type, std::size_t group)
+    {
+        if (type != boolean_result && type != number_result && type != string_result)
+        {
+            throw bad_dom_operation("fail to add XPath to batch: invalid type " + to_string(type));
+        }
+        if (group != no_group && group >= groups_.size())
+        {
+            throw bad_dom_operation("fail to add XPath to batch: invalid group");
+        }
+        std::size_t index = fields_.size();
+        field f = { expr, type, group };
+        fields_.push_back(f);
+        std::vector<std::size_t>& indexes = ( group != no_group
+                                            ? groups_[group].fields
+                                            : ungrouped_ );
+        indexes.push_back(index);
+        return index;
+    }
+
+
+    void xpath_batch::eval(xpath_evaluator& evaluator, std::vector<xpath_value>& values) const
+    {
+        values.assign(fields_.size(), xpath_value());
+        context_node_scope scope(evaluator);
+        eval_fields_(evaluator, ungrouped_, values);
+        // Evaluate each group path once, then the expressions of the group from its element.
+        for (std::vector<field_group>::const_iterator i = groups_.begin(); i != groups_.end(); ++i)
+        {
+            if (i->fields.empty())
+            {
+                continue;
+            }
+            node_set nodes;
+            evaluator.eval(i->path, nodes);
+            node_set::element_iterator first = nodes.begin_element();
+            if (first != nodes.end_element())
+            {
+                evaluator.set_context_node(*first);
+                eval_fields_(evaluator, i->fields, values);
+            }
+            else
+            {
+                for (std::size_t j = 0; j < i->fields.size(); ++j)
+                {
+                    std::size_t index = i->fields[j];
+                    detail::convert_xpath_result(0, fields_[index].type, values[index]);
+                }
+            }
+            // Evaluate the next group from the original context node.
+            scope.restore();
+        }
+    }
+
+
+    void xpath_batch::eval(document& doc, std::vector<xpath_value>& values) const
+    {
+        xpath_evaluator evaluator(doc);
+        eval(evaluator, values);
+    }
+
+
+    void xpath_batch::eval(element& elem, std::vector<xpath_value>& values) const
+    {
+        xpath_evaluator evaluator(elem.doc());
+        evaluator.set_context_node(elem);
+        eval(evaluator, values);
+    }
+
+
+    void xpath_batch::eval_fields_(xpath_evaluator& evaluator,
+                                   const std::vector<std::size_t>& indexes,
+                                   std::vector<xpath_value>& values) const
+    {
+        for (std::vector<std::size_t>::const_iterator i = indexes.begin(); i != indexes.end(); ++i)
+        {
+            const field& f = fields_[*i];
+            xpath_result result;
+            evaluator.eval(f.expr, result);
+            xmlXPathObject* px = const_cast<xmlXPathObject*>(result.raw());
+            detail::convert_xpath_result(px, f.type, values[*i]);
+        }
+    }
+
+
+}  // namespace xtree
+
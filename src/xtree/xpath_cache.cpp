@@ -0,0 +1,550 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/xpath_cache.hpp"
+#include "xtree/exceptions.hpp"
+#include "xtree/libxml2_utility.hpp"
+
+#include <libxml/xpath.h>
+
+#include <cassert>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef XTREE_HAS_CXX11
+#  include <atomic>
+#  include <mutex>
+#endif
+
+
+namespace xtree {
+namespace detail {
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // compiled_xpath
+    //
+
+
+    class compiled_xpath
+    {
+
+    public:
+
+        //! Constructs a compiled XPath expression with one reference.
+        //! \param raw             the underlying libxml2 object, which is owned by this object.
+        //! \param str             the XPath expression.
+        //! \param calls_functions whether the expression may contain function calls.
+        explicit compiled_xpath(xmlXPathCompExpr* raw,
+                                const std::string& str,
+                                bool calls_functions)
+        : raw_(raw)
+        , str_(str)
+        , calls_functions_(calls_functions)
+        , refs_(1)
+        , copies_()
+        , functions_()
+        {
+            assert(raw_ != 0);
+            if (calls_functions_)
+            {
+                copies_.push_back(raw_);
+            }
+        }
+
+        const xmlXPathCompExpr* raw() const
+        {
+            return raw_;
+        }
+
+        //! Evaluates the expression. Libxml2 caches the functions it resolves in the compiled
+        //! expression: an expression which may call functions is evaluated on a private copy,
+        //! taken from a pool, so that concurrent evaluations never write to the same copy.
+        xmlXPathObject* eval(xmlXPathContext* ctxt)
+        {
+            if (!calls_functions_)
+            {
+                return xmlXPathCompiledEval(raw_, ctxt);
+            }
+            xmlXPathCompExpr* copy = acquire_copy_();
+            if (copy == 0)
+            {
+                return 0;
+            }
+            xmlXPathObject* px = xmlXPathCompiledEval(copy, ctxt);
+            release_copy_(copy);
+            return px;
+        }
+
+        void add_ref()
+        {
+            ++refs_;
+        }
+
+        void release()
+        {
+            if (--refs_ == 0)
+            {
+                delete this;
+            }
+        }
+
+        void add_resolved_function(const xmlChar* name,
+                                   const std::string& uri,
+                                   const std::string& local_name)
+        {
+            lock_type lock(functions_mutex_);
+            for (std::vector<resolved_function>::iterator i = functions_.begin();
+                 i != functions_.end();
+                 ++i)
+            {
+                if (i->name == name)
+                {
+                    i->uri = uri;
+                    i->local_name = local_name;
+                    return;
+                }
+            }
+            resolved_function function = { name, uri, local_name };
+            functions_.push_back(function);
+        }
+
+        bool find_resolved_function(const xmlChar* name,
+                                    std::string& uri,
+                                    std::string& local_name) const
+        {
+            lock_type lock(functions_mutex_);
+            for (std::vector<resolved_function>::const_iterator i = functions_.begin();
+                 i != functions_.end();
+                 ++i)
+            {
+                if (i->name == name)
+                {
+                    uri = i->uri;
+                    local_name = i->local_name;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+
+#ifdef XTREE_HAS_CXX11
+        typedef std::lock_guard<std::mutex> lock_type;
+#else
+        //! Without C++11 support, the copies and the resolved functions are not guarded.
+        struct lock_type
+        {
+            explicit lock_type(int)
+            {
+                // Do nothing.
+            }
+        };
+#endif
+
+        //! A function resolved by libxml2, identified by its name owned by the expression.
+        struct resolved_function
+        {
+            const xmlChar* name;        //!< The function name owned by the expression.
+            std::string    uri;         //!< The namespace URI of the function.
+            std::string    local_name;  //!< The local name of the function.
+        };
+
+        ~compiled_xpath()
+        {
+            // No evaluation is running: all the copies (including raw_, if any) are in the pool.
+            for (std::vector<xmlXPathCompExpr*>::iterator i = copies_.begin();
+                 i != copies_.end();
+                 ++i)
+            {
+                if (*i != raw_)
+                {
+                    xmlXPathFreeCompExpr(*i);
+                }
+            }
+            copies_.clear();
+            xmlXPathFreeCompExpr(raw_);
+            raw_ = 0;
+        }
+
+        //! Takes a copy of the expression from the pool, or compiles a new one.
+        //! \return the copy, or null if fail to compile it.
+        xmlXPathCompExpr* acquire_copy_()
+        {
+            {
+                lock_type lock(copies_mutex_);
+                if (!copies_.empty())
+                {
+                    xmlXPathCompExpr* copy = copies_.back();
+                    copies_.pop_back();
+                    return copy;
+                }
+            }
+            return xmlXPathCompile(detail::to_xml_chars(str_.c_str()));
+        }
+
+        //! Returns a copy of the expression to the pool.
+        void release_copy_(xmlXPathCompExpr* copy)
+        {
+            lock_type lock(copies_mutex_);
+            copies_.push_back(copy);
+        }
+
+        //! Non-implemented copy constructor.
+        compiled_xpath(const compiled_xpath&);
+
+        //! Non-implemented copy assignment.
+        compiled_xpath& operator=(const compiled_xpath&);
+
+    private:
+
+        xmlXPathCompExpr*               raw_;              //!< The underlying libxml2 object.
+        std::string                     str_;              //!< The XPath expression.
+        bool                            calls_functions_;  //!< Whether it may call functions.
+#ifdef XTREE_HAS_CXX11
+        std::atomic<long>               refs_;             //!< The reference count.
+#else
+        long                            refs_;             //!< The reference count.
+#endif
+        std::vector<xmlXPathCompExpr*>  copies_;           //!< The copies not being evaluated.
+        std::vector<resolved_function>  functions_;        //!< The functions resolved.
+#ifdef XTREE_HAS_CXX11
+        std::mutex                      copies_mutex_;     //!< Guards the copies.
+        mutable std::mutex              functions_mutex_;  //!< Guards the functions resolved.
+#else
+        int                             copies_mutex_;     //!< Placeholder for the mutex.
+        int                             functions_mutex_;  //!< Placeholder for the mutex.
+#endif
+
+    };
+
+
+    namespace {
+
+
+        //! Returns whether a character may be part of an XPath name (ignoring non-ASCII letters,
+        //! which are always part of a name).
+        bool is_name_char(char c)
+        {
+            return ( (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+                  || c == '_' || c == '-' || c == '.' || c == ':' || (c & 0x80) != 0 );
+        }
+
+
+        //! Returns whether an XPath expression may contain function calls, i.e. a name followed
+        //! by an opening parenthesis which is not a node type test. Operator names followed by a
+        //! parenthesis are reported as function calls as well: this is only a conservative guess.
+        //! \param str  the XPath expression.
+        //! \return false if the expression contains no function call, true otherwise.
+        bool may_call_functions(const std::string& str)
+        {
+            std::string::size_type i = 0;
+            while (i < str.size())
+            {
+                char c = str[i];
+                if (c == '"' || c == '\'')
+                {
+                    // Skip the string literal.
+                    std::string::size_type end = str.find(c, i + 1);
+                    i = (end == std::string::npos ? str.size() : end + 1);
+                }
+                else if (is_name_char(c))
+                {
+                    std::string::size_type begin = i;
+                    while (i < str.size() && is_name_char(str[i]))
+                    {
+                        ++i;
+                    }
+                    std::string name = str.substr(begin, i - begin);
+                    std::string::size_type axis = name.rfind("::");
+                    if (axis != std::string::npos)
+                    {
+                        name.erase(0, axis + 2);
+                    }
+                    std::string::size_type next = str.find_first_not_of(" \t\r\n", i);
+                    if ( next != std::string::npos
+                      && str[next] == '('
+                      && name != "node"
+                      && name != "text"
+                      && name != "comment"
+                      && name != "processing-instruction" )
+                    {
+                        return true;
+                    }
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+            return false;
+        }
+
+
+        //! Compiles an XPath expression.
+        //! \param str  the XPath expression.
+        //! \return the compiled XPath expression with one reference, never null.
+        //! \throws xpath_error  if fail to compile the XPath expression.
+        compiled_xpath* compile_xpath_(const std::string& str)
+        {
+            xmlXPathCompExpr* px = xmlXPathCompile(detail::to_xml_chars(str.c_str()));
+            if (px == 0)
+            {
+                std::string what = "fail to compile XPath expression: " + str;
+                throw xpath_error(what);
+            }
+            return new compiled_xpath(px, str, may_call_functions(str));
+        }
+
+
+        //! This class implements the compiled XPath cache, as a list of compiled expressions in
+        //! the order of their last use, indexed by their expression strings and namespace
+        //! registries. The registry is part of the key because libxml2 caches the functions
+        //! resolved during evaluation, with their namespace URIs, in the compiled expression. It
+        //! is guarded by a mutex, and the expressions are compiled with the mutex unlocked.
+        class xpath_cache
+        {
+
+            typedef std::pair<std::string, xmlns_registry>     key_type;
+            typedef std::pair<key_type, compiled_xpath*>       entry_type;
+            typedef std::list<entry_type>                      entry_list;
+            typedef std::map<key_type, entry_list::iterator>   entry_index;
+
+        public:
+
+            static const std::size_t default_capacity = 256;
+
+            explicit xpath_cache(): entries_(), index_(), stats_()
+            {
+                stats_.capacity = default_capacity;
+            }
+
+            ~xpath_cache()
+            {
+                clear_();
+            }
+
+            compiled_xpath* get(const std::string& str, const xmlns_registry& registry)
+            {
+                key_type key(str, registry);
+                {
+                    lock_type lock(mutex_);
+                    entry_index::iterator i = index_.find(key);
+                    if (i != index_.end())
+                    {
+                        // Move the entry to the front of the list.
+                        entries_.splice(entries_.begin(), entries_, i->second);
+                        ++stats_.hits;
+                        i->second->second->add_ref();
+                        return i->second->second;
+                    }
+                    ++stats_.misses;
+                }
+                compiled_xpath* compiled = compile_xpath_(str);
+                lock_type lock(mutex_);
+                if (stats_.capacity > 0 && index_.find(key) == index_.end())
+                {
+                    compiled->add_ref();
+                    entries_.push_front(entry_type(key, compiled));
+                    index_.insert(std::make_pair(key, entries_.begin()));
+                    evict_(stats_.capacity);
+                }
+                return compiled;
+            }
+
+            void set_capacity(std::size_t capacity)
+            {
+                lock_type lock(mutex_);
+                stats_.capacity = capacity;
+                evict_(capacity);
+            }
+
+            xpath_cache_stats get_stats()
+            {
+                lock_type lock(mutex_);
+                xpath_cache_stats stats = stats_;
+                stats.size = entries_.size();
+                return stats;
+            }
+
+            void clear()
+            {
+                lock_type lock(mutex_);
+                clear_();
+                std::size_t capacity = stats_.capacity;
+                stats_ = xpath_cache_stats();
+                stats_.capacity = capacity;
+            }
+
+        private:
+
+#ifdef XTREE_HAS_CXX11
+            typedef std::lock_guard<std::mutex> lock_type;
+#else
+            //! Without C++11 support, the cache is not guarded.
+            struct lock_type
+            {
+                explicit lock_type(int)
+                {
+                    // Do nothing.
+                }
+            };
+#endif
+
+            //! Evicts the least recently used entries until the size does not exceed a limit.
+            void evict_(std::size_t limit)
+            {
+                while (entries_.size() > limit)
+                {
+                    index_.erase(entries_.back().first);
+                    entries_.back().second->release();
+                    entries_.pop_back();
+                    ++stats_.evictions;
+                }
+            }
+
+            //! Releases all the entries.
+            void clear_()
+            {
+                for (entry_list::iterator i = entries_.begin(); i != entries_.end(); ++i)
+                {
+                    i->second->release();
+                }
+                entries_.clear();
+                index_.clear();
+            }
+
+            //! Non-implemented copy constructor.
+            xpath_cache(const xpath_cache&);
+
+            //! Non-implemented copy assignment.
+            xpath_cache& operator=(const xpath_cache&);
+
+        private:
+
+#ifdef XTREE_HAS_CXX11
+            std::mutex        mutex_;    //!< Guards the members below.
+#else
+            int               mutex_;    //!< Placeholder for the mutex.
+#endif
+            entry_list        entries_;  //!< The entries, most recently used first.
+            entry_index       index_;    //!< The entries indexed by expressions and registries.
+            xpath_cache_stats stats_;    //!< The statistics, not including the size.
+
+        };
+
+
+        const std::size_t xpath_cache::default_capacity;
+
+
+        //! Returns the process-wide compiled XPath cache.
+        xpath_cache& get_xpath_cache()
+        {
+            static xpath_cache cache;
+            return cache;
+        }
+
+
+    }  // anonymous namespace
+
+
+    compiled_xpath* compile_xpath(const std::string& str, const xmlns_registry& registry)
+    {
+        return get_xpath_cache().get(str, registry);
+    }
+
+
+    void add_ref_compiled_xpath(compiled_xpath* compiled)
+    {
+        assert(compiled != 0);
+        compiled->add_ref();
+    }
+
+
+    void release_compiled_xpath(compiled_xpath* compiled)
+    {
+        if (compiled != 0)
+        {
+            compiled->release();
+        }
+    }
+
+
+    xmlXPathObject* eval_compiled_xpath(compiled_xpath* compiled, xmlXPathContext* ctxt)
+    {
+        assert(compiled != 0);
+        return compiled->eval(ctxt);
+    }
+
+
+    void add_resolved_function(compiled_xpath* compiled,
+                               const xmlChar* name,
+                               const std::string& uri,
+                               const std::string& local_name)
+    {
+        assert(compiled != 0);
+        compiled->add_resolved_function(name, uri, local_name);
+    }
+
+
+    bool find_resolved_function(const compiled_xpath* compiled,
+                                const xmlChar* name,
+                                std::string& uri,
+                                std::string& local_name)
+    {
+        assert(compiled != 0);
+        return compiled->find_resolved_function(name, uri, local_name);
+    }
+
+
+    const xmlXPathCompExpr* get_raw_xpath(const compiled_xpath* compiled)
+    {
+        assert(compiled != 0);
+        return compiled->raw();
+    }
+
+
+}  // namespace xtree::detail
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // compiled XPath cache functions
+    //
+
+
+    void set_xpath_cache_capacity(std::size_t capacity)
+    {
+        detail::get_xpath_cache().set_capacity(capacity);
+    }
+
+
+    std::size_t get_xpath_cache_capacity()
+    {
+        return detail::get_xpath_cache().get_stats().capacity;
+    }
+
+
+    xpath_cache_stats get_xpath_cache_stats()
+    {
+        return detail::get_xpath_cache().get_stats();
+    }
+
+
+    void clear_xpath_cache()
+    {
+        detail::get_xpath_cache().clear();
+    }
+
+
+}  // namespace xtree
+
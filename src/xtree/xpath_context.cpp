@@ -9,6 +9,8 @@
 #include "xtree/xpath_context.hpp"
 #include "xtree/xpath.hpp"
 #include "xtree/xpath_result.hpp"
+#include "xtree/xpath_variables.hpp"
+#include "xtree/xpath_function.hpp"
 #include "xtree/exceptions.hpp"
 #include "xtree/libxml2_utility.hpp"
 
@@ -17,7 +19,10 @@
 #include <libxml/xpathInternals.h>
 
 #include <cassert>
+#include <exception>
+#include <map>
 #include <string>
+#include <utility>
 
 
 namespace xtree {
@@ -35,13 +40,104 @@ namespace detail {
         }
 
 
+        //! Libxml2 callback function to call an XPath extension function. The arguments are
+        //! popped from the XPath stack, and the return value is pushed to it.
+        void libxml2_call_xpath_function(xmlXPathParserContext* ctxt, int nargs)
+        {
+            xpath_context* self = static_cast<xpath_context*>(ctxt->context->funcLookupData);
+            std::string uri;
+            std::string name;
+            xpath_function* fn = 0;
+            compiled_xpath* compiled = (self != 0 ? self->current_xpath() : 0);
+            if ( compiled != 0
+              && find_resolved_function(compiled, ctxt->context->function, uri, name) )
+            {
+                fn = self->find_function(name, uri);
+            }
+            if (fn == 0)
+            {
+                xmlXPathErr(ctxt, XPATH_UNKNOWN_FUNC_ERROR);
+                return;
+            }
+            try
+            {
+                xpath_function_args args;
+                for (int i = 0; i < nargs; ++i)
+                {
+                    xmlXPathObject* arg = valuePop(ctxt);
+                    if (arg == 0)
+                    {
+                        xmlXPathErr(ctxt, XPATH_INVALID_OPERAND);
+                        return;
+                    }
+                    args.push_front(arg);
+                }
+                xpath_value value = fn->call(args);
+                xmlXPathObject* px = 0;
+                switch (value.type)
+                {
+                case boolean_result:
+                    px = xmlXPathNewBoolean(value.boolean ? 1 : 0);
+                    break;
+                case number_result:
+                    px = xmlXPathNewFloat(value.number);
+                    break;
+                case string_result:
+                    px = xmlXPathNewString(detail::to_xml_chars(value.str.c_str()));
+                    break;
+                default:
+                    self->set_function_error("XPath function " + name + "() returned no value");
+                    xmlXPathErr(ctxt, XPATH_EXPR_ERROR);
+                    return;
+                }
+                if (px == 0)
+                {
+                    xmlXPathErr(ctxt, XPATH_MEMORY_ERROR);
+                    return;
+                }
+                valuePush(ctxt, px);
+            }
+            catch (const std::exception& ex)
+            {
+                self->set_function_error("XPath function " + name + "() failed: " + ex.what());
+                xmlXPathErr(ctxt, XPATH_EXPR_ERROR);
+            }
+            catch (...)
+            {
+                self->set_function_error("XPath function " + name + "() failed");
+                xmlXPathErr(ctxt, XPATH_EXPR_ERROR);
+            }
+        }
+
+
+        //! Libxml2 callback function to look up XPath extension functions.
+        xmlXPathFunction libxml2_lookup_xpath_function(void* data,
+                                                       const xmlChar* name,
+                                                       const xmlChar* uri)
+        {
+            xpath_context* self = static_cast<xpath_context*>(data);
+            std::string uri_str = (uri != 0 ? detail::to_chars(uri) : "");
+            if (name == 0 || self->find_function(detail::to_chars(name), uri_str) == 0)
+            {
+                return 0;
+            }
+            if (self->current_xpath() == 0)
+            {
+                return 0;
+            }
+            add_resolved_function(self->current_xpath(), name, uri_str, detail::to_chars(name));
+            return &libxml2_call_xpath_function;
+        }
+
+
     }  // anonymous namespace
 
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
 
 
-    xpath_context::xpath_context(xmlDoc* px_doc, xmlNode* px_node): raw_(0)
+    xpath_context::xpath_context(xmlDoc* px_doc, xmlNode* px_node)
+    : raw_(0), node_(px_node), xmlns_(), functions_(), function_error_(), current_xpath_(0)
     {
         assert(px_doc != 0);
         assert(px_node == 0 || px_node->doc == px_doc);
@@ -53,6 +149,7 @@ namespace detail {
         }
         raw_->node = px_node;
         raw_->error = &libxml2_on_xpath_error;
+        xmlXPathRegisterFuncLookup(raw_, &libxml2_lookup_xpath_function, this);
     }
 
 
@@ -66,13 +163,73 @@ namespace detail {
     }
 
 
+    void xpath_context::set_doc(xmlDoc* px_doc)
+    {
+        assert(px_doc != 0);
+        raw_->doc = px_doc;
+        node_ = 0;
+    }
+
+
+    void xpath_context::set_node(xmlNode* px_node)
+    {
+        assert(px_node == 0 || px_node->doc == raw_->doc);
+        node_ = px_node;
+    }
+
+
+    void xpath_context::set_variables(const xpath_variables* vars)
+    {
+        if (vars != 0)
+        {
+            vars->register_to(raw_);
+        }
+        else
+        {
+            xmlXPathRegisteredVariablesCleanup(raw_);
+        }
+    }
+
+
+    void xpath_context::set_function(const std::string& name,
+                                     const std::string& uri,
+                                     xpath_function* fn)
+    {
+        if (fn != 0)
+        {
+            functions_[std::make_pair(uri, name)] = fn;
+        }
+        else
+        {
+            functions_.erase(std::make_pair(uri, name));
+        }
+    }
+
+
+    xpath_function* xpath_context::find_function(const std::string& name,
+                                                 const std::string& uri) const
+    {
+        function_map::const_iterator i = functions_.find(std::make_pair(uri, name));
+        if (i != functions_.end())
+        {
+            return i->second;
+        }
+        return find_xpath_function(name, uri);
+    }
+
+
     void xpath_context::eval(const xpath& expr, xpath_result& result)
     {
-        // Register XML namespaces.
+        // Register XML namespaces, skipping those registered already.
         typedef xpath::xmlns_registry::const_iterator const_iterator;
         const xpath::xmlns_registry& registry = expr.get_xmlns_registry();
         for (const_iterator i = registry.begin(); i != registry.end(); ++i)
         {
+            std::map<std::string, std::string>::const_iterator found = xmlns_.find(i->first);
+            if (found != xmlns_.end() && found->second == i->second)
+            {
+                continue;
+            }
             int ret_code = xmlXPathRegisterNs( raw_,
                                                detail::to_xml_chars(i->first.c_str()),
                                                detail::to_xml_chars(i->second.c_str()) );
@@ -82,13 +239,27 @@ namespace detail {
                                  + ": xmlXPathRegisterNs returned non-zero";
                 throw xpath_error(what);
             }
+            xmlns_[i->first] = i->second;
         }
+        // Reset the evaluation state left by the previous evaluation, if any.
+        raw_->node = node_;
+        raw_->contextSize = -1;
+        raw_->proximityPosition = -1;
+        xmlResetError(&raw_->lastError);
+        function_error_.clear();
         // Evaluate the XPath expression.
-        xmlXPathObject* px = xmlXPathCompiledEval(const_cast<xmlXPathCompExpr*>(expr.raw()), raw_); 
+        // The current expression records the functions resolved, and is restored on return
+        // since an extension function may evaluate another expression in the same context.
+        compiled_xpath* outer_xpath = current_xpath_;
+        current_xpath_ = expr.compiled();
+        xmlXPathObject* px = detail::eval_compiled_xpath(expr.compiled(), raw_);
+        current_xpath_ = outer_xpath;
         if (px == 0)
         {
             std::string what = "fail to evaluate XPath '" + expr.str() + "': "
-                             + detail::build_error_message(raw_->lastError);
+                             + ( !function_error_.empty()
+                               ? function_error_
+                               : detail::build_error_message(raw_->lastError) );
             throw xpath_error(what);
         }
         xpath_result tmp_result(expr.str(), px);
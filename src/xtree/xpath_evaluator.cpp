@@ -0,0 +1,126 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/xpath_evaluator.hpp"
+#include "xtree/document.hpp"
+#include "xtree/element.hpp"
+#include "xtree/exceptions.hpp"
+#include "xtree/node_set.hpp"
+#include "xtree/xpath.hpp"
+#include "xtree/xpath_result.hpp"
+#include "xtree/xpath_typed_results.hpp"
+
+#include <libxml/tree.h>
+
+#include <string>
+
+
+namespace xtree {
+
+
+    xpath_evaluator::xpath_evaluator(document& doc)
+    : doc_(doc), context_node_(), context_(doc.raw_doc(), 0)
+    {
+        // Do nothing.
+    }
+
+
+    xpath_evaluator::~xpath_evaluator()
+    {
+        // Do nothing.
+    }
+
+
+    void xpath_evaluator::set_context_node(element& elem)
+    {
+        if (elem.raw()->doc != doc_.raw_doc())
+        {
+            throw bad_dom_operation("the context node does not belong to the evaluator's document");
+        }
+        context_.set_node(elem.raw());
+        context_node_ = basic_node_ptr<element>(&elem);
+    }
+
+
+    void xpath_evaluator::reset_context_node()
+    {
+        context_.set_node(0);
+        context_node_ = basic_node_ptr<element>();
+    }
+
+
+    void xpath_evaluator::set_variables(const xpath_variables& vars)
+    {
+        context_.set_variables(&vars);
+    }
+
+
+    void xpath_evaluator::clear_variables()
+    {
+        context_.set_variables(0);
+    }
+
+
+    void xpath_evaluator::register_function(const std::string& name,
+                                            const std::string& uri,
+                                            xpath_function& fn)
+    {
+        context_.set_function(name, uri, &fn);
+    }
+
+
+    void xpath_evaluator::register_function(const std::string& name, xpath_function& fn)
+    {
+        context_.set_function(name, std::string(), &fn);
+    }
+
+
+    void xpath_evaluator::unregister_function(const std::string& name, const std::string& uri)
+    {
+        context_.set_function(name, uri, 0);
+    }
+
+
+    void xpath_evaluator::eval(const xpath& expr, xpath_result& result)
+    {
+        context_.eval(expr, result);
+    }
+
+
+    bool xpath_evaluator::eval_boolean(const xpath& expr)
+    {
+        xpath_boolean result;
+        context_.eval(expr, result);
+        return result.value();
+    }
+
+
+    double xpath_evaluator::eval_number(const xpath& expr)
+    {
+        xpath_number result;
+        context_.eval(expr, result);
+        return result.value();
+    }
+
+
+    std::string xpath_evaluator::eval_string(const xpath& expr)
+    {
+        xpath_string result;
+        context_.eval(expr, result);
+        return result.value();
+    }
+
+
+    void xpath_evaluator::select_nodes(const xpath& expr, node_set& nodes)
+    {
+        eval(expr, nodes);
+    }
+
+
+}  // namespace xtree
+
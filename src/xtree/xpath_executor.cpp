@@ -0,0 +1,363 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/xpath_executor.hpp"
+#include "xtree/document.hpp"
+#include "xtree/exceptions.hpp"
+#include "xtree/libxml2_utility.hpp"
+#include "xtree/xpath.hpp"
+#include "xtree/xpath_context.hpp"
+#include "xtree/xpath_result.hpp"
+
+#if defined(XTREE_GNUC) && XTREE_GNUC >= 4
+#  pragma GCC diagnostic ignored "-Wdeprecated-declarations"  // std::auto_ptr is deprecated.
+#endif
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#ifdef XTREE_HAS_CXX11
+#  include <algorithm>
+#  include <condition_variable>
+#  include <exception>
+#  include <mutex>
+#  include <thread>
+#endif
+
+
+namespace xtree {
+
+
+    namespace {
+
+
+        //! This processor converts the XPath results to values of the requested type. Each
+        //! value is written by the worker thread evaluating its document only.
+        class value_collector: public xpath_result_processor
+        {
+
+        public:
+
+            explicit value_collector(xpath_result_t type, std::vector<xpath_value>& values)
+            : type_(type), values_(values)
+            {
+                // Do nothing.
+            }
+
+            virtual void process(document&, std::size_t index, xpath_result& result)
+            {
+                xmlXPathObject* px = const_cast<xmlXPathObject*>(result.raw());
+                detail::convert_xpath_result(px, type_, values_[index]);
+            }
+
+        private:
+
+            xpath_result_t            type_;    //!< The requested value type.
+            std::vector<xpath_value>& values_;  //!< The values, one per document.
+
+        };
+
+
+        //! Evaluates an XPath expression on a document and processes the result. The evaluation
+        //! context is created for the first document, and rebound to the following ones.
+        void eval_document(std::auto_ptr<detail::xpath_context>& context,
+                           document& doc,
+                           std::size_t index,
+                           const xpath& expr,
+                           xpath_result_processor& processor)
+        {
+            if (context.get() == 0)
+            {
+                context.reset(new detail::xpath_context(doc.raw_doc(), 0));
+            }
+            else
+            {
+                context->set_doc(doc.raw_doc());
+            }
+            xpath_result result;
+            context->eval(expr, result);
+            processor.process(doc, index, result);
+        }
+
+
+    }  // anonymous namespace
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // xpath_result_processor
+    //
+
+
+    xpath_result_processor::xpath_result_processor()
+    {
+        // Do nothing.
+    }
+
+
+    xpath_result_processor::~xpath_result_processor()
+    {
+        // Do nothing.
+    }
+
+
+#ifdef XTREE_HAS_CXX11
+
+
+    namespace detail {
+
+
+        //! An XPath expression to evaluate on a range of documents.
+        struct xpath_job
+        {
+            const std::vector<document*>* docs;       //!< The documents.
+            const xpath*                  expr;       //!< The XPath expression.
+            xpath_result_processor*       processor;  //!< The XPath result processor.
+        };
+
+
+        //! This class holds the worker threads and the current job. All the members are guarded
+        //! by the mutex, except the worker threads and the run mutex.
+        class xpath_executor_state
+        {
+
+        public:
+
+            explicit xpath_executor_state(std::size_t thread_count)
+            : run_mutex_()
+            , mutex_()
+            , work_ready_()
+            , done_ready_()
+            , job_(0)
+            , next_(0)
+            , remaining_(0)
+            , error_()
+            , stopping_(false)
+            , workers_()
+            {
+                try
+                {
+                    for (std::size_t i = 0; i < thread_count; ++i)
+                    {
+                        workers_.push_back(std::thread(&xpath_executor_state::work_, this));
+                    }
+                }
+                catch (...)
+                {
+                    shutdown_();
+                    throw;
+                }
+            }
+
+            ~xpath_executor_state()
+            {
+                shutdown_();
+            }
+
+            std::size_t thread_count() const
+            {
+                return workers_.size();
+            }
+
+            //! Dispatches a job to the worker threads, and waits for it to be done. The jobs
+            //! dispatched by several threads at once are run one after the other.
+            void run(const xpath_job& job)
+            {
+                std::lock_guard<std::mutex> run_guard(run_mutex_);
+                std::unique_lock<std::mutex> lock(mutex_);
+                job_ = &job;
+                next_ = 0;
+                remaining_ = job.docs->size();
+                work_ready_.notify_all();
+                while (remaining_ > 0)
+                {
+                    done_ready_.wait(lock);
+                }
+                job_ = 0;
+                if (error_)
+                {
+                    std::exception_ptr error = error_;
+                    error_ = std::exception_ptr();
+                    std::rethrow_exception(error);
+                }
+            }
+
+        private:
+
+            //! The body of the worker threads. Each worker thread owns an evaluation context.
+            void work_()
+            {
+                std::auto_ptr<xpath_context> context;
+                std::unique_lock<std::mutex> lock(mutex_);
+                for (;;)
+                {
+                    while (!stopping_ && (job_ == 0 || next_ >= job_->docs->size()))
+                    {
+                        work_ready_.wait(lock);
+                    }
+                    if (stopping_)
+                    {
+                        return;
+                    }
+                    const xpath_job& job = *job_;
+                    std::size_t index = next_++;
+                    lock.unlock();
+                    try
+                    {
+                        document& doc = *(*job.docs)[index];
+                        eval_document(context, doc, index, *job.expr, *job.processor);
+                    }
+                    catch (...)
+                    {
+                        lock.lock();
+                        if (!error_)
+                        {
+                            error_ = std::current_exception();
+                        }
+                        // Skip the documents not evaluated yet.
+                        remaining_ -= (job.docs->size() - next_);
+                        next_ = job.docs->size();
+                        lock.unlock();
+                    }
+                    lock.lock();
+                    if (--remaining_ == 0)
+                    {
+                        done_ready_.notify_all();
+                    }
+                }
+            }
+
+            //! Stops and joins the worker threads.
+            void shutdown_()
+            {
+                {
+                    std::lock_guard<std::mutex> guard(mutex_);
+                    stopping_ = true;
+                }
+                work_ready_.notify_all();
+                for (std::vector<std::thread>::iterator i = workers_.begin();
+                     i != workers_.end();
+                     ++i)
+                {
+                    i->join();
+                }
+                workers_.clear();
+            }
+
+        private:
+
+            std::mutex               run_mutex_;   //!< Serialises the jobs.
+            std::mutex               mutex_;       //!< Guards the members below.
+            std::condition_variable  work_ready_;  //!< Signals a new job.
+            std::condition_variable  done_ready_;  //!< Signals the job done.
+            const xpath_job*         job_;         //!< The current job, or null.
+            std::size_t              next_;        //!< The next document to evaluate.
+            std::size_t              remaining_;   //!< The documents not done yet.
+            std::exception_ptr       error_;       //!< The first error.
+            bool                     stopping_;    //!< Whether stopping.
+            std::vector<std::thread> workers_;     //!< The worker threads.
+
+        };
+
+
+    }  // namespace xtree::detail
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // xpath_executor
+    //
+
+
+    xpath_executor::xpath_executor(std::size_t thread_count): state_(0)
+    {
+        if (thread_count == 0)
+        {
+            thread_count = std::max(std::thread::hardware_concurrency(), 1U);
+        }
+        state_ = new detail::xpath_executor_state(thread_count);
+    }
+
+
+    xpath_executor::~xpath_executor()
+    {
+        delete state_;
+        state_ = 0;
+    }
+
+
+    std::size_t xpath_executor::thread_count() const
+    {
+        return state_->thread_count();
+    }
+
+
+    void xpath_executor::eval_(const std::vector<document*>& docs,
+                               const xpath& expr,
+                               xpath_result_processor& processor)
+    {
+        if (docs.empty())
+        {
+            return;
+        }
+        detail::xpath_job job = { &docs, &expr, &processor };
+        state_->run(job);
+    }
+
+
+#else  // !XTREE_HAS_CXX11
+
+
+    xpath_executor::xpath_executor(std::size_t): state_(0)
+    {
+        // Do nothing.
+    }
+
+
+    xpath_executor::~xpath_executor()
+    {
+        // Do nothing.
+    }
+
+
+    std::size_t xpath_executor::thread_count() const
+    {
+        return 0;
+    }
+
+
+    void xpath_executor::eval_(const std::vector<document*>& docs,
+                               const xpath& expr,
+                               xpath_result_processor& processor)
+    {
+        std::auto_ptr<detail::xpath_context> context;
+        for (std::size_t i = 0; i < docs.size(); ++i)
+        {
+            eval_document(context, *docs[i], i, expr, processor);
+        }
+    }
+
+
+#endif  // XTREE_HAS_CXX11
+
+
+    void xpath_executor::eval_(const std::vector<document*>& docs,
+                               const xpath& expr,
+                               xpath_result_t type,
+                               std::vector<xpath_value>& values)
+    {
+        if (type != boolean_result && type != number_result && type != string_result)
+        {
+            throw bad_dom_operation("fail to evaluate XPath: invalid type " + to_string(type));
+        }
+        values.assign(docs.size(), xpath_value());
+        value_collector collector(type, values);
+        eval_(docs, expr, collector);
+    }
+
+
+}  // namespace xtree
@@ -0,0 +1,254 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/xpath_function.hpp"
+#include "xtree/exceptions.hpp"
+#include "xtree/libxml2_utility.hpp"
+#include "xtree/node_set.hpp"
+#include "xtree/xpath_result.hpp"
+
+#include <libxml/xpath.h>
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef XTREE_HAS_CXX11
+#  include <mutex>
+#endif
+
+
+namespace xtree {
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // xpath_function_args
+    //
+
+
+    xpath_function_args::xpath_function_args(): args_()
+    {
+        // Do nothing.
+    }
+
+
+    xpath_function_args::~xpath_function_args()
+    {
+        typedef std::vector<xmlXPathObject*>::iterator iterator;
+        for (iterator i = args_.begin(); i != args_.end(); ++i)
+        {
+            xmlXPathFreeObject(*i);
+        }
+        args_.clear();
+    }
+
+
+    void xpath_function_args::push_front(xmlXPathObject* px)
+    {
+        try
+        {
+            args_.insert(args_.begin(), px);
+        }
+        catch (...)
+        {
+            xmlXPathFreeObject(px);
+            throw;
+        }
+    }
+
+
+    xpath_result_t xpath_function_args::type(std::size_t index) const
+    {
+        switch (args_.at(index)->type)
+        {
+        case XPATH_NODESET:
+            return node_set_result;
+        case XPATH_BOOLEAN:
+            return boolean_result;
+        case XPATH_NUMBER:
+            return number_result;
+        case XPATH_STRING:
+            return string_result;
+        default:
+            return undefined_result;
+        }
+    }
+
+
+    std::string xpath_function_args::string_at(std::size_t index) const
+    {
+        xmlChar* chars = xmlXPathCastToString(args_.at(index));
+        std::string str = (chars != 0 ? detail::to_chars(chars) : "");
+        xmlFree(chars);
+        return str;
+    }
+
+
+    double xpath_function_args::number_at(std::size_t index) const
+    {
+        return xmlXPathCastToNumber(args_.at(index));
+    }
+
+
+    bool xpath_function_args::boolean_at(std::size_t index) const
+    {
+        return (xmlXPathCastToBoolean(args_.at(index)) != 0);
+    }
+
+
+    void xpath_function_args::nodes_at(std::size_t index, node_set& nodes) const
+    {
+        xmlXPathObject* px = xmlXPathObjectCopy(args_.at(index));
+        if (px == 0)
+        {
+            throw internal_dom_error("fail to copy XPath function argument: out of memory");
+        }
+        xpath_result tmp_result("XPath function argument", px);
+        tmp_result.transfer(nodes);
+    }
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // xpath_function
+    //
+
+
+    xpath_function::xpath_function()
+    {
+        // Do nothing.
+    }
+
+
+    xpath_function::~xpath_function()
+    {
+        // Do nothing.
+    }
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // global XPath function registry
+    //
+
+
+    namespace {
+
+
+        //! This class implements the global registry of XPath extension functions, indexed by
+        //! their namespace URIs and local names. It is guarded by a mutex.
+        class xpath_function_registry
+        {
+
+            typedef std::pair<std::string, std::string> key_type;
+            typedef std::map<key_type, xpath_function*> function_map;
+
+        public:
+
+            explicit xpath_function_registry(): functions_()
+            {
+                // Do nothing.
+            }
+
+            void add(const std::string& name, const std::string& uri, xpath_function& fn)
+            {
+                lock_type lock(mutex_);
+                functions_[key_type(uri, name)] = &fn;
+            }
+
+            bool remove(const std::string& name, const std::string& uri)
+            {
+                lock_type lock(mutex_);
+                return (functions_.erase(key_type(uri, name)) > 0);
+            }
+
+            xpath_function* find(const std::string& name, const std::string& uri)
+            {
+                lock_type lock(mutex_);
+                function_map::const_iterator i = functions_.find(key_type(uri, name));
+                return (i != functions_.end() ? i->second : 0);
+            }
+
+        private:
+
+#ifdef XTREE_HAS_CXX11
+            typedef std::lock_guard<std::mutex> lock_type;
+#else
+            //! Without C++11 support, the registry is not guarded.
+            struct lock_type
+            {
+                explicit lock_type(int)
+                {
+                    // Do nothing.
+                }
+            };
+#endif
+
+            //! Non-implemented copy constructor.
+            xpath_function_registry(const xpath_function_registry&);
+
+            //! Non-implemented copy assignment.
+            xpath_function_registry& operator=(const xpath_function_registry&);
+
+        private:
+
+#ifdef XTREE_HAS_CXX11
+            std::mutex   mutex_;      //!< Guards the functions.
+#else
+            int          mutex_;      //!< Placeholder for the mutex.
+#endif
+            function_map functions_;  //!< The functions registered.
+
+        };
+
+
+        //! Returns the global registry of XPath extension functions.
+        xpath_function_registry& get_xpath_function_registry()
+        {
+            static xpath_function_registry registry;
+            return registry;
+        }
+
+
+    }  // anonymous namespace
+
+
+    void register_xpath_function(const std::string& name,
+                                 const std::string& uri,
+                                 xpath_function& fn)
+    {
+        get_xpath_function_registry().add(name, uri, fn);
+    }
+
+
+    void register_xpath_function(const std::string& name, xpath_function& fn)
+    {
+        get_xpath_function_registry().add(name, std::string(), fn);
+    }
+
+
+    bool unregister_xpath_function(const std::string& name, const std::string& uri)
+    {
+        return get_xpath_function_registry().remove(name, uri);
+    }
+
+
+    namespace detail {
+
+
+        xpath_function* find_xpath_function(const std::string& name, const std::string& uri)
+        {
+            return get_xpath_function_registry().find(name, uri);
+        }
+
+
+    }  // namespace xtree::detail
+
+
+}  // namespace xtree
+
@@ -0,0 +1,137 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#ifndef XTREE_SOURCE
+#define XTREE_SOURCE
+#endif
+
+#include "xtree/xpath_variables.hpp"
+#include "xtree/exceptions.hpp"
+#include "xtree/libxml2_utility.hpp"
+#include "xtree/node_set.hpp"
+
+#include <libxml/xpath.h>
+#include <libxml/xpathInternals.h>
+
+#include <map>
+#include <string>
+#include <utility>
+
+
+namespace xtree {
+
+
+    xpath_variables::xpath_variables(): vars_()
+    {
+        // Do nothing.
+    }
+
+
+    xpath_variables::~xpath_variables()
+    {
+        clear();
+    }
+
+
+    void xpath_variables::set_string(const std::string& name, const std::string& value)
+    {
+        set_(name, xmlXPathNewString(detail::to_xml_chars(value.c_str())));
+    }
+
+
+    void xpath_variables::set_number(const std::string& name, double value)
+    {
+        set_(name, xmlXPathNewFloat(value));
+    }
+
+
+    void xpath_variables::set_boolean(const std::string& name, bool value)
+    {
+        set_(name, xmlXPathNewBoolean(value ? 1 : 0));
+    }
+
+
+    void xpath_variables::set_nodes(const std::string& name, const node_set& nodes)
+    {
+        if (nodes.raw() != 0)
+        {
+            set_(name, xmlXPathObjectCopy(const_cast<xmlXPathObject*>(nodes.raw())));
+        }
+        else
+        {
+            set_(name, xmlXPathNewNodeSet(0));
+        }
+    }
+
+
+    bool xpath_variables::remove(const std::string& name)
+    {
+        std::map<std::string, xmlXPathObject*>::iterator i = vars_.find(name);
+        if (i == vars_.end())
+        {
+            return false;
+        }
+        xmlXPathFreeObject(i->second);
+        vars_.erase(i);
+        return true;
+    }
+
+
+    void xpath_variables::clear()
+    {
+        typedef std::map<std::string, xmlXPathObject*>::iterator iterator;
+        for (iterator i = vars_.begin(); i != vars_.end(); ++i)
+        {
+            xmlXPathFreeObject(i->second);
+        }
+        vars_.clear();
+    }
+
+
+    void xpath_variables::register_to(xmlXPathContext* px) const
+    {
+        xmlXPathRegisteredVariablesCleanup(px);
+        typedef std::map<std::string, xmlXPathObject*>::const_iterator const_iterator;
+        for (const_iterator i = vars_.begin(); i != vars_.end(); ++i)
+        {
+            // The XPath context takes the ownership of the copy once it is registered.
+            xmlXPathObject* value = xmlXPathObjectCopy(i->second);
+            if (value == 0)
+            {
+                std::string what = "fail to copy XPath variable $" + i->first;
+                throw internal_dom_error(what);
+            }
+            const xmlChar* name = detail::to_xml_chars(i->first.c_str());
+            if (xmlXPathRegisterVariable(px, name, value) != 0)
+            {
+                xmlXPathFreeObject(value);
+                std::string what = "fail to register XPath variable $" + i->first;
+                throw xpath_error(what);
+            }
+        }
+    }
+
+
+    void xpath_variables::set_(const std::string& name, xmlXPathObject* value)
+    {
+        if (value == 0)
+        {
+            std::string what = "fail to set XPath variable $" + name + ": out of memory";
+            throw internal_dom_error(what);
+        }
+        std::map<std::string, xmlXPathObject*>::iterator i = vars_.find(name);
+        if (i != vars_.end())
+        {
+            xmlXPathFreeObject(i->second);
+            i->second = value;
+        }
+        else
+        {
+            vars_.insert(std::make_pair(name, value));
+        }
+    }
+
+
+}  // namespace xtree
+
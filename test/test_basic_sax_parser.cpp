@@ -0,0 +1,236 @@
+//
+// Created by ZHENG Zhong on 2011-10-14.
+//
+
+#include "xtree_test_utils.hpp"
+
+#include <xtree/xtree_sax.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+
+    //! This handler records the ids and the texts of the items, and stops the parser after a
+    //! given number of items. It does not handle comments nor errors.
+    class item_handler: public xtree::basic_sax_handler<item_handler>
+    {
+
+    public:
+
+        typedef xtree::basic_sax_parser<item_handler> parser_type;
+
+        explicit item_handler(int stop_after)
+            : parser_(0)
+            , stop_after_(stop_after)
+            , ids_()
+            , texts_()
+            , ended_(false)
+        {
+            // Do nothing.
+        }
+
+        void set_parser(parser_type* parser)
+        {
+            parser_ = parser;
+        }
+
+        void end_document()
+        {
+            ended_ = true;
+        }
+
+        void start_element(const xtree::sax_string_view& name,
+                           const xtree::sax_string_view& prefix,
+                           const xtree::sax_string_view& uri,
+                           const xtree::sax_attribute_view_list& attrs)
+        {
+            if (name == "item")
+            {
+                BOOST_CHECK_EQUAL(prefix, "x");
+                BOOST_CHECK_EQUAL(uri, "http://example.com/x");
+                xtree::sax_attribute_view_list::const_iterator i = attrs.find("id");
+                BOOST_REQUIRE(i != attrs.end());
+                ids_.push_back((*i).value().str());
+                texts_.push_back(std::string());
+            }
+        }
+
+        void characters(const xtree::sax_string_view& chars)
+        {
+            if (!texts_.empty())
+            {
+                texts_.back().append(chars.data(), chars.size());
+            }
+            if (stop_after_ > 0 && static_cast<int>(ids_.size()) == stop_after_)
+            {
+                BOOST_REQUIRE(parser_ != 0);
+                parser_->stop();
+            }
+        }
+
+        const std::vector<std::string>& ids() const
+        {
+            return ids_;
+        }
+
+        const std::vector<std::string>& texts() const
+        {
+            return texts_;
+        }
+
+        bool ended() const
+        {
+            return ended_;
+        }
+
+    private:
+
+        parser_type*             parser_;
+        int                      stop_after_;
+        std::vector<std::string> ids_;
+        std::vector<std::string> texts_;
+        bool                     ended_;
+
+    };
+
+
+    //! This handler counts the fatal errors only.
+    class fatal_counter
+        : public test_utils::basic_fatal_counter< xtree::basic_sax_handler<fatal_counter> >
+    {
+        // Nothing else.
+    };
+
+
+}  // anonymous namespace
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_basic_sax_parser)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 100;
+    std::string xml = test_utils::make_test_xml("<root xmlns:x='http://example.com/x'>",
+                                                "<x:item id='{i}'>item #{i}</x:item>"
+                                                "<!-- comment -->",
+                                                "</root>",
+                                                COUNT);
+    try
+    {
+        // Only the events handled by the handler are dispatched.
+        typedef xtree::detail::sax_handler_traits<item_handler> traits;
+        BOOST_CHECK_EQUAL(static_cast<bool>(traits::start_element), true);
+        BOOST_CHECK_EQUAL(static_cast<bool>(traits::characters), true);
+        BOOST_CHECK_EQUAL(static_cast<bool>(traits::end_document), true);
+        BOOST_CHECK_EQUAL(static_cast<bool>(traits::start_document), false);
+        BOOST_CHECK_EQUAL(static_cast<bool>(traits::end_element), false);
+        BOOST_CHECK_EQUAL(static_cast<bool>(traits::comment), false);
+        BOOST_CHECK_EQUAL(static_cast<bool>(traits::fatal), false);
+        // Parse the XML string, then the same XML as a vector of characters.
+        for (int i = 0; i < 2; ++i)
+        {
+            item_handler handler(0);
+            item_handler::parser_type parser(handler);
+            if (i == 0)
+            {
+                parser.parse_string(xml.c_str());
+            }
+            else
+            {
+                parser.parse_buffer(std::vector<char>(xml.begin(), xml.end()));
+            }
+            BOOST_CHECK_EQUAL(parser.stopped(), false);
+            BOOST_REQUIRE_EQUAL(handler.ids().size(), static_cast<std::size_t>(COUNT));
+            BOOST_CHECK_EQUAL(handler.ids().back(), "99");
+            BOOST_CHECK_EQUAL(handler.texts().back(), "item #99");
+            BOOST_CHECK_EQUAL(handler.ended(), true);
+        }
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_basic_sax_parser_stop)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 1000;
+    std::string xml = test_utils::make_test_xml("<root xmlns:x='http://example.com/x'>",
+                                                "<x:item id='{i}'>item #{i}</x:item>"
+                                                "<!-- comment -->",
+                                                "</root></not-well-formed>",
+                                                COUNT);
+    try
+    {
+        // Stop after 10 items: the rest of the XML (even if not well-formed) is ignored.
+        item_handler handler(10);
+        item_handler::parser_type parser(handler);
+        handler.set_parser(&parser);
+        parser.parse_buffer(xml.data(), xml.size());
+        BOOST_CHECK_EQUAL(parser.stopped(), true);
+        BOOST_REQUIRE_EQUAL(handler.ids().size(), 10U);
+        BOOST_CHECK_EQUAL(handler.ids().back(), "9");
+        BOOST_CHECK_EQUAL(handler.ended(), false);
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_basic_sax_parser_error)
+{
+    XTREE_LOG_TEST_NAME;
+    fatal_counter handler;
+    xtree::basic_sax_parser<fatal_counter> parser(handler);
+    BOOST_CHECK_THROW(parser.parse_string("<root><a></b></root>"), xtree::sax_error);
+    BOOST_CHECK(handler.count() > 0);
+    BOOST_CHECK_THROW(parser.parse_string(0), xtree::sax_error);
+    BOOST_CHECK_THROW(parser.parse_file("non-existent.xml"), xtree::sax_error);
+    // The parser is still usable after an error.
+    parser.parse_string("<root/>");
+    BOOST_CHECK_EQUAL(parser.stopped(), false);
+}
+
+
+BOOST_AUTO_TEST_CASE(test_basic_sax_parser_features)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML =
+        "<!DOCTYPE root [<!ENTITY e '42'>]>"
+        "<root xmlns:x='http://example.com/x'><x:item id='&e;'>&e;</x:item></root>"
+    ;
+    try
+    {
+        // Entities declared in the document type declaration are resolved.
+        item_handler substituted(0);
+        item_handler::parser_type parser(substituted);
+        BOOST_CHECK(parser.get_features() == xtree::sax_feature_set());
+        parser.parse_string(TEST_XML);
+        BOOST_REQUIRE_EQUAL(substituted.ids().size(), 1U);
+        BOOST_CHECK_EQUAL(substituted.ids().front(), "42");
+        BOOST_CHECK_EQUAL(substituted.texts().front(), "42");
+        // If disabled, entity references are kept in attribute values.
+        item_handler not_substituted(0);
+        item_handler::parser_type another_parser(not_substituted);
+        another_parser.set_feature(xtree::sax_feature::substitute_entities, false);
+        another_parser.parse_string(TEST_XML);
+        BOOST_REQUIRE_EQUAL(not_substituted.ids().size(), 1U);
+        BOOST_CHECK_EQUAL(not_substituted.ids().front(), "&e;");
+        BOOST_CHECK_EQUAL(not_substituted.texts().front(), "42");
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
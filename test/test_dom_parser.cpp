@@ -17,8 +17,11 @@
 
 #include <xtree/xtree_dom.hpp>
 
+#include <cstdio>
+#include <fstream>
 #include <memory>
 #include <string>
+#include <vector>
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -133,3 +136,230 @@ BOOST_AUTO_TEST_CASE(test_dom_parse_bad_xml)
 }
 
 
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_dom_parser_options)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML =
+        "<!DOCTYPE root [<!ENTITY name 'xtree'>]>"
+        "<root>\n  <a>&name;</a>\n</root>"
+    ;
+    try
+    {
+        // By default, blank text nodes are removed, and entities are substituted.
+        xtree::dom_parser parser;
+        BOOST_CHECK_EQUAL(parser.get_keep_blanks(), false);
+        BOOST_CHECK_EQUAL(parser.get_substitute_entities(), true);
+        BOOST_CHECK_EQUAL(parser.get_load_external_dtd(), true);
+        std::auto_ptr<xtree::document> doc = parser.parse_string(TEST_XML);
+        BOOST_CHECK_EQUAL(doc->root()->size(), 1U);
+        BOOST_CHECK_EQUAL(doc->root()->find_first_elem()->content(), "xtree");
+        // Keep blank text nodes: the option only applies to this parser.
+        parser.set_keep_blanks(true);
+        BOOST_CHECK_EQUAL(parser.get_keep_blanks(), true);
+        doc = parser.parse_string(TEST_XML);
+        BOOST_CHECK_EQUAL(doc->root()->size(), 3U);
+        BOOST_CHECK_EQUAL(xtree::parse_string(TEST_XML)->root()->size(), 1U);
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_dom_parser_reuse)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML[] = {
+        "<root><a>1</a></root>",
+        "<root><a>2</a><b/></root>",
+        "<root><a>3</a>",  // not well-formed.
+        "<root><a>4</a><b/><c/></root>",
+    };
+    const char* TEST_FILE = "test_dom_parser_reuse.xml";
+    try
+    {
+        // The same parser (and libxml2 parser context) is used to parse all the documents.
+        xtree::dom_parser parser;
+        std::auto_ptr<xtree::document> docs[4];
+        for (unsigned int i = 0; i < sizeof(TEST_XML) / sizeof(const char*); ++i)
+        {
+            if (i == 2)
+            {
+                BOOST_CHECK_THROW(parser.parse_string(TEST_XML[i]), xtree::dom_error);
+            }
+            else
+            {
+                docs[i] = parser.parse_string(TEST_XML[i]);
+            }
+        }
+        BOOST_CHECK_EQUAL(docs[0]->root()->size(), 1U);
+        BOOST_CHECK_EQUAL(docs[1]->root()->size(), 2U);
+        BOOST_CHECK_EQUAL(docs[3]->root()->size(), 3U);
+        BOOST_CHECK_EQUAL(docs[3]->root()->find_first_elem()->content(), "4");
+        // Parse a file with the same parser.
+        docs[1]->save_to_file(TEST_FILE);
+        docs[2] = parser.parse_file(TEST_FILE);
+        BOOST_CHECK_EQUAL(docs[2]->str(), docs[1]->str());
+        BOOST_CHECK_THROW(parser.parse_file("no-such-file.xml"), xtree::dom_error);
+        BOOST_CHECK_EQUAL(parser.parse_string(TEST_XML[0])->str(), docs[0]->str());
+        std::remove(TEST_FILE);
+#ifdef XTREE_HAS_CXX11
+        // The thread-local parser is created once per thread.
+        xtree::dom_parser& local_parser = xtree::get_thread_dom_parser();
+        BOOST_CHECK_EQUAL(&local_parser, &xtree::get_thread_dom_parser());
+        BOOST_CHECK_EQUAL(local_parser.parse_string(TEST_XML[1])->str(), docs[1]->str());
+#endif
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_dom_parse_buffer)
+{
+    XTREE_LOG_TEST_NAME;
+    // Two XML messages in a buffer, followed by an incomplete message.
+    const char BUFFER[] = "<root><a>1</a></root><root><a>2</a><b/></root><root><a>";
+    const std::size_t SIZE_1 = std::string("<root><a>1</a></root>").size();
+    const std::size_t SIZE_2 = std::string("<root><a>2</a><b/></root>").size();
+    try
+    {
+        // Parse slices of the buffer, which are not null-terminated.
+        xtree::dom_parser parser;
+        std::auto_ptr<xtree::document> doc = parser.parse_buffer(BUFFER, SIZE_1);
+        BOOST_CHECK_EQUAL(doc->root()->size(), 1U);
+        BOOST_CHECK_EQUAL(doc->root()->find_first_elem()->content(), "1");
+        doc = xtree::parse_buffer(BUFFER + SIZE_1, SIZE_2);
+        BOOST_CHECK_EQUAL(doc->root()->size(), 2U);
+        BOOST_CHECK_EQUAL(doc->root()->find_first_elem()->content(), "2");
+        BOOST_CHECK_THROW(parser.parse_buffer(BUFFER, SIZE_1 + 1), xtree::dom_error);
+        BOOST_CHECK_THROW(parser.parse_buffer(BUFFER, SIZE_1 - 1), xtree::dom_error);
+        BOOST_CHECK_THROW(parser.parse_buffer(BUFFER, 0), xtree::dom_error);
+        BOOST_CHECK_THROW(parser.parse_buffer(0, SIZE_1), xtree::dom_error);
+        // Parse contiguous ranges.
+        std::vector<char> vec(BUFFER, BUFFER + SIZE_1);
+        doc = parser.parse_buffer(vec);
+        BOOST_CHECK_EQUAL(doc->root()->find_first_elem()->content(), "1");
+        std::string str(BUFFER + SIZE_1, SIZE_2);
+        doc = xtree::parse_buffer(str);
+        BOOST_CHECK_EQUAL(doc->root()->find_first_elem()->content(), "2");
+        BOOST_CHECK_THROW(parser.parse_buffer(std::string()), xtree::dom_error);
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+namespace {
+
+
+    //! Writes data to a binary file.
+    void write_file(const std::string& file_name, const std::string& data)
+    {
+        std::ofstream ofs(file_name.c_str(), std::ios::out | std::ios::binary);
+        ofs.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+
+    //! Returns the little-endian representation of a 32-bit unsigned integer.
+    std::string to_le32(unsigned long value)
+    {
+        std::string le;
+        for (int i = 0; i < 4; ++i)
+        {
+            le += static_cast<char>((value >> (i * 8)) & 0xFF);
+        }
+        return le;
+    }
+
+
+    //! Wraps data (less than 64KB) into a gzip stream, using a single stored (not compressed)
+    //! deflate block.
+    std::string make_gzip(const std::string& data)
+    {
+        unsigned long crc = 0xFFFFFFFFUL;
+        for (std::string::size_type i = 0; i < data.size(); ++i)
+        {
+            crc ^= static_cast<unsigned char>(data[i]);
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc & 1) ? ((crc >> 1) ^ 0xEDB88320UL) : (crc >> 1);
+            }
+        }
+        crc ^= 0xFFFFFFFFUL;
+        unsigned long len = static_cast<unsigned long>(data.size());
+        std::string gz("\x1F\x8B\x08\x00\x00\x00\x00\x00\x00\xFF\x01", 11);
+        gz += to_le32(len | ((~len & 0xFFFF) << 16));
+        gz += data;
+        gz += to_le32(crc);
+        gz += to_le32(len);
+        return gz;
+    }
+
+
+}  // anonymous namespace
+
+
+BOOST_AUTO_TEST_CASE(test_dom_parser_memory_map)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_DTD = "<!ENTITY name 'xtree'>";
+    const char* TEST_XML =
+        "<!DOCTYPE root SYSTEM 'test_dom_parser_memory_map.dtd'>"
+        "<root><a>&name;</a><b/></root>"
+    ;
+    const char* TEST_DTD_FILE = "test_dom_parser_memory_map.dtd";
+    const char* TEST_FILE = "test_dom_parser_memory_map.xml";
+    const char* TEST_GZ_FILE = "test_dom_parser_memory_map.xml.gz";
+    const char* TEST_EMPTY_FILE = "test_dom_parser_memory_map.empty";
+    write_file(TEST_DTD_FILE, TEST_DTD);
+    write_file(TEST_FILE, TEST_XML);
+    write_file(TEST_GZ_FILE, make_gzip(TEST_XML));
+    write_file(TEST_EMPTY_FILE, std::string());
+    try
+    {
+        xtree::dom_parser parser;
+        BOOST_CHECK_EQUAL(parser.get_memory_map(), false);
+        std::auto_ptr<xtree::document> expected = parser.parse_file(TEST_FILE);
+        parser.set_memory_map(true);
+        BOOST_CHECK_EQUAL(parser.get_memory_map(), true);
+        // Parse a file mapped to memory: the relative DTD should be loaded.
+        std::auto_ptr<xtree::document> doc = parser.parse_file(TEST_FILE);
+        BOOST_CHECK_EQUAL(doc->str(), expected->str());
+        BOOST_CHECK_EQUAL(doc->root()->find_first_elem()->content(), "xtree");
+        // Compressed files are parsed by libxml2's file reader.
+        doc = parser.parse_file(TEST_GZ_FILE);
+        BOOST_CHECK_EQUAL(doc->str(), expected->str());
+        // Files which cannot be mapped are parsed by libxml2's file reader.
+        BOOST_CHECK_THROW(parser.parse_file(TEST_EMPTY_FILE), xtree::dom_error);
+        BOOST_CHECK_THROW(parser.parse_file("no-such-file.xml"), xtree::dom_error);
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+    std::remove(TEST_DTD_FILE);
+    std::remove(TEST_FILE);
+    std::remove(TEST_GZ_FILE);
+    std::remove(TEST_EMPTY_FILE);
+}
+
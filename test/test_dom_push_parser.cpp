@@ -0,0 +1,128 @@
+//
+// Created by ZHENG Zhong on 2011-10-08.
+//
+
+#include "xtree_test_utils.hpp"
+
+#include <xtree/xtree_dom.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+
+
+namespace {
+
+
+    //! Feeds a string to a push parser, chunk by chunk.
+    void feed_chunks(xtree::dom_push_parser& parser, const std::string& xml, std::size_t size)
+    {
+        for (std::size_t pos = 0; pos < xml.size(); pos += size)
+        {
+            parser.feed(xml.data() + pos, std::min(size, xml.size() - pos));
+        }
+    }
+
+
+}  // anonymous namespace
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_dom_push_parser)
+{
+    XTREE_LOG_TEST_NAME;
+    // The string contains a multi-byte UTF-8 character, which is split across chunks.
+    const std::string TEST_XML =
+        "<?xml version='1.0' encoding='UTF-8'?>"
+        "<root><a id='1'>caf\xC3\xA9</a><b/><!--comment--></root>"
+    ;
+    try
+    {
+        std::auto_ptr<xtree::document> expected = xtree::parse_string(TEST_XML.c_str());
+        xtree::dom_push_parser parser;
+        BOOST_CHECK_EQUAL(parser.started(), false);
+        // Feed the XML in chunks of various sizes: the same parser is reused for each document.
+        for (std::size_t size = 1; size <= TEST_XML.size(); size += 7)
+        {
+            feed_chunks(parser, TEST_XML, size);
+            BOOST_CHECK_EQUAL(parser.started(), true);
+            std::auto_ptr<xtree::document> doc = parser.finish();
+            BOOST_CHECK_EQUAL(parser.started(), false);
+            BOOST_CHECK_EQUAL(doc->str(), expected->str());
+            BOOST_CHECK_EQUAL(doc->root()->find_first_elem()->content(), "caf\xC3\xA9");
+        }
+        // Empty chunks are allowed.
+        parser.feed("", 0);
+        parser.feed(TEST_XML.data(), TEST_XML.size());
+        parser.feed(0, 0);
+        BOOST_CHECK_EQUAL(parser.finish()->str(), expected->str());
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_dom_push_parser_errors)
+{
+    XTREE_LOG_TEST_NAME;
+    try
+    {
+        xtree::dom_push_parser parser;
+        // Nothing has been fed.
+        BOOST_CHECK_THROW(parser.finish(), xtree::dom_error);
+        // The XML is not well-formed: the error is detected when feeding.
+        BOOST_CHECK_THROW(feed_chunks(parser, "<root><a></b></root>", 4), xtree::dom_error);
+        BOOST_CHECK_EQUAL(parser.started(), false);
+        // The XML is incomplete: the error is detected when finishing.
+        feed_chunks(parser, "<root><a>", 4);
+        BOOST_CHECK_THROW(parser.finish(), xtree::dom_error);
+        BOOST_CHECK_EQUAL(parser.started(), false);
+        // Discard a document being parsed.
+        feed_chunks(parser, "<root><a>", 4);
+        parser.reset();
+        BOOST_CHECK_EQUAL(parser.started(), false);
+        // The parser is still usable after the errors.
+        feed_chunks(parser, "<root><a>1</a></root>", 4);
+        BOOST_CHECK_EQUAL(parser.finish()->root()->find_first_elem()->content(), "1");
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_dom_push_parser_options)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML =
+        "<!DOCTYPE root [<!ENTITY name 'xtree'>]>"
+        "<root>\n  <a>&name;</a>\n</root>"
+    ;
+    try
+    {
+        // Use the parsing options of a DOM parser.
+        xtree::dom_parser options;
+        options.set_keep_blanks(true);
+        xtree::dom_push_parser parser(options);
+        parser.feed(TEST_XML, std::strlen(TEST_XML));
+        std::auto_ptr<xtree::document> doc = parser.finish();
+        BOOST_CHECK_EQUAL(doc->root()->size(), 3U);
+        BOOST_CHECK_EQUAL(doc->root()->find_first_elem()->content(), "xtree");
+        // By default, blank text nodes are removed.
+        xtree::dom_push_parser default_parser;
+        default_parser.feed(TEST_XML, std::strlen(TEST_XML));
+        BOOST_CHECK_EQUAL(default_parser.finish()->root()->size(), 1U);
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
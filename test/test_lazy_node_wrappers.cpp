@@ -0,0 +1,90 @@
+//
+// Created by ZHENG Zhong on 2011-09-12.
+//
+
+#include "xtree_test_utils.hpp"
+
+#include <xtree/xtree_dom.hpp>
+#include <xtree/libxml2_globals.hpp>
+
+#include <libxml/tree.h>
+
+#include <memory>
+#include <string>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_lazy_node_wrappers)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML =
+        "<root xmlns:x='http://www.example.com/xtree'>"
+        "<a id='1'>A</a><!--comment--><x:b>B</x:b><?pi value?><c>C<d>D</d></c>"
+        "</root>"
+    ;
+    BOOST_CHECK_EQUAL(xtree::get_lazy_node_wrappers(), false);
+    xtree::set_lazy_node_wrappers(true);
+    BOOST_CHECK_EQUAL(xtree::get_lazy_node_wrappers(), true);
+    try
+    {
+        std::auto_ptr<xtree::document> doc(xtree::parse_string(TEST_XML));
+        // No wrapper should have been created by the parser.
+        const xmlNode* px_root = xmlDocGetRootElement(doc->raw_doc());
+        BOOST_REQUIRE(px_root != 0);
+        BOOST_CHECK(px_root->_private == 0);
+        BOOST_CHECK(px_root->children->_private == 0);
+        // Wrappers are created on first access.
+        xtree::element_ptr root = doc->root();
+        BOOST_REQUIRE(root != 0);
+        BOOST_CHECK(px_root->_private == root.operator->());
+        BOOST_CHECK_EQUAL(root->name(), "root");
+        BOOST_CHECK(px_root->children->_private == 0);
+        // Finding an element does not create wrappers for the skipped elements.
+        xtree::element_ptr c = root->find_elem_by_name("c");
+        BOOST_REQUIRE(c != 0);
+        BOOST_CHECK_EQUAL(c->content(), "CD");
+        BOOST_CHECK(px_root->children->_private == 0);
+        BOOST_CHECK_EQUAL(root->find_elem("b", "http://www.example.com/xtree")->content(), "B");
+        BOOST_CHECK_EQUAL(root->find_elem_by_path("c/d")->content(), "D");
+        BOOST_CHECK_EQUAL(root->find_last_elem(), c);
+        // Iterate over the child nodes.
+        const xtree::node_t TYPES[] = {
+            xtree::element_node,
+            xtree::comment_node,
+            xtree::element_node,
+            xtree::instruction_node,
+            xtree::element_node,
+        };
+        unsigned int index = 0;
+        for (xtree::element::child_iterator i = root->begin(); i != root->end(); ++i, ++index)
+        {
+            BOOST_REQUIRE(index < sizeof(TYPES) / sizeof(const xtree::node_t));
+            BOOST_CHECK_EQUAL(i->type(), TYPES[index]);
+            BOOST_CHECK(i->parent() == root);
+        }
+        BOOST_CHECK_EQUAL(index, 5U);
+        // Access attributes.
+        xtree::element_ptr a = root->find_first_elem();
+        BOOST_REQUIRE(a != 0);
+        BOOST_CHECK_EQUAL(a->attr("id"), "1");
+        BOOST_CHECK_EQUAL(a->attrs().begin()->value(), "1");
+        // Evaluate XPath.
+        xtree::node_set nodes;
+        doc->select_nodes("//d/text()", nodes);
+        BOOST_REQUIRE_EQUAL(nodes.size(), 1U);
+        BOOST_CHECK_EQUAL(nodes.begin()->content(), "D");
+        // Modify the tree.
+        root->push_back_clone(*c);
+        BOOST_CHECK_EQUAL(root->size(), 6U);
+        root->erase(root->begin());
+        BOOST_CHECK_EQUAL(root->size(), 5U);
+        BOOST_CHECK_EQUAL(root->find_first_elem()->qname(), "x:b");
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+    xtree::set_lazy_node_wrappers(false);
+}
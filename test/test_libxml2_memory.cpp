@@ -0,0 +1,185 @@
+//
+// Created by ZHENG Zhong on 2011-09-27.
+//
+
+#include "xtree_test_utils.hpp"
+
+#include <xtree/xtree_dom.hpp>
+#include <xtree/libxml2_globals.hpp>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef XTREE_HAS_CXX11
+#  include <thread>
+#endif
+
+
+namespace {
+
+
+    void parse_and_check(const std::string& xml, int count)
+    {
+        std::auto_ptr<xtree::document> doc(xtree::parse_string(xml.c_str()));
+        BOOST_REQUIRE(doc->root() != 0);
+        BOOST_CHECK_EQUAL(doc->root()->size(), static_cast<xtree::size_type>(count));
+        xtree::element_ptr last = doc->root()->find_last_elem();
+        BOOST_REQUIRE(last != 0);
+        std::ostringstream oss;
+        oss << "item #" << (count - 1);
+        BOOST_CHECK_EQUAL(last->content(), oss.str());
+        std::auto_ptr<xtree::document> cloned(xtree::clone_document(*doc));
+        BOOST_CHECK_EQUAL(cloned->str(), doc->str());
+    }
+
+
+    void parse_repeatedly(const std::string* xml, int times, int* failures)
+    {
+        // Do not use Boost.Test macros here: they are not thread-safe.
+        try
+        {
+            xtree::dom_parser parser;
+            for (int i = 0; i < times; ++i)
+            {
+                std::auto_ptr<xtree::document> doc(parser.parse_string(xml->c_str()));
+                xtree::element_ptr first = doc->root()->find_first_elem();
+                if (first == 0 || first->attr("id") != "0")
+                {
+                    ++(*failures);
+                }
+            }
+        }
+        catch (const xtree::dom_error&)
+        {
+            ++(*failures);
+        }
+    }
+
+
+}  // anonymous namespace
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#ifdef XTREE_HAS_CXX11
+
+
+BOOST_AUTO_TEST_CASE(test_libxml2_pool_allocator)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 100;
+    std::string xml = test_utils::make_test_xml("<root xmlns:x='http://www.example.com/xtree'>",
+                                                "<x:item id='{i}'>item #{i}<!--comment--></x:item>",
+                                                "</root>",
+                                                COUNT);
+    try
+    {
+        // Parse a document with the malloc allocator, and keep it while switching allocator.
+        std::auto_ptr<xtree::document> doc(xtree::parse_string(xml.c_str()));
+        // Install the pool allocator: memory blocks allocated before should be handled properly.
+        xtree::set_libxml2_allocator(xtree::libxml2_pool_allocator);
+        BOOST_CHECK_EQUAL(xtree::get_libxml2_allocator(), xtree::libxml2_pool_allocator);
+        xtree::libxml2_memory_stats before = xtree::get_libxml2_memory_stats();
+        parse_and_check(xml, COUNT);
+        doc->root()->push_back_element("new")->set_attr("id", "new");
+        doc.reset();
+        xtree::libxml2_memory_stats after = xtree::get_libxml2_memory_stats();
+        BOOST_CHECK(after.allocations > before.allocations);
+        BOOST_CHECK(after.deallocations > before.deallocations);
+        BOOST_CHECK(after.allocated_bytes > before.allocated_bytes);
+        BOOST_CHECK(after.reserved_bytes > 0U);
+        // The pool allocator cannot be uninstalled.
+        xtree::set_libxml2_allocator(xtree::libxml2_pool_allocator);
+        try
+        {
+            xtree::set_libxml2_allocator(xtree::libxml2_malloc_allocator);
+            BOOST_ERROR("bad_dom_operation should be thrown when uninstalling pool allocator");
+        }
+        catch (const xtree::bad_dom_operation&)
+        {
+            // Expected.
+        }
+        BOOST_CHECK_EQUAL(xtree::get_libxml2_allocator(), xtree::libxml2_pool_allocator);
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_libxml2_document_regions)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 100;
+    std::string xml = test_utils::make_test_xml("<root xmlns:x='http://www.example.com/xtree'>",
+                                                "<x:item id='{i}'>item #{i}<!--comment--></x:item>",
+                                                "</root>",
+                                                COUNT);
+    BOOST_CHECK_EQUAL(xtree::get_libxml2_document_regions(), false);
+    xtree::set_libxml2_document_regions(true);
+    BOOST_CHECK_EQUAL(xtree::get_libxml2_document_regions(), true);
+    try
+    {
+        xtree::libxml2_memory_stats before = xtree::get_libxml2_memory_stats();
+        parse_and_check(xml, COUNT);
+        xtree::libxml2_memory_stats after = xtree::get_libxml2_memory_stats();
+        BOOST_CHECK_EQUAL(after.regions, before.regions + 2U);
+        // Move nodes between documents allocated from different regions.
+        std::auto_ptr<xtree::document> doc1(xtree::parse_string(xml.c_str()));
+        std::auto_ptr<xtree::document> doc2(xtree::parse_string("<root/>"));
+        doc2->root()->push_back_adopt(*doc1->root()->find_first_elem());
+        doc1.reset();
+        BOOST_CHECK_EQUAL(doc2->root()->find_first_elem()->content(), "item #0");
+        doc2->root()->push_back_element("new")->set_attr("id", "new");
+        BOOST_CHECK_EQUAL(doc2->root()->size(), 2U);
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+    xtree::set_libxml2_document_regions(false);
+}
+
+
+BOOST_AUTO_TEST_CASE(test_libxml2_pool_allocator_threads)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 200;
+    const int THREADS = 4;
+    std::string xml = test_utils::make_test_xml("<root xmlns:x='http://www.example.com/xtree'>",
+                                                "<x:item id='{i}'>item #{i}<!--comment--></x:item>",
+                                                "</root>",
+                                                COUNT);
+    xtree::set_libxml2_document_regions(true);
+    try
+    {
+        xtree::libxml2_memory_stats before = xtree::get_libxml2_memory_stats();
+        std::vector<int> failures(THREADS, 0);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < THREADS; ++i)
+        {
+            threads.push_back(std::thread(&parse_repeatedly, &xml, 10, &failures[i]));
+        }
+        for (int i = 0; i < THREADS; ++i)
+        {
+            threads[i].join();
+            BOOST_CHECK_EQUAL(failures[i], 0);
+        }
+        xtree::libxml2_memory_stats after = xtree::get_libxml2_memory_stats();
+        BOOST_CHECK(after.allocations > before.allocations);
+        BOOST_CHECK(after.regions >= before.regions + THREADS * 10U);
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+    xtree::set_libxml2_document_regions(false);
+}
+
+
+#endif  // XTREE_HAS_CXX11
+
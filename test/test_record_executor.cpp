@@ -0,0 +1,180 @@
+//
+// Created by ZHENG Zhong on 2011-10-18.
+//
+
+#include "xtree_test_utils.hpp"
+
+#include <xtree/xtree.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+
+    //! Makes a record holding the values from 0 to (index % 7).
+    std::string make_record(int index, int)
+    {
+        std::ostringstream oss;
+        oss << "<record id='" << index << "'>";
+        for (int j = 0; j <= index % 7; ++j)
+        {
+            oss << "<value>" << j << "</value>";
+        }
+        oss << "</record>";
+        return oss.str();
+    }
+
+
+    //! This processor sums the values of each record on the worker threads, and stores the sum
+    //! in the record itself. The sums are collected when the records are completed.
+    class sum_processor: public xtree::record_processor
+    {
+
+    public:
+
+        explicit sum_processor(std::size_t throw_at = static_cast<std::size_t>(-1))
+            : throw_at_(throw_at)
+            , indices_()
+            , sums_()
+        {
+            // Do nothing.
+        }
+
+        void process(xtree::document& record, std::size_t index)
+        {
+            if (index == throw_at_)
+            {
+                throw std::runtime_error("fail to process record");
+            }
+            double sum = record.eval_number(xtree::xpath("sum(/record/value)"));
+            std::ostringstream oss;
+            oss << sum;
+            record.root()->set_attr("sum", oss.str());
+        }
+
+        void complete(xtree::document& record, std::size_t index)
+        {
+            indices_.push_back(index);
+            sums_.push_back(record.root()->attr("sum"));
+        }
+
+        const std::vector<std::size_t>& indices() const
+        {
+            return indices_;
+        }
+
+        const std::vector<std::string>& sums() const
+        {
+            return sums_;
+        }
+
+    private:
+
+        std::size_t              throw_at_;
+        std::vector<std::size_t> indices_;
+        std::vector<std::string> sums_;
+
+    };
+
+
+}  // anonymous namespace
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_record_executor)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 1000;
+    std::string xml = test_utils::make_test_xml("<feed>", &make_record, "</feed>", COUNT);
+    try
+    {
+        // Process the records in ordered mode, then in unordered mode, with a tight bound.
+        for (int i = 0; i < 2; ++i)
+        {
+            bool ordered = (i == 0);
+            sum_processor processor;
+            xtree::record_executor executor(processor, 4, (ordered ? 0 : 1), ordered);
+            BOOST_CHECK(executor.max_in_flight() > 0);
+            xtree::subtree_splitter splitter("/feed/record");
+            splitter.set_subtree_handler(&executor);
+            splitter.parse_string(xml.c_str());
+            executor.finish();
+            BOOST_CHECK_EQUAL(executor.completed(), static_cast<std::size_t>(COUNT));
+            BOOST_REQUIRE_EQUAL(processor.indices().size(), static_cast<std::size_t>(COUNT));
+            std::vector<std::size_t> indices = processor.indices();
+            if (ordered)
+            {
+                BOOST_CHECK_EQUAL(processor.sums()[0], "0");
+                BOOST_CHECK_EQUAL(processor.sums()[6], "21");
+                BOOST_CHECK_EQUAL(processor.sums()[COUNT - 1], "15");
+            }
+            else
+            {
+                std::sort(indices.begin(), indices.end());
+            }
+            for (std::size_t n = 0; n < indices.size(); ++n)
+            {
+                BOOST_REQUIRE_EQUAL(indices[n], n);
+            }
+        }
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_record_executor_error)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 1000;
+    std::string xml = test_utils::make_test_xml("<feed>", &make_record, "</feed>", COUNT);
+    try
+    {
+        // The exception thrown by the processor is propagated, either through the splitter or
+        // by finish(): the records after the failed one are not all completed.
+        sum_processor processor(100);
+        xtree::record_executor executor(processor, 2, 4, true);
+        xtree::subtree_splitter splitter("/feed/record");
+        splitter.set_subtree_handler(&executor);
+        try
+        {
+            splitter.parse_string(xml.c_str());
+            executor.finish();
+            BOOST_ERROR("record_executor should propagate the exception");
+        }
+        catch (const std::runtime_error&)
+        {
+            // Expected.
+        }
+        BOOST_CHECK(processor.indices().size() <= 100U);
+        BOOST_CHECK_EQUAL(executor.completed(), processor.indices().size());
+        // The executor is ready to be used again.
+        executor.finish();
+        splitter.parse_string("<feed><record><value>1</value></record></feed>");
+        executor.finish();
+        BOOST_CHECK_EQUAL(processor.sums().back(), "1");
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
@@ -0,0 +1,193 @@
+//
+// Created by ZHENG Zhong on 2011-10-17.
+//
+
+#include "xtree_test_utils.hpp"
+
+#include <xtree/xtree_dom.hpp>
+#include <xtree/xtree_sax.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+
+    //! This content handler records all the events as strings.
+    class recording_handler: public xtree::sax_content_handler
+    {
+
+    public:
+
+        void start_document()
+        {
+            events_.push_back("start_document");
+        }
+
+        void end_document()
+        {
+            events_.push_back("end_document");
+        }
+
+        void start_element(const std::string& name,
+                           const std::string& prefix,
+                           const std::string& uri,
+                           const xtree::sax_attribute_list& attrs)
+        {
+            std::string event = "start_element: {" + uri + "}" + prefix + ":" + name;
+            for (xtree::sax_attribute_list::const_iterator i = attrs.begin(); i != attrs.end(); ++i)
+            {
+                event += " {" + i->uri() + "}" + i->prefix() + ":" + i->name() + "=" + i->value();
+            }
+            events_.push_back(event);
+        }
+
+        void end_element(const std::string& name,
+                         const std::string& prefix,
+                         const std::string& uri)
+        {
+            events_.push_back("end_element: {" + uri + "}" + prefix + ":" + name);
+        }
+
+        void characters(const char* chars, int length)
+        {
+            events_.push_back("characters: " + std::string(chars, length));
+        }
+
+        void cdata_block(const char* chars, int length)
+        {
+            events_.push_back("cdata_block: " + std::string(chars, length));
+        }
+
+        void comment(const char* chars)
+        {
+            events_.push_back("comment: " + std::string(chars));
+        }
+
+        const std::vector<std::string>& events() const
+        {
+            return events_;
+        }
+
+    private:
+
+        std::vector<std::string> events_;
+
+    };
+
+
+}  // anonymous namespace
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_sax_event_buffer)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 100;
+    std::string xml = test_utils::make_test_xml("<root xmlns='http://example.com/xtree'>",
+                                                "<x:item xmlns:x='http://example.com/x'"
+                                                " x:id='{i}' type='t'>item #{i}<![CDATA[<{i}>]]>"
+                                                "</x:item><!-- comment #{i} -->",
+                                                "</root>",
+                                                COUNT);
+    try
+    {
+        // Record the events, and the events expected.
+        xtree::sax_event_buffer buffer;
+        BOOST_CHECK(buffer.empty());
+        recording_handler expected;
+        xtree::sax_parser parser;
+        parser.set_content_handler(&buffer);
+        parser.parse_string(xml.c_str());
+        parser.set_content_handler(&expected);
+        parser.parse_string(xml.c_str());
+        BOOST_CHECK_EQUAL(buffer.size(), expected.events().size());
+        // The names are interned: "", root, item, x, id, type, and the two URIs.
+        BOOST_CHECK_EQUAL(buffer.name_count(), 8U);
+        // The events can be replayed many times.
+        for (int i = 0; i < 3; ++i)
+        {
+            recording_handler handler;
+            buffer.replay(handler);
+            BOOST_CHECK(handler.events() == expected.events());
+        }
+        // Clear the buffer: nothing is replayed.
+        buffer.clear();
+        BOOST_CHECK(buffer.empty());
+        BOOST_CHECK_EQUAL(buffer.name_count(), 0U);
+        BOOST_CHECK_EQUAL(buffer.text_size(), 0U);
+        recording_handler nothing;
+        buffer.replay(nothing);
+        BOOST_CHECK(nothing.events().empty());
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_sax_event_buffer_replay_document)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 10;
+    std::string xml = test_utils::make_test_xml("<root xmlns='http://example.com/xtree'>",
+                                                "<x:item xmlns:x='http://example.com/x'"
+                                                " x:id='{i}' type='t'>item #{i}<![CDATA[<{i}>]]>"
+                                                "</x:item><!-- comment #{i} -->",
+                                                "</root>",
+                                                COUNT);
+    try
+    {
+        // The document built from the events is the same as the document parsed.
+        std::auto_ptr<xtree::document> expected = xtree::dom_parser().parse_string(xml.c_str());
+        xtree::sax_event_buffer buffer;
+        xtree::sax_parser parser;
+        parser.set_content_handler(&buffer);
+        parser.parse_string(xml.c_str());
+        std::auto_ptr<xtree::document> doc = buffer.replay_document();
+        BOOST_CHECK_EQUAL(doc->str(), expected->str());
+        xtree::basic_node_ptr<xtree::element> root = doc->root();
+        BOOST_REQUIRE(root != 0);
+        BOOST_CHECK_EQUAL(root->uri(), "http://example.com/xtree");
+        BOOST_CHECK_EQUAL(root->size(), static_cast<std::size_t>(2 * COUNT));
+        // A dom_builder can also be set as the content handler of a SAX parser.
+        xtree::dom_builder builder;
+        parser.set_content_handler(&builder);
+        parser.parse_string(xml.c_str());
+        BOOST_CHECK_EQUAL(builder.release()->str(), expected->str());
+        BOOST_CHECK_THROW(builder.release(), xtree::bad_dom_operation);
+        // Namespace declarations reported as attributes are not turned into attributes.
+        parser.set_feature(xtree::sax_feature::namespace_prefixes, true);
+        parser.parse_string(xml.c_str());
+        std::auto_ptr<xtree::document> prefixed = builder.release();
+        BOOST_CHECK_EQUAL(prefixed->str(), expected->str());
+        xtree::basic_node_ptr<xtree::element> item = prefixed->root()->find_first_elem();
+        BOOST_REQUIRE(item != 0);
+        BOOST_CHECK_EQUAL(item->attrs().size(), 2U);
+        BOOST_CHECK_EQUAL(item->prefix(), "x");
+        BOOST_CHECK(item->find_xmlns_by_prefix("xmlns") == 0);
+        parser.set_feature(xtree::sax_feature::namespace_prefixes, false);
+        // The events recorded do not form a document.
+        xtree::sax_event_buffer partial;
+        partial.start_document();
+        partial.start_element("root", "", "", xtree::sax_attribute_list());
+        partial.end_element("root", "", "");
+        partial.end_element("root", "", "");
+        BOOST_CHECK_THROW(partial.replay_document(), xtree::bad_dom_operation);
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
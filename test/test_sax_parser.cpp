@@ -6,8 +6,11 @@
 
 #include <xtree/xtree_sax.hpp>
 
+#include <cstdio>
+#include <fstream>
 #include <memory>
 #include <string>
+#include <vector>
 
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -153,3 +156,370 @@ BOOST_AUTO_TEST_CASE(test_sax_parser_with_handler)
     }
 }
 
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_sax_parser_parse_buffer)
+{
+    XTREE_LOG_TEST_NAME;
+    const std::string TEST_XML =
+        "<root xmlns='http://example.com/xtree'>"
+          "<x:sub1 xmlns:x='http://example.com/xtree/x1'>"
+            "<x:sub2 xmlns:x='http://example.com/xtree/x2'>"
+              "<x:sub3 a='A' x:b='B'>hello,world</x:sub3>"
+            "</x:sub2>"
+          "</x:sub1>"
+        "</root>"
+    ;
+    try
+    {
+        // Parse a slice of a buffer, which is not null-terminated.
+        std::vector<char> buffer(TEST_XML.begin(), TEST_XML.end());
+        buffer.insert(buffer.end(), 8, '<');
+        xtree::sax_parser parser;
+        dummy_content_handler handler;
+        parser.set_content_handler(&handler);
+        parser.parse_buffer(&buffer[0], TEST_XML.size());
+        // Parse a contiguous range.
+        dummy_content_handler range_handler;
+        parser.set_content_handler(&range_handler);
+        buffer.resize(TEST_XML.size());
+        parser.parse_buffer(buffer);
+        // Parse a slice which is not well-formed.
+        parser.set_content_handler(0);
+        BOOST_CHECK_THROW(parser.parse_buffer(&buffer[0], buffer.size() - 1), xtree::sax_error);
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_sax_parser_memory_map)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML =
+        "<root xmlns='http://example.com/xtree'>"
+          "<x:sub1 xmlns:x='http://example.com/xtree/x1'>"
+            "<x:sub2 xmlns:x='http://example.com/xtree/x2'>"
+              "<x:sub3 a='A' x:b='B'>hello,world</x:sub3>"
+            "</x:sub2>"
+          "</x:sub1>"
+        "</root>"
+    ;
+    const char* TEST_FILE = "test_sax_parser_memory_map.xml";
+    {
+        std::ofstream ofs(TEST_FILE, std::ios::out | std::ios::binary);
+        ofs << TEST_XML;
+    }
+    try
+    {
+        xtree::sax_parser parser;
+        dummy_content_handler handler;
+        parser.set_content_handler(&handler);
+        parser.set_memory_map(true);
+        BOOST_CHECK_EQUAL(parser.get_memory_map(), true);
+        parser.parse_file(TEST_FILE);
+        BOOST_CHECK_THROW(parser.parse_file("no-such-file.xml"), xtree::sax_error);
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+    std::remove(TEST_FILE);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+namespace {
+
+
+    //! This view handler checks the same events as dummy_content_handler, through string views.
+    class dummy_view_handler: public xtree::sax_view_handler
+    {
+
+    public:
+
+        dummy_view_handler(): index_(0)
+        {
+            // Do nothing.
+        }
+
+        void start_document()
+        {
+            check_("start_document: ");
+        }
+
+        void end_document()
+        {
+            check_("end_document: ");
+            BOOST_CHECK_EQUAL(index_, MAX_INDEX_);
+        }
+
+        void start_element(const xtree::sax_string_view& name,
+                           const xtree::sax_string_view& prefix,
+                           const xtree::sax_string_view& uri,
+                           const xtree::sax_attribute_view_list& attrs)
+        {
+            check_("start_element: {" + uri.str() + "}" + prefix.str() + ":" + name.str());
+            typedef xtree::sax_attribute_view_list::const_iterator iterator;
+            for (iterator i = attrs.begin(); i != attrs.end(); ++i)
+            {
+                xtree::sax_attribute_view attr = *i;
+                check_( "attribute: {" + attr.uri().str() + "}@" + attr.prefix().str() + ":"
+                      + attr.name().str() + "=" + attr.value().str() );
+            }
+            if (name == "sub3")
+            {
+                BOOST_REQUIRE_EQUAL(attrs.size(), 2U);
+                BOOST_CHECK_EQUAL(attrs.end() - attrs.begin(), 2);
+                BOOST_CHECK(attrs.find("a") == attrs.begin());
+                BOOST_CHECK(attrs.find("b", "http://example.com/xtree/x2") == attrs.begin() + 1);
+                BOOST_CHECK(attrs.find("b", "") == attrs.end());
+                BOOST_CHECK(attrs.find("c") == attrs.end());
+                BOOST_CHECK_EQUAL(attrs[1].value(), "B");
+                BOOST_CHECK_EQUAL(attrs[1].prefix(), std::string("x"));
+                BOOST_CHECK(attrs[0].prefix().empty());
+            }
+        }
+
+        void end_element(const xtree::sax_string_view& name,
+                         const xtree::sax_string_view& prefix,
+                         const xtree::sax_string_view& uri)
+        {
+            check_("end_element: {" + uri.str() + "}" + prefix.str() + ":" + name.str());
+        }
+
+        void characters(const xtree::sax_string_view& chars)
+        {
+            check_("characters: " + chars.str());
+        }
+
+    private:
+
+        void check_(const std::string& got)
+        {
+            BOOST_REQUIRE(index_ < MAX_INDEX_);
+            BOOST_CHECK_EQUAL(got, EXPECTED_[index_++]);
+        }
+
+    private:
+
+        unsigned int index_;
+
+    };
+
+
+}  // anonymous namespace
+
+
+BOOST_AUTO_TEST_CASE(test_sax_parser_with_view_handler)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML =
+        "<root xmlns='http://example.com/xtree'>"
+          "<x:sub1 xmlns:x='http://example.com/xtree/x1'>"
+            "<x:sub2 xmlns:x='http://example.com/xtree/x2'>"
+              "<x:sub3 a='A' x:b='B'>hello,world</x:sub3>"
+            "</x:sub2>"
+          "</x:sub1>"
+        "</root>"
+    ;
+    try
+    {
+        // Use a view handler only.
+        xtree::sax_parser parser;
+        dummy_view_handler view_handler;
+        parser.set_view_handler(&view_handler);
+        parser.parse_string(TEST_XML);
+        // Use both a view handler and a content handler.
+        dummy_view_handler another_view_handler;
+        dummy_content_handler content_handler;
+        parser.set_view_handler(&another_view_handler);
+        parser.set_content_handler(&content_handler);
+        parser.parse_string(TEST_XML);
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_sax_string_view)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* BUFFER = "hello,world";
+    xtree::sax_string_view empty;
+    BOOST_CHECK(empty.empty());
+    BOOST_CHECK_EQUAL(empty.size(), 0U);
+    BOOST_CHECK(empty == "");
+    BOOST_CHECK(xtree::sax_string_view(0) == empty);
+    xtree::sax_string_view hello(BUFFER, 5);
+    BOOST_CHECK_EQUAL(hello.size(), 5U);
+    BOOST_CHECK_EQUAL(hello.str(), "hello");
+    BOOST_CHECK(hello == "hello");
+    BOOST_CHECK(hello != "hello,world");
+    BOOST_CHECK(hello != "hell");
+    BOOST_CHECK(std::string("hello") == hello);
+    BOOST_CHECK(hello != std::string("hello,"));
+    BOOST_CHECK(hello == xtree::sax_string_view("hello"));
+    BOOST_CHECK(xtree::sax_string_view(BUFFER) == "hello,world");
+    BOOST_CHECK_EQUAL(std::string(hello.begin(), hello.end()), "hello");
+    BOOST_CHECK_EQUAL(hello[4], 'o');
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+namespace {
+
+
+    //! This content handler records the elements, the attributes and the characters.
+    class recording_content_handler: public xtree::sax_content_handler
+    {
+
+    public:
+
+        void start_element(const std::string& name,
+                           const std::string& prefix,
+                           const std::string& uri,
+                           const xtree::sax_attribute_list& attrs)
+        {
+            events_.push_back("start_element: {" + uri + "}" + prefix + ":" + name);
+            for (xtree::sax_attribute_list::const_iterator i = attrs.begin(); i != attrs.end(); ++i)
+            {
+                events_.push_back( "attribute: {" + i->uri() + "}@" + i->prefix() + ":"
+                                 + i->name() + "=" + i->value() );
+            }
+        }
+
+        void end_element(const std::string& name,
+                         const std::string& prefix,
+                         const std::string& uri)
+        {
+            events_.push_back("end_element: {" + uri + "}" + prefix + ":" + name);
+        }
+
+        void characters(const char* chars, int length)
+        {
+            events_.push_back("characters: " + std::string(chars, length));
+        }
+
+        const std::vector<std::string>& events() const
+        {
+            return events_;
+        }
+
+    private:
+
+        std::vector<std::string> events_;
+
+    };
+
+
+}  // anonymous namespace
+
+
+BOOST_AUTO_TEST_CASE(test_sax_parser_features)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML =
+        "<root xmlns='http://example.com/xtree'>"
+          "<x:sub xmlns:x='http://example.com/xtree/x' a='A' x:b='B'/>"
+        "</root>"
+    ;
+    const char* XMLNS_URI = "http://www.w3.org/2000/xmlns/";
+    try
+    {
+        // Check the default features, and the SAX2 standard feature names.
+        xtree::sax_parser parser;
+        BOOST_CHECK(parser.get_features() == xtree::sax_feature_set());
+        BOOST_CHECK(parser.get_feature(xtree::sax_feature::namespaces));
+        BOOST_CHECK(parser.get_feature(xtree::sax_feature::substitute_entities));
+        BOOST_CHECK(parser.get_feature(xtree::sax_feature::load_external_dtd));
+        BOOST_CHECK(!parser.get_feature(xtree::sax_feature::namespace_prefixes));
+        BOOST_CHECK(!parser.get_feature(xtree::sax_feature::huge));
+        BOOST_CHECK(!parser.get_feature(xtree::sax_feature::no_network));
+        BOOST_CHECK(parser.get_feature(xtree::sax_namespaces));
+        BOOST_CHECK(!parser.get_feature(xtree::sax_namespace_prefixes));
+        parser.set_feature(xtree::sax_external_general_entities, false);
+        BOOST_CHECK(!parser.get_feature(xtree::sax_feature::substitute_entities));
+        BOOST_CHECK_THROW(parser.set_feature("no-such-feature", true), xtree::sax_error);
+        BOOST_CHECK(!parser.get_feature("no-such-feature"));
+        // Disable namespaces: the content handler receives QNames.
+        parser.set_features(xtree::sax_feature_set().reset(xtree::sax_feature::namespaces));
+        recording_content_handler no_namespaces;
+        parser.set_content_handler(&no_namespaces);
+        parser.parse_string(TEST_XML);
+        BOOST_REQUIRE_EQUAL(no_namespaces.events().size(), 6U);
+        BOOST_CHECK_EQUAL(no_namespaces.events()[0], "start_element: {}:root");
+        BOOST_CHECK_EQUAL(no_namespaces.events()[1], "start_element: {}:x:sub");
+        BOOST_CHECK_EQUAL(no_namespaces.events()[2], "attribute: {}@:a=A");
+        BOOST_CHECK_EQUAL(no_namespaces.events()[3], "attribute: {}@:x:b=B");
+        BOOST_CHECK_EQUAL(no_namespaces.events()[4], "end_element: {}:x:sub");
+        // Enable namespace prefixes: the namespace declarations are reported as attributes.
+        parser.set_feature(xtree::sax_feature::namespaces, true);
+        parser.set_feature(xtree::sax_namespace_prefixes, true);
+        recording_content_handler prefixes;
+        parser.set_content_handler(&prefixes);
+        parser.parse_string(TEST_XML);
+        BOOST_REQUIRE_EQUAL(prefixes.events().size(), 8U);
+        BOOST_CHECK_EQUAL( prefixes.events()[1],
+                           "attribute: {" + std::string(XMLNS_URI)
+                         + "}@:xmlns=http://example.com/xtree" );
+        BOOST_CHECK_EQUAL(prefixes.events()[2], "start_element: {http://example.com/xtree/x}x:sub");
+        BOOST_CHECK_EQUAL(prefixes.events()[4], "attribute: {http://example.com/xtree/x}@x:b=B");
+        BOOST_CHECK_EQUAL( prefixes.events()[5],
+                           "attribute: {" + std::string(XMLNS_URI)
+                         + "}@xmlns:x=http://example.com/xtree/x" );
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_sax_parser_substitute_entities)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML = "<!DOCTYPE root [<!ENTITY e 'entity'>]><root a='[&e;]'>[&e;]</root>";
+    try
+    {
+        // Entities are substituted in attribute values and in texts.
+        xtree::sax_parser parser;
+        recording_content_handler substituted;
+        parser.set_content_handler(&substituted);
+        parser.parse_string(TEST_XML);
+        BOOST_REQUIRE(substituted.events().size() >= 2U);
+        BOOST_CHECK_EQUAL(substituted.events()[1], "attribute: {}@:a=[entity]");
+        // If disabled, entity references are kept in attribute values. Internal entities are
+        // still expanded in texts, as required by SAX2.
+        parser.set_feature(xtree::sax_feature::substitute_entities, false);
+        recording_content_handler not_substituted;
+        parser.set_content_handler(&not_substituted);
+        parser.parse_string(TEST_XML);
+        BOOST_REQUIRE(not_substituted.events().size() >= 2U);
+        BOOST_CHECK_EQUAL(not_substituted.events()[1], "attribute: {}@:a=[&e;]");
+        std::string text;
+        for (std::size_t i = 2; i < not_substituted.events().size() - 1; ++i)
+        {
+            text += not_substituted.events()[i];
+        }
+        BOOST_CHECK_EQUAL(text, "characters: [characters: entitycharacters: ]");
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
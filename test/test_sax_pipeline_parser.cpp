@@ -0,0 +1,221 @@
+//
+// Created by ZHENG Zhong on 2011-10-16.
+//
+
+#include "xtree_test_utils.hpp"
+
+#include <xtree/xtree_sax.hpp>
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+
+    //! This content handler records all the events, and throws after a given number of items.
+    class recording_handler: public xtree::sax_content_handler
+    {
+
+    public:
+
+        explicit recording_handler(int throw_after = 0)
+            : throw_after_(throw_after)
+            , items_(0)
+            , events_()
+        {
+            // Do nothing.
+        }
+
+        void start_document()
+        {
+            events_.push_back("start_document");
+        }
+
+        void end_document()
+        {
+            events_.push_back("end_document");
+        }
+
+        void start_element(const std::string& name,
+                           const std::string& prefix,
+                           const std::string& uri,
+                           const xtree::sax_attribute_list& attrs)
+        {
+            std::string event = "start_element: {" + uri + "}" + prefix + ":" + name;
+            for (xtree::sax_attribute_list::const_iterator i = attrs.begin(); i != attrs.end(); ++i)
+            {
+                event += " " + i->name() + "=" + i->value();
+            }
+            events_.push_back(event);
+            if (name == "item" && ++items_ == throw_after_)
+            {
+                throw std::runtime_error("too many items");
+            }
+        }
+
+        void end_element(const std::string& name,
+                         const std::string& prefix,
+                         const std::string& uri)
+        {
+            events_.push_back("end_element: {" + uri + "}" + prefix + ":" + name);
+        }
+
+        void characters(const char* chars, int length)
+        {
+            events_.push_back("characters: " + std::string(chars, length));
+        }
+
+        void comment(const char* chars)
+        {
+            events_.push_back("comment: " + std::string(chars));
+        }
+
+        const std::vector<std::string>& events() const
+        {
+            return events_;
+        }
+
+    private:
+
+        int                      throw_after_;
+        int                      items_;
+        std::vector<std::string> events_;
+
+    };
+
+
+    //! This error handler counts the fatal errors only.
+    typedef test_utils::basic_fatal_counter<xtree::sax_error_handler> fatal_counter;
+
+
+}  // anonymous namespace
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_sax_pipeline_parser)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 1000;
+    std::string xml = test_utils::make_test_xml("<root xmlns:x='http://example.com/x'>",
+                                                "<x:item id='{i}'>item #{i}</x:item>"
+                                                "<!-- comment -->",
+                                                "</root>",
+                                                COUNT);
+    try
+    {
+        // The pipelined parser should replay exactly the same events as the SAX parser.
+        recording_handler expected;
+        xtree::sax_parser parser;
+        parser.set_content_handler(&expected);
+        parser.parse_string(xml.c_str());
+        std::size_t event_count = static_cast<std::size_t>(2 + 4 * COUNT + 2);
+        BOOST_REQUIRE_EQUAL(expected.events().size(), event_count);
+        // Use tiny blocks to pass the events through many blocks, then the default blocks.
+        const std::size_t block_sizes[] = {
+            1, 100, xtree::sax_pipeline_parser::default_block_size
+        };
+        for (std::size_t i = 0; i < sizeof(block_sizes) / sizeof(block_sizes[0]); ++i)
+        {
+            xtree::sax_pipeline_parser pipeline(block_sizes[i], 2);
+            // The same pipelined parser is reused for each document.
+            for (int j = 0; j < 2; ++j)
+            {
+                recording_handler handler;
+                pipeline.set_content_handler(&handler);
+                if (j == 0)
+                {
+                    pipeline.parse_string(xml.c_str());
+                }
+                else
+                {
+                    pipeline.parse_buffer(std::vector<char>(xml.begin(), xml.end()));
+                }
+                BOOST_CHECK(handler.events() == expected.events());
+            }
+        }
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_sax_pipeline_parser_features)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML = "<x:root xmlns:x='http://example.com/x' x:a='A'/>";
+    try
+    {
+        xtree::sax_pipeline_parser pipeline;
+        BOOST_CHECK(pipeline.get_features() == xtree::sax_feature_set());
+        recording_handler with_namespaces;
+        pipeline.set_content_handler(&with_namespaces);
+        pipeline.parse_string(TEST_XML);
+        BOOST_REQUIRE_EQUAL(with_namespaces.events().size(), 4U);
+        BOOST_CHECK_EQUAL( with_namespaces.events()[1],
+                           "start_element: {http://example.com/x}x:root a=A" );
+        // Disable namespaces: the qualified names are reported.
+        pipeline.set_feature(xtree::sax_feature::namespaces, false);
+        BOOST_CHECK(!pipeline.get_feature(xtree::sax_feature::namespaces));
+        recording_handler without_namespaces;
+        pipeline.set_content_handler(&without_namespaces);
+        pipeline.parse_string(TEST_XML);
+        BOOST_REQUIRE_EQUAL(without_namespaces.events().size(), 4U);
+        BOOST_CHECK_EQUAL(without_namespaces.events()[1], "start_element: {}:x:root x:a=A");
+        BOOST_CHECK_EQUAL(without_namespaces.events()[2], "end_element: {}:x:root");
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_sax_pipeline_parser_error)
+{
+    XTREE_LOG_TEST_NAME;
+    xtree::sax_pipeline_parser pipeline(16, 2);
+    // The events preceding the error are replayed before the exception is thrown.
+    recording_handler handler;
+    fatal_counter errors;
+    pipeline.set_content_handler(&handler);
+    pipeline.set_error_handler(&errors);
+    BOOST_CHECK_THROW(pipeline.parse_string("<root><a></b></root>"), xtree::sax_error);
+    BOOST_REQUIRE(handler.events().size() >= 3U);
+    BOOST_CHECK_EQUAL(handler.events()[2], "start_element: {}:a");
+    BOOST_CHECK(errors.count() > 0);
+    pipeline.set_content_handler(0);
+    pipeline.set_error_handler(0);
+    BOOST_CHECK_THROW(pipeline.parse_string(0), xtree::sax_error);
+    BOOST_CHECK_THROW(pipeline.parse_file("non-existent.xml"), xtree::sax_error);
+    // An exception thrown by the handler cancels the parsing, and is propagated.
+    const int COUNT = 10000;
+    std::string xml = test_utils::make_test_xml("<root xmlns:x='http://example.com/x'>",
+                                                "<x:item id='{i}'>item #{i}</x:item>"
+                                                "<!-- comment -->",
+                                                "</root>",
+                                                COUNT);
+    recording_handler throwing(10);
+    pipeline.set_content_handler(&throwing);
+    BOOST_CHECK_THROW(pipeline.parse_string(xml.c_str()), std::runtime_error);
+    BOOST_CHECK(throwing.events().size() < static_cast<std::size_t>(COUNT));
+    // The parser is still usable after an error.
+    recording_handler another;
+    pipeline.set_content_handler(&another);
+    try
+    {
+        pipeline.parse_string("<root/>");
+        BOOST_CHECK_EQUAL(another.events().size(), 4U);
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
@@ -0,0 +1,319 @@
+//
+// Created by ZHENG Zhong on 2011-10-10.
+//
+
+#include "xtree_test_utils.hpp"
+
+#include <xtree/xtree_sax.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+
+    //! Feeds a string to a push parser, chunk by chunk.
+    void feed_chunks(xtree::sax_push_parser& parser, const std::string& xml, std::size_t size)
+    {
+        for (std::size_t pos = 0; pos < xml.size(); pos += size)
+        {
+            parser.feed(xml.data() + pos, std::min(size, xml.size() - pos));
+        }
+    }
+
+
+    //! This content handler records the ids of the items, and stops or pauses the parser after
+    //! a given number of items.
+    class item_handler: public xtree::sax_content_handler
+    {
+
+    public:
+
+        explicit item_handler(xtree::sax_push_parser& parser, int stop_after, int pause_every)
+            : parser_(parser)
+            , stop_after_(stop_after)
+            , pause_every_(pause_every)
+            , ids_()
+            , ended_(false)
+        {
+            // Do nothing.
+        }
+
+        void end_document()
+        {
+            ended_ = true;
+        }
+
+        void start_element(const std::string& name,
+                           const std::string&,
+                           const std::string&,
+                           const xtree::sax_attribute_list& attrs)
+        {
+            if (name == "item")
+            {
+                BOOST_REQUIRE(!attrs.empty());
+                ids_.push_back(attrs.begin()->value());
+                int count = static_cast<int>(ids_.size());
+                if (stop_after_ > 0 && count == stop_after_)
+                {
+                    parser_.stop();
+                }
+                else if (pause_every_ > 0 && count % pause_every_ == 0)
+                {
+                    parser_.pause();
+                }
+            }
+        }
+
+        const std::vector<std::string>& ids() const
+        {
+            return ids_;
+        }
+
+        bool ended() const
+        {
+            return ended_;
+        }
+
+    private:
+
+        xtree::sax_push_parser&  parser_;
+        int                      stop_after_;
+        int                      pause_every_;
+        std::vector<std::string> ids_;
+        bool                     ended_;
+
+    };
+
+
+    //! This content handler throws when it receives the start of a given element.
+    class throwing_handler: public xtree::sax_content_handler
+    {
+
+    public:
+
+        explicit throwing_handler(const std::string& name): name_(name), count_(0)
+        {
+            // Do nothing.
+        }
+
+        void start_element(const std::string& name,
+                           const std::string&,
+                           const std::string&,
+                           const xtree::sax_attribute_list&)
+        {
+            ++count_;
+            if (name == name_)
+            {
+                throw std::runtime_error("throwing_handler: " + name);
+            }
+        }
+
+        int count() const
+        {
+            return count_;
+        }
+
+    private:
+
+        std::string name_;
+        int         count_;
+
+    };
+
+
+}  // anonymous namespace
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_sax_push_parser)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 100;
+    std::string xml = test_utils::make_test_xml("<root>",
+                                                "<item id='{i}'>item #{i}</item>",
+                                                "</root>",
+                                                COUNT);
+    try
+    {
+        xtree::sax_push_parser parser;
+        // Parse the XML in chunks of various sizes: the same parser is reused for each document.
+        for (std::size_t size = 1; size <= xml.size(); size += 331)
+        {
+            item_handler handler(parser, 0, 0);
+            parser.set_content_handler(&handler);
+            feed_chunks(parser, xml, size);
+            BOOST_CHECK_EQUAL(parser.started(), true);
+            parser.finish();
+            BOOST_CHECK_EQUAL(parser.started(), false);
+            BOOST_REQUIRE_EQUAL(handler.ids().size(), static_cast<std::size_t>(COUNT));
+            BOOST_CHECK_EQUAL(handler.ids().back(), "99");
+            BOOST_CHECK_EQUAL(handler.ended(), true);
+        }
+        // The XML is not well-formed.
+        parser.set_content_handler(0);
+        BOOST_CHECK_THROW(feed_chunks(parser, "<root><a></b></root>", 4), xtree::sax_error);
+        BOOST_CHECK_EQUAL(parser.started(), false);
+        feed_chunks(parser, "<root><a>", 4);
+        BOOST_CHECK_THROW(parser.finish(), xtree::sax_error);
+        BOOST_CHECK_THROW(parser.finish(), xtree::sax_error);
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_sax_push_parser_stop)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 1000;
+    std::string xml = test_utils::make_test_xml("<root>",
+                                                "<item id='{i}'>item #{i}</item>",
+                                                "</root>",
+                                                COUNT);
+    try
+    {
+        // Stop after 10 items: the rest of the XML (even if not well-formed) is ignored.
+        xtree::sax_push_parser parser;
+        item_handler handler(parser, 10, 0);
+        parser.set_content_handler(&handler);
+        feed_chunks(parser, xml, 4096);
+        BOOST_CHECK_EQUAL(parser.stopped(), true);
+        parser.feed("</not-well-formed>", 18);
+        parser.finish();
+        BOOST_CHECK_EQUAL(parser.stopped(), false);
+        BOOST_REQUIRE_EQUAL(handler.ids().size(), 10U);
+        BOOST_CHECK_EQUAL(handler.ids().back(), "9");
+        BOOST_CHECK_EQUAL(handler.ended(), false);
+        // The parser is still usable after being stopped.
+        item_handler another(parser, 0, 0);
+        parser.set_content_handler(&another);
+        feed_chunks(parser, xml, 4096);
+        parser.finish();
+        BOOST_CHECK_EQUAL(another.ids().size(), static_cast<std::size_t>(COUNT));
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_sax_push_parser_throwing_handler)
+{
+    XTREE_LOG_TEST_NAME;
+    try
+    {
+        // A callback throws: the exception goes through feed(), and the document is discarded.
+        std::auto_ptr<xtree::sax_push_parser> parser(new xtree::sax_push_parser());
+        throwing_handler handler("bad");
+        parser->set_content_handler(&handler);
+        BOOST_CHECK_THROW(parser->feed("<root><bad/></root>", 19), std::runtime_error);
+        BOOST_CHECK_EQUAL(parser->started(), false);
+        BOOST_CHECK_EQUAL(handler.count(), 2);
+        // The parser is ready to parse another document.
+        BOOST_CHECK_THROW(parser->feed("<root><a/><bad/></root>", 23), std::runtime_error);
+        BOOST_CHECK_EQUAL(handler.count(), 5);
+        parser->feed("<root><a/>", 10);
+        parser->feed("<b/></root>", 11);
+        parser->finish();
+        BOOST_CHECK_EQUAL(handler.count(), 8);
+        // The parser may be destructed after a callback has thrown.
+        BOOST_CHECK_THROW(parser->feed("<bad/>", 6), std::runtime_error);
+        parser.reset();
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_sax_push_parser_pause)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 1000;
+    const int PAUSE_EVERY = 100;
+    std::string xml = test_utils::make_test_xml("<root>",
+                                                "<item id='{i}'>item #{i}</item>",
+                                                "</root>",
+                                                COUNT);
+    try
+    {
+        // Pause every 100 items: the XML fed while paused is kept until resumed. Parse in slices
+        // smaller than 100 items, so that each pause takes effect before the next one.
+        xtree::sax_push_parser parser;
+        BOOST_CHECK(parser.get_slice_size() == xtree::sax_push_parser::default_slice_size);
+        parser.set_slice_size(1024);
+        item_handler handler(parser, 0, PAUSE_EVERY);
+        parser.set_content_handler(&handler);
+        parser.feed(xml.data(), xml.size());
+        int pauses = 0;
+        while (parser.paused())
+        {
+            ++pauses;
+            // A pause takes effect at the end of the current slice.
+            std::size_t count = handler.ids().size();
+            BOOST_CHECK(count >= static_cast<std::size_t>(pauses * PAUSE_EVERY));
+            BOOST_CHECK(count < static_cast<std::size_t>((pauses + 1) * PAUSE_EVERY));
+            BOOST_CHECK_THROW(parser.finish(), xtree::bad_dom_operation);
+            parser.resume();
+        }
+        BOOST_CHECK_EQUAL(pauses, COUNT / PAUSE_EVERY);
+        parser.finish();
+        BOOST_REQUIRE_EQUAL(handler.ids().size(), static_cast<std::size_t>(COUNT));
+        for (int i = 0; i < COUNT; ++i)
+        {
+            std::ostringstream oss;
+            oss << i;
+            BOOST_CHECK_EQUAL(handler.ids()[i], oss.str());
+        }
+        BOOST_CHECK_EQUAL(handler.ended(), true);
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(test_sax_push_parser_features)
+{
+    XTREE_LOG_TEST_NAME;
+    std::string xml = "<!DOCTYPE root [<!ENTITY e '42'>]><root><item id='&e;'/></root>";
+    try
+    {
+        // Entities declared in the document type declaration are resolved.
+        xtree::sax_push_parser parser;
+        item_handler substituted(parser, 0, 0);
+        parser.set_content_handler(&substituted);
+        feed_chunks(parser, xml, 7);
+        parser.finish();
+        BOOST_REQUIRE_EQUAL(substituted.ids().size(), 1U);
+        BOOST_CHECK_EQUAL(substituted.ids().front(), "42");
+        // The features are applied when the parser starts parsing a new document.
+        parser.set_features(xtree::sax_feature_set().reset(xtree::sax_feature::substitute_entities)
+                                                    .set(xtree::sax_feature::huge));
+        item_handler not_substituted(parser, 0, 0);
+        parser.set_content_handler(&not_substituted);
+        feed_chunks(parser, xml, 7);
+        parser.finish();
+        BOOST_REQUIRE_EQUAL(not_substituted.ids().size(), 1U);
+        BOOST_CHECK_EQUAL(not_substituted.ids().front(), "&e;");
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
@@ -0,0 +1,220 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#include "xtree_test_utils.hpp"
+
+#include <xtree/xtree.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+
+    const char* TEST_XML = "<feed xmlns:x='http://example.com/x'>"
+                           "<item id='1' type='book'><title>A</title>"
+                           "<item id='1.1' type='book'/></item>"
+                           "<item id='2' type='cd'><title>B</title></item>"
+                           "<x:item id='3' x:type='book'><title>C</title></x:item>"
+                           "<group><item id='4' type='book'><title>D</title></item></group>"
+                           "</feed>";
+
+
+    //! This match handler records the ids of the matching elements, and the text they contain
+    //! (received as the content handler of the matcher).
+    class item_handler: public xtree::stream_match_handler, public xtree::sax_content_handler
+    {
+
+    public:
+
+        explicit item_handler(const xtree::stream_matcher& matcher)
+        : matcher_(matcher), ids_(), text_(), ends_(0)
+        {
+            // Do nothing.
+        }
+
+        virtual void start_match(const std::string&,
+                                 const std::string&,
+                                 const std::string&,
+                                 const xtree::sax_attribute_list& attrs)
+        {
+            for (xtree::sax_attribute_list::const_iterator i = attrs.begin(); i != attrs.end(); ++i)
+            {
+                if (i->name() == "id")
+                {
+                    ids_.push_back(i->value());
+                }
+            }
+        }
+
+        virtual void end_match(const std::string&, const std::string&, const std::string&)
+        {
+            ++ends_;
+        }
+
+        virtual void characters(const char* chars, int length)
+        {
+            if (matcher_.in_match())
+            {
+                text_.append(chars, length);
+            }
+        }
+
+        const std::vector<std::string>& ids() const
+        {
+            return ids_;
+        }
+
+        const std::string& text() const
+        {
+            return text_;
+        }
+
+        std::size_t ends() const
+        {
+            return ends_;
+        }
+
+    private:
+
+        const xtree::stream_matcher& matcher_;
+        std::vector<std::string>     ids_;
+        std::string                  text_;
+        std::size_t                  ends_;
+
+    };
+
+
+    //! Returns the ids of the elements matching a pattern, using SAX mode.
+    std::string match_sax(const xtree::stream_pattern& pattern)
+    {
+        xtree::stream_matcher matcher(pattern);
+        item_handler handler(matcher);
+        matcher.set_match_handler(&handler);
+        xtree::sax_parser parser;
+        parser.set_content_handler(&matcher);
+        parser.parse_string(TEST_XML);
+        std::string ids;
+        for (std::size_t i = 0; i < handler.ids().size(); ++i)
+        {
+            ids += (i == 0 ? "" : ",") + handler.ids()[i];
+        }
+        BOOST_CHECK_EQUAL(matcher.count(), handler.ids().size());
+        BOOST_CHECK_EQUAL(handler.ends(), handler.ids().size());
+        BOOST_CHECK(!matcher.in_match());
+        return ids;
+    }
+
+
+    //! Returns the ids of the elements matching a pattern, using pull mode.
+    std::string match_reader(const xtree::stream_pattern& pattern)
+    {
+        xtree::xml_reader reader;
+        reader.open_string(TEST_XML);
+        xtree::stream_matcher matcher(pattern);
+        std::string ids;
+        while (matcher.next(reader))
+        {
+            ids += (ids.empty() ? "" : ",") + reader.attr("id");
+        }
+        return ids;
+    }
+
+
+}  // anonymous namespace
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_stream_pattern)
+{
+    XTREE_LOG_TEST_NAME;
+    const std::string X_URI = "http://example.com/x";
+    try
+    {
+        const char* patterns[][2] = {
+            { "/feed/item",                     "1,2"         },
+            { "//item",                         "1,1.1,2,4"   },
+            { "/feed//item",                    "1,1.1,2,4"   },
+            { "item",                           ""            },
+            { "/feed/*[@id]",                   "1,2,3"       },
+            { "//item[@type='book']",           "1,1.1,4"     },
+            { "//item[@type != \"book\"]",      "2"           },
+            { "//item[@type='book'][@id='4']",  "4"           },
+            { "/feed/x:item | //group/item",    "3,4"         },
+            { "//x:item[@x:type='book']",       "3"           },
+            { "//*[@x:type]",                   "3"           },
+            { "//item[@missing]",               ""            },
+        };
+        for (std::size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); ++i)
+        {
+            xtree::stream_pattern pattern(patterns[i][0], "x", X_URI);
+            BOOST_CHECK_EQUAL(pattern.str(), patterns[i][0]);
+            BOOST_CHECK_EQUAL(match_sax(pattern), patterns[i][1]);
+            BOOST_CHECK_EQUAL(match_reader(pattern), patterns[i][1]);
+        }
+        // The text of the matching elements is received by the content handler.
+        xtree::stream_pattern pattern("//item[@type='book']");
+        xtree::stream_matcher matcher(pattern);
+        item_handler handler(matcher);
+        matcher.set_match_handler(&handler);
+        matcher.set_content_handler(&handler);
+        xtree::sax_parser parser;
+        parser.set_content_handler(&matcher);
+        parser.parse_string(TEST_XML);
+        BOOST_CHECK_EQUAL(handler.text(), "AD");
+        // The matcher is reset by each parsing.
+        parser.parse_string(TEST_XML);
+        BOOST_CHECK_EQUAL(matcher.count(), 3U);
+        // Skip the subtrees of the matching elements in pull mode.
+        xtree::xml_reader reader;
+        reader.open_string(TEST_XML);
+        xtree::stream_matcher pull_matcher(pattern);
+        std::vector<std::string> titles;
+        while (pull_matcher.next(reader))
+        {
+            xtree::basic_node_ptr<xtree::element> item = reader.expand();
+            BOOST_REQUIRE(item != 0);
+            titles.push_back(item->eval_string("string(title)"));
+            pull_matcher.skip(reader);
+        }
+        BOOST_REQUIRE_EQUAL(titles.size(), 2U);
+        BOOST_CHECK_EQUAL(titles[0], "A");
+        BOOST_CHECK_EQUAL(titles[1], "D");
+        BOOST_CHECK_EQUAL(pull_matcher.count(), 2U);
+        // Adjacent matching elements are matched after skipping.
+        xtree::stream_pattern all_items("//item | //x:item", "x", X_URI);
+        reader.open_string(TEST_XML);
+        xtree::stream_matcher skip_matcher(all_items);
+        std::string ids;
+        while (skip_matcher.next(reader))
+        {
+            ids += (ids.empty() ? "" : ",") + reader.attr("id");
+            skip_matcher.skip(reader);
+        }
+        BOOST_CHECK_EQUAL(ids, "1,2,3,4");
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_stream_pattern_errors)
+{
+    XTREE_LOG_TEST_NAME;
+    BOOST_CHECK_THROW(xtree::stream_pattern("//item[@id"), xtree::xpath_error);
+    BOOST_CHECK_THROW(xtree::stream_pattern("//item[@id]/title"), xtree::xpath_error);
+    BOOST_CHECK_THROW(xtree::stream_pattern("//item[position()=1]"), xtree::xpath_error);
+    BOOST_CHECK_THROW(xtree::stream_pattern("//item[@x:id]"), xtree::xpath_error);
+    BOOST_CHECK_THROW(xtree::stream_pattern("//item/@id"), xtree::xpath_error);
+    BOOST_CHECK_THROW(xtree::stream_pattern("//item[@id=1]"), xtree::xpath_error);
+    BOOST_CHECK_THROW(xtree::stream_pattern("/feed/item | "), xtree::xpath_error);
+    BOOST_CHECK_THROW(xtree::stream_pattern("//x:item"), xtree::xpath_error);
+}
+
@@ -0,0 +1,184 @@
+//
+// Created by ZHENG Zhong on 2011-10-17.
+//
+
+#include "xtree_test_utils.hpp"
+
+#include <xtree/xtree.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+
+    //! This subtree handler records the ids and the titles of the records, keeps the last
+    //! record, and stops the splitter after a given number of records.
+    class record_handler: public xtree::subtree_handler
+    {
+
+    public:
+
+        explicit record_handler(xtree::subtree_splitter& splitter, std::size_t stop_after)
+            : splitter_(splitter)
+            , stop_after_(stop_after)
+            , ids_()
+            , titles_()
+            , last_()
+        {
+            // Do nothing.
+        }
+
+        void subtree(std::auto_ptr<xtree::document> doc, std::size_t index)
+        {
+            BOOST_CHECK_EQUAL(index, ids_.size());
+            xtree::basic_node_ptr<xtree::element> root = doc->root();
+            BOOST_REQUIRE(root != 0);
+            BOOST_CHECK_EQUAL(root->name(), "record");
+            BOOST_CHECK_EQUAL(root->uri(), "http://example.com/feed");
+            ids_.push_back(root->attr("id"));
+            // The XPath API is available on each record.
+            xtree::xpath expr("string(/f:record/f:title)", "f", "http://example.com/feed");
+            titles_.push_back(doc->eval_string(expr));
+            last_ = doc;
+            if (stop_after_ > 0 && ids_.size() == stop_after_)
+            {
+                splitter_.stop();
+            }
+        }
+
+        const std::vector<std::string>& ids() const
+        {
+            return ids_;
+        }
+
+        const std::vector<std::string>& titles() const
+        {
+            return titles_;
+        }
+
+        const xtree::document* last() const
+        {
+            return last_.get();
+        }
+
+    private:
+
+        xtree::subtree_splitter&        splitter_;
+        std::size_t                     stop_after_;
+        std::vector<std::string>        ids_;
+        std::vector<std::string>        titles_;
+        std::auto_ptr<xtree::document>  last_;
+
+    };
+
+
+}  // anonymous namespace
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_subtree_splitter)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 100;
+    std::string xml = test_utils::make_test_xml("<feed xmlns='http://example.com/feed'>"
+                                                "<header><record id='none'/></header>",
+                                                "<record id='{i}'><title>record #{i}</title>"
+                                                "<!-- comment --><record id='nested'/></record>",
+                                                "</feed>",
+                                                COUNT);
+    try
+    {
+        // Only the records directly under the feed are materialized.
+        const char* PATHS[] = { "/feed/record", "feed/record", "/*/record" };
+        for (std::size_t i = 0; i < sizeof(PATHS) / sizeof(PATHS[0]); ++i)
+        {
+            xtree::subtree_splitter splitter(PATHS[i]);
+            BOOST_CHECK_EQUAL(splitter.path(), PATHS[i]);
+            record_handler handler(splitter, 0);
+            splitter.set_subtree_handler(&handler);
+            splitter.parse_string(xml.c_str());
+            BOOST_CHECK_EQUAL(splitter.stopped(), false);
+            BOOST_CHECK_EQUAL(splitter.count(), static_cast<std::size_t>(COUNT));
+            BOOST_REQUIRE_EQUAL(handler.ids().size(), static_cast<std::size_t>(COUNT));
+            BOOST_CHECK_EQUAL(handler.ids().back(), "99");
+            BOOST_CHECK_EQUAL(handler.titles().back(), "record #99");
+        }
+        // The handler may keep the ownership of a record.
+        xtree::subtree_splitter splitter("/feed/record");
+        record_handler handler(splitter, 0);
+        splitter.set_subtree_handler(&handler);
+        splitter.parse_buffer(std::vector<char>(xml.begin(), xml.end()));
+        BOOST_REQUIRE(handler.last() != 0);
+        BOOST_CHECK_EQUAL( handler.last()->root()->str(),
+                           "<record xmlns=\"http://example.com/feed\" id=\"99\">"
+                           "<title>record #99</title><!-- comment --><record id=\"nested\"/>"
+                           "</record>" );
+        // Match nothing.
+        xtree::subtree_splitter nothing("/feed/nothing");
+        nothing.parse_string(xml.c_str());
+        BOOST_CHECK_EQUAL(nothing.count(), 0U);
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_subtree_splitter_stop)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 1000;
+    std::string xml = test_utils::make_test_xml("<feed xmlns='http://example.com/feed'>"
+                                                "<header><record id='none'/></header>",
+                                                "<record id='{i}'><title>record #{i}</title>"
+                                                "<!-- comment --><record id='nested'/></record>",
+                                                "</feed></not-well-formed>",
+                                                COUNT);
+    try
+    {
+        // Stop after 10 records: the rest of the XML (even if not well-formed) is ignored.
+        xtree::subtree_splitter splitter("/feed/record");
+        record_handler handler(splitter, 10);
+        splitter.set_subtree_handler(&handler);
+        splitter.parse_string(xml.c_str());
+        BOOST_CHECK_EQUAL(splitter.stopped(), true);
+        BOOST_CHECK_EQUAL(splitter.count(), 10U);
+        BOOST_REQUIRE_EQUAL(handler.ids().size(), 10U);
+        BOOST_CHECK_EQUAL(handler.ids().back(), "9");
+    }
+    catch (const xtree::sax_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_subtree_splitter_error)
+{
+    XTREE_LOG_TEST_NAME;
+    BOOST_CHECK_THROW(xtree::subtree_splitter(""), xtree::sax_error);
+    BOOST_CHECK_THROW(xtree::subtree_splitter("/"), xtree::sax_error);
+    BOOST_CHECK_THROW(xtree::subtree_splitter("/feed//record"), xtree::sax_error);
+    BOOST_CHECK_THROW(xtree::subtree_splitter("/feed/record/"), xtree::sax_error);
+    // The records preceding the error are handed to the handler.
+    xtree::subtree_splitter splitter("/feed/record");
+    record_handler handler(splitter, 0);
+    splitter.set_subtree_handler(&handler);
+    const char* BAD_XML = "<feed xmlns='http://example.com/feed'><record id='0'/><record></feed>";
+    BOOST_CHECK_THROW(splitter.parse_string(BAD_XML), xtree::sax_error);
+    BOOST_CHECK_EQUAL(handler.ids().size(), 1U);
+    BOOST_CHECK_THROW(splitter.parse_string(0), xtree::sax_error);
+    BOOST_CHECK_THROW(splitter.parse_file("non-existent.xml"), xtree::sax_error);
+}
+
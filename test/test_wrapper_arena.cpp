@@ -0,0 +1,215 @@
+//
+// Created by ZHENG Zhong on 2011-09-20.
+//
+
+#include "xtree_test_utils.hpp"
+
+#include <xtree/xtree_dom.hpp>
+#include <xtree/xtree_sax.hpp>
+#include <xtree/libxml2_globals.hpp>
+#include <xtree/wrapper_arena.hpp>
+
+#include <libxml/tree.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_wrapper_arena)
+{
+    XTREE_LOG_TEST_NAME;
+    xtree::detail::wrapper_arena* arena = xtree::detail::wrapper_arena::create();
+    try
+    {
+        // Allocate, free and reuse memory blocks.
+        void* p1 = arena->allocate(40);
+        void* p2 = arena->allocate(40);
+        BOOST_CHECK(p1 != 0 && p2 != 0 && p1 != p2);
+        BOOST_CHECK(arena->reserved_bytes() > 0U);
+        arena->deallocate(p1, 40);
+        BOOST_CHECK(arena->allocate(40) == p1);
+        // Large memory blocks are served from dedicated chunks.
+        std::size_t reserved = arena->reserved_bytes();
+        BOOST_CHECK(arena->allocate(64 * 1024) != 0);
+        BOOST_CHECK(arena->reserved_bytes() >= reserved + 64 * 1024);
+    }
+    catch (const std::bad_alloc& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+    arena->release();
+}
+
+
+BOOST_AUTO_TEST_CASE(test_document_wrapper_arena)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML = "<root><a>A</a><b>B</b><c>C</c></root>";
+    xtree::set_lazy_node_wrappers(true);
+    try
+    {
+        std::auto_ptr<xtree::document> doc(xtree::parse_string(TEST_XML));
+        BOOST_CHECK(doc->find_wrapper_arena() == 0);
+        // Wrappers created lazily are allocated from the document's arena.
+        xtree::element_ptr root = doc->root();
+        BOOST_REQUIRE(root != 0);
+        xtree::detail::wrapper_arena* arena = doc->find_wrapper_arena();
+        BOOST_REQUIRE(arena != 0);
+        BOOST_CHECK(xtree::detail::get_wrapper_arena(root.operator->()) == arena);
+        BOOST_CHECK_EQUAL(root->find_elem_by_name("b")->content(), "B");
+        // Wrappers of the new nodes are also allocated from the arena once they are linked.
+        xtree::element_ptr d = root->push_back_element("d");
+        BOOST_REQUIRE(d != 0);
+        d->push_back_text("D");
+        BOOST_CHECK_EQUAL(root->size(), 4U);
+        root->erase(root->begin());
+        BOOST_CHECK_EQUAL(root->size(), 3U);
+        BOOST_CHECK_EQUAL(root->find_first_elem()->name(), "b");
+        // Adopt nodes from another document, then destroy the other document.
+        std::auto_ptr<xtree::document> other(xtree::parse_string("<other><x>X</x></other>"));
+        xtree::element_ptr x = other->root()->find_first_elem();
+        BOOST_REQUIRE(x != 0);
+        BOOST_CHECK(xtree::detail::get_wrapper_arena(x.operator->()) != arena);
+        root->push_back_adopt(*x);
+        other.reset();
+        // The wrappers created by the other document should still be valid.
+        BOOST_CHECK_EQUAL(x->name(), "x");
+        BOOST_CHECK_EQUAL(x->content(), "X");
+        BOOST_CHECK(x->parent() == root);
+        BOOST_CHECK_EQUAL(root->find_last_elem(), x);
+        // Adopt a root element from another document.
+        other = xtree::parse_string("<other><y>Y</y></other>");
+        xtree::element_ptr y = other->root()->find_first_elem();
+        BOOST_REQUIRE(y != 0);
+        xtree::element_ptr new_root = doc->reset_root_adopt(*other->root());
+        other.reset();
+        BOOST_CHECK_EQUAL(new_root->name(), "other");
+        BOOST_CHECK_EQUAL(y->content(), "Y");
+        BOOST_CHECK(y->parent() == new_root);
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+    xtree::set_lazy_node_wrappers(false);
+}
+
+
+BOOST_AUTO_TEST_CASE(test_parsed_document_wrapper_arena)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML = "<x:root xmlns:x='http://example.com/x' xmlns:y='http://example.com/y'>"
+                           "<x:a y:id='1'>A</x:a>"
+                           "</x:root>";
+    try
+    {
+        // Wrappers created while parsing are allocated from the document's arena.
+        std::auto_ptr<xtree::document> doc(xtree::parse_string(TEST_XML));
+        xtree::detail::wrapper_arena* arena = doc->find_wrapper_arena();
+#ifdef XTREE_HAS_CXX11
+        BOOST_REQUIRE(arena != 0);
+#endif
+        xtree::element_ptr root = doc->root();
+        BOOST_REQUIRE(root != 0);
+        BOOST_CHECK(xtree::detail::get_wrapper_arena(root.operator->()) == arena);
+        xtree::element_ptr a = root->find_first_elem();
+        BOOST_REQUIRE(a != 0);
+        BOOST_CHECK(xtree::detail::get_wrapper_arena(a.operator->()) == arena);
+        BOOST_CHECK(xtree::detail::get_wrapper_arena(a->begin().operator->()) == arena);
+        xtree::attribute_map::iterator id = a->attrs().find("id", "http://example.com/y");
+        BOOST_REQUIRE(id != a->attrs().end());
+        BOOST_CHECK(xtree::detail::get_wrapper_arena(id.operator->()) == arena);
+        // XML namespace wrappers are allocated from the document's arena as well.
+        xtree::xmlns_ptr x = root->get_xmlns();
+        BOOST_REQUIRE(x != 0);
+        BOOST_CHECK(xtree::detail::get_wrapper_arena(x.operator->()) == arena);
+        xtree::xmlns_ptr y = x->next_sibling();
+        BOOST_REQUIRE(y != 0);
+        BOOST_CHECK_EQUAL(y->prefix(), "y");
+        BOOST_CHECK(xtree::detail::get_wrapper_arena(y.operator->()) == arena);
+        BOOST_CHECK(xtree::detail::get_wrapper_arena(id->get_xmlns().operator->()) == arena);
+        // So are the wrappers created while cloning a document.
+        std::auto_ptr<xtree::document> cloned(xtree::clone_document(*doc));
+        xtree::detail::wrapper_arena* cloned_arena = cloned->find_wrapper_arena();
+#ifdef XTREE_HAS_CXX11
+        BOOST_REQUIRE(cloned_arena != 0 && cloned_arena != arena);
+#endif
+        xtree::element_ptr cloned_root = cloned->root();
+        BOOST_REQUIRE(cloned_root != 0);
+        BOOST_CHECK(xtree::detail::get_wrapper_arena(cloned_root.operator->()) == cloned_arena);
+        BOOST_CHECK_EQUAL(cloned_root->find_first_elem()->content(), "A");
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_pushed_document_wrapper_arena)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML = "<root xmlns='http://example.com/x'><a id='1'>A</a><!--B--></root>";
+    try
+    {
+        // Wrappers created while push-parsing are allocated from the document's arena.
+        xtree::dom_push_parser parser;
+        parser.feed(TEST_XML, std::strlen(TEST_XML) / 2);
+        parser.feed(TEST_XML + std::strlen(TEST_XML) / 2,
+                    std::strlen(TEST_XML) - std::strlen(TEST_XML) / 2);
+        std::auto_ptr<xtree::document> doc = parser.finish();
+        xtree::detail::wrapper_arena* arena = doc->find_wrapper_arena();
+        BOOST_REQUIRE(arena != 0);
+        xtree::element_ptr root = doc->root();
+        BOOST_REQUIRE(root != 0);
+        xtree::element_ptr a = root->find_first_elem();
+        BOOST_REQUIRE(a != 0);
+        BOOST_CHECK_EQUAL(a->content(), "A");
+#ifdef XTREE_HAS_CXX11
+        BOOST_CHECK(xtree::detail::get_wrapper_arena(root.operator->()) == arena);
+        BOOST_CHECK(xtree::detail::get_wrapper_arena(a.operator->()) == arena);
+        BOOST_CHECK(xtree::detail::get_wrapper_arena(a->begin().operator->()) == arena);
+#endif
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_replayed_document_wrapper_arena)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML = "<root xmlns='http://example.com/x'><a id='1'>A</a><!--B--></root>";
+    try
+    {
+        // Wrappers created by a DOM builder are allocated from the document's arena.
+        xtree::sax_event_buffer buffer;
+        xtree::sax_parser parser;
+        parser.set_content_handler(&buffer);
+        parser.parse_string(TEST_XML);
+        std::auto_ptr<xtree::document> doc = buffer.replay_document();
+        xtree::detail::wrapper_arena* arena = doc->find_wrapper_arena();
+        BOOST_REQUIRE(arena != 0);
+        xtree::element_ptr root = doc->root();
+        BOOST_REQUIRE(root != 0);
+        xtree::element_ptr a = root->find_first_elem();
+        BOOST_REQUIRE(a != 0);
+        BOOST_CHECK_EQUAL(a->attr("id"), "1");
+        BOOST_CHECK_EQUAL(root->size(), 2U);
+#ifdef XTREE_HAS_CXX11
+        BOOST_CHECK(xtree::detail::get_wrapper_arena(root.operator->()) == arena);
+        BOOST_CHECK(xtree::detail::get_wrapper_arena(a.operator->()) == arena);
+        BOOST_CHECK(xtree::detail::get_wrapper_arena(&root->back()) == arena);
+#endif
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
@@ -0,0 +1,187 @@
+//
+// Created by ZHENG Zhong on 2011-10-18.
+//
+
+#include "xtree_test_utils.hpp"
+
+#include <xtree/xtree.hpp>
+
+#include <climits>
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+
+    //! Makes a record whose rank decreases with its index.
+    std::string make_record(int index, int count)
+    {
+        std::ostringstream oss;
+        oss << "<record id='" << index << "' x:rank='" << (count - index) << "'>"
+            << "<title>record #" << index << "</title><value>" << index << "</value>"
+            << "<value>1</value></record>";
+        return oss.str();
+    }
+
+
+}  // anonymous namespace
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_xml_reader)
+{
+    XTREE_LOG_TEST_NAME;
+    try
+    {
+        xtree::xml_reader reader;
+        BOOST_CHECK_EQUAL(reader.is_open(), false);
+        BOOST_CHECK_EQUAL(reader.node_type(), xtree::reader_none);
+        reader.open_string("<a xmlns:p='http://example.com/p' p:id='1'>"
+                           "text<![CDATA[cdata]]><?pi data?><p:b/><!--comment--></a>");
+        BOOST_CHECK_EQUAL(reader.is_open(), true);
+        // Walk through all the nodes in document order.
+        BOOST_REQUIRE(reader.next());
+        BOOST_CHECK_EQUAL(reader.node_type(), xtree::reader_element);
+        BOOST_CHECK_EQUAL(reader.name(), "a");
+        BOOST_CHECK_EQUAL(reader.depth(), 0);
+        BOOST_CHECK_EQUAL(reader.is_empty_element(), false);
+        BOOST_CHECK_EQUAL(reader.attr_count(), 2);
+        BOOST_CHECK_EQUAL(reader.attr("p:id"), "1");
+        BOOST_CHECK_EQUAL(reader.attr("id", "http://example.com/p"), "1");
+        BOOST_CHECK_EQUAL(reader.attr(1), "1");
+        BOOST_CHECK_EQUAL(reader.attr("id"), "");
+        BOOST_CHECK_EQUAL(reader.attr(2), "");
+        BOOST_REQUIRE(reader.next());
+        BOOST_CHECK_EQUAL(reader.node_type(), xtree::reader_text);
+        BOOST_CHECK_EQUAL(reader.value(), "text");
+        BOOST_CHECK_EQUAL(reader.depth(), 1);
+        BOOST_REQUIRE(reader.next());
+        BOOST_CHECK_EQUAL(reader.node_type(), xtree::reader_cdata);
+        BOOST_CHECK_EQUAL(reader.value(), "cdata");
+        BOOST_REQUIRE(reader.next());
+        BOOST_CHECK_EQUAL(reader.node_type(), xtree::reader_instruction);
+        BOOST_CHECK_EQUAL(reader.name(), "pi");
+        BOOST_CHECK_EQUAL(reader.value(), "data");
+        BOOST_REQUIRE(reader.next());
+        BOOST_CHECK_EQUAL(reader.node_type(), xtree::reader_element);
+        BOOST_CHECK_EQUAL(reader.name(), "p:b");
+        BOOST_CHECK_EQUAL(reader.local_name(), "b");
+        BOOST_CHECK_EQUAL(reader.prefix(), "p");
+        BOOST_CHECK_EQUAL(reader.uri(), "http://example.com/p");
+        BOOST_CHECK_EQUAL(reader.is_empty_element(), true);
+        BOOST_REQUIRE(reader.next());
+        BOOST_CHECK_EQUAL(reader.node_type(), xtree::reader_comment);
+        BOOST_CHECK_EQUAL(reader.value(), "comment");
+        BOOST_REQUIRE(reader.next());
+        BOOST_CHECK_EQUAL(reader.node_type(), xtree::reader_end_element);
+        BOOST_CHECK_EQUAL(reader.name(), "a");
+        BOOST_CHECK_EQUAL(reader.next(), false);
+        BOOST_CHECK_EQUAL(reader.next(), false);
+        reader.close();
+        BOOST_CHECK_EQUAL(reader.is_open(), false);
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_xml_reader_expand)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 100;
+    std::string xml = test_utils::make_test_xml("<feed xmlns='http://example.com/feed' "
+                                                "xmlns:x='http://example.com/x'><!-- header -->"
+                                                "<header><record id='none'/></header>",
+                                                &make_record,
+                                                "</feed>",
+                                                COUNT);
+    try
+    {
+        // The reader is reused from one XML to the next.
+        xtree::xml_reader reader;
+        for (int i = 0; i < 2; ++i)
+        {
+            std::vector<char> buffer(xml.begin(), xml.end());
+            reader.open_buffer(&buffer[0], buffer.size());
+            std::vector<std::string> ids;
+            std::vector<std::string> titles;
+            std::vector<std::string> ranks;
+            xtree::xpath sum_expr("sum(f:value)", "f", "http://example.com/feed");
+            double sum = 0;
+            bool moved = reader.next();
+            while (moved)
+            {
+                if (reader.node_type() != xtree::reader_element || reader.depth() != 1)
+                {
+                    moved = reader.next();
+                }
+                else if (reader.local_name() == "record")
+                {
+                    ids.push_back(reader.attr("id"));
+                    ranks.push_back(reader.attr("rank", "http://example.com/x"));
+                    // Expand the record, use the DOM API on it, then skip its subtree.
+                    xtree::basic_node_ptr<xtree::element> record = reader.expand();
+                    BOOST_REQUIRE(record != 0);
+                    BOOST_CHECK_EQUAL(record->name(), "record");
+                    BOOST_CHECK_EQUAL(record->uri(), "http://example.com/feed");
+                    BOOST_CHECK_EQUAL(record->attr("id"), ids.back());
+                    titles.push_back(record->front().content());
+                    sum += record->eval_number(sum_expr);
+                    moved = reader.next_sibling();
+                }
+                else
+                {
+                    // Skip the header without visiting its content.
+                    BOOST_CHECK_EQUAL(reader.local_name(), "header");
+                    moved = reader.next_sibling();
+                }
+            }
+            BOOST_REQUIRE_EQUAL(ids.size(), static_cast<std::size_t>(COUNT));
+            BOOST_CHECK_EQUAL(ids.front(), "0");
+            BOOST_CHECK_EQUAL(ids.back(), "99");
+            BOOST_CHECK_EQUAL(ranks.back(), "1");
+            BOOST_CHECK_EQUAL(titles.back(), "record #99");
+            BOOST_CHECK_EQUAL(sum, COUNT * (COUNT - 1) / 2 + COUNT);
+        }
+        // Expanding a node which is not an element returns null.
+        reader.open_string("<a>text</a>");
+        BOOST_REQUIRE(reader.next() && reader.next());
+        BOOST_CHECK(reader.expand() == 0);
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_xml_reader_error)
+{
+    XTREE_LOG_TEST_NAME;
+    xtree::xml_reader reader;
+    BOOST_CHECK_THROW(reader.next(), xtree::dom_error);
+    BOOST_CHECK_THROW(reader.open_string(0), xtree::dom_error);
+    BOOST_CHECK_THROW(reader.open_file("non-existent.xml"), xtree::dom_error);
+    if (static_cast<std::size_t>(INT_MAX) < static_cast<std::size_t>(-1))
+    {
+        // The size is checked before the buffer is read.
+        std::size_t too_large = static_cast<std::size_t>(INT_MAX) + 1;
+        BOOST_CHECK_THROW(reader.open_buffer("<a/>", too_large), xtree::dom_error);
+    }
+    // The error is reported when the cursor reaches it, possibly earlier as libxml2 reads ahead.
+    reader.open_string("<a><b/><c></a>");
+    BOOST_CHECK_THROW(while (reader.next()) {}, xtree::dom_error);
+    // The reader may be reused after an error.
+    reader.open_string("<a/>");
+    BOOST_CHECK(reader.next());
+    BOOST_CHECK_EQUAL(reader.name(), "a");
+    BOOST_CHECK_EQUAL(reader.next(), false);
+}
+
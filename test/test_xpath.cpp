@@ -20,6 +20,11 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
+
+#ifdef XTREE_HAS_CXX11
+#  include <thread>
+#endif
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -132,3 +137,118 @@ BOOST_AUTO_TEST_CASE(test_bad_xpaths)
     }
 }
 
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_xpath_copy)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML = "<x:root xmlns:x='http://example.com/x'><x:item>1</x:item></x:root>";
+    try
+    {
+        std::auto_ptr<xtree::document> doc = xtree::parse_string(TEST_XML);
+        xtree::xpath expr("count(//x:item)", "x", "http://example.com/x");
+        // Copies share the compiled XPath expression.
+        xtree::xpath copy(expr);
+        BOOST_CHECK(copy.raw() == expr.raw());
+        BOOST_CHECK_EQUAL(copy.str(), expr.str());
+        BOOST_CHECK(copy.get_xmlns_registry() == expr.get_xmlns_registry());
+        std::vector<xtree::xpath> exprs(10, expr);
+        BOOST_CHECK(exprs.back().raw() == expr.raw());
+        xtree::xpath other("string(//x:item)", "x", "http://example.com/x");
+        copy = other;
+        BOOST_CHECK(copy.raw() == other.raw());
+        BOOST_CHECK_EQUAL(doc->eval_string(copy), "1");
+        copy.swap(exprs.front());
+        BOOST_CHECK(copy.raw() == expr.raw());
+        BOOST_CHECK_EQUAL(doc->eval_number(copy), 1);
+        BOOST_CHECK_EQUAL(doc->eval_string(exprs.front()), "1");
+        exprs.clear();
+        BOOST_CHECK_EQUAL(doc->eval_number(expr), 1);
+#ifdef XTREE_HAS_CXX11
+        // Moving an xpath object transfers its compiled XPath expression.
+        const xmlXPathCompExpr* raw = other.raw();
+        xtree::xpath moved(std::move(other));
+        BOOST_CHECK(moved.raw() == raw);
+        other = std::move(moved);
+        BOOST_CHECK(other.raw() == raw);
+        BOOST_CHECK_EQUAL(doc->eval_string(other), "1");
+#endif
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+#ifdef XTREE_HAS_CXX11
+
+
+namespace {
+
+
+    void eval_repeatedly(const std::vector<xtree::xpath>* exprs, int times, int* failures)
+    {
+        try
+        {
+            std::auto_ptr<xtree::document> doc = xtree::parse_string(
+                "<root><item>1</item><item>2</item><item>3</item></root>"
+            );
+            for (int i = 0; i < times; ++i)
+            {
+                if ( doc->eval_number((*exprs)[0]) != 3
+                  || doc->eval_number((*exprs)[1]) != 6
+                  || doc->eval_string((*exprs)[2]) != "2"
+                  || doc->eval_number((*exprs)[3]) != 5 )
+                {
+                    ++(*failures);
+                }
+            }
+        }
+        catch (const xtree::dom_error&)
+        {
+            ++(*failures);
+        }
+    }
+
+
+}  // anonymous namespace
+
+
+BOOST_AUTO_TEST_CASE(test_xpath_threads)
+{
+    XTREE_LOG_TEST_NAME;
+    const int THREADS = 4;
+    try
+    {
+        // The same xpath objects are evaluated by several threads at once.
+        std::vector<xtree::xpath> exprs;
+        exprs.push_back(xtree::xpath("count(//item)"));
+        exprs.push_back(xtree::xpath("sum(/root/item)"));
+        exprs.push_back(xtree::xpath("string(//item[2])"));
+        // Libxml2 resolves the function calls in the predicates while evaluating.
+        exprs.push_back(xtree::xpath("sum(//item[number(.) > 1 and position() <= last()])"));
+        std::vector<int> failures(THREADS, 0);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < THREADS; ++i)
+        {
+            threads.push_back(std::thread(&eval_repeatedly, &exprs, 1000, &failures[i]));
+        }
+        for (int i = 0; i < THREADS; ++i)
+        {
+            threads[i].join();
+            BOOST_CHECK_EQUAL(failures[i], 0);
+        }
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+#endif  // XTREE_HAS_CXX11
+
@@ -0,0 +1,90 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#include "xtree_test_utils.hpp"
+
+#include <xtree/xtree_dom.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_xpath_batch)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML = "<orders xmlns:x='http://example.com/x'>"
+                           "<order id='1'><customer><name>Foo</name><x:vip/></customer>"
+                           "<item><price>10</price></item><item><price>5.5</price></item></order>"
+                           "<order id='2'><item><price>1</price></item></order>"
+                           "</orders>";
+    try
+    {
+        std::auto_ptr<xtree::document> doc = xtree::parse_string(TEST_XML);
+        xtree::xpath_batch batch;
+        std::size_t id = batch.add("@id");
+        std::size_t total = batch.add("sum(item/price)", xtree::number_result);
+        std::size_t count = batch.add("item", xtree::number_result);
+        std::size_t first = batch.add("item/price");
+        std::size_t customer = batch.add_group("customer");
+        std::size_t name = batch.add("name", xtree::string_result, customer);
+        std::size_t vip = batch.add(xtree::xpath("x:vip", "x", "http://example.com/x"),
+                                    xtree::boolean_result,
+                                    customer);
+        BOOST_CHECK_EQUAL(batch.size(), 6U);
+        BOOST_CHECK_EQUAL(batch.group_count(), 1U);
+        BOOST_CHECK_EQUAL(batch.at(total).str(), "sum(item/price)");
+        // Evaluate the batch on each order, sharing the evaluator.
+        xtree::xpath_evaluator evaluator(*doc);
+        xtree::node_set orders;
+        evaluator.select_nodes("/orders/order", orders);
+        std::vector<std::vector<xtree::xpath_value> > results;
+        for (xtree::node_set::element_iterator i = orders.begin_element();
+             i != orders.end_element();
+             ++i)
+        {
+            evaluator.set_context_node(*i);
+            results.push_back(std::vector<xtree::xpath_value>());
+            batch.eval(evaluator, results.back());
+            BOOST_CHECK(evaluator.context_node() == xtree::element_ptr(&(*i)));
+        }
+        BOOST_REQUIRE_EQUAL(results.size(), 2U);
+        BOOST_REQUIRE_EQUAL(results[0].size(), batch.size());
+        BOOST_CHECK_EQUAL(results[0][id].type, xtree::string_result);
+        BOOST_CHECK_EQUAL(results[0][id].str, "1");
+        BOOST_CHECK_EQUAL(results[0][total].type, xtree::number_result);
+        BOOST_CHECK_EQUAL(results[0][total].number, 15.5);
+        BOOST_CHECK_EQUAL(results[0][count].number, 10);
+        BOOST_CHECK_EQUAL(results[0][first].str, "10");
+        BOOST_CHECK_EQUAL(results[0][name].str, "Foo");
+        BOOST_CHECK_EQUAL(results[0][vip].type, xtree::boolean_result);
+        BOOST_CHECK_EQUAL(results[0][vip].boolean, true);
+        // The second order has no customer.
+        BOOST_CHECK_EQUAL(results[1][id].str, "2");
+        BOOST_CHECK_EQUAL(results[1][total].number, 1);
+        BOOST_CHECK_EQUAL(results[1][name].str, "");
+        BOOST_CHECK_EQUAL(results[1][vip].boolean, false);
+        // Evaluate the batch on an element or a document.
+        std::vector<xtree::xpath_value> values;
+        batch.eval(*orders.begin_element(), values);
+        BOOST_CHECK_EQUAL(values[name].str, "Foo");
+        batch.eval(*doc, values);
+        BOOST_CHECK_EQUAL(values[id].str, "");
+        BOOST_CHECK(values[total].number == 0);
+        BOOST_CHECK(values[count].number != values[count].number);  // NaN
+        // Invalid types and groups are rejected.
+        BOOST_CHECK_THROW(batch.add("item", xtree::node_set_result), xtree::bad_dom_operation);
+        BOOST_CHECK_THROW(batch.add("item", xtree::string_result, 1), xtree::bad_dom_operation);
+        BOOST_CHECK_EQUAL(batch.size(), 6U);
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
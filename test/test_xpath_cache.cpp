@@ -0,0 +1,90 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#include "xtree_test_utils.hpp"
+
+#include <xtree/xtree_dom.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_xpath_cache)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML = "<root><item>1</item><item>2</item><item>3</item></root>";
+    std::size_t old_capacity = xtree::get_xpath_cache_capacity();
+    try
+    {
+        std::auto_ptr<xtree::document> doc = xtree::parse_string(TEST_XML);
+        xtree::clear_xpath_cache();
+        xtree::xpath_cache_stats stats = xtree::get_xpath_cache_stats();
+        BOOST_CHECK_EQUAL(stats.hits, 0U);
+        BOOST_CHECK_EQUAL(stats.misses, 0U);
+        BOOST_CHECK_EQUAL(stats.size, 0U);
+        BOOST_CHECK_EQUAL(stats.capacity, old_capacity);
+        // The same expression is compiled once.
+        double sum = 0;
+        for (int i = 0; i < 100; ++i)
+        {
+            sum += doc->eval_number(xtree::xpath("sum(//item)"));
+        }
+        BOOST_CHECK_EQUAL(sum, 600);
+        stats = xtree::get_xpath_cache_stats();
+        BOOST_CHECK_EQUAL(stats.misses, 1U);
+        BOOST_CHECK_EQUAL(stats.hits, 99U);
+        BOOST_CHECK_EQUAL(stats.size, 1U);
+        // The least recently used expressions are evicted.
+        xtree::set_xpath_cache_capacity(2);
+        xtree::xpath first("count(//item)");
+        xtree::xpath second("string(//item[1])");
+        stats = xtree::get_xpath_cache_stats();
+        BOOST_CHECK_EQUAL(stats.size, 2U);
+        BOOST_CHECK_EQUAL(stats.evictions, 1U);
+        xtree::xpath third("sum(//item)");
+        stats = xtree::get_xpath_cache_stats();
+        BOOST_CHECK_EQUAL(stats.misses, 4U);
+        BOOST_CHECK_EQUAL(stats.evictions, 2U);
+        // The xpath objects remain valid after their expressions are evicted.
+        xtree::clear_xpath_cache();
+        BOOST_CHECK_EQUAL(xtree::get_xpath_cache_stats().size, 0U);
+        BOOST_CHECK_EQUAL(doc->eval_number(first), 3);
+        BOOST_CHECK_EQUAL(doc->eval_string(second), "1");
+        BOOST_CHECK_EQUAL(doc->eval_number(third), 6);
+        // Disable the cache.
+        xtree::set_xpath_cache_capacity(0);
+        xtree::xpath fourth("count(//item)");
+        xtree::xpath fifth("count(//item)");
+        stats = xtree::get_xpath_cache_stats();
+        BOOST_CHECK_EQUAL(stats.misses, 2U);
+        BOOST_CHECK_EQUAL(stats.size, 0U);
+        BOOST_CHECK_EQUAL(doc->eval_number(fifth), 3);
+        // Bad expressions are not cached.
+        xtree::set_xpath_cache_capacity(old_capacity);
+        BOOST_CHECK_THROW(xtree::xpath("bad XPath"), xtree::xpath_error);
+        BOOST_CHECK_THROW(xtree::xpath("bad XPath"), xtree::xpath_error);
+        BOOST_CHECK_EQUAL(xtree::get_xpath_cache_stats().size, 0U);
+        // The same expression is compiled once per namespace registry.
+        xtree::clear_xpath_cache();
+        xtree::xpath a1("count(//p:item)", "p", "urn:a");
+        xtree::xpath a2("count(//p:item)", "p", "urn:a");
+        xtree::xpath b1("count(//p:item)", "p", "urn:b");
+        stats = xtree::get_xpath_cache_stats();
+        BOOST_CHECK_EQUAL(stats.misses, 2U);
+        BOOST_CHECK_EQUAL(stats.hits, 1U);
+        BOOST_CHECK_EQUAL(stats.size, 2U);
+        b1.register_xmlns("p", "urn:a");
+        BOOST_CHECK_EQUAL(xtree::get_xpath_cache_stats().hits, 2U);
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+    xtree::set_xpath_cache_capacity(old_capacity);
+}
+
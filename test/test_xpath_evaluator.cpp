@@ -0,0 +1,71 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#include "xtree_test_utils.hpp"
+
+#include <xtree/xtree_dom.hpp>
+
+#include <memory>
+#include <string>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_xpath_evaluator)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML = "<root xmlns:a='http://example.com/a' xmlns:b='http://example.com/b'>"
+                           "<a:item id='1'><a:value>10</a:value><b:value>-1</b:value></a:item>"
+                           "<a:item id='2'><a:value>20</a:value><b:value>-2</b:value></a:item>"
+                           "</root>";
+    try
+    {
+        std::auto_ptr<xtree::document> doc = xtree::parse_string(TEST_XML);
+        xtree::xpath_evaluator evaluator(*doc);
+        BOOST_CHECK(&evaluator.doc() == doc.get());
+        BOOST_CHECK(evaluator.context_node() == 0);
+        // Evaluate from the document.
+        xtree::xpath count_expr("count(//x:item)", "x", "http://example.com/a");
+        BOOST_CHECK_EQUAL(evaluator.eval_number(count_expr), 2);
+        BOOST_CHECK_EQUAL(evaluator.eval_boolean("count(/root/*)=2"), true);
+        // Evaluate from each item: the same prefix may be mapped to different URIs.
+        xtree::xpath a_expr("string(x:value)", "x", "http://example.com/a");
+        xtree::xpath b_expr("string(x:value)", "x", "http://example.com/b");
+        xtree::node_set items;
+        evaluator.select_nodes(xtree::xpath("//x:item", "x", "http://example.com/a"), items);
+        BOOST_REQUIRE_EQUAL(items.size(), 2U);
+        const char* A_VALUES[] = { "10", "20" };
+        const char* B_VALUES[] = { "-1", "-2" };
+        int index = 0;
+        for (xtree::node_set::element_iterator i = items.begin_element();
+             i != items.end_element();
+             ++i, ++index)
+        {
+            xtree::element_ptr item(&(*i));
+            evaluator.set_context_node(*item);
+            BOOST_CHECK(evaluator.context_node() == item);
+            BOOST_CHECK_EQUAL(evaluator.eval_string(a_expr), A_VALUES[index]);
+            BOOST_CHECK_EQUAL(evaluator.eval_string(b_expr), B_VALUES[index]);
+            BOOST_CHECK_EQUAL(evaluator.eval_string(a_expr), A_VALUES[index]);
+            BOOST_CHECK_EQUAL(evaluator.eval_string("string(@id)"), item->attr("id"));
+            BOOST_CHECK_EQUAL(evaluator.eval_number("count(ancestor::*)"), 1);
+        }
+        evaluator.reset_context_node();
+        BOOST_CHECK(evaluator.context_node() == 0);
+        BOOST_CHECK_EQUAL(evaluator.eval_string("name(/*)"), "root");
+        // Errors do not affect the next evaluations.
+        BOOST_CHECK_THROW(evaluator.eval_number("//root"), xtree::xpath_error);
+        BOOST_CHECK_THROW(evaluator.eval_string("string(y:value)"), xtree::xpath_error);
+        BOOST_CHECK_EQUAL(evaluator.eval_number(count_expr), 2);
+        // The context node should belong to the document.
+        std::auto_ptr<xtree::document> other = xtree::parse_string("<root/>");
+        BOOST_CHECK_THROW(evaluator.set_context_node(*other->root()), xtree::bad_dom_operation);
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
@@ -0,0 +1,291 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#include "xtree_test_utils.hpp"
+
+#include <xtree/xtree_dom.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef XTREE_HAS_CXX11
+#  include <thread>
+#endif
+
+
+namespace {
+
+
+    //! This class owns a collection of documents, each one holding a book with a number of
+    //! chapters depending on its index.
+    class book_collection
+    {
+
+    public:
+
+        explicit book_collection(int count): docs_()
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                std::ostringstream oss;
+                oss << "<x:book xmlns:x='http://example.com/x' id='" << i << "'>";
+                for (int j = 0; j <= i % 5; ++j)
+                {
+                    oss << "<x:chapter>" << j << "</x:chapter>";
+                }
+                oss << "</x:book>";
+                std::auto_ptr<xtree::document> doc = xtree::parse_string(oss.str().c_str());
+                docs_.push_back(doc.get());
+                doc.release();
+            }
+        }
+
+        ~book_collection()
+        {
+            for (std::size_t i = 0; i < docs_.size(); ++i)
+            {
+                delete docs_[i];
+            }
+        }
+
+        const std::vector<xtree::document*>& docs() const
+        {
+            return docs_;
+        }
+
+    private:
+
+        book_collection(const book_collection&);
+
+        book_collection& operator=(const book_collection&);
+
+    private:
+
+        std::vector<xtree::document*> docs_;
+
+    };
+
+
+    //! This processor counts the nodes selected in each document, on the worker threads.
+    class count_processor: public xtree::xpath_result_processor
+    {
+
+    public:
+
+        explicit count_processor(std::size_t size,
+                                 std::size_t throw_at = static_cast<std::size_t>(-1))
+        : throw_at_(throw_at), counts_(size, 0)
+        {
+            // Do nothing.
+        }
+
+        virtual void process(xtree::document&, std::size_t index, xtree::xpath_result& result)
+        {
+            if (index == throw_at_)
+            {
+                throw std::runtime_error("fail to process result");
+            }
+            xtree::node_set nodes;
+            result.transfer(nodes);
+            counts_[index] = nodes.size();
+        }
+
+        const std::vector<std::size_t>& counts() const
+        {
+            return counts_;
+        }
+
+    private:
+
+        std::size_t              throw_at_;
+        std::vector<std::size_t> counts_;
+
+    };
+
+
+}  // anonymous namespace
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_xpath_executor)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 200;
+    const std::string X_URI = "http://example.com/x";
+    try
+    {
+        book_collection books(COUNT);
+        const std::vector<xtree::document*>& docs = books.docs();
+        xtree::xpath_executor executor(4);
+        BOOST_CHECK_EQUAL(executor.thread_count(), 4U);
+        // Evaluate to typed values, twice with the same executor.
+        xtree::xpath chapters("count(/x:book/x:chapter)", "x", X_URI);
+        for (int i = 0; i < 2; ++i)
+        {
+            std::vector<xtree::xpath_value> values;
+            executor.eval(docs.begin(), docs.end(), chapters, xtree::number_result, values);
+            BOOST_REQUIRE_EQUAL(values.size(), static_cast<std::size_t>(COUNT));
+            for (std::size_t n = 0; n < values.size(); ++n)
+            {
+                BOOST_CHECK_EQUAL(values[n].type, xtree::number_result);
+                BOOST_CHECK_EQUAL(values[n].number, static_cast<double>(n % 5 + 1));
+            }
+        }
+        std::vector<xtree::xpath_value> ids;
+        executor.eval(docs.begin(), docs.end(), "string(/*/@id)", xtree::string_result, ids);
+        BOOST_REQUIRE_EQUAL(ids.size(), static_cast<std::size_t>(COUNT));
+        BOOST_CHECK_EQUAL(ids[0].str, "0");
+        BOOST_CHECK_EQUAL(ids[COUNT - 1].str, "199");
+        // Process the node sets on the worker threads.
+        count_processor processor(COUNT);
+        executor.eval(docs.begin(),
+                      docs.end(),
+                      xtree::xpath("/x:book/x:chapter[. > 1]", "x", X_URI),
+                      processor);
+        for (std::size_t n = 0; n < processor.counts().size(); ++n)
+        {
+            BOOST_CHECK_EQUAL(processor.counts()[n], (n % 5 > 1 ? n % 5 - 1 : 0));
+        }
+        // An empty range gives no value.
+        executor.eval(docs.end(), docs.end(), chapters, xtree::boolean_result, ids);
+        BOOST_CHECK(ids.empty());
+        BOOST_CHECK_THROW( executor.eval(docs.begin(), docs.end(), chapters,
+                                         xtree::node_set_result, ids),
+                           xtree::bad_dom_operation );
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_xpath_executor_error)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 200;
+    try
+    {
+        book_collection books(COUNT);
+        const std::vector<xtree::document*>& docs = books.docs();
+        xtree::xpath_executor executor(2);
+        // The exception thrown by the processor is propagated to the calling thread.
+        count_processor processor(COUNT, 50);
+        BOOST_CHECK_THROW( executor.eval(docs.begin(), docs.end(), "/*", processor),
+                           std::runtime_error );
+        // The XPath errors are propagated as well: undefined namespace prefix.
+        std::vector<xtree::xpath_value> values;
+        BOOST_CHECK_THROW( executor.eval(docs.begin(), docs.end(), "count(/y:book)",
+                                         xtree::number_result, values),
+                           xtree::xpath_error );
+        // The executor is ready to be used again.
+        executor.eval(docs.begin(), docs.end(), "count(/*)", xtree::number_result, values);
+        BOOST_REQUIRE_EQUAL(values.size(), static_cast<std::size_t>(COUNT));
+        BOOST_CHECK_EQUAL(values[COUNT - 1].number, 1.0);
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_xpath_executor_functions)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 200;
+    try
+    {
+        book_collection books(COUNT);
+        const std::vector<xtree::document*>& docs = books.docs();
+        xtree::xpath_executor executor(4);
+        // The function calls in the predicate are resolved concurrently by the worker threads.
+        xtree::xpath last_chapter("count(/x:book/x:chapter[position() = last() and . > 2])",
+                                  "x",
+                                  "http://example.com/x");
+        for (int i = 0; i < 2; ++i)
+        {
+            std::vector<xtree::xpath_value> values;
+            executor.eval(docs.begin(), docs.end(), last_chapter, xtree::number_result, values);
+            BOOST_REQUIRE_EQUAL(values.size(), static_cast<std::size_t>(COUNT));
+            for (std::size_t n = 0; n < values.size(); ++n)
+            {
+                BOOST_CHECK_EQUAL(values[n].number, (n % 5 > 2 ? 1.0 : 0.0));
+            }
+        }
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+#ifdef XTREE_HAS_CXX11
+
+
+namespace {
+
+
+    void eval_ids(xtree::xpath_executor* executor,
+                  const std::vector<xtree::document*>* docs,
+                  std::vector<xtree::xpath_value>* ids)
+    {
+        try
+        {
+            executor->eval(docs->begin(), docs->end(), "string(/*/@id)",
+                           xtree::string_result, *ids);
+        }
+        catch (const xtree::dom_error&)
+        {
+            ids->clear();
+        }
+    }
+
+
+}  // anonymous namespace
+
+
+BOOST_AUTO_TEST_CASE(test_xpath_executor_threads)
+{
+    XTREE_LOG_TEST_NAME;
+    const int COUNT = 200;
+    const int THREADS = 4;
+    try
+    {
+        book_collection books(COUNT);
+        xtree::xpath_executor executor(2);
+        // Several threads use the same executor at once: their calls run one after the other.
+        std::vector< std::vector<xtree::xpath_value> > ids(THREADS);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < THREADS; ++i)
+        {
+            threads.push_back(std::thread(&eval_ids, &executor, &books.docs(), &ids[i]));
+        }
+        for (int i = 0; i < THREADS; ++i)
+        {
+            threads[i].join();
+            BOOST_REQUIRE_EQUAL(ids[i].size(), static_cast<std::size_t>(COUNT));
+            for (std::size_t n = 0; n < ids[i].size(); ++n)
+            {
+                std::ostringstream oss;
+                oss << n;
+                BOOST_CHECK_EQUAL(ids[i][n].str, oss.str());
+            }
+        }
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+#endif  // XTREE_HAS_CXX11
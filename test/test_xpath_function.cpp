@@ -0,0 +1,184 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#include "xtree_test_utils.hpp"
+
+#include <xtree/xtree_dom.hpp>
+
+#include <cctype>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+
+namespace {
+
+
+    //! Returns its string argument, trimmed and converted to upper case.
+    class upper_function: public xtree::xpath_function
+    {
+    public:
+        virtual xtree::xpath_value call(const xtree::xpath_function_args& args)
+        {
+            std::string str = args.string_at(0);
+            std::string::size_type begin = str.find_first_not_of(" \t");
+            std::string::size_type end = str.find_last_not_of(" \t");
+            str = (begin != std::string::npos ? str.substr(begin, end - begin + 1) : "");
+            for (std::string::iterator i = str.begin(); i != str.end(); ++i)
+            {
+                *i = static_cast<char>(std::toupper(static_cast<unsigned char>(*i)));
+            }
+            return xtree::xpath_value(str);
+        }
+    };
+
+
+    //! Returns the sum of the numeric values of the nodes of its node set argument, multiplied
+    //! by its number argument.
+    class scaled_sum_function: public xtree::xpath_function
+    {
+    public:
+        virtual xtree::xpath_value call(const xtree::xpath_function_args& args)
+        {
+            xtree::node_set nodes;
+            args.nodes_at(0, nodes);
+            double sum = 0;
+            for (xtree::node_set::iterator i = nodes.begin(); i != nodes.end(); ++i)
+            {
+                sum += std::atof(i->content().c_str());
+            }
+            return xtree::xpath_value(sum * args.number_at(1));
+        }
+    };
+
+
+    //! Returns a constant string.
+    class constant_function: public xtree::xpath_function
+    {
+    public:
+        explicit constant_function(const std::string& value): value_(value)
+        {
+            // Do nothing.
+        }
+        virtual xtree::xpath_value call(const xtree::xpath_function_args&)
+        {
+            return xtree::xpath_value(value_);
+        }
+    private:
+        std::string value_;
+    };
+
+
+    //! Always fails.
+    class failing_function: public xtree::xpath_function
+    {
+    public:
+        virtual xtree::xpath_value call(const xtree::xpath_function_args&)
+        {
+            throw std::runtime_error("out of order");
+        }
+    };
+
+
+}  // anonymous namespace
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_xpath_function)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML = "<root>"
+                           "<item code=' abc ' price='10'/>"
+                           "<item code='Def' price='20'/>"
+                           "<item code='ABC' price='30'/>"
+                           "</root>";
+    const std::string FN_URI = "http://example.com/fn";
+    try
+    {
+        std::auto_ptr<xtree::document> doc = xtree::parse_string(TEST_XML);
+        upper_function upper;
+        scaled_sum_function scaled_sum;
+        failing_function failing;
+        // Functions registered to an evaluator.
+        xtree::xpath_evaluator evaluator(*doc);
+        evaluator.register_function("upper", FN_URI, upper);
+        evaluator.register_function("scaled-sum", scaled_sum);
+        xtree::xpath by_code("count(//item[my:upper(@code)='ABC'])", "my", FN_URI);
+        BOOST_CHECK_EQUAL(evaluator.eval_number(by_code), 2);
+        BOOST_CHECK_EQUAL(evaluator.eval_string("my:upper(' x ')"), "X");
+        BOOST_CHECK_EQUAL(evaluator.eval_number("scaled-sum(//item/@price, 2)"), 120);
+        xtree::node_set items;
+        evaluator.select_nodes(xtree::xpath("//item[scaled-sum(@price, 1) > 15]"), items);
+        BOOST_CHECK_EQUAL(items.size(), 2U);
+        // Other evaluations do not see the functions of the evaluator.
+        BOOST_CHECK_THROW(doc->eval_number(by_code), xtree::xpath_error);
+        // Functions registered globally, overridden by the evaluator.
+        xtree::register_xpath_function("upper", FN_URI, upper);
+        BOOST_CHECK_EQUAL(doc->eval_number(by_code), 2);
+        BOOST_CHECK_EQUAL(doc->root()->eval_number(by_code), 2);
+        evaluator.register_function("upper", FN_URI, failing);
+        BOOST_CHECK_THROW(evaluator.eval_number(by_code), xtree::xpath_error);
+        evaluator.unregister_function("upper", FN_URI);
+        BOOST_CHECK_EQUAL(evaluator.eval_number(by_code), 2);
+        BOOST_CHECK(xtree::unregister_xpath_function("upper", FN_URI));
+        BOOST_CHECK(!xtree::unregister_xpath_function("upper", FN_URI));
+        BOOST_CHECK_THROW(doc->eval_number(by_code), xtree::xpath_error);
+        BOOST_CHECK_THROW(evaluator.eval_number(by_code), xtree::xpath_error);
+        // Errors thrown by functions are reported.
+        xtree::register_xpath_function("fail", failing);
+        try
+        {
+            doc->eval_boolean("fail()");
+            BOOST_ERROR("fail() should throw xpath_error");
+        }
+        catch (const xtree::xpath_error& ex)
+        {
+            BOOST_CHECK(std::string(ex.what()).find("out of order") != std::string::npos);
+        }
+        BOOST_CHECK_THROW(evaluator.eval_string("scaled-sum('x', 1)"), xtree::xpath_error);
+        BOOST_CHECK(xtree::unregister_xpath_function("fail"));
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_xpath_function_bindings)
+{
+    XTREE_LOG_TEST_NAME;
+    try
+    {
+        std::auto_ptr<xtree::document> doc = xtree::parse_string("<root/>");
+        constant_function a("A");
+        constant_function b("B");
+        xtree::register_xpath_function("f", "urn:a", a);
+        xtree::register_xpath_function("f", "urn:b", b);
+        // The same expression text bound to different namespaces calls different functions.
+        for (int i = 0; i < 2; ++i)
+        {
+            BOOST_CHECK_EQUAL(doc->eval_string(xtree::xpath("p:f()", "p", "urn:a")), "A");
+            BOOST_CHECK_EQUAL(doc->eval_string(xtree::xpath("p:f()", "p", "urn:b")), "B");
+        }
+        // The same compiled expression calls the function of each evaluation context.
+        xtree::xpath expr("p:f()", "p", "urn:c");
+        xtree::xpath_evaluator first(*doc);
+        first.register_function("f", "urn:c", a);
+        xtree::xpath_evaluator second(*doc);
+        second.register_function("f", "urn:c", b);
+        BOOST_CHECK_EQUAL(first.eval_string(expr), "A");
+        BOOST_CHECK_EQUAL(second.eval_string(expr), "B");
+        BOOST_CHECK_EQUAL(first.eval_string(expr), "A");
+        BOOST_CHECK(xtree::unregister_xpath_function("f", "urn:a"));
+        BOOST_CHECK(xtree::unregister_xpath_function("f", "urn:b"));
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
@@ -0,0 +1,80 @@
+//
+// Created by ZHENG Zhong on 2011-10-19.
+//
+
+#include "xtree_test_utils.hpp"
+
+#include <xtree/xtree_dom.hpp>
+
+#include <memory>
+#include <string>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+BOOST_AUTO_TEST_CASE(test_xpath_variables)
+{
+    XTREE_LOG_TEST_NAME;
+    const char* TEST_XML = "<root>"
+                           "<item id='1' price='10'>foo</item>"
+                           "<item id='2' price='20'>bar</item>"
+                           "<item id='3' price='30'>baz</item>"
+                           "</root>";
+    try
+    {
+        std::auto_ptr<xtree::document> doc = xtree::parse_string(TEST_XML);
+        xtree::xpath_variables vars;
+        BOOST_CHECK(vars.empty());
+        vars.set_string("id", "2");
+        vars.set_number("min", 15);
+        vars.set_boolean("flag", true);
+        BOOST_CHECK_EQUAL(vars.size(), 3U);
+        BOOST_CHECK(vars.contains("min"));
+        // One compiled expression serves every value of its variables.
+        xtree::xpath by_id("string(//item[@id=$id])");
+        xtree::xpath_string str;
+        doc->eval(by_id, vars, str);
+        BOOST_CHECK_EQUAL(str.value(), "bar");
+        vars.set_string("id", "3");
+        doc->eval(by_id, vars, str);
+        BOOST_CHECK_EQUAL(str.value(), "baz");
+        xtree::xpath_number number;
+        doc->root()->eval("count(item[@price > $min])", vars, number);
+        BOOST_CHECK_EQUAL(number.value(), 2);
+        xtree::xpath_boolean boolean;
+        doc->eval("$flag and $min = 15", vars, boolean);
+        BOOST_CHECK_EQUAL(boolean.value(), true);
+        // Node set variables.
+        xtree::node_set items;
+        doc->eval(xtree::xpath("//item[@price > $min]"), vars, items);
+        BOOST_CHECK_EQUAL(items.size(), 2U);
+        vars.set_nodes("items", items);
+        doc->eval("sum($items/@price)", vars, number);
+        BOOST_CHECK_EQUAL(number.value(), 50);
+        // Bind the variables to an evaluator.
+        xtree::xpath_evaluator evaluator(*doc);
+        evaluator.set_variables(vars);
+        BOOST_CHECK_EQUAL(evaluator.eval_string(by_id), "baz");
+        BOOST_CHECK_EQUAL(evaluator.eval_number("count($items)"), 2);
+        vars.set_string("id", "1");
+        BOOST_CHECK_EQUAL(evaluator.eval_string(by_id), "baz");
+        evaluator.set_variables(vars);
+        BOOST_CHECK_EQUAL(evaluator.eval_string(by_id), "foo");
+        // Unbound variables are errors.
+        BOOST_CHECK(vars.remove("id"));
+        BOOST_CHECK(!vars.remove("id"));
+        evaluator.set_variables(vars);
+        BOOST_CHECK_THROW(evaluator.eval_string(by_id), xtree::xpath_error);
+        evaluator.clear_variables();
+        BOOST_CHECK_THROW(evaluator.eval_number("count($items)"), xtree::xpath_error);
+        BOOST_CHECK_THROW(doc->eval_string(by_id), xtree::xpath_error);
+        vars.clear();
+        BOOST_CHECK(vars.empty());
+    }
+    catch (const xtree::dom_error& ex)
+    {
+        BOOST_ERROR(ex.what());
+    }
+}
+
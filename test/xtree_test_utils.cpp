@@ -33,6 +33,7 @@
 
 #include <cstdlib>
 #include <functional>
+#include <sstream>
 #include <string>
 
 
@@ -133,5 +134,46 @@ namespace test_utils {
     }
 
 
+    std::string make_test_xml(const std::string& head,
+                              const std::string& item,
+                              const std::string& tail,
+                              int count)
+    {
+        const std::string placeholder = "{i}";
+        std::ostringstream oss;
+        oss << head;
+        for (int i = 0; i < count; ++i)
+        {
+            std::string::size_type begin = 0;
+            std::string::size_type found = item.find(placeholder);
+            while (found != std::string::npos)
+            {
+                oss << item.substr(begin, found - begin) << i;
+                begin = found + placeholder.size();
+                found = item.find(placeholder, begin);
+            }
+            oss << item.substr(begin);
+        }
+        oss << tail;
+        return oss.str();
+    }
+
+
+    std::string make_test_xml(const std::string& head,
+                              test_item_maker item,
+                              const std::string& tail,
+                              int count)
+    {
+        std::ostringstream oss;
+        oss << head;
+        for (int i = 0; i < count; ++i)
+        {
+            oss << item(i, count);
+        }
+        oss << tail;
+        return oss.str();
+    }
+
+
 }  // namespace test_utils
 
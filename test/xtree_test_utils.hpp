@@ -28,6 +28,8 @@
 #  pragma warning(pop)
 #endif
 
+#include <xtree/sax_error_info.hpp>
+
 #include <string>
 
 
@@ -67,6 +69,64 @@ namespace test_utils {
     //! \return the path to the fixture file.
     std::string get_fixture_path(const std::string& name);
 
+    //! Function making the markup of an item in a test XML document.
+    //! \param index  the index of the item.
+    //! \param count  the number of items in the document.
+    //! \return the markup of the item.
+    typedef std::string (*test_item_maker)(int index, int count);
+
+    //! Makes a test XML document made of a number of items between a head and a tail.
+    //! \param head   the markup before the items, typically the start tag of the root element.
+    //! \param item   the markup of an item, in which every "{i}" is replaced by the item index.
+    //! \param tail   the markup after the items, typically the end tag of the root element.
+    //! \param count  the number of items.
+    //! \return the test XML document.
+    std::string make_test_xml(const std::string& head,
+                              const std::string& item,
+                              const std::string& tail,
+                              int count);
+
+    //! Makes a test XML document made of a number of items between a head and a tail.
+    //! \param head   the markup before the items, typically the start tag of the root element.
+    //! \param item   the function making the markup of an item.
+    //! \param tail   the markup after the items, typically the end tag of the root element.
+    //! \param count  the number of items.
+    //! \return the test XML document.
+    std::string make_test_xml(const std::string& head,
+                              test_item_maker item,
+                              const std::string& tail,
+                              int count);
+
+    //! This class template counts the fatal errors reported to a SAX handler. The base class is
+    //! either xtree::sax_error_handler, or xtree::basic_sax_handler<H> where H derives from this
+    //! class template.
+    template<class Base>
+    class basic_fatal_counter: public Base
+    {
+
+    public:
+
+        explicit basic_fatal_counter(): count_(0)
+        {
+            // Do nothing.
+        }
+
+        void fatal(const xtree::sax_error_info&)
+        {
+            ++count_;
+        }
+
+        int count() const
+        {
+            return count_;
+        }
+
+    private:
+
+        int count_;
+
+    };
+
 
 }  // namespace test_utils
 